@@ -29,6 +29,47 @@ __C {
         llaisysTensor_t *mlp_down_w;
     };
 
+    struct LlaisysQwen2PrefixCacheStats {
+        uint64_t hits, misses;
+        uint64_t hit_tokens, miss_tokens;
+        uint64_t cached_tokens, evicted_tokens;
+    };
+
+    struct LlaisysQwen2GenerateParams {
+        size_t max_new_tokens;
+        // Sampling. top_k == 1 or temperature <= 0 decodes greedily; top_k == 0 keeps the whole vocabulary.
+        float temperature;
+        size_t top_k;
+        float top_p;
+        uint64_t seed;
+        // Speculative decoding: longest trailing n-gram to match for prompt lookup (0 disables) and the
+        // maximum number of draft tokens verified per forward pass, also used with a draft model.
+        size_t ngram;
+        size_t num_draft;
+    };
+
+    // Cumulative since model creation. Acceptance rate is accepted / drafted; decode_tokens / decode_steps is
+    // the number of tokens produced per forward pass, i.e. the speedup over plain decoding.
+    struct LlaisysQwen2SpeculativeStats {
+        uint64_t decode_steps, decode_tokens;
+        uint64_t drafted_tokens, accepted_tokens;
+    };
+
+    // Tokens dropped from the KV cache by streaming or heavy-hitter eviction. evictions and evicted_entries are
+    // cumulative since model creation; an entry is one token's row in one layer and KV head. cached_tokens is
+    // the number of rows each head currently holds.
+    struct LlaisysQwen2KVEvictionStats {
+        uint64_t evictions, evicted_entries;
+        uint64_t cached_tokens;
+    };
+
+    // Session preemption counters, cumulative since sessions were enabled, and the current session counts.
+    struct LlaisysQwen2SessionStats {
+        uint64_t preemptions, swap_outs, swap_ins, recomputes;
+        uint64_t swapped_bytes, recomputed_tokens;
+        uint64_t resident_sessions, swapped_sessions;
+    };
+
     struct LlaisysQwen2Model;
 
     __export struct LlaisysQwen2Model *llaisysQwen2ModelCreate(const LlaisysQwen2Meta *meta, llaisysDeviceType_t device, int *device_ids, int ndevice);
@@ -38,5 +79,87 @@ __C {
     __export struct LlaisysQwen2Weights *llaisysQwen2ModelWeights(struct LlaisysQwen2Model * model);
 
     __export int64_t llaisysQwen2ModelInfer(struct LlaisysQwen2Model * model, int64_t * token_ids, size_t ntoken);
+
+    typedef void (*LlaisysQwen2TokenCallback)(int64_t token, void *userdata);
+
+    // Start generating on a thread of the model's own and return immediately. The current sequence is
+    // continued when the prompt extends it, otherwise a new one is started. Each token is passed to
+    // `callback` on that thread, or, when it is NULL, queued for ReadTokens. Generation stops after
+    // end_token or params->max_new_tokens tokens. The model must not be used otherwise until Wait.
+    __export void llaisysQwen2ModelGenerate(struct LlaisysQwen2Model * model, int64_t * token_ids, size_t ntoken, const struct LlaisysQwen2GenerateParams *params, LlaisysQwen2TokenCallback callback, void *userdata);
+
+    // Block until generated tokens are available and copy up to max_tokens of them to out_tokens. Returns 0
+    // once generation has finished and every token has been read.
+    __export size_t llaisysQwen2ModelReadTokens(struct LlaisysQwen2Model * model, int64_t * out_tokens, size_t max_tokens);
+
+    // Ask the running generation to stop after its current step.
+    __export void llaisysQwen2ModelCancel(struct LlaisysQwen2Model * model);
+
+    // Wait for generation to finish and return the number of tokens generated.
+    __export size_t llaisysQwen2ModelWait(struct LlaisysQwen2Model * model);
+
+    // Use `draft`, a smaller model with the same vocabulary, to propose tokens during Generate; it takes
+    // precedence over n-gram lookup. The draft must outlive the pairing; pass NULL to detach it.
+    __export void llaisysQwen2ModelSetDraft(struct LlaisysQwen2Model * model, struct LlaisysQwen2Model * draft);
+
+    __export void llaisysQwen2ModelSpeculativeStats(struct LlaisysQwen2Model * model, struct LlaisysQwen2SpeculativeStats * stats);
+
+    // Save the current sequence's tokens and KV cache to a file. With `quantize`, KV rows are stored as int8
+    // with a float scale per token and KV head.
+    __export void llaisysQwen2ModelSaveSnapshot(struct LlaisysQwen2Model * model, const char *path, uint8_t quantize);
+
+    // Replace the current sequence with a saved snapshot, mapped from disk. Returns the number of tokens
+    // restored; Infer and Generate continue from them. Snapshots are portable across processes for a model
+    // with the same shape, and across dtypes when quantized.
+    __export size_t llaisysQwen2ModelLoadSnapshot(struct LlaisysQwen2Model * model, const char *path);
+
+    // Autotune the GEMM blocking of every projection for forward passes of each of the `n` token counts, NULL
+    // meaning decode only. Results are saved to the tuning cache file (LLAISYS_GEMM_CACHE, else
+    // ~/.cache/llaisys/gemm_tuning.tsv) per CPU model and loaded by later processes on first use.
+    __export void llaisysQwen2ModelTune(struct LlaisysQwen2Model * model, const size_t *ntokens, size_t n);
+
+    // End the current sequence; the next Infer call starts a new one.
+    __export void llaisysQwen2ModelReset(struct LlaisysQwen2Model * model);
+
+    // StreamingLLM mode: keep the first sink_tokens tokens plus a sliding window over the rest of maxseq, so
+    // sequences can grow without bound at constant memory and per-token cost. Ends the current sequence.
+    // Speculative decoding, prefix caching and snapshots are unavailable while it is enabled.
+    __export void llaisysQwen2ModelSetStreaming(struct LlaisysQwen2Model * model, uint8_t enable, size_t sink_tokens);
+
+    // Heavy-hitter (H2O) mode: attention accumulates how much weight every cached token receives, and each
+    // layer and KV head keeps at most budget_tokens of them, evicting the least attended but never the
+    // recent_tokens newest. Bounds KV memory per sequence at some cost in quality; budget_tokens must be
+    // below maxseq, which is then no longer a limit on sequence length. Ends the current sequence and has the
+    // same restrictions as streaming.
+    __export void llaisysQwen2ModelSetHeavyHitter(struct LlaisysQwen2Model * model, uint8_t enable, size_t budget_tokens, size_t recent_tokens);
+
+    __export void llaisysQwen2ModelKVEvictionStats(struct LlaisysQwen2Model * model, struct LlaisysQwen2KVEvictionStats * stats);
+
+    // Let several sequences (sessions) take turns on the model. At most max_resident of them hold a KV cache;
+    // when another needs one, the least recently used session of the lowest priority is preempted. Its KV is
+    // swapped out, to spill_dir through an mmap-backed file or to host memory when spill_dir is NULL, with
+    // int8 rows when `quantize` is set; or it is dropped and recomputed on return, whichever a cost model of
+    // measured prefill and swap throughput expects to be cheaper. Ends the current sequence; 0 disables.
+    __export void llaisysQwen2ModelSetSessions(struct LlaisysQwen2Model * model, size_t max_resident, const char *spill_dir, uint8_t quantize);
+
+    // Make `session` the current sequence for Infer, Generate and snapshots, creating it if new. A higher
+    // priority value preempts lower ones; fails if every other resident session has a higher priority. Not
+    // to be called while a generation is running.
+    __export void llaisysQwen2ModelSelectSession(struct LlaisysQwen2Model * model, uint64_t session, int priority);
+
+    // Free a session's KV cache and spill; releasing the current session only resets it.
+    __export void llaisysQwen2ModelReleaseSession(struct LlaisysQwen2Model * model, uint64_t session);
+
+    __export void llaisysQwen2ModelSessionStats(struct LlaisysQwen2Model * model, struct LlaisysQwen2SessionStats * stats);
+
+    // Replay single-token decode steps from the ops captured on the first one, skipping per-op validation,
+    // view construction and dispatch; only the token and position inputs change between replays. On by
+    // default, and not used in streaming or heavy-hitter mode.
+    __export void llaisysQwen2ModelSetGraph(struct LlaisysQwen2Model * model, uint8_t enable);
+
+    // Share KV of common prompt prefixes across sequences. A capacity of 0 tokens disables the cache.
+    __export void llaisysQwen2ModelSetPrefixCache(struct LlaisysQwen2Model * model, size_t capacity_tokens);
+
+    __export void llaisysQwen2ModelPrefixCacheStats(struct LlaisysQwen2Model * model, struct LlaisysQwen2PrefixCacheStats * stats);
 }
 #endif // LLAISYS_MODELS_QWEN2_H
@@ -6,13 +6,27 @@
 __C {
     __export void llaisysAdd(llaisysTensor_t c, llaisysTensor_t a, llaisysTensor_t b);
     __export void llaisysArgmax(llaisysTensor_t max_idx, llaisysTensor_t max_val, llaisysTensor_t vals);
+    __export void llaisysCast(llaisysTensor_t out, llaisysTensor_t in);
     __export void llaisysEmbedding(llaisysTensor_t out, llaisysTensor_t index, llaisysTensor_t weight);
     __export void llaisysLinear(llaisysTensor_t out, llaisysTensor_t in, llaisysTensor_t weight, llaisysTensor_t bias);
+    // Autotune the GEMM blocking of Linear for `ntoken` input rows and this weight; see LLAISYS_GEMM_CACHE.
+    __export void llaisysTuneLinear(llaisysTensor_t weight, size_t ntoken);
+    __export void llaisysMul(llaisysTensor_t c, llaisysTensor_t a, llaisysTensor_t b);
     __export void llaisysRearrange(llaisysTensor_t out, llaisysTensor_t in);
     __export void llaisysRmsNorm(llaisysTensor_t out, llaisysTensor_t in, llaisysTensor_t weight, float eps);
     __export void llaisysROPE(llaisysTensor_t out, llaisysTensor_t in, llaisysTensor_t pos_ids, float theta);
+    __export void llaisysScale(llaisysTensor_t out, llaisysTensor_t in, float scale);
     __export void llaisysSelfAttention(llaisysTensor_t attn_val, llaisysTensor_t q, llaisysTensor_t k, llaisysTensor_t v, float scale);
     __export void llaisysSwiGLU(llaisysTensor_t out, llaisysTensor_t gate, llaisysTensor_t up);
+
+    // Lazy fusion of elementwise ops on the calling thread. Outputs of recorded ops are only valid after a flush,
+    // which also happens on any other op and when fusion is disabled.
+    __export void llaisysEnableFusion(uint8_t enable);
+    __export void llaisysFlushFusion();
+
+    // Runs the kernel called `name` for `op` (e.g. "linear") whenever it accepts the call, instead of the
+    // highest-priority one. NULL or "" restores the priority order.
+    __export void llaisysPreferKernel(const char *op, const char *name);
 }
 
 #endif
@@ -21,6 +21,15 @@ __C {
     // Memory copy
     typedef void (*memcpy_sync_api)(void *, const void *, size_t, llaisysMemcpyKind_t);
     typedef void (*memcpy_async_api)(void *, const void *, size_t, llaisysMemcpyKind_t, llaisysStream_t);
+    // Host work, run in stream order
+    typedef void (*host_func_t)(void *);
+    typedef void (*launch_host_func_api)(llaisysStream_t, host_func_t, void *);
+    // Event
+    typedef llaisysEvent_t (*create_event_api)();
+    typedef void (*destroy_event_api)(llaisysEvent_t);
+    typedef void (*record_event_api)(llaisysEvent_t, llaisysStream_t);
+    typedef void (*stream_wait_event_api)(llaisysStream_t, llaisysEvent_t);
+    typedef void (*event_synchronize_api)(llaisysEvent_t);
 
     struct LlaisysRuntimeAPI {
         get_device_count_api get_device_count;
@@ -35,6 +44,12 @@ __C {
         free_host_api free_host;
         memcpy_sync_api memcpy_sync;
         memcpy_async_api memcpy_async;
+        launch_host_func_api launch_host_func;
+        create_event_api create_event;
+        destroy_event_api destroy_event;
+        record_event_api record_event;
+        stream_wait_event_api stream_wait_event;
+        event_synchronize_api event_synchronize;
     };
 
     // Llaisys API for getting the runtime APIs
@@ -42,6 +57,27 @@ __C {
 
     // Llaisys API for switching device context
     __export void llaisysSetContextRuntime(llaisysDeviceType_t, int);
+
+    // Backing of large CPU allocations. Huge pages cut TLB misses when streaming weights; explicit huge pages
+    // (MAP_HUGETLB) need a reserved pool, transparent ones (THP) are requested per mapping with madvise.
+    typedef enum {
+        LLAISYS_HUGE_PAGES_OFF = 0,
+        LLAISYS_HUGE_PAGES_THP = 1,
+        LLAISYS_HUGE_PAGES_HUGETLB = 2,
+    } llaisysHugePages_t;
+
+    typedef struct {
+        // Bytes currently mapped with each kind of huge page.
+        size_t hugetlb_bytes;
+        size_t thp_bytes;
+        // Large allocations that fell back, from explicit huge pages to THP, or from a mapping to the heap.
+        size_t hugetlb_fallbacks;
+        size_t mmap_fallbacks;
+    } LlaisysCpuMemoryStats;
+
+    // Applies to allocations made afterwards; the default comes from LLAISYS_HUGEPAGES ("thp" or "hugetlb").
+    __export void llaisysSetCpuHugePages(llaisysHugePages_t mode);
+    __export void llaisysGetCpuMemoryStats(LlaisysCpuMemoryStats *stats);
 }
 
 #endif // LLAISYS_RUNTIME_H
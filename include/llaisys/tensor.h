@@ -63,6 +63,22 @@ __C {
         size_t dim,
         size_t start,
         size_t end);
+
+    // Shares memory with `tensor` when it is already contiguous.
+    __export llaisysTensor_t tensorContiguous(
+        llaisysTensor_t tensor);
+
+    // Shares memory with `tensor` whenever its strides allow, otherwise copies.
+    __export llaisysTensor_t tensorReshape(
+        llaisysTensor_t tensor,
+        size_t * shape,
+        size_t ndim);
+
+    // A device_id of -1 keeps the device id for the same device type, and means 0 otherwise.
+    __export llaisysTensor_t tensorTo(
+        llaisysTensor_t tensor,
+        llaisysDeviceType_t device_type,
+        int device_id);
 }
 
 #endif // LLAISYS_TENSOR_H
@@ -1,7 +1,8 @@
-from .runtime import RuntimeAPI
+from .runtime import RuntimeAPI, set_cpu_huge_pages, cpu_memory_stats
 from .libllaisys import DeviceType
 from .libllaisys import DataType
 from .libllaisys import MemcpyKind
+from .libllaisys import HugePages
 from .libllaisys import llaisysStream_t as Stream
 from .tensor import Tensor
 from .ops import Ops
@@ -13,6 +14,9 @@ __all__ = [
     "DeviceType",
     "DataType",
     "MemcpyKind",
+    "HugePages",
+    "set_cpu_huge_pages",
+    "cpu_memory_stats",
     "Stream",
     "Tensor",
     "Ops",
@@ -4,14 +4,16 @@ import ctypes
 from pathlib import Path
 
 from .runtime import load_runtime
-from .runtime import LlaisysRuntimeAPI
+from .runtime import LlaisysRuntimeAPI, LlaisysCpuMemoryStats
 from .llaisys_types import llaisysDeviceType_t, DeviceType
 from .llaisys_types import llaisysDataType_t, DataType
 from .llaisys_types import llaisysMemcpyKind_t, MemcpyKind
-from .llaisys_types import llaisysStream_t
+from .llaisys_types import llaisysHugePages_t, HugePages
+from .llaisys_types import llaisysStream_t, llaisysEvent_t
 from .tensor import llaisysTensor_t
 from .tensor import load_tensor
 from .ops import load_ops
+from .models import load_qwen2
 
 
 def load_shared_library():
@@ -38,11 +40,13 @@ LIB_LLAISYS = load_shared_library()
 load_runtime(LIB_LLAISYS)
 load_tensor(LIB_LLAISYS)
 load_ops(LIB_LLAISYS)
+load_qwen2(LIB_LLAISYS)
 
 
 __all__ = [
     "LIB_LLAISYS",
     "LlaisysRuntimeAPI",
+    "LlaisysCpuMemoryStats",
     "llaisysStream_t",
     "llaisysTensor_t",
     "llaisysDataType_t",
@@ -51,5 +55,8 @@ __all__ = [
     "DeviceType",
     "llaisysMemcpyKind_t",
     "MemcpyKind",
+    "llaisysHugePages_t",
+    "HugePages",
     "llaisysStream_t",
+    "llaisysEvent_t",
 ]
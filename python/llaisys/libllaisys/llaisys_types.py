@@ -49,9 +49,22 @@ class MemcpyKind(IntEnum):
 
 llaisysMemcpyKind_t = ctypes.c_int
 
+
+# Huge page backing of large CPU allocations
+class HugePages(IntEnum):
+    OFF = 0
+    THP = 1
+    HUGETLB = 2
+
+
+llaisysHugePages_t = ctypes.c_int
+
 # Stream type (opaque pointer)
 llaisysStream_t = ctypes.c_void_p
 
+# Event type (opaque pointer)
+llaisysEvent_t = ctypes.c_void_p
+
 __all__ = [
     "llaisysDeviceType_t",
     "DeviceType",
@@ -59,5 +72,8 @@ __all__ = [
     "DataType",
     "llaisysMemcpyKind_t",
     "MemcpyKind",
+    "llaisysHugePages_t",
+    "HugePages",
     "llaisysStream_t",
+    "llaisysEvent_t",
 ]
@@ -0,0 +1,18 @@
+from .qwen2 import load_qwen2
+from .qwen2 import LlaisysQwen2Meta, LlaisysQwen2Weights, LlaisysQwen2PrefixCacheStats
+from .qwen2 import LlaisysQwen2GenerateParams, LlaisysQwen2SpeculativeStats
+from .qwen2 import LlaisysQwen2KVEvictionStats, LlaisysQwen2SessionStats
+from .qwen2 import llaisysQwen2Model_t, LlaisysQwen2TokenCallback
+
+__all__ = [
+    "load_qwen2",
+    "LlaisysQwen2Meta",
+    "LlaisysQwen2Weights",
+    "LlaisysQwen2PrefixCacheStats",
+    "LlaisysQwen2GenerateParams",
+    "LlaisysQwen2SpeculativeStats",
+    "LlaisysQwen2KVEvictionStats",
+    "LlaisysQwen2SessionStats",
+    "llaisysQwen2Model_t",
+    "LlaisysQwen2TokenCallback",
+]
@@ -0,0 +1,223 @@
+from ctypes import (
+    CFUNCTYPE,
+    POINTER,
+    Structure,
+    c_float,
+    c_int,
+    c_int64,
+    c_size_t,
+    c_uint64,
+    c_uint8,
+    c_void_p,
+    c_char_p,
+)
+from ..llaisys_types import llaisysDataType_t, llaisysDeviceType_t
+from ..tensor import llaisysTensor_t
+
+
+class LlaisysQwen2Meta(Structure):
+    _fields_ = [
+        ("dtype", llaisysDataType_t),
+        ("nlayer", c_size_t),
+        ("hs", c_size_t),
+        ("nh", c_size_t),
+        ("nkvh", c_size_t),
+        ("dh", c_size_t),
+        ("di", c_size_t),
+        ("maxseq", c_size_t),
+        ("voc", c_size_t),
+        ("epsilon", c_float),
+        ("theta", c_float),
+        ("end_token", c_int64),
+    ]
+
+
+class LlaisysQwen2Weights(Structure):
+    _fields_ = [
+        ("in_embed", llaisysTensor_t),
+        ("out_embed", llaisysTensor_t),
+        ("out_norm_w", llaisysTensor_t),
+        ("attn_norm_w", POINTER(llaisysTensor_t)),
+        ("attn_q_w", POINTER(llaisysTensor_t)),
+        ("attn_q_b", POINTER(llaisysTensor_t)),
+        ("attn_k_w", POINTER(llaisysTensor_t)),
+        ("attn_k_b", POINTER(llaisysTensor_t)),
+        ("attn_v_w", POINTER(llaisysTensor_t)),
+        ("attn_v_b", POINTER(llaisysTensor_t)),
+        ("attn_o_w", POINTER(llaisysTensor_t)),
+        ("mlp_norm_w", POINTER(llaisysTensor_t)),
+        ("mlp_gate_w", POINTER(llaisysTensor_t)),
+        ("mlp_up_w", POINTER(llaisysTensor_t)),
+        ("mlp_down_w", POINTER(llaisysTensor_t)),
+    ]
+
+
+class LlaisysQwen2PrefixCacheStats(Structure):
+    _fields_ = [
+        ("hits", c_uint64),
+        ("misses", c_uint64),
+        ("hit_tokens", c_uint64),
+        ("miss_tokens", c_uint64),
+        ("cached_tokens", c_uint64),
+        ("evicted_tokens", c_uint64),
+    ]
+
+
+class LlaisysQwen2GenerateParams(Structure):
+    _fields_ = [
+        ("max_new_tokens", c_size_t),
+        ("temperature", c_float),
+        ("top_k", c_size_t),
+        ("top_p", c_float),
+        ("seed", c_uint64),
+        ("ngram", c_size_t),
+        ("num_draft", c_size_t),
+    ]
+
+
+class LlaisysQwen2SpeculativeStats(Structure):
+    _fields_ = [
+        ("decode_steps", c_uint64),
+        ("decode_tokens", c_uint64),
+        ("drafted_tokens", c_uint64),
+        ("accepted_tokens", c_uint64),
+    ]
+
+
+class LlaisysQwen2KVEvictionStats(Structure):
+    _fields_ = [
+        ("evictions", c_uint64),
+        ("evicted_entries", c_uint64),
+        ("cached_tokens", c_uint64),
+    ]
+
+
+class LlaisysQwen2SessionStats(Structure):
+    _fields_ = [
+        ("preemptions", c_uint64),
+        ("swap_outs", c_uint64),
+        ("swap_ins", c_uint64),
+        ("recomputes", c_uint64),
+        ("swapped_bytes", c_uint64),
+        ("recomputed_tokens", c_uint64),
+        ("resident_sessions", c_uint64),
+        ("swapped_sessions", c_uint64),
+    ]
+
+
+# Handle type
+llaisysQwen2Model_t = c_void_p
+
+LlaisysQwen2TokenCallback = CFUNCTYPE(None, c_int64, c_void_p)
+
+
+def load_qwen2(lib):
+    lib.llaisysQwen2ModelCreate.argtypes = [
+        POINTER(LlaisysQwen2Meta),  # meta
+        llaisysDeviceType_t,  # device
+        POINTER(c_int),  # device_ids
+        c_int,  # ndevice
+    ]
+    lib.llaisysQwen2ModelCreate.restype = llaisysQwen2Model_t
+
+    lib.llaisysQwen2ModelDestroy.argtypes = [llaisysQwen2Model_t]
+    lib.llaisysQwen2ModelDestroy.restype = None
+
+    lib.llaisysQwen2ModelWeights.argtypes = [llaisysQwen2Model_t]
+    lib.llaisysQwen2ModelWeights.restype = POINTER(LlaisysQwen2Weights)
+
+    lib.llaisysQwen2ModelInfer.argtypes = [llaisysQwen2Model_t, POINTER(c_int64), c_size_t]
+    lib.llaisysQwen2ModelInfer.restype = c_int64
+
+    lib.llaisysQwen2ModelGenerate.argtypes = [
+        llaisysQwen2Model_t,
+        POINTER(c_int64),  # token_ids
+        c_size_t,  # ntoken
+        POINTER(LlaisysQwen2GenerateParams),
+        LlaisysQwen2TokenCallback,  # callback
+        c_void_p,  # userdata
+    ]
+    lib.llaisysQwen2ModelGenerate.restype = None
+
+    lib.llaisysQwen2ModelReadTokens.argtypes = [
+        llaisysQwen2Model_t,
+        POINTER(c_int64),  # out_tokens
+        c_size_t,  # max_tokens
+    ]
+    lib.llaisysQwen2ModelReadTokens.restype = c_size_t
+
+    lib.llaisysQwen2ModelCancel.argtypes = [llaisysQwen2Model_t]
+    lib.llaisysQwen2ModelCancel.restype = None
+
+    lib.llaisysQwen2ModelWait.argtypes = [llaisysQwen2Model_t]
+    lib.llaisysQwen2ModelWait.restype = c_size_t
+
+    lib.llaisysQwen2ModelSetDraft.argtypes = [llaisysQwen2Model_t, llaisysQwen2Model_t]
+    lib.llaisysQwen2ModelSetDraft.restype = None
+
+    lib.llaisysQwen2ModelSpeculativeStats.argtypes = [
+        llaisysQwen2Model_t,
+        POINTER(LlaisysQwen2SpeculativeStats),
+    ]
+    lib.llaisysQwen2ModelSpeculativeStats.restype = None
+
+    lib.llaisysQwen2ModelSaveSnapshot.argtypes = [llaisysQwen2Model_t, c_char_p, c_uint8]
+    lib.llaisysQwen2ModelSaveSnapshot.restype = None
+
+    lib.llaisysQwen2ModelLoadSnapshot.argtypes = [llaisysQwen2Model_t, c_char_p]
+    lib.llaisysQwen2ModelLoadSnapshot.restype = c_size_t
+
+    lib.llaisysQwen2ModelTune.argtypes = [llaisysQwen2Model_t, POINTER(c_size_t), c_size_t]
+    lib.llaisysQwen2ModelTune.restype = None
+
+    lib.llaisysQwen2ModelReset.argtypes = [llaisysQwen2Model_t]
+    lib.llaisysQwen2ModelReset.restype = None
+
+    lib.llaisysQwen2ModelSetStreaming.argtypes = [llaisysQwen2Model_t, c_uint8, c_size_t]
+    lib.llaisysQwen2ModelSetStreaming.restype = None
+
+    lib.llaisysQwen2ModelSetHeavyHitter.argtypes = [
+        llaisysQwen2Model_t,
+        c_uint8,
+        c_size_t,
+        c_size_t,
+    ]
+    lib.llaisysQwen2ModelSetHeavyHitter.restype = None
+
+    lib.llaisysQwen2ModelKVEvictionStats.argtypes = [
+        llaisysQwen2Model_t,
+        POINTER(LlaisysQwen2KVEvictionStats),
+    ]
+    lib.llaisysQwen2ModelKVEvictionStats.restype = None
+
+    lib.llaisysQwen2ModelSetSessions.argtypes = [
+        llaisysQwen2Model_t,
+        c_size_t,
+        c_char_p,
+        c_uint8,
+    ]
+    lib.llaisysQwen2ModelSetSessions.restype = None
+
+    lib.llaisysQwen2ModelSelectSession.argtypes = [llaisysQwen2Model_t, c_uint64, c_int]
+    lib.llaisysQwen2ModelSelectSession.restype = None
+
+    lib.llaisysQwen2ModelReleaseSession.argtypes = [llaisysQwen2Model_t, c_uint64]
+    lib.llaisysQwen2ModelReleaseSession.restype = None
+
+    lib.llaisysQwen2ModelSessionStats.argtypes = [
+        llaisysQwen2Model_t,
+        POINTER(LlaisysQwen2SessionStats),
+    ]
+    lib.llaisysQwen2ModelSessionStats.restype = None
+
+    lib.llaisysQwen2ModelSetGraph.argtypes = [llaisysQwen2Model_t, c_uint8]
+    lib.llaisysQwen2ModelSetGraph.restype = None
+
+    lib.llaisysQwen2ModelSetPrefixCache.argtypes = [llaisysQwen2Model_t, c_size_t]
+    lib.llaisysQwen2ModelSetPrefixCache.restype = None
+
+    lib.llaisysQwen2ModelPrefixCacheStats.argtypes = [
+        llaisysQwen2Model_t,
+        POINTER(LlaisysQwen2PrefixCacheStats),
+    ]
+    lib.llaisysQwen2ModelPrefixCacheStats.restype = None
@@ -1,5 +1,5 @@
 from .tensor import llaisysTensor_t
-from ctypes import c_float
+from ctypes import c_char_p, c_float, c_size_t, c_uint8
 
 def load_ops(lib):
     lib.llaisysAdd.argtypes = [llaisysTensor_t, llaisysTensor_t, llaisysTensor_t]
@@ -8,12 +8,21 @@ def load_ops(lib):
     lib.llaisysArgmax.argtypes = [llaisysTensor_t, llaisysTensor_t, llaisysTensor_t]
     lib.llaisysArgmax.restype = None
 
+    lib.llaisysCast.argtypes = [llaisysTensor_t, llaisysTensor_t]
+    lib.llaisysCast.restype = None
+
     lib.llaisysEmbedding.argtypes = [llaisysTensor_t, llaisysTensor_t, llaisysTensor_t]
     lib.llaisysEmbedding.restype = None
 
     lib.llaisysLinear.argtypes = [llaisysTensor_t, llaisysTensor_t, llaisysTensor_t, llaisysTensor_t]
     lib.llaisysLinear.restype = None
 
+    lib.llaisysTuneLinear.argtypes = [llaisysTensor_t, c_size_t]
+    lib.llaisysTuneLinear.restype = None
+
+    lib.llaisysMul.argtypes = [llaisysTensor_t, llaisysTensor_t, llaisysTensor_t]
+    lib.llaisysMul.restype = None
+
     lib.llaisysRearrange.argtypes = [llaisysTensor_t, llaisysTensor_t]
     lib.llaisysRearrange.restype = None
 
@@ -23,6 +32,9 @@ def load_ops(lib):
     lib.llaisysROPE.argtypes = [llaisysTensor_t, llaisysTensor_t, llaisysTensor_t, c_float]
     lib.llaisysROPE.restype = None
 
+    lib.llaisysScale.argtypes = [llaisysTensor_t, llaisysTensor_t, c_float]
+    lib.llaisysScale.restype = None
+
     lib.llaisysSelfAttention.argtypes = [
         llaisysTensor_t,  # attn_val
         llaisysTensor_t,  # q
@@ -34,3 +46,12 @@ def load_ops(lib):
 
     lib.llaisysSwiGLU.argtypes = [llaisysTensor_t, llaisysTensor_t, llaisysTensor_t]
     lib.llaisysSwiGLU.restype = None
+
+    lib.llaisysEnableFusion.argtypes = [c_uint8]
+    lib.llaisysEnableFusion.restype = None
+
+    lib.llaisysFlushFusion.argtypes = []
+    lib.llaisysFlushFusion.restype = None
+
+    lib.llaisysPreferKernel.argtypes = [c_char_p, c_char_p]
+    lib.llaisysPreferKernel.restype = None
@@ -19,6 +19,15 @@ free_host_api = CFUNCTYPE(None, c_void_p)
 memcpy_sync_api = CFUNCTYPE(None, c_void_p, c_void_p, c_size_t, llaisysMemcpyKind_t)
 memcpy_async_api = CFUNCTYPE(None, c_void_p, c_void_p, c_size_t, llaisysMemcpyKind_t, llaisysStream_t)
 
+host_func_t = CFUNCTYPE(None, c_void_p)
+launch_host_func_api = CFUNCTYPE(None, llaisysStream_t, host_func_t, c_void_p)
+
+create_event_api = CFUNCTYPE(llaisysEvent_t)
+destroy_event_api = CFUNCTYPE(None, llaisysEvent_t)
+record_event_api = CFUNCTYPE(None, llaisysEvent_t, llaisysStream_t)
+stream_wait_event_api = CFUNCTYPE(None, llaisysStream_t, llaisysEvent_t)
+event_synchronize_api = CFUNCTYPE(None, llaisysEvent_t)
+
 
 # Define the struct matching LlaisysRuntimeAPI
 class LlaisysRuntimeAPI(Structure):
@@ -35,6 +44,21 @@ class LlaisysRuntimeAPI(Structure):
         ("free_host", free_host_api),
         ("memcpy_sync", memcpy_sync_api),
         ("memcpy_async", memcpy_async_api),
+        ("launch_host_func", launch_host_func_api),
+        ("create_event", create_event_api),
+        ("destroy_event", destroy_event_api),
+        ("record_event", record_event_api),
+        ("stream_wait_event", stream_wait_event_api),
+        ("event_synchronize", event_synchronize_api),
+    ]
+
+
+class LlaisysCpuMemoryStats(Structure):
+    _fields_ = [
+        ("hugetlb_bytes", c_size_t),
+        ("thp_bytes", c_size_t),
+        ("hugetlb_fallbacks", c_size_t),
+        ("mmap_fallbacks", c_size_t),
     ]
 
 
@@ -46,3 +70,9 @@ def load_runtime(lib):
 
     lib.llaisysSetContextRuntime.argtypes = [llaisysDeviceType_t, c_int]
     lib.llaisysSetContextRuntime.restype = None
+
+    lib.llaisysSetCpuHugePages.argtypes = [llaisysHugePages_t]
+    lib.llaisysSetCpuHugePages.restype = None
+
+    lib.llaisysGetCpuMemoryStats.argtypes = [ctypes.POINTER(LlaisysCpuMemoryStats)]
+    lib.llaisysGetCpuMemoryStats.restype = None
@@ -1,33 +1,285 @@
 from typing import Sequence
 from ..libllaisys import LIB_LLAISYS
 from ..libllaisys import DeviceType
+from ..libllaisys import DataType
+from ..libllaisys.models import LlaisysQwen2Meta, LlaisysQwen2PrefixCacheStats
+from ..libllaisys.models import LlaisysQwen2GenerateParams, LlaisysQwen2SpeculativeStats
+from ..libllaisys.models import LlaisysQwen2TokenCallback, LlaisysQwen2KVEvictionStats
+from ..libllaisys.models import LlaisysQwen2SessionStats
 
+from ctypes import byref, c_int, c_int64, c_size_t, c_uint8, c_uint64
 from pathlib import Path
+import json
 import safetensors
 
 
-class Qwen2:
+_DTYPES = {
+    "float32": DataType.F32,
+    "float16": DataType.F16,
+    "bfloat16": DataType.BF16,
+}
+
 
-    def __init__(self, model_path, device: DeviceType = DeviceType.CPU):
-        # TODO: Implement model constructor
+class Qwen2:
 
+    def __init__(
+        self,
+        model_path,
+        device: DeviceType = DeviceType.CPU,
+        max_seq_len: int = 8192,
+        prefix_cache_tokens: int = 0,
+    ):
         model_path = Path(model_path)
+        with open(model_path / "config.json") as f:
+            config = json.load(f)
+
+        end_token = config["eos_token_id"]
+        if isinstance(end_token, list):
+            end_token = end_token[0]
+        nh = config["num_attention_heads"]
+        meta = LlaisysQwen2Meta(
+            dtype=_DTYPES[config.get("torch_dtype", "bfloat16")],
+            nlayer=config["num_hidden_layers"],
+            hs=config["hidden_size"],
+            nh=nh,
+            nkvh=config["num_key_value_heads"],
+            dh=config["hidden_size"] // nh,
+            di=config["intermediate_size"],
+            maxseq=min(config["max_position_embeddings"], max_seq_len),
+            voc=config["vocab_size"],
+            epsilon=config["rms_norm_eps"],
+            theta=config.get("rope_theta", 10000.0),
+            end_token=end_token,
+        )
+        self._meta = meta
+        self._end_token = end_token
+        self._draft = None
+
+        device_ids = (c_int * 1)(0)
+        self._model = LIB_LLAISYS.llaisysQwen2ModelCreate(
+            byref(meta), device, device_ids, 1
+        )
+        weights = LIB_LLAISYS.llaisysQwen2ModelWeights(self._model).contents
+        tie_embeddings = config.get("tie_word_embeddings", False)
 
         for file in sorted(model_path.glob("*.safetensors")):
-            data_ = safetensors.safe_open(file, framework="numpy", device="cpu")
+            data_ = safetensors.safe_open(file, framework="pt", device="cpu")
             for name_ in data_.keys():
-                ## TODO: load the model weights
-                pass
+                handles = self._weight_handles(weights, name_, tie_embeddings)
+                if not handles:
+                    continue
+                tensor_ = data_.get_tensor(name_).contiguous()
+                for handle in handles:
+                    LIB_LLAISYS.tensorLoad(handle, tensor_.data_ptr())
+
+        if prefix_cache_tokens > 0:
+            self.set_prefix_cache(prefix_cache_tokens)
 
-    def generate(
+    @staticmethod
+    def _weight_handles(weights, name: str, tie_embeddings: bool):
+        if name == "model.embed_tokens.weight":
+            if tie_embeddings:
+                return [weights.in_embed, weights.out_embed]
+            return [weights.in_embed]
+        if name == "lm_head.weight":
+            return [weights.out_embed]
+        if name == "model.norm.weight":
+            return [weights.out_norm_w]
+
+        prefix = "model.layers."
+        if not name.startswith(prefix):
+            return []
+        layer, _, key = name[len(prefix) :].partition(".")
+        layer = int(layer)
+        fields = {
+            "input_layernorm.weight": weights.attn_norm_w,
+            "self_attn.q_proj.weight": weights.attn_q_w,
+            "self_attn.q_proj.bias": weights.attn_q_b,
+            "self_attn.k_proj.weight": weights.attn_k_w,
+            "self_attn.k_proj.bias": weights.attn_k_b,
+            "self_attn.v_proj.weight": weights.attn_v_w,
+            "self_attn.v_proj.bias": weights.attn_v_b,
+            "self_attn.o_proj.weight": weights.attn_o_w,
+            "post_attention_layernorm.weight": weights.mlp_norm_w,
+            "mlp.gate_proj.weight": weights.mlp_gate_w,
+            "mlp.up_proj.weight": weights.mlp_up_w,
+            "mlp.down_proj.weight": weights.mlp_down_w,
+        }
+        if key not in fields:
+            return []
+        return [fields[key][layer]]
+
+    def __del__(self):
+        if hasattr(self, "_model") and self._model is not None:
+            LIB_LLAISYS.llaisysQwen2ModelDestroy(self._model)
+            self._draft = None
+            self._model = None
+
+    def set_prefix_cache(self, capacity_tokens: int):
+        LIB_LLAISYS.llaisysQwen2ModelSetPrefixCache(
+            self._model, c_size_t(capacity_tokens)
+        )
+
+    def set_graph(self, enable: bool = True):
+        """Replay decode steps from the ops captured on the first one (the
+        default), or run every step op by op."""
+        LIB_LLAISYS.llaisysQwen2ModelSetGraph(self._model, c_uint8(enable))
+
+    def set_streaming(self, enable: bool = True, sink_tokens: int = 4):
+        """Keep `sink_tokens` leading tokens plus a sliding window of recent
+        ones, so generation can run past max_seq_len."""
+        LIB_LLAISYS.llaisysQwen2ModelSetStreaming(
+            self._model, c_uint8(enable), c_size_t(sink_tokens)
+        )
+
+    def set_heavy_hitter(
+        self, enable: bool = True, budget_tokens: int = 256, recent_tokens: int = None
+    ):
+        """Keep at most `budget_tokens` KV rows per layer and head, evicting
+        the least attended tokens but never the `recent_tokens` newest (half
+        the budget by default)."""
+        if recent_tokens is None:
+            recent_tokens = budget_tokens // 2
+        LIB_LLAISYS.llaisysQwen2ModelSetHeavyHitter(
+            self._model, c_uint8(enable), c_size_t(budget_tokens), c_size_t(recent_tokens)
+        )
+
+    def kv_eviction_stats(self):
+        stats = LlaisysQwen2KVEvictionStats()
+        LIB_LLAISYS.llaisysQwen2ModelKVEvictionStats(self._model, byref(stats))
+        return {name: getattr(stats, name) for name, _ in stats._fields_}
+
+    def set_sessions(self, max_resident: int, spill_dir=None, quantize: bool = True):
+        """Let sequences take turns on the model, with at most `max_resident`
+        holding a KV cache. Preempted sessions spill to `spill_dir` (host
+        memory if None) or are recomputed when selected again."""
+        LIB_LLAISYS.llaisysQwen2ModelSetSessions(
+            self._model,
+            c_size_t(max_resident),
+            None if spill_dir is None else str(spill_dir).encode("utf-8"),
+            c_uint8(quantize),
+        )
+
+    def select_session(self, session: int, priority: int = 0):
+        LIB_LLAISYS.llaisysQwen2ModelSelectSession(
+            self._model, c_uint64(session), c_int(priority)
+        )
+
+    def release_session(self, session: int):
+        LIB_LLAISYS.llaisysQwen2ModelReleaseSession(self._model, c_uint64(session))
+
+    def session_stats(self):
+        stats = LlaisysQwen2SessionStats()
+        LIB_LLAISYS.llaisysQwen2ModelSessionStats(self._model, byref(stats))
+        return {name: getattr(stats, name) for name, _ in stats._fields_}
+
+    def prefix_cache_stats(self):
+        stats = LlaisysQwen2PrefixCacheStats()
+        LIB_LLAISYS.llaisysQwen2ModelPrefixCacheStats(self._model, byref(stats))
+        return {name: getattr(stats, name) for name, _ in stats._fields_}
+
+    def tune(self, ntokens: Sequence[int] = (1,)):
+        """Autotune the GEMMs for forward passes of each of `ntokens` tokens
+        (1 is decode). Results persist in the tuning cache file and are
+        picked up by later runs on the same CPU."""
+        _ntokens = (c_size_t * len(ntokens))(*ntokens)
+        LIB_LLAISYS.llaisysQwen2ModelTune(
+            self._model, _ntokens, c_size_t(len(ntokens))
+        )
+
+    def save_snapshot(self, path, quantize: bool = False):
+        """Save the current sequence (e.g. an idle chat session) to `path`."""
+        LIB_LLAISYS.llaisysQwen2ModelSaveSnapshot(
+            self._model, str(path).encode("utf-8"), c_uint8(quantize)
+        )
+
+    def load_snapshot(self, path) -> int:
+        """Restore a sequence saved by `save_snapshot`; the next `generate`
+        whose prompt extends it only prefills the new tokens."""
+        return int(
+            LIB_LLAISYS.llaisysQwen2ModelLoadSnapshot(
+                self._model, str(path).encode("utf-8")
+            )
+        )
+
+    def set_draft(self, draft: "Qwen2" = None):
+        """Propose tokens with a smaller model sharing this model's vocabulary,
+        or stop doing so when `draft` is None."""
+        LIB_LLAISYS.llaisysQwen2ModelSetDraft(
+            self._model, draft._model if draft is not None else None
+        )
+        self._draft = draft
+
+    def speculative_stats(self):
+        stats = LlaisysQwen2SpeculativeStats()
+        LIB_LLAISYS.llaisysQwen2ModelSpeculativeStats(self._model, byref(stats))
+        result = {name: getattr(stats, name) for name, _ in stats._fields_}
+        result["acceptance_rate"] = (
+            stats.accepted_tokens / stats.drafted_tokens if stats.drafted_tokens else 0.0
+        )
+        result["tokens_per_step"] = (
+            stats.decode_tokens / stats.decode_steps if stats.decode_steps else 0.0
+        )
+        return result
+
+    def _infer(self, token_ids: Sequence[int]) -> int:
+        _ids = (c_int64 * len(token_ids))(*token_ids)
+        return int(
+            LIB_LLAISYS.llaisysQwen2ModelInfer(
+                self._model, _ids, c_size_t(len(token_ids))
+            )
+        )
+
+    def stream(
         self,
         inputs: Sequence[int],
         max_new_tokens: int = None,
         top_k: int = 1,
         top_p: float = 0.8,
         temperature: float = 0.8,
+        seed: int = 0,
+        ngram: int = 0,
+        num_draft: int = 4,
     ):
+        """Yield new tokens as the model's generation thread produces them.
+        Closing the generator early cancels generation.
+
+        Drafts of up to `num_draft` tokens from the draft model (see
+        `set_draft`), or from prompt lookup when ngram > 0, are verified per
+        forward pass."""
+        if max_new_tokens is None:
+            max_new_tokens = max(self._meta.maxseq - len(inputs), 1)
 
-        # TODO: Implement generate function
+        params = LlaisysQwen2GenerateParams(
+            max_new_tokens=max_new_tokens,
+            temperature=temperature,
+            top_k=top_k,
+            top_p=top_p,
+            seed=seed,
+            ngram=ngram,
+            num_draft=num_draft,
+        )
+        _ids = (c_int64 * len(inputs))(*inputs)
+        LIB_LLAISYS.llaisysQwen2ModelGenerate(
+            self._model,
+            _ids,
+            c_size_t(len(inputs)),
+            byref(params),
+            LlaisysQwen2TokenCallback(),  # tokens are drained from the ring below
+            None,
+        )
+        _buf = (c_int64 * 64)()
+        try:
+            while True:
+                n = LIB_LLAISYS.llaisysQwen2ModelReadTokens(
+                    self._model, _buf, c_size_t(len(_buf))
+                )
+                if n == 0:
+                    break
+                yield from _buf[:n]
+        finally:
+            LIB_LLAISYS.llaisysQwen2ModelCancel(self._model)
+            LIB_LLAISYS.llaisysQwen2ModelWait(self._model)
 
-        return []
+    def generate(self, inputs: Sequence[int], max_new_tokens: int = None, **kwargs):
+        return list(inputs) + list(self.stream(inputs, max_new_tokens, **kwargs))
@@ -1,6 +1,7 @@
 from .libllaisys import LIB_LLAISYS
 from .tensor import Tensor
 from ctypes import c_float, c_int
+from contextlib import contextmanager
 
 
 class Ops:
@@ -12,6 +13,10 @@ class Ops:
     def argmax(max_idx: Tensor, max_val: Tensor, vals: Tensor):
         LIB_LLAISYS.llaisysArgmax(max_idx.lib_tensor(), max_val.lib_tensor(), vals.lib_tensor())
 
+    @staticmethod
+    def cast(out: Tensor, inp: Tensor):
+        LIB_LLAISYS.llaisysCast(out.lib_tensor(), inp.lib_tensor())
+
     @staticmethod
     def embedding(out: Tensor, index: Tensor, weight: Tensor):
         LIB_LLAISYS.llaisysEmbedding(
@@ -19,11 +24,24 @@ class Ops:
         )
 
     @staticmethod
-    def linear(out: Tensor, inp: Tensor, weight: Tensor, bias: Tensor):
+    def linear(out: Tensor, inp: Tensor, weight: Tensor, bias: Tensor = None):
         LIB_LLAISYS.llaisysLinear(
-            out.lib_tensor(), inp.lib_tensor(), weight.lib_tensor(), bias.lib_tensor()
+            out.lib_tensor(),
+            inp.lib_tensor(),
+            weight.lib_tensor(),
+            bias.lib_tensor() if bias is not None else None,
         )
 
+    @staticmethod
+    def tune_linear(weight: Tensor, ntoken: int = 1):
+        """Autotune linear for `ntoken` input rows and this weight; the result
+        is kept in the GEMM tuning cache file."""
+        LIB_LLAISYS.llaisysTuneLinear(weight.lib_tensor(), ntoken)
+
+    @staticmethod
+    def mul(c: Tensor, a: Tensor, b: Tensor):
+        LIB_LLAISYS.llaisysMul(c.lib_tensor(), a.lib_tensor(), b.lib_tensor())
+
     @staticmethod
     def rearrange(out: Tensor, inp: Tensor):
         LIB_LLAISYS.llaisysRearrange(out.lib_tensor(), inp.lib_tensor())
@@ -40,6 +58,10 @@ class Ops:
             out.lib_tensor(), inp.lib_tensor(), pos_ids.lib_tensor(), c_float(theta)
         )
 
+    @staticmethod
+    def scale(out: Tensor, inp: Tensor, scale: float):
+        LIB_LLAISYS.llaisysScale(out.lib_tensor(), inp.lib_tensor(), c_float(scale))
+
     @staticmethod
     def self_attention(attn_val: Tensor, q: Tensor, k: Tensor, v: Tensor, scale: float):
         LIB_LLAISYS.llaisysSelfAttention(
@@ -53,3 +75,27 @@ class Ops:
     @staticmethod
     def swiglu(out: Tensor, gate: Tensor, up: Tensor):
         LIB_LLAISYS.llaisysSwiGLU(out.lib_tensor(), gate.lib_tensor(), up.lib_tensor())
+
+    @staticmethod
+    @contextmanager
+    def fusion():
+        """Record the elementwise ops run inside the block and run them as one
+        fused loop. Their outputs are only valid after the block, or once any
+        other op runs."""
+        LIB_LLAISYS.llaisysEnableFusion(1)
+        try:
+            yield
+        finally:
+            LIB_LLAISYS.llaisysEnableFusion(0)
+
+    @staticmethod
+    def flush_fusion():
+        LIB_LLAISYS.llaisysFlushFusion()
+
+    @staticmethod
+    def prefer_kernel(op: str, name: str = None):
+        """Run the kernel `name` for `op` whenever it accepts the call; None
+        restores the default choice."""
+        LIB_LLAISYS.llaisysPreferKernel(
+            op.encode(), name.encode() if name is not None else None
+        )
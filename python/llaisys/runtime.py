@@ -1,6 +1,6 @@
 from . import libllaisys
 from .libllaisys import LIB_LLAISYS
-from ctypes import c_void_p
+from ctypes import byref, c_void_p
 
 
 class RuntimeAPI:
@@ -66,3 +66,33 @@ class RuntimeAPI:
         self._api.contents.memcpy_async(
             dst, src, size, libllaisys.llaisysMemcpyKind_t(kind), stream
         )
+
+    def create_event(self) -> libllaisys.llaisysEvent_t:
+        return self._api.contents.create_event()
+
+    def destroy_event(self, event: libllaisys.llaisysEvent_t) -> None:
+        self._api.contents.destroy_event(event)
+
+    def record_event(
+        self, event: libllaisys.llaisysEvent_t, stream: libllaisys.llaisysStream_t
+    ) -> None:
+        self._api.contents.record_event(event, stream)
+
+    def stream_wait_event(
+        self, stream: libllaisys.llaisysStream_t, event: libllaisys.llaisysEvent_t
+    ) -> None:
+        self._api.contents.stream_wait_event(stream, event)
+
+    def event_synchronize(self, event: libllaisys.llaisysEvent_t) -> None:
+        self._api.contents.event_synchronize(event)
+
+
+def set_cpu_huge_pages(mode: libllaisys.HugePages) -> None:
+    """Backs CPU allocations of 2 MiB or more made from now on with huge pages."""
+    LIB_LLAISYS.llaisysSetCpuHugePages(libllaisys.llaisysHugePages_t(mode))
+
+
+def cpu_memory_stats() -> dict:
+    stats = libllaisys.LlaisysCpuMemoryStats()
+    LIB_LLAISYS.llaisysGetCpuMemoryStats(byref(stats))
+    return {name: getattr(stats, name) for name, _ in stats._fields_}
@@ -12,8 +12,9 @@ protected:
 
 public:
     virtual ~MemoryAllocator() = default;
+    // Both may be called from any thread. `size` is the size the memory was allocated with.
     virtual std::byte *allocate(size_t size) = 0;
-    virtual void release(std::byte *memory) = 0;
+    virtual void release(std::byte *memory, size_t size) = 0;
 };
 
 } // namespace llaisys::core
@@ -0,0 +1,197 @@
+#include "caching_allocator.hpp"
+
+#include <algorithm>
+#include <utility>
+
+namespace llaisys::core::allocators {
+namespace {
+// Size classes run from 256 bytes: class 4 * (e - 8) + q holds blocks of 2^e + q * 2^(e - 2) bytes.
+constexpr size_t MIN_CLASS_SHIFT = 8;
+// Larger blocks, e.g. weights, are allocated at their exact size and never cached.
+constexpr size_t MAX_CACHED_SIZE = size_t(64) << 20;
+// Per thread, blocks of at most this size, and at most this many of each class.
+constexpr size_t MAX_THREAD_SIZE = size_t(1) << 20;
+constexpr size_t THREAD_BLOCKS = 4;
+
+constexpr size_t classOf(size_t size) {
+    if (size <= (size_t(1) << MIN_CLASS_SHIFT)) {
+        return 0;
+    }
+    size_t e = 0;
+    while ((size_t(2) << e) < size) {
+        ++e;
+    }
+    // 2^e < size <= 2^(e + 1); q == 4 is class 0 of the next power.
+    size_t quarter = size_t(1) << (e - 2);
+    size_t q = (size - (size_t(1) << e) + quarter - 1) / quarter;
+    return 4 * (e - MIN_CLASS_SHIFT) + q;
+}
+
+constexpr size_t classSize(size_t index) {
+    size_t e = index / 4 + MIN_CLASS_SHIFT;
+    return (size_t(1) << e) + (index % 4) * (size_t(1) << (e - 2));
+}
+
+// Blocks beyond the thread classes are allocated at their exact size, so weights are not padded by up to a quarter,
+// and kept in the largest class that size fills; any request of that class fits them.
+constexpr size_t poolClassOf(size_t size, size_t index) {
+    return classSize(index) > size ? index - 1 : index;
+}
+
+constexpr size_t MAX_CLASS = classOf(MAX_CACHED_SIZE);
+constexpr size_t MAX_THREAD_CLASS = classOf(MAX_THREAD_SIZE);
+
+// Set once the calling thread's cache is destroyed, for storages freed later in its exit.
+thread_local bool t_cache_gone = false;
+} // namespace
+
+// The blocks a thread keeps, per allocator it used; they go back to the shared pools when the thread exits.
+struct ThreadCache {
+    std::vector<std::pair<CachingAllocator *, std::vector<std::vector<std::byte *>>>> bins;
+
+    std::vector<std::vector<std::byte *>> &of(CachingAllocator *allocator) {
+        for (auto &entry : bins) {
+            if (entry.first == allocator) {
+                return entry.second;
+            }
+        }
+        bins.emplace_back(allocator, std::vector<std::vector<std::byte *>>(MAX_THREAD_CLASS + 1));
+        return bins.back().second;
+    }
+
+    ~ThreadCache() {
+        t_cache_gone = true;
+        for (auto &[allocator, classes] : bins) {
+            for (size_t index = 0; index < classes.size(); ++index) {
+                for (std::byte *memory : classes[index]) {
+                    allocator->_give(memory, index);
+                }
+            }
+        }
+    }
+};
+
+namespace {
+ThreadCache *threadCache() {
+    if (t_cache_gone) {
+        return nullptr;
+    }
+    thread_local ThreadCache cache;
+    return &cache;
+}
+} // namespace
+
+CachingAllocator::CachingAllocator(const LlaisysRuntimeAPI *runtime_api, size_t budget)
+    : MemoryAllocator(runtime_api), _free(MAX_CLASS + 1), _cached(0), _budget(budget) {}
+
+CachingAllocator::~CachingAllocator() {
+    trim();
+}
+
+size_t CachingAllocator::_sizeOf(std::byte *memory, size_t index) const {
+    auto it = _sizes.find(memory);
+    return it != _sizes.end() ? it->second : classSize(index);
+}
+
+std::byte *CachingAllocator::_take(size_t index) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto &blocks = _free[index];
+    if (blocks.empty()) {
+        return nullptr;
+    }
+    std::byte *memory = blocks.back();
+    blocks.pop_back();
+    _cached -= _sizeOf(memory, index);
+    return memory;
+}
+
+void CachingAllocator::_give(std::byte *memory, size_t index) {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        auto exact = _sizes.find(memory);
+        size_t size = classSize(index);
+        if (exact != _sizes.end()) {
+            size = exact->second;
+            index = poolClassOf(size, classOf(size));
+        }
+        if (_cached + size <= _budget) {
+            _free[index].push_back(memory);
+            _cached += size;
+            return;
+        }
+        if (exact != _sizes.end()) {
+            _sizes.erase(exact);
+        }
+    }
+    _api->free_device(memory);
+}
+
+std::byte *CachingAllocator::allocate(size_t size) {
+    if (size > MAX_CACHED_SIZE) {
+        return static_cast<std::byte *>(_api->malloc_device(size));
+    }
+    size_t index = classOf(size);
+    ThreadCache *cache = index <= MAX_THREAD_CLASS ? threadCache() : nullptr;
+    if (cache != nullptr) {
+        auto &blocks = cache->of(this)[index];
+        if (!blocks.empty()) {
+            std::byte *memory = blocks.back();
+            blocks.pop_back();
+            return memory;
+        }
+    }
+    if (std::byte *memory = _take(index)) {
+        return memory;
+    }
+    size_t block = index <= MAX_THREAD_CLASS ? classSize(index) : size;
+    auto *memory = static_cast<std::byte *>(_api->malloc_device(block));
+    if (memory == nullptr) {
+        // Cached blocks of other sizes may be what the device is short of.
+        trim();
+        memory = static_cast<std::byte *>(_api->malloc_device(block));
+    }
+    if (memory != nullptr && index > MAX_THREAD_CLASS) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _sizes[memory] = block;
+    }
+    return memory;
+}
+
+void CachingAllocator::release(std::byte *memory, size_t size) {
+    if (memory == nullptr) {
+        return;
+    }
+    if (size > MAX_CACHED_SIZE) {
+        return _api->free_device(memory);
+    }
+    size_t index = classOf(size);
+    ThreadCache *cache = index <= MAX_THREAD_CLASS ? threadCache() : nullptr;
+    if (cache != nullptr) {
+        auto &blocks = cache->of(this)[index];
+        if (blocks.size() < THREAD_BLOCKS) {
+            blocks.push_back(memory);
+            return;
+        }
+    }
+    _give(memory, index);
+}
+
+void CachingAllocator::trim() {
+    std::vector<std::vector<std::byte *>> blocks(_free.size());
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        std::swap(blocks, _free);
+        _cached = 0;
+        for (auto &list : blocks) {
+            for (std::byte *memory : list) {
+                _sizes.erase(memory);
+            }
+        }
+    }
+    for (auto &list : blocks) {
+        for (std::byte *memory : list) {
+            _api->free_device(memory);
+        }
+    }
+}
+} // namespace llaisys::core::allocators
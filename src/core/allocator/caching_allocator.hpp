@@ -0,0 +1,44 @@
+#pragma once
+
+#include "allocator.hpp"
+
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace llaisys::core::allocators {
+// Keeps freed device memory for reuse by any thread. Blocks are grouped in size classes, four per power of two.
+// Each thread keeps a few small blocks of every class to itself, so most allocations in a decode loop take no lock;
+// the rest go through a pool shared under a mutex, which holds at most `budget` bytes and returns anything beyond
+// that to the device. Only small blocks are rounded up to their class, and the largest go straight to the device.
+//
+// Threads hold on to blocks until they exit, so the allocator must outlive every thread that used it.
+class CachingAllocator : public MemoryAllocator {
+private:
+    std::mutex _mutex;
+    // Shared free blocks, by size class.
+    std::vector<std::vector<std::byte *>> _free;
+    // Sizes of the blocks allocated at their exact size, in use or not. A request that reuses one may be smaller,
+    // so the size it is released with says little; the budget and filing go by these.
+    std::unordered_map<std::byte *, size_t> _sizes;
+    size_t _cached;
+    size_t _budget;
+
+    // The bytes behind a block of class `index`. Requires the mutex.
+    size_t _sizeOf(std::byte *memory, size_t index) const;
+    // Takes a block of class `index` from the shared pool, or nullptr.
+    std::byte *_take(size_t index);
+    // Keeps a block of class `index` in the shared pool, or frees it beyond the budget.
+    void _give(std::byte *memory, size_t index);
+
+    friend struct ThreadCache;
+
+public:
+    CachingAllocator(const LlaisysRuntimeAPI *runtime_api, size_t budget);
+    ~CachingAllocator();
+    std::byte *allocate(size_t size) override;
+    void release(std::byte *memory, size_t size) override;
+    // Frees the blocks in the shared pool.
+    void trim();
+};
+} // namespace llaisys::core::allocators
@@ -10,7 +10,7 @@ std::byte *NaiveAllocator::allocate(size_t size) {
     return static_cast<std::byte *>(_api->malloc_device(size));
 }
 
-void NaiveAllocator::release(std::byte *memory) {
+void NaiveAllocator::release(std::byte *memory, size_t) {
     _api->free_device(memory);
 }
 } // namespace llaisys::core::allocators
\ No newline at end of file
@@ -8,6 +8,6 @@ public:
     NaiveAllocator(const LlaisysRuntimeAPI *runtime_api);
     ~NaiveAllocator() = default;
     std::byte *allocate(size_t size) override;
-    void release(std::byte *memory) override;
+    void release(std::byte *memory, size_t size) override;
 };
 } // namespace llaisys::core::allocators
\ No newline at end of file
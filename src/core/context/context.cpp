@@ -1,10 +1,12 @@
 #include "context.hpp"
 #include "../../utils.hpp"
-#include <thread>
+
+#include <mutex>
+#include <vector>
 
 namespace llaisys::core {
 
-Context::Context() {
+Context::Context() : _current_runtime(nullptr) {
     // All device types, put CPU at the end
     std::vector<llaisysDeviceType_t> device_typs;
     for (int i = 1; i < LLAISYS_DEVICE_TYPE_COUNT; i++) {
@@ -12,56 +14,39 @@ Context::Context() {
     }
     device_typs.push_back(LLAISYS_DEVICE_CPU);
 
-    // Create runtimes for each device type.
     // Activate the first available device. If no other device is available, activate CPU runtime.
     for (auto device_type : device_typs) {
-        const LlaisysRuntimeAPI *api_ = llaisysGetRuntimeAPI(device_type);
-        int device_count = api_->get_device_count();
-        std::vector<Runtime *> runtimes_(device_count);
-        for (int device_id = 0; device_id < device_count; device_id++) {
-
-            if (_current_runtime == nullptr) {
-                auto runtime = new Runtime(device_type, device_id);
-                runtime->_activate();
-                runtimes_[device_id] = runtime;
-                _current_runtime = runtime;
-            }
+        if (llaisysGetRuntimeAPI(device_type)->get_device_count() > 0) {
+            setDevice(device_type, 0);
+            break;
         }
-        _runtime_map[device_type] = runtimes_;
     }
 }
 
-Context::~Context() {
-    // Destroy current runtime first.
-    delete _current_runtime;
+Runtime &Context::_runtime(llaisysDeviceType_t device_type, int device_id) {
+    // Slots for every device, sized on first use; a runtime is created the first time its device is selected.
+    static std::mutex mutex;
+    static auto *runtimes = new std::vector<std::vector<Runtime *>>(LLAISYS_DEVICE_TYPE_COUNT);
 
-    for (auto &runtime_entry : _runtime_map) {
-        std::vector<Runtime *> runtimes = runtime_entry.second;
-        for (auto runtime : runtimes) {
-            if (runtime != nullptr && runtime != _current_runtime) {
-                runtime->_activate();
-                delete runtime;
-            }
-        }
-        runtimes.clear();
+    CHECK_ARGUMENT(device_type >= 0 && device_type < LLAISYS_DEVICE_TYPE_COUNT, "invalid device type");
+    std::lock_guard<std::mutex> lock(mutex);
+    auto &devices = (*runtimes)[device_type];
+    if (devices.empty()) {
+        devices.resize(llaisysGetRuntimeAPI(device_type)->get_device_count(), nullptr);
     }
-    _current_runtime = nullptr;
-    _runtime_map.clear();
+    CHECK_ARGUMENT((size_t)device_id < devices.size() && device_id >= 0, "invalid device id");
+    if (devices[device_id] == nullptr) {
+        devices[device_id] = new Runtime(device_type, device_id);
+    }
+    return *devices[device_id];
 }
 
 void Context::setDevice(llaisysDeviceType_t device_type, int device_id) {
     // If doest not match the current runtime.
     if (_current_runtime == nullptr || _current_runtime->deviceType() != device_type || _current_runtime->deviceId() != device_id) {
-        auto runtimes = _runtime_map[device_type];
-        CHECK_ARGUMENT((size_t)device_id < runtimes.size() && device_id >= 0, "invalid device id");
-        if (_current_runtime != nullptr) {
-            _current_runtime->_deactivate();
-        }
-        if (runtimes[device_id] == nullptr) {
-            runtimes[device_id] = new Runtime(device_type, device_id);
-        }
-        runtimes[device_id]->_activate();
-        _current_runtime = runtimes[device_id];
+        Runtime &runtime = _runtime(device_type, device_id);
+        runtime._activate();
+        _current_runtime = &runtime;
     }
 }
 
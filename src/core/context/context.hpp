@@ -6,18 +6,20 @@
 
 #include "../runtime/runtime.hpp"
 
-#include <unordered_map>
-#include <vector>
-
 namespace llaisys::core {
+// The device selected on a thread. Runtimes are created on first use and shared by every thread of the process,
+// so storage allocated on one thread can be freed on another and freed memory is cached for all of them.
 class Context {
 private:
-    std::unordered_map<llaisysDeviceType_t, std::vector<Runtime *>> _runtime_map;
     Runtime *_current_runtime;
     Context();
 
+    // The process-wide runtime of a device, created on first use and never destroyed, as storages may outlive
+    // any thread.
+    static Runtime &_runtime(llaisysDeviceType_t device_type, int device_id);
+
 public:
-    ~Context();
+    ~Context() = default;
 
     // Prevent copy
     Context(const Context &) = delete;
@@ -1,20 +1,30 @@
 #include "runtime.hpp"
 
 #include "../../device/runtime_api.hpp"
-#include "../allocator/naive_allocator.hpp"
+#include "../allocator/caching_allocator.hpp"
+
+#include <algorithm>
+#include <cstdlib>
 
 namespace llaisys::core {
+namespace {
+// Bytes of freed device memory kept for reuse: LLAISYS_ALLOCATOR_CACHE_MB, 256 MiB by default.
+size_t allocatorCacheBytes() {
+    const char *env = std::getenv("LLAISYS_ALLOCATOR_CACHE_MB");
+    long mb = env != nullptr ? std::atol(env) : 256;
+    return static_cast<size_t>(std::max(mb, 0L)) << 20;
+}
+} // namespace
+
 Runtime::Runtime(llaisysDeviceType_t device_type, int device_id)
-    : _device_type(device_type), _device_id(device_id), _is_active(false) {
+    : _device_type(device_type), _device_id(device_id) {
     _api = llaisys::device::getRuntimeAPI(_device_type);
+    _api->set_device(_device_id);
     _stream = _api->create_stream();
-    _allocator = new allocators::NaiveAllocator(_api);
+    _allocator = new allocators::CachingAllocator(_api, allocatorCacheBytes());
 }
 
 Runtime::~Runtime() {
-    if (!_is_active) {
-        std::cerr << "Mallicious destruction of inactive runtime." << std::endl;
-    }
     delete _allocator;
     _allocator = nullptr;
     _api->destroy_stream(_stream);
@@ -23,15 +33,6 @@ Runtime::~Runtime() {
 
 void Runtime::_activate() {
     _api->set_device(_device_id);
-    _is_active = true;
-}
-
-void Runtime::_deactivate() {
-    _is_active = false;
-}
-
-bool Runtime::isActive() const {
-    return _is_active;
 }
 
 llaisysDeviceType_t Runtime::deviceType() const {
@@ -58,7 +59,7 @@ void Runtime::freeStorage(Storage *storage) {
     if (storage->isHost()) {
         _api->free_host(storage->memory());
     } else {
-        _allocator->release(storage->memory());
+        _allocator->release(storage->memory(), storage->size());
     }
 }
 
@@ -5,15 +5,15 @@
 #include "../allocator/allocator.hpp"
 
 namespace llaisys::core {
+// Runtimes are shared by every thread, and so are their allocator and stream.
 class Runtime {
 private:
     llaisysDeviceType_t _device_type;
     int _device_id;
     const LlaisysRuntimeAPI *_api;
     MemoryAllocator *_allocator;
-    bool _is_active;
+    // Makes this the device of the calling thread.
     void _activate();
-    void _deactivate();
     llaisysStream_t _stream;
     Runtime(llaisysDeviceType_t device_type, int device_id);
 
@@ -32,12 +32,10 @@ public:
 
     llaisysDeviceType_t deviceType() const;
     int deviceId() const;
-    bool isActive() const;
 
     const LlaisysRuntimeAPI *api() const;
 
     storage_t allocateDeviceStorage(size_t size);
-    ;
     storage_t allocateHostStorage(size_t size);
     void freeStorage(Storage *storage);
 
@@ -0,0 +1,169 @@
+#include "cpu_memory.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <unordered_map>
+
+#ifdef _WIN32
+#include <malloc.h>
+#else
+#include <sys/mman.h>
+#endif
+
+namespace llaisys::device::cpu {
+namespace {
+llaisysHugePages_t initialHugePages() {
+    const char *env = std::getenv("LLAISYS_HUGEPAGES");
+    if (env != nullptr && std::strcmp(env, "hugetlb") == 0) {
+        return LLAISYS_HUGE_PAGES_HUGETLB;
+    }
+    if (env != nullptr && std::strcmp(env, "thp") == 0) {
+        return LLAISYS_HUGE_PAGES_THP;
+    }
+    return LLAISYS_HUGE_PAGES_OFF;
+}
+
+std::atomic<llaisysHugePages_t> &mode() {
+    static std::atomic<llaisysHugePages_t> mode{initialHugePages()};
+    return mode;
+}
+
+// Mapped blocks and their kind, to tell them from heap blocks when freed.
+struct Mapping {
+    size_t size;
+    llaisysHugePages_t kind;
+};
+
+struct Mappings {
+    std::mutex mutex;
+    std::unordered_map<void *, Mapping> blocks;
+    // Lets frees skip the lock while nothing is mapped.
+    std::atomic<size_t> count{0};
+    std::atomic<size_t> hugetlb_bytes{0}, thp_bytes{0}, hugetlb_fallbacks{0}, mmap_fallbacks{0};
+};
+
+Mappings &mappings() {
+    // Never destroyed, as storages may be freed during exit.
+    static auto *mappings = new Mappings();
+    return *mappings;
+}
+
+void *allocateAligned(size_t size) {
+    // Both need a size that is a nonzero multiple of the alignment.
+    size = (std::max<size_t>(size, 1) + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+#ifdef _WIN32
+    return _aligned_malloc(size, ALIGNMENT);
+#else
+    void *memory = nullptr;
+    return posix_memalign(&memory, ALIGNMENT, size) == 0 ? memory : nullptr;
+#endif
+}
+
+void releaseAligned(void *memory) {
+#ifdef _WIN32
+    _aligned_free(memory);
+#else
+    std::free(memory);
+#endif
+}
+
+#ifndef _WIN32
+// A mapping of `size` bytes, a multiple of HUGE_PAGE_SIZE, backed by huge pages of `kind`, or nullptr.
+void *mapHuge(size_t size, llaisysHugePages_t kind) {
+    if (kind == LLAISYS_HUGE_PAGES_HUGETLB) {
+#ifdef MAP_HUGETLB
+        void *memory = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        return memory != MAP_FAILED ? memory : nullptr;
+#else
+        return nullptr;
+#endif
+    }
+    // THP only backs huge-page-aligned ranges, so map one page more and trim both ends to an aligned range.
+    void *raw = ::mmap(nullptr, size + HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (raw == MAP_FAILED) {
+        return nullptr;
+    }
+    auto begin = reinterpret_cast<uintptr_t>(raw);
+    auto aligned = (begin + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+    if (aligned > begin) {
+        ::munmap(raw, aligned - begin);
+    }
+    ::munmap(reinterpret_cast<void *>(aligned + size), begin + HUGE_PAGE_SIZE - aligned);
+#ifdef MADV_HUGEPAGE
+    ::madvise(reinterpret_cast<void *>(aligned), size, MADV_HUGEPAGE);
+#endif
+    return reinterpret_cast<void *>(aligned);
+}
+#endif
+} // namespace
+
+llaisysHugePages_t hugePages() {
+    return mode();
+}
+
+void setHugePages(llaisysHugePages_t kind) {
+    mode() = kind;
+}
+
+void *allocate(size_t size) {
+#ifndef _WIN32
+    llaisysHugePages_t kind = mode();
+    if (kind != LLAISYS_HUGE_PAGES_OFF && size >= HUGE_PAGE_SIZE) {
+        auto &state = mappings();
+        size_t mapped = (size + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+        void *memory = mapHuge(mapped, kind);
+        if (memory == nullptr && kind == LLAISYS_HUGE_PAGES_HUGETLB) {
+            // The reserved pool is empty or absent.
+            ++state.hugetlb_fallbacks;
+            kind = LLAISYS_HUGE_PAGES_THP;
+            memory = mapHuge(mapped, kind);
+        }
+        if (memory != nullptr) {
+            (kind == LLAISYS_HUGE_PAGES_HUGETLB ? state.hugetlb_bytes : state.thp_bytes) += mapped;
+            std::lock_guard<std::mutex> lock(state.mutex);
+            state.blocks.emplace(memory, Mapping{mapped, kind});
+            ++state.count;
+            return memory;
+        }
+        ++state.mmap_fallbacks;
+    }
+#endif
+    return allocateAligned(size);
+}
+
+void release(void *memory) {
+    if (memory == nullptr) {
+        return;
+    }
+#ifndef _WIN32
+    auto &state = mappings();
+    if (state.count > 0) {
+        Mapping mapping{0, LLAISYS_HUGE_PAGES_OFF};
+        {
+            std::lock_guard<std::mutex> lock(state.mutex);
+            auto it = state.blocks.find(memory);
+            if (it != state.blocks.end()) {
+                mapping = it->second;
+                state.blocks.erase(it);
+                --state.count;
+            }
+        }
+        if (mapping.size > 0) {
+            (mapping.kind == LLAISYS_HUGE_PAGES_HUGETLB ? state.hugetlb_bytes : state.thp_bytes) -= mapping.size;
+            ::munmap(memory, mapping.size);
+            return;
+        }
+    }
+#endif
+    releaseAligned(memory);
+}
+
+LlaisysCpuMemoryStats memoryStats() {
+    auto &state = mappings();
+    return {state.hugetlb_bytes, state.thp_bytes, state.hugetlb_fallbacks, state.mmap_fallbacks};
+}
+} // namespace llaisys::device::cpu
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "llaisys/runtime.h"
+
+#include <cstddef>
+
+namespace llaisys::device::cpu {
+// Alignment of every CPU allocation: a cache line, and enough for aligned AVX-512 loads.
+constexpr size_t ALIGNMENT = 64;
+// Allocations of at least this size may be backed by huge pages.
+constexpr size_t HUGE_PAGE_SIZE = size_t(2) << 20;
+
+// Where large allocations come from. Starts as LLAISYS_HUGEPAGES ("thp" or "hugetlb"), off by default.
+llaisysHugePages_t hugePages();
+void setHugePages(llaisysHugePages_t mode);
+
+// Aligned host memory. Large allocations are mapped with huge pages when enabled, falling back to THP and then to
+// the heap when the system has none to spare.
+void *allocate(size_t size);
+void release(void *memory);
+
+LlaisysCpuMemoryStats memoryStats();
+} // namespace llaisys::device::cpu
@@ -1,6 +1,8 @@
 #include "../runtime_api.hpp"
 
-#include <cstdlib>
+#include "cpu_memory.hpp"
+#include "cpu_stream.hpp"
+
 #include <cstring>
 
 namespace llaisys::device::cpu {
@@ -14,27 +16,39 @@ void setDevice(int) {
     // do nothing
 }
 
+// Work on the null stream runs synchronously on the caller.
+Stream *asStream(llaisysStream_t stream) {
+    return reinterpret_cast<Stream *>(stream);
+}
+
+Event *asEvent(llaisysEvent_t event) {
+    return reinterpret_cast<Event *>(event);
+}
+
 void deviceSynchronize() {
-    // do nothing
+    synchronizeStreams();
 }
 
 llaisysStream_t createStream() {
-    return (llaisysStream_t)0; // null stream
+    return new Stream();
 }
 
 void destroyStream(llaisysStream_t stream) {
-    // do nothing
+    delete asStream(stream);
 }
+
 void streamSynchronize(llaisysStream_t stream) {
-    // do nothing
+    if (stream != nullptr) {
+        asStream(stream)->synchronize();
+    }
 }
 
 void *mallocDevice(size_t size) {
-    return std::malloc(size);
+    return allocate(size);
 }
 
 void freeDevice(void *ptr) {
-    std::free(ptr);
+    release(ptr);
 }
 
 void *mallocHost(size_t size) {
@@ -50,7 +64,37 @@ void memcpySync(void *dst, const void *src, size_t size, llaisysMemcpyKind_t kin
 }
 
 void memcpyAsync(void *dst, const void *src, size_t size, llaisysMemcpyKind_t kind, llaisysStream_t stream) {
-    memcpySync(dst, src, size, kind);
+    if (stream == nullptr) {
+        return memcpySync(dst, src, size, kind);
+    }
+    asStream(stream)->enqueue([=] { std::memcpy(dst, src, size); });
+}
+
+void launchHostFunc(llaisysStream_t stream, host_func_t fn, void *arg) {
+    if (stream == nullptr) {
+        return fn(arg);
+    }
+    asStream(stream)->enqueue([=] { fn(arg); });
+}
+
+llaisysEvent_t createEvent() {
+    return new Event();
+}
+
+void destroyEvent(llaisysEvent_t event) {
+    delete asEvent(event);
+}
+
+void recordEvent(llaisysEvent_t event, llaisysStream_t stream) {
+    asEvent(event)->record(asStream(stream));
+}
+
+void streamWaitEvent(llaisysStream_t stream, llaisysEvent_t event) {
+    asEvent(event)->wait(asStream(stream));
+}
+
+void eventSynchronize(llaisysEvent_t event) {
+    asEvent(event)->synchronize();
 }
 
 static const LlaisysRuntimeAPI RUNTIME_API = {
@@ -65,7 +109,13 @@ static const LlaisysRuntimeAPI RUNTIME_API = {
     &mallocHost,
     &freeHost,
     &memcpySync,
-    &memcpyAsync};
+    &memcpyAsync,
+    &launchHostFunc,
+    &createEvent,
+    &destroyEvent,
+    &recordEvent,
+    &streamWaitEvent,
+    &eventSynchronize};
 
 } // namespace runtime_api
 
@@ -0,0 +1,183 @@
+#include "cpu_stream.hpp"
+
+#include <algorithm>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace llaisys::device::cpu {
+namespace {
+std::mutex &streamsMutex() {
+    static std::mutex mutex;
+    return mutex;
+}
+
+std::unordered_set<Stream *> &streams() {
+    static std::unordered_set<Stream *> streams;
+    return streams;
+}
+
+// Signalled when synchronizeStreams() is done with the streams it drained.
+std::condition_variable &streamsDrained() {
+    static std::condition_variable drained;
+    return drained;
+}
+} // namespace
+
+Stream::Stream() : _busy(false), _stop(false), _draining(0) {
+    std::lock_guard<std::mutex> lock(streamsMutex());
+    streams().insert(this);
+}
+
+Stream::~Stream() {
+    {
+        std::unique_lock<std::mutex> lock(streamsMutex());
+        streams().erase(this);
+        streamsDrained().wait(lock, [&] { return _draining == 0; });
+    }
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stop = true;
+    }
+    _changed.notify_all();
+    if (_worker.joinable()) {
+        _worker.join();
+    }
+}
+
+void Stream::_work() {
+    std::unique_lock<std::mutex> lock(_mutex);
+    while (true) {
+        _changed.wait(lock, [&] { return _stop || !_queue.empty(); });
+        if (_queue.empty()) {
+            return;
+        }
+        auto work = std::move(_queue.front());
+        _queue.pop_front();
+        _busy = true;
+        lock.unlock();
+        std::exception_ptr error;
+        try {
+            work();
+        } catch (...) {
+            error = std::current_exception();
+        }
+        work = nullptr;
+        lock.lock();
+        if (error && !_error) {
+            _error = error;
+        }
+        _busy = false;
+        _changed.notify_all();
+    }
+}
+
+void Stream::enqueue(std::function<void()> work) {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _queue.push_back(std::move(work));
+        if (!_worker.joinable()) {
+            _worker = std::thread([this] { _work(); });
+        }
+    }
+    _changed.notify_all();
+}
+
+void Stream::synchronize() {
+    std::unique_lock<std::mutex> lock(_mutex);
+    _changed.wait(lock, [&] { return _queue.empty() && !_busy; });
+    if (_error) {
+        std::rethrow_exception(std::exchange(_error, nullptr));
+    }
+}
+
+Event::Event() : _recorded(0), _completed(0), _waiting(0) {}
+
+Event::~Event() {
+    std::unique_lock<std::mutex> lock(_mutex);
+    _changed.wait(lock, [&] { return _completed >= _recorded && _waiting == 0; });
+}
+
+void Event::_waitFor(uint64_t target) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    _changed.wait(lock, [&] { return _completed >= target; });
+}
+
+void Event::record(Stream *stream) {
+    uint64_t target;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        target = ++_recorded;
+        if (stream == nullptr) {
+            _completed = target;
+            _changed.notify_all();
+            return;
+        }
+    }
+    // Signalled under the lock, as the destructor may run as soon as the event looks complete.
+    stream->enqueue([this, target] {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _completed = std::max(_completed, target);
+        _changed.notify_all();
+    });
+}
+
+void Event::wait(Stream *stream) {
+    uint64_t target;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        target = _recorded;
+        if (stream != nullptr) {
+            ++_waiting;
+        }
+    }
+    if (stream == nullptr) {
+        return _waitFor(target);
+    }
+    stream->enqueue([this, target] {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _changed.wait(lock, [&] { return _completed >= target; });
+        --_waiting;
+        _changed.notify_all();
+    });
+}
+
+void Event::synchronize() {
+    uint64_t target;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        target = _recorded;
+    }
+    _waitFor(target);
+}
+
+void synchronizeStreams() {
+    // Streams are waited for without the registry lock, which work on them may need to create or destroy streams.
+    std::vector<Stream *> draining;
+    {
+        std::lock_guard<std::mutex> lock(streamsMutex());
+        for (Stream *stream : streams()) {
+            ++stream->_draining;
+            draining.push_back(stream);
+        }
+    }
+    std::exception_ptr error;
+    for (Stream *stream : draining) {
+        try {
+            stream->synchronize();
+        } catch (...) {
+            error = error ? error : std::current_exception();
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(streamsMutex());
+        for (Stream *stream : draining) {
+            --stream->_draining;
+        }
+    }
+    streamsDrained().notify_all();
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+} // namespace llaisys::device::cpu
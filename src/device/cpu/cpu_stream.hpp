@@ -0,0 +1,76 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace llaisys::device::cpu {
+// An ordered queue of host work, run by a thread of its own that starts with the first piece of work. Work on one
+// stream runs in the order it was enqueued; work on different streams, and on the caller, runs concurrently.
+class Stream {
+private:
+    std::mutex _mutex;
+    // Signalled when work is queued or finishes, or the stream stops.
+    std::condition_variable _changed;
+    std::deque<std::function<void()>> _queue;
+    // Whether the worker is running work it took off the queue.
+    bool _busy;
+    bool _stop;
+    std::exception_ptr _error;
+    std::thread _worker;
+    // Calls to synchronizeStreams() draining this stream; the destructor waits for them. Guarded by the registry
+    // of live streams.
+    size_t _draining;
+
+    void _work();
+
+    friend void synchronizeStreams();
+
+public:
+    Stream();
+    // Runs the work still queued first.
+    ~Stream();
+
+    Stream(const Stream &) = delete;
+    Stream &operator=(const Stream &) = delete;
+
+    void enqueue(std::function<void()> work);
+    // Blocks until the work enqueued so far has run, and rethrows the first exception it threw, if any.
+    void synchronize();
+};
+
+// A point in the work of a stream. It completes once the work enqueued before record() has run; recording it again
+// moves the point, and waits refer to the latest one recorded when they start.
+class Event {
+private:
+    std::mutex _mutex;
+    // Signalled when a record completes or a stream stops waiting.
+    std::condition_variable _changed;
+    uint64_t _recorded, _completed;
+    // Waits enqueued on streams and not finished yet.
+    size_t _waiting;
+
+    void _waitFor(uint64_t target);
+
+public:
+    Event();
+    // Waits for the last record and for streams waiting on the event, so no work outlives it.
+    ~Event();
+
+    Event(const Event &) = delete;
+    Event &operator=(const Event &) = delete;
+
+    // A null stream runs work synchronously, so the event completes at once.
+    void record(Stream *stream);
+    // Work enqueued on `stream` afterwards starts once the event completes; a null stream waits on the host.
+    void wait(Stream *stream);
+    void synchronize();
+};
+
+// Waits for every stream live at the call, and rethrows the first exception one of them threw once all have drained.
+void synchronizeStreams();
+} // namespace llaisys::device::cpu
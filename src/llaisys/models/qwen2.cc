@@ -0,0 +1,195 @@
+#include "llaisys/models/qwen2.h"
+
+#include "../llaisys_tensor.hpp"
+
+#include "../../models/generation/async_generation.hpp"
+#include "../../models/qwen2/qwen2.hpp"
+
+#include <memory>
+#include <vector>
+
+__C {
+    struct LlaisysQwen2Model {
+        std::unique_ptr<llaisys::models::Qwen2> model;
+        LlaisysQwen2Weights weights;
+        // Handles exposed through `weights`, owned by the model.
+        std::vector<LlaisysTensor *> handles;
+        std::vector<std::vector<llaisysTensor_t>> layer_handles;
+        // Declared after `model` so that a running generation is cancelled before the model goes away.
+        llaisys::models::AsyncGeneration generation;
+    };
+
+    struct LlaisysQwen2Model *llaisysQwen2ModelCreate(const LlaisysQwen2Meta *meta, llaisysDeviceType_t device, int *device_ids, int ndevice) {
+        int device_id = (device_ids != nullptr && ndevice > 0) ? device_ids[0] : 0;
+        auto model = new LlaisysQwen2Model;
+        model->model = std::make_unique<llaisys::models::Qwen2>(*meta, device, device_id);
+
+        auto &w = model->model->weights();
+        auto wrap = [&](llaisys::tensor_t tensor) {
+            auto handle = new LlaisysTensor{tensor};
+            model->handles.push_back(handle);
+            return handle;
+        };
+        auto wrap_layers = [&](const std::vector<llaisys::tensor_t> &tensors) {
+            std::vector<llaisysTensor_t> layer;
+            for (auto &tensor : tensors) {
+                layer.push_back(wrap(tensor));
+            }
+            model->layer_handles.push_back(std::move(layer));
+            return model->layer_handles.back().data();
+        };
+
+        model->weights.in_embed = wrap(w.in_embed);
+        model->weights.out_embed = wrap(w.out_embed);
+        model->weights.out_norm_w = wrap(w.out_norm_w);
+        model->weights.attn_norm_w = wrap_layers(w.attn_norm_w);
+        model->weights.attn_q_w = wrap_layers(w.attn_q_w);
+        model->weights.attn_q_b = wrap_layers(w.attn_q_b);
+        model->weights.attn_k_w = wrap_layers(w.attn_k_w);
+        model->weights.attn_k_b = wrap_layers(w.attn_k_b);
+        model->weights.attn_v_w = wrap_layers(w.attn_v_w);
+        model->weights.attn_v_b = wrap_layers(w.attn_v_b);
+        model->weights.attn_o_w = wrap_layers(w.attn_o_w);
+        model->weights.mlp_norm_w = wrap_layers(w.mlp_norm_w);
+        model->weights.mlp_gate_w = wrap_layers(w.mlp_gate_w);
+        model->weights.mlp_up_w = wrap_layers(w.mlp_up_w);
+        model->weights.mlp_down_w = wrap_layers(w.mlp_down_w);
+        return model;
+    }
+
+    void llaisysQwen2ModelDestroy(struct LlaisysQwen2Model * model) {
+        for (auto handle : model->handles) {
+            delete handle;
+        }
+        delete model;
+    }
+
+    struct LlaisysQwen2Weights *llaisysQwen2ModelWeights(struct LlaisysQwen2Model * model) {
+        return &model->weights;
+    }
+
+    int64_t llaisysQwen2ModelInfer(struct LlaisysQwen2Model * model, int64_t * token_ids, size_t ntoken) {
+        return model->model->infer(token_ids, ntoken);
+    }
+
+    void llaisysQwen2ModelGenerate(struct LlaisysQwen2Model * model, int64_t * token_ids, size_t ntoken, const struct LlaisysQwen2GenerateParams *params, LlaisysQwen2TokenCallback callback, void *userdata) {
+        CHECK_ARGUMENT(ntoken > 0, "qwen2: no input tokens");
+        std::vector<int64_t> prompt(token_ids, token_ids + ntoken);
+        model->generation.start(
+            [qwen2 = model->model.get(), prompt = std::move(prompt), params = *params](const std::function<bool(int64_t)> &emit) {
+                return qwen2->generate(prompt.data(), prompt.size(), params, emit);
+            },
+            callback, userdata);
+    }
+
+    size_t llaisysQwen2ModelReadTokens(struct LlaisysQwen2Model * model, int64_t * out_tokens, size_t max_tokens) {
+        return model->generation.read(out_tokens, max_tokens);
+    }
+
+    void llaisysQwen2ModelCancel(struct LlaisysQwen2Model * model) {
+        model->generation.cancel();
+    }
+
+    size_t llaisysQwen2ModelWait(struct LlaisysQwen2Model * model) {
+        return model->generation.wait();
+    }
+
+    void llaisysQwen2ModelSetDraft(struct LlaisysQwen2Model * model, struct LlaisysQwen2Model * draft) {
+        model->model->setDraft(draft != nullptr ? draft->model.get() : nullptr);
+    }
+
+    void llaisysQwen2ModelSpeculativeStats(struct LlaisysQwen2Model * model, struct LlaisysQwen2SpeculativeStats * stats) {
+        const auto &s = model->model->speculativeStats();
+        stats->decode_steps = s.decode_steps;
+        stats->decode_tokens = s.decode_tokens;
+        stats->drafted_tokens = s.drafted_tokens;
+        stats->accepted_tokens = s.accepted_tokens;
+    }
+
+    void llaisysQwen2ModelSaveSnapshot(struct LlaisysQwen2Model * model, const char *path, uint8_t quantize) {
+        model->model->saveSnapshot(path, quantize != 0);
+    }
+
+    size_t llaisysQwen2ModelLoadSnapshot(struct LlaisysQwen2Model * model, const char *path) {
+        return model->model->loadSnapshot(path);
+    }
+
+    void llaisysQwen2ModelTune(struct LlaisysQwen2Model * model, const size_t *ntokens, size_t n) {
+        std::vector<size_t> counts{1};
+        if (ntokens != nullptr) {
+            counts.assign(ntokens, ntokens + n);
+        }
+        model->model->tune(counts);
+    }
+
+    void llaisysQwen2ModelReset(struct LlaisysQwen2Model * model) {
+        model->model->reset();
+    }
+
+    void llaisysQwen2ModelSetStreaming(struct LlaisysQwen2Model * model, uint8_t enable, size_t sink_tokens) {
+        model->model->enableStreaming(enable != 0, sink_tokens);
+    }
+
+    void llaisysQwen2ModelSetHeavyHitter(struct LlaisysQwen2Model * model, uint8_t enable, size_t budget_tokens, size_t recent_tokens) {
+        model->model->enableHeavyHitter(enable != 0, budget_tokens, recent_tokens);
+    }
+
+    void llaisysQwen2ModelKVEvictionStats(struct LlaisysQwen2Model * model, struct LlaisysQwen2KVEvictionStats * stats) {
+        const auto &s = model->model->evictionStats();
+        stats->evictions = s.evictions;
+        stats->evicted_entries = s.evicted_entries;
+        stats->cached_tokens = model->model->cachedTokens();
+    }
+
+    void llaisysQwen2ModelSetSessions(struct LlaisysQwen2Model * model, size_t max_resident, const char *spill_dir, uint8_t quantize) {
+        model->model->enableSessions(max_resident, spill_dir != nullptr ? spill_dir : "", quantize != 0);
+    }
+
+    void llaisysQwen2ModelSelectSession(struct LlaisysQwen2Model * model, uint64_t session, int priority) {
+        model->model->selectSession(session, priority);
+    }
+
+    void llaisysQwen2ModelReleaseSession(struct LlaisysQwen2Model * model, uint64_t session) {
+        model->model->releaseSession(session);
+    }
+
+    void llaisysQwen2ModelSessionStats(struct LlaisysQwen2Model * model, struct LlaisysQwen2SessionStats * stats) {
+        *stats = LlaisysQwen2SessionStats{};
+        auto pool = model->model->sessionPool();
+        if (pool == nullptr) {
+            return;
+        }
+        const auto &s = pool->stats();
+        stats->preemptions = s.preemptions;
+        stats->swap_outs = s.swap_outs;
+        stats->swap_ins = s.swap_ins;
+        stats->recomputes = s.recomputes;
+        stats->swapped_bytes = s.swapped_bytes;
+        stats->recomputed_tokens = s.recomputed_tokens;
+        stats->resident_sessions = pool->parked() + 1;
+        stats->swapped_sessions = pool->swappedSessions();
+    }
+
+    void llaisysQwen2ModelSetGraph(struct LlaisysQwen2Model * model, uint8_t enable) {
+        model->model->enableGraph(enable != 0);
+    }
+
+    void llaisysQwen2ModelSetPrefixCache(struct LlaisysQwen2Model * model, size_t capacity_tokens) {
+        model->model->enablePrefixCache(capacity_tokens);
+    }
+
+    void llaisysQwen2ModelPrefixCacheStats(struct LlaisysQwen2Model * model, struct LlaisysQwen2PrefixCacheStats * stats) {
+        *stats = LlaisysQwen2PrefixCacheStats{};
+        auto cache = model->model->prefixCache();
+        if (cache == nullptr) {
+            return;
+        }
+        const auto &s = cache->stats();
+        stats->hits = s.hits;
+        stats->misses = s.misses;
+        stats->hit_tokens = s.hit_tokens;
+        stats->miss_tokens = s.miss_tokens;
+        stats->cached_tokens = s.cached_tokens;
+        stats->evicted_tokens = s.evicted_tokens;
+    }
+}
@@ -4,11 +4,16 @@
 
 #include "../ops/add/op.hpp"
 #include "../ops/argmax/op.hpp"
+#include "../ops/cast/op.hpp"
+#include "../ops/elementwise/fusion.hpp"
 #include "../ops/embedding/op.hpp"
 #include "../ops/linear/op.hpp"
+#include "../ops/mul/op.hpp"
 #include "../ops/rearrange/op.hpp"
+#include "../ops/registry/registry.hpp"
 #include "../ops/rms_norm/op.hpp"
 #include "../ops/rope/op.hpp"
+#include "../ops/scale/op.hpp"
 #include "../ops/self_attention/op.hpp"
 #include "../ops/swiglu/op.hpp"
 
@@ -19,11 +24,20 @@ __C {
     void llaisysArgmax(llaisysTensor_t max_idx, llaisysTensor_t max_val, llaisysTensor_t vals) {
         llaisys::ops::argmax(max_idx->tensor, max_val->tensor, vals->tensor);
     }
+    void llaisysCast(llaisysTensor_t out, llaisysTensor_t in) {
+        llaisys::ops::cast(out->tensor, in->tensor);
+    }
     void llaisysEmbedding(llaisysTensor_t out, llaisysTensor_t index, llaisysTensor_t weight) {
         llaisys::ops::embedding(out->tensor, index->tensor, weight->tensor);
     }
     void llaisysLinear(llaisysTensor_t out, llaisysTensor_t in, llaisysTensor_t weight, llaisysTensor_t bias) {
-        llaisys::ops::linear(out->tensor, in->tensor, weight->tensor, bias->tensor);
+        llaisys::ops::linear(out->tensor, in->tensor, weight->tensor, bias != nullptr ? bias->tensor : nullptr);
+    }
+    void llaisysTuneLinear(llaisysTensor_t weight, size_t ntoken) {
+        llaisys::ops::tuneLinear(ntoken, weight->tensor);
+    }
+    void llaisysMul(llaisysTensor_t c, llaisysTensor_t a, llaisysTensor_t b) {
+        llaisys::ops::mul(c->tensor, a->tensor, b->tensor);
     }
     void llaisysRearrange(llaisysTensor_t out, llaisysTensor_t in) {
         llaisys::ops::rearrange(out->tensor, in->tensor);
@@ -34,10 +48,22 @@ __C {
     void llaisysROPE(llaisysTensor_t out, llaisysTensor_t in, llaisysTensor_t pos_ids, float theta) {
         llaisys::ops::rope(out->tensor, in->tensor, pos_ids->tensor, theta);
     }
+    void llaisysScale(llaisysTensor_t out, llaisysTensor_t in, float scale) {
+        llaisys::ops::scale(out->tensor, in->tensor, scale);
+    }
     void llaisysSelfAttention(llaisysTensor_t attn_val, llaisysTensor_t q, llaisysTensor_t k, llaisysTensor_t v, float scale) {
         llaisys::ops::self_attention(attn_val->tensor, q->tensor, k->tensor, v->tensor, scale);
     }
     void llaisysSwiGLU(llaisysTensor_t out, llaisysTensor_t gate, llaisysTensor_t up) {
         llaisys::ops::swiglu(out->tensor, gate->tensor, up->tensor);
     }
+    void llaisysEnableFusion(uint8_t enable) {
+        llaisys::ops::enableFusion(enable != 0);
+    }
+    void llaisysFlushFusion() {
+        llaisys::ops::flushFusion();
+    }
+    void llaisysPreferKernel(const char *op, const char *name) {
+        llaisys::ops::preferKernel(op, name != nullptr ? name : "");
+    }
 }
@@ -1,5 +1,6 @@
 #include "llaisys/runtime.h"
 #include "../core/context/context.hpp"
+#include "../device/cpu/cpu_memory.hpp"
 #include "../device/runtime_api.hpp"
 
 // Llaisys API for setting context runtime.
@@ -10,4 +11,12 @@ __C void llaisysSetContextRuntime(llaisysDeviceType_t device_type, int device_id
 // Llaisys API for getting the runtime APIs
 __C const LlaisysRuntimeAPI *llaisysGetRuntimeAPI(llaisysDeviceType_t device_type) {
     return llaisys::device::getRuntimeAPI(device_type);
-}
\ No newline at end of file
+}
+
+__C void llaisysSetCpuHugePages(llaisysHugePages_t mode) {
+    llaisys::device::cpu::setHugePages(mode);
+}
+
+__C void llaisysGetCpuMemoryStats(LlaisysCpuMemoryStats *stats) {
+    *stats = llaisys::device::cpu::memoryStats();
+}
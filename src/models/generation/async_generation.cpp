@@ -0,0 +1,144 @@
+#include "async_generation.hpp"
+
+#include "../../utils.hpp"
+
+namespace llaisys::models {
+AsyncGeneration::AsyncGeneration(size_t ring_capacity)
+    : _ring(ring_capacity), _callback(nullptr), _userdata(nullptr), _reader_waiting(false), _writer_waiting(false),
+      _finished(true), _cancelled(false), _generated(0), _stop(false) {}
+
+AsyncGeneration::~AsyncGeneration() {
+    cancel();
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _cv.wait(lock, [&] { return _finished; });
+        _stop = true;
+    }
+    _cv.notify_all();
+    if (_worker.joinable()) {
+        _worker.join();
+    }
+}
+
+void AsyncGeneration::_run() {
+    std::unique_lock<std::mutex> lock(_mutex);
+    while (true) {
+        _cv.wait(lock, [&] { return _stop || _task != nullptr; });
+        if (_task == nullptr) {
+            return;
+        }
+        auto task = std::move(_task);
+        _task = nullptr;
+        lock.unlock();
+        task();
+        lock.lock();
+    }
+}
+
+// Wakes the other side of the ring if it has published that it waits. The fence orders the ring update before
+// the flag is read, against the waiter's store of the flag before it checks the ring.
+void AsyncGeneration::_wake(const std::atomic<bool> &waiting) {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (waiting.load(std::memory_order_relaxed)) {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+        }
+        _cv.notify_all();
+    }
+}
+
+bool AsyncGeneration::_emit(int64_t token) {
+    if (_cancelled) {
+        return false;
+    }
+    if (_callback != nullptr) {
+        _callback(token, _userdata);
+        ++_generated;
+        return !_cancelled;
+    }
+    while (!_ring.tryPush(token)) {
+        // The reader has fallen a full ring behind; wait for it to catch up.
+        std::unique_lock<std::mutex> lock(_mutex);
+        _writer_waiting.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        _cv.wait(lock, [&] { return _cancelled || !_ring.full(); });
+        _writer_waiting.store(false, std::memory_order_relaxed);
+        if (_cancelled) {
+            return false;
+        }
+    }
+    ++_generated;
+    _wake(_reader_waiting);
+    return !_cancelled;
+}
+
+void AsyncGeneration::start(Job job, Callback callback, void *userdata) {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        CHECK_ARGUMENT(_finished, "generation: the previous generation is still running");
+        _ring.clear();
+        _callback = callback;
+        _userdata = userdata;
+        _finished = false;
+        _cancelled = false;
+        _generated = 0;
+        _error = nullptr;
+        _task = [this, job = std::move(job)] {
+            std::exception_ptr error;
+            try {
+                job([this](int64_t token) { return _emit(token); });
+            } catch (...) {
+                error = std::current_exception();
+            }
+            std::lock_guard<std::mutex> lock(_mutex);
+            _error = error;
+            _finished = true;
+            _cv.notify_all();
+        };
+        if (!_worker.joinable()) {
+            _worker = std::thread([this] { _run(); });
+        }
+    }
+    _cv.notify_all();
+}
+
+size_t AsyncGeneration::read(int64_t *out, size_t max_tokens) {
+    if (max_tokens == 0) {
+        return 0;
+    }
+    while (true) {
+        size_t n = _ring.tryPop(out, max_tokens);
+        if (n > 0) {
+            _wake(_writer_waiting);
+            return n;
+        }
+        std::unique_lock<std::mutex> lock(_mutex);
+        _reader_waiting.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        _cv.wait(lock, [&] { return _finished || !_ring.empty(); });
+        _reader_waiting.store(false, std::memory_order_relaxed);
+        if (_finished && _ring.empty()) {
+            return 0;
+        }
+    }
+}
+
+void AsyncGeneration::cancel() {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _cancelled = true;
+    }
+    _cv.notify_all();
+}
+
+size_t AsyncGeneration::wait() {
+    std::unique_lock<std::mutex> lock(_mutex);
+    _cv.wait(lock, [&] { return _finished; });
+    if (_error) {
+        auto error = _error;
+        _error = nullptr;
+        std::rethrow_exception(error);
+    }
+    return _generated;
+}
+} // namespace llaisys::models
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "token_ring.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace llaisys::models {
+// Runs one generation at a time for a model on a worker thread of its own, so models generate concurrently.
+// Tokens are handed to a callback on that thread, or queued in a ring that the caller drains with read().
+//
+// The worker starts with the first generation and is joined on destruction. Runtimes and their allocators are
+// process-wide, so the tensors a generation leaves behind stay valid after the worker exits.
+class AsyncGeneration {
+public:
+    // Produces tokens through `emit` until done or `emit` returns false; returns the number produced.
+    using Job = std::function<size_t(const std::function<bool(int64_t)> &emit)>;
+    using Callback = void (*)(int64_t token, void *userdata);
+
+private:
+    TokenRing _ring;
+    Callback _callback;
+    void *_userdata;
+
+    std::mutex _mutex;
+    std::condition_variable _cv;
+    // Set by the reader waiting for tokens and by the generation waiting for room in the ring, so that the other
+    // side only takes the mutex to wake it when it actually waits.
+    std::atomic<bool> _reader_waiting;
+    std::atomic<bool> _writer_waiting;
+    bool _finished;
+    std::atomic<bool> _cancelled;
+    size_t _generated;
+    std::exception_ptr _error;
+
+    // The next generation for the worker to run, and whether it should exit instead.
+    std::function<void()> _task;
+    bool _stop;
+    std::thread _worker;
+
+    void _wake(const std::atomic<bool> &waiting);
+    bool _emit(int64_t token);
+    void _run();
+
+public:
+    explicit AsyncGeneration(size_t ring_capacity = 256);
+    // Cancels and waits for a running generation.
+    ~AsyncGeneration();
+
+    // Queues `job` and returns immediately. The previous generation must have finished.
+    void start(Job job, Callback callback, void *userdata);
+    // Blocks until tokens are available and copies up to `max_tokens` of them. Returns 0 once the generation
+    // has finished and every token has been read.
+    size_t read(int64_t *out, size_t max_tokens);
+    void cancel();
+    // Waits for the generation to finish and returns the number of tokens it produced. Rethrows its error.
+    size_t wait();
+};
+} // namespace llaisys::models
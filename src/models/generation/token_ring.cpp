@@ -0,0 +1,47 @@
+#include "token_ring.hpp"
+
+#include <algorithm>
+
+namespace llaisys::models {
+TokenRing::TokenRing(size_t capacity) : _head(0), _tail(0) {
+    size_t size = 1;
+    while (size < capacity) {
+        size <<= 1;
+    }
+    _buffer.resize(size);
+    _mask = size - 1;
+}
+
+bool TokenRing::tryPush(int64_t token) {
+    size_t head = _head.load(std::memory_order_relaxed);
+    if (head - _tail.load(std::memory_order_acquire) == _buffer.size()) {
+        return false;
+    }
+    _buffer[head & _mask] = token;
+    _head.store(head + 1, std::memory_order_release);
+    return true;
+}
+
+bool TokenRing::full() const {
+    return _head.load(std::memory_order_relaxed) - _tail.load(std::memory_order_acquire) == _buffer.size();
+}
+
+size_t TokenRing::tryPop(int64_t *out, size_t max_tokens) {
+    size_t tail = _tail.load(std::memory_order_relaxed);
+    size_t n = std::min(_head.load(std::memory_order_acquire) - tail, max_tokens);
+    for (size_t i = 0; i < n; ++i) {
+        out[i] = _buffer[(tail + i) & _mask];
+    }
+    _tail.store(tail + n, std::memory_order_release);
+    return n;
+}
+
+bool TokenRing::empty() const {
+    return _head.load(std::memory_order_acquire) == _tail.load(std::memory_order_relaxed);
+}
+
+void TokenRing::clear() {
+    _head.store(0, std::memory_order_relaxed);
+    _tail.store(0, std::memory_order_relaxed);
+}
+} // namespace llaisys::models
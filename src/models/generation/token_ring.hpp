@@ -0,0 +1,32 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace llaisys::models {
+// Lock-free single-producer single-consumer ring of token ids. The capacity is rounded up to a power of two.
+class TokenRing {
+private:
+    std::vector<int64_t> _buffer;
+    size_t _mask;
+    // Producer and consumer positions, on separate cache lines; they only ever increase.
+    alignas(64) std::atomic<size_t> _head;
+    alignas(64) std::atomic<size_t> _tail;
+
+public:
+    explicit TokenRing(size_t capacity);
+
+    // Producer side.
+    bool tryPush(int64_t token);
+    bool full() const;
+
+    // Consumer side. Copies up to `max_tokens` tokens and returns how many were copied.
+    size_t tryPop(int64_t *out, size_t max_tokens);
+    bool empty() const;
+
+    // Only valid while neither side is active.
+    void clear();
+};
+} // namespace llaisys::models
@@ -0,0 +1,242 @@
+#include "kv_cache.hpp"
+
+#include "../../core/llaisys_core.hpp"
+#include "../../utils.hpp"
+
+#include <algorithm>
+
+namespace llaisys::models {
+KVCache::KVCache(size_t nlayer, size_t capacity, size_t nkvh, size_t dh, llaisysDataType_t dtype,
+                 llaisysDeviceType_t device_type, int device_id)
+    : _capacity(capacity), _length(0), _streaming(false), _sinks(0), _head(0), _heavy_hitter(false), _budget(0),
+      _recent(0), _stats{} {
+    CHECK_ARGUMENT(capacity > 0, "kv_cache: capacity must be positive");
+    _keys.reserve(nlayer);
+    _values.reserve(nlayer);
+    for (size_t i = 0; i < nlayer; ++i) {
+        _keys.push_back(Tensor::create({capacity, nkvh, dh}, dtype, device_type, device_id));
+        _values.push_back(Tensor::create({capacity, nkvh, dh}, dtype, device_type, device_id));
+    }
+}
+
+size_t KVCache::nlayer() const {
+    return _keys.size();
+}
+
+size_t KVCache::capacity() const {
+    return _capacity;
+}
+
+size_t KVCache::length() const {
+    return _length;
+}
+
+void KVCache::setLength(size_t length) {
+    CHECK_ARGUMENT(length <= _capacity, "kv_cache: length exceeds capacity");
+    CHECK_ARGUMENT(!_streaming || length == 0 || length == _length, "kv_cache: a streaming cache can only be cleared");
+    _length = length;
+    if (length == 0) {
+        _head = 0;
+    }
+}
+
+void KVCache::setStreaming(bool enabled, size_t sinks) {
+    CHECK_ARGUMENT(!enabled || sinks < _capacity, "kv_cache: sinks leave no room for the window");
+    CHECK_ARGUMENT(!enabled || !_heavy_hitter, "kv_cache: streaming cannot be combined with heavy-hitter eviction");
+    _streaming = enabled;
+    _sinks = enabled ? sinks : 0;
+    _slot_pos.assign(enabled ? _capacity : 0, 0);
+    setLength(0);
+}
+
+bool KVCache::streaming() const {
+    return _streaming;
+}
+
+size_t KVCache::sinks() const {
+    return _sinks;
+}
+
+void KVCache::append(size_t ntoken, std::vector<size_t> &slots) {
+    CHECK_ARGUMENT(_streaming, "kv_cache: append requires streaming mode");
+    size_t window = _capacity - _sinks;
+    CHECK_ARGUMENT(ntoken <= window, "kv_cache: more new tokens than the window holds");
+
+    slots.clear();
+    size_t evicted = 0;
+    for (size_t i = 0; i < ntoken; ++i) {
+        if (_length < _capacity) {
+            slots.push_back(_length++);
+        } else {
+            slots.push_back(_sinks + _head);
+            _head = (_head + 1) % window;
+            ++evicted;
+        }
+    }
+    if (evicted > 0) {
+        _stats.evictions += 1;
+        _stats.evicted_entries += evicted * _keys.size() * _keys[0]->shape()[1];
+    }
+
+    size_t nsink = std::min(_length, _sinks);
+    for (size_t i = 0; i < nsink; ++i) {
+        _slot_pos[i] = static_cast<int64_t>(i);
+    }
+    bool full = _length == _capacity;
+    for (size_t k = 0; k < _length - nsink; ++k) {
+        size_t slot = _sinks + (full ? (_head + k) % window : k);
+        _slot_pos[slot] = static_cast<int64_t>(_sinks + k);
+    }
+}
+
+const std::vector<int64_t> &KVCache::slotPositions() const {
+    return _slot_pos;
+}
+
+void KVCache::setHeavyHitter(bool enabled, size_t budget, size_t recent) {
+    if (enabled) {
+        CHECK_ARGUMENT(!_streaming, "kv_cache: heavy-hitter eviction cannot be combined with streaming");
+        CHECK_ARGUMENT(budget > 0 && budget < _capacity, "kv_cache: budget must leave room for new rows");
+        CHECK_ARGUMENT(recent <= budget, "kv_cache: recent tokens exceed the budget");
+        if (_positions.empty()) {
+            size_t nkvh = _keys[0]->shape()[1];
+            auto device_type = _keys[0]->deviceType();
+            int device_id = _keys[0]->deviceId();
+            for (size_t i = 0; i < _keys.size(); ++i) {
+                _positions.push_back(Tensor::create({_capacity, nkvh}, LLAISYS_DTYPE_I64, device_type, device_id));
+                _mass.push_back(Tensor::create({_capacity, nkvh}, LLAISYS_DTYPE_F32, device_type, device_id));
+            }
+        }
+    }
+    _heavy_hitter = enabled;
+    _budget = enabled ? budget : 0;
+    _recent = enabled ? recent : 0;
+    setLength(0);
+}
+
+bool KVCache::heavyHitter() const {
+    return _heavy_hitter;
+}
+
+size_t KVCache::budget() const {
+    return _budget;
+}
+
+void KVCache::prepareRows(const int64_t *pos, size_t ntoken) {
+    CHECK_ARGUMENT(_heavy_hitter, "kv_cache: prepareRows requires heavy-hitter mode");
+    CHECK_ARGUMENT(_length + ntoken <= _capacity, "kv_cache: length exceeds capacity");
+    size_t nkvh = _keys[0]->shape()[1];
+    _host_pos.resize(ntoken * nkvh);
+    for (size_t i = 0; i < ntoken; ++i) {
+        std::fill_n(_host_pos.begin() + i * nkvh, nkvh, pos[i]);
+    }
+    _host_mass.assign(ntoken * nkvh, 0.0f);
+    core::context().setDevice(_keys[0]->deviceType(), _keys[0]->deviceId());
+    auto api = core::context().runtime().api();
+    for (size_t l = 0; l < _keys.size(); ++l) {
+        api->memcpy_sync(_positions[l]->data() + _length * nkvh * sizeof(int64_t), _host_pos.data(),
+                         _host_pos.size() * sizeof(int64_t), LLAISYS_MEMCPY_H2D);
+        api->memcpy_sync(_mass[l]->data() + _length * nkvh * sizeof(float), _host_mass.data(),
+                         _host_mass.size() * sizeof(float), LLAISYS_MEMCPY_H2D);
+    }
+}
+
+tensor_t KVCache::positions(size_t layer) const {
+    return _positions[layer];
+}
+
+tensor_t KVCache::attentionMass(size_t layer) const {
+    return _mass[layer];
+}
+
+void KVCache::evict() {
+    CHECK_ARGUMENT(_heavy_hitter, "kv_cache: evict requires heavy-hitter mode");
+    if (_length <= _budget) {
+        return;
+    }
+    size_t nkvh = _keys[0]->shape()[1];
+    size_t head_bytes = rowBytes() / nkvh;
+    size_t nevict = _length - _budget;
+    core::context().setDevice(_keys[0]->deviceType(), _keys[0]->deviceId());
+    auto api = core::context().runtime().api();
+
+    std::vector<size_t> candidates, holes;
+    std::vector<bool> evicted(_length);
+    _host_pos.resize(_length * nkvh);
+    _host_mass.resize(_length * nkvh);
+    for (size_t l = 0; l < _keys.size(); ++l) {
+        api->memcpy_sync(_host_pos.data(), _positions[l]->data(), _host_pos.size() * sizeof(int64_t),
+                         LLAISYS_MEMCPY_D2H);
+        api->memcpy_sync(_host_mass.data(), _mass[l]->data(), _host_mass.size() * sizeof(float), LLAISYS_MEMCPY_D2H);
+        for (size_t h = 0; h < nkvh; ++h) {
+            auto pos = [&](size_t slot) { return _host_pos[slot * nkvh + h]; };
+            auto mass = [&](size_t slot) { return _host_mass[slot * nkvh + h]; };
+
+            // Every head holds the newest tokens, which are never evicted; the rest compete on attention mass.
+            int64_t newest = pos(0);
+            for (size_t s = 1; s < _length; ++s) {
+                newest = std::max(newest, pos(s));
+            }
+            candidates.clear();
+            for (size_t s = 0; s < _length; ++s) {
+                if (pos(s) + static_cast<int64_t>(_recent) <= newest) {
+                    candidates.push_back(s);
+                }
+            }
+            ASSERT(candidates.size() >= nevict, "kv_cache: too few tokens to evict");
+            std::nth_element(candidates.begin(), candidates.begin() + nevict, candidates.end(),
+                             [&](size_t a, size_t b) { return mass(a) < mass(b); });
+            std::fill(evicted.begin(), evicted.end(), false);
+            holes.clear();
+            for (size_t i = 0; i < nevict; ++i) {
+                evicted[candidates[i]] = true;
+                if (candidates[i] < _budget) {
+                    holes.push_back(candidates[i]);
+                }
+            }
+
+            // Compact: survivors beyond the budget move into the holes left below it.
+            size_t next = 0;
+            for (size_t s = _budget; s < _length; ++s) {
+                if (evicted[s]) {
+                    continue;
+                }
+                size_t hole = holes[next++];
+                for (const auto &tensor : {_keys[l], _values[l]}) {
+                    api->memcpy_sync(tensor->data() + (hole * nkvh + h) * head_bytes,
+                                     tensor->data() + (s * nkvh + h) * head_bytes, head_bytes, LLAISYS_MEMCPY_D2D);
+                }
+                _host_pos[hole * nkvh + h] = pos(s);
+                _host_mass[hole * nkvh + h] = mass(s);
+            }
+        }
+        api->memcpy_sync(_positions[l]->data(), _host_pos.data(), _budget * nkvh * sizeof(int64_t),
+                         LLAISYS_MEMCPY_H2D);
+        api->memcpy_sync(_mass[l]->data(), _host_mass.data(), _budget * nkvh * sizeof(float), LLAISYS_MEMCPY_H2D);
+    }
+    _length = _budget;
+    _stats.evictions += 1;
+    _stats.evicted_entries += nevict * _keys.size() * nkvh;
+}
+
+bool KVCache::evicts() const {
+    return _streaming || _heavy_hitter;
+}
+
+const KVEvictionStats &KVCache::evictionStats() const {
+    return _stats;
+}
+
+size_t KVCache::rowBytes() const {
+    const auto &shape = _keys[0]->shape();
+    return shape[1] * shape[2] * _keys[0]->elementSize();
+}
+
+tensor_t KVCache::keys(size_t layer) const {
+    return _keys[layer];
+}
+
+tensor_t KVCache::values(size_t layer) const {
+    return _values[layer];
+}
+} // namespace llaisys::models
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "../../tensor/tensor.hpp"
+
+#include <vector>
+
+namespace llaisys::models {
+struct KVEvictionStats {
+    uint64_t evictions;       // passes that dropped rows
+    uint64_t evicted_entries; // rows dropped, counted per layer and KV head
+};
+
+// Per-sequence key/value cache. Every layer owns a [capacity, nkvh, dh] buffer for keys and one for values,
+// of which the first `length()` rows are valid.
+class KVCache {
+private:
+    std::vector<tensor_t> _keys;
+    std::vector<tensor_t> _values;
+    size_t _capacity;
+    size_t _length;
+
+    // Streaming mode
+    bool _streaming;
+    size_t _sinks;
+    size_t _head; // window index of the oldest row once the window is full
+    std::vector<int64_t> _slot_pos;
+
+    // Heavy-hitter mode
+    bool _heavy_hitter;
+    size_t _budget;
+    size_t _recent;
+    std::vector<tensor_t> _positions; // per layer, [capacity, nkvh] I64
+    std::vector<tensor_t> _mass;      // per layer, [capacity, nkvh] F32
+    std::vector<int64_t> _host_pos;
+    std::vector<float> _host_mass;
+
+    KVEvictionStats _stats;
+
+public:
+    KVCache(size_t nlayer, size_t capacity, size_t nkvh, size_t dh, llaisysDataType_t dtype,
+            llaisysDeviceType_t device_type, int device_id);
+    KVCache(KVCache &&) = default;
+    KVCache &operator=(KVCache &&) = default;
+    ~KVCache() = default;
+
+    size_t nlayer() const;
+    size_t capacity() const;
+    size_t length() const;
+    // Shrinking the length rolls back the cache; rows beyond it are overwritten by later writes. A streaming
+    // cache can only be cleared.
+    void setLength(size_t length);
+
+    // Streaming mode (StreamingLLM) keeps the first `sinks` rows plus a ring of the most recent
+    // capacity - sinks rows, so a sequence can grow without bound. Clears the cache.
+    void setStreaming(bool enabled, size_t sinks);
+    bool streaming() const;
+    size_t sinks() const;
+    // Streaming mode: takes rows for `ntoken` new tokens, evicting the oldest window rows when full, and
+    // writes their slot indices to `slots`.
+    void append(size_t ntoken, std::vector<size_t> &slots);
+    // Streaming mode: the position of each of the first `length()` slots among the retained tokens, i.e.
+    // sinks first and then the window from oldest to newest. New tokens always take the largest positions.
+    const std::vector<int64_t> &slotPositions() const;
+
+    // Heavy-hitter mode (H2O) bounds every KV head to `budget` rows by evicting, per layer and head, the
+    // tokens that have received the least attention, except the `recent` newest. Heads then hold different
+    // tokens, so each row carries its own position. Clears the cache.
+    void setHeavyHitter(bool enabled, size_t budget, size_t recent);
+    bool heavyHitter() const;
+    size_t budget() const;
+    // Heavy-hitter mode: gives the next `ntoken` rows the positions `pos` in every head and clears their mass.
+    void prepareRows(const int64_t *pos, size_t ntoken);
+    // Heavy-hitter mode: per-head positions and accumulated attention mass of each row.
+    tensor_t positions(size_t layer) const;
+    tensor_t attentionMass(size_t layer) const;
+    // Heavy-hitter mode: shrinks the cache to the budget.
+    void evict();
+
+    // Whether rows are dropped to make room: the sequence is then unbounded but cannot be rolled back.
+    bool evicts() const;
+    const KVEvictionStats &evictionStats() const;
+
+    // Bytes of one token row of one layer's keys (or values).
+    size_t rowBytes() const;
+
+    tensor_t keys(size_t layer) const;
+    tensor_t values(size_t layer) const;
+};
+} // namespace llaisys::models
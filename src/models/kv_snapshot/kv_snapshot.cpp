@@ -0,0 +1,258 @@
+#include "kv_snapshot.hpp"
+
+#include "../../core/llaisys_core.hpp"
+#include "../../utils.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+constexpr char SNAPSHOT_MAGIC[8] = {'L', 'L', 'A', 'I', 'S', 'K', 'V', '\0'};
+constexpr uint32_t SNAPSHOT_VERSION = 1;
+
+enum SnapshotFormat : uint32_t {
+    SNAPSHOT_RAW = 0,
+    SNAPSHOT_INT8 = 1,
+};
+
+struct SnapshotHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t format;
+    uint32_t dtype; // dtype of raw rows
+    uint32_t reserved;
+    uint64_t nlayer, nkvh, dh, ntoken;
+};
+
+// Read-only view of a whole file. Maps it where the platform allows, otherwise reads it into memory.
+class MappedFile {
+private:
+    const std::byte *_data;
+    size_t _size;
+#ifdef _WIN32
+    std::vector<std::byte> _buffer;
+#endif
+
+public:
+    explicit MappedFile(const std::string &path) : _data(nullptr), _size(0) {
+#ifdef _WIN32
+        std::ifstream file(path, std::ios::binary | std::ios::ate);
+        CHECK_ARGUMENT(file.good(), "kv_snapshot: cannot open file");
+        _buffer.resize(static_cast<size_t>(file.tellg()));
+        file.seekg(0);
+        file.read(reinterpret_cast<char *>(_buffer.data()), _buffer.size());
+        _data = _buffer.data();
+        _size = _buffer.size();
+#else
+        int fd = ::open(path.c_str(), O_RDONLY);
+        CHECK_ARGUMENT(fd >= 0, "kv_snapshot: cannot open file");
+        struct stat st;
+        if (::fstat(fd, &st) != 0 || st.st_size == 0) {
+            ::close(fd);
+            CHECK_ARGUMENT(false, "kv_snapshot: empty or unreadable file");
+        }
+        _size = static_cast<size_t>(st.st_size);
+        void *data = ::mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        ASSERT(data != MAP_FAILED, "kv_snapshot: mmap failed");
+        ::madvise(data, _size, MADV_SEQUENTIAL);
+        _data = static_cast<const std::byte *>(data);
+#endif
+    }
+
+    ~MappedFile() {
+#ifndef _WIN32
+        ::munmap(const_cast<std::byte *>(_data), _size);
+#endif
+    }
+
+    const std::byte *data() const {
+        return _data;
+    }
+
+    size_t size() const {
+        return _size;
+    }
+};
+
+size_t rowsBytes(const SnapshotHeader &header, size_t element_size) {
+    size_t row = header.nkvh * header.dh;
+    if (header.format == SNAPSHOT_INT8) {
+        return header.ntoken * (header.nkvh * sizeof(float) + row);
+    }
+    return header.ntoken * row * element_size;
+}
+
+// Scales are copied with memcpy since the mapped file gives them no alignment guarantee.
+template <typename T>
+void quantize_(std::byte *out, const T *rows, size_t nrow, size_t dh) {
+    auto data = reinterpret_cast<int8_t *>(out + nrow * sizeof(float));
+    for (size_t r = 0; r < nrow; ++r) {
+        const T *row = rows + r * dh;
+        float amax = 0.0f;
+        for (size_t d = 0; d < dh; ++d) {
+            amax = std::max(amax, std::fabs(llaisys::utils::cast<float>(row[d])));
+        }
+        float scale = amax / 127.0f;
+        float inv_scale = scale > 0.0f ? 1.0f / scale : 0.0f;
+        std::memcpy(out + r * sizeof(float), &scale, sizeof(float));
+        for (size_t d = 0; d < dh; ++d) {
+            float q = std::nearbyint(llaisys::utils::cast<float>(row[d]) * inv_scale);
+            data[r * dh + d] = static_cast<int8_t>(std::clamp(q, -127.0f, 127.0f));
+        }
+    }
+}
+
+template <typename T>
+void dequantize_(T *rows, const std::byte *in, size_t nrow, size_t dh) {
+    auto data = reinterpret_cast<const int8_t *>(in + nrow * sizeof(float));
+    for (size_t r = 0; r < nrow; ++r) {
+        float scale;
+        std::memcpy(&scale, in + r * sizeof(float), sizeof(float));
+        for (size_t d = 0; d < dh; ++d) {
+            rows[r * dh + d] = llaisys::utils::cast<T>(scale * static_cast<float>(data[r * dh + d]));
+        }
+    }
+}
+
+// `nrow` rows of `dh` elements, one per token and KV head.
+void quantize(std::byte *out, const std::byte *rows, llaisysDataType_t type, size_t nrow, size_t dh) {
+    switch (type) {
+    case LLAISYS_DTYPE_F32:
+        return quantize_(out, reinterpret_cast<const float *>(rows), nrow, dh);
+    case LLAISYS_DTYPE_BF16:
+        return quantize_(out, reinterpret_cast<const llaisys::bf16_t *>(rows), nrow, dh);
+    case LLAISYS_DTYPE_F16:
+        return quantize_(out, reinterpret_cast<const llaisys::fp16_t *>(rows), nrow, dh);
+    default:
+        EXCEPTION_UNSUPPORTED_DATATYPE(type);
+    }
+}
+
+void dequantize(std::byte *rows, const std::byte *in, llaisysDataType_t type, size_t nrow, size_t dh) {
+    switch (type) {
+    case LLAISYS_DTYPE_F32:
+        return dequantize_(reinterpret_cast<float *>(rows), in, nrow, dh);
+    case LLAISYS_DTYPE_BF16:
+        return dequantize_(reinterpret_cast<llaisys::bf16_t *>(rows), in, nrow, dh);
+    case LLAISYS_DTYPE_F16:
+        return dequantize_(reinterpret_cast<llaisys::fp16_t *>(rows), in, nrow, dh);
+    default:
+        EXCEPTION_UNSUPPORTED_DATATYPE(type);
+    }
+}
+} // namespace
+
+namespace llaisys::models {
+size_t kvSnapshotBytes(size_t ntoken, const KVCache &cache, bool quantize) {
+    auto keys = cache.keys(0);
+    SnapshotHeader header{};
+    header.format = quantize ? SNAPSHOT_INT8 : SNAPSHOT_RAW;
+    header.nkvh = keys->shape()[1];
+    header.dh = keys->shape()[2];
+    header.ntoken = ntoken;
+    return sizeof(header) + ntoken * sizeof(int64_t) + 2 * cache.nlayer() * rowsBytes(header, keys->elementSize());
+}
+
+void writeKVSnapshot(const std::function<void(const void *, size_t)> &write, const int64_t *tokens, size_t ntoken,
+                     const KVCache &cache, bool quantize) {
+    CHECK_ARGUMENT(ntoken <= cache.length(), "kv_snapshot: tokens exceed cached rows");
+    auto keys = cache.keys(0);
+    SnapshotHeader header{};
+    std::memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+    header.version = SNAPSHOT_VERSION;
+    header.format = quantize ? SNAPSHOT_INT8 : SNAPSHOT_RAW;
+    header.dtype = keys->dtype();
+    header.nlayer = cache.nlayer();
+    header.nkvh = keys->shape()[1];
+    header.dh = keys->shape()[2];
+    header.ntoken = ntoken;
+    write(&header, sizeof(header));
+    write(tokens, ntoken * sizeof(int64_t));
+
+    core::context().setDevice(keys->deviceType(), keys->deviceId());
+    auto api = core::context().runtime().api();
+    std::vector<std::byte> rows(ntoken * cache.rowBytes());
+    std::vector<std::byte> packed(quantize ? rowsBytes(header, 0) : 0);
+    for (size_t l = 0; l < cache.nlayer(); ++l) {
+        for (const auto &tensor : {cache.keys(l), cache.values(l)}) {
+            api->memcpy_sync(rows.data(), tensor->data(), rows.size(), LLAISYS_MEMCPY_D2H);
+            if (quantize) {
+                ::quantize(packed.data(), rows.data(), keys->dtype(), ntoken * header.nkvh, header.dh);
+                write(packed.data(), packed.size());
+            } else {
+                write(rows.data(), rows.size());
+            }
+        }
+    }
+}
+
+std::vector<int64_t> readKVSnapshot(const std::byte *data, size_t size, KVCache &cache) {
+    CHECK_ARGUMENT(size >= sizeof(SnapshotHeader), "kv_snapshot: truncated file");
+    SnapshotHeader header;
+    std::memcpy(&header, data, sizeof(header));
+    CHECK_ARGUMENT(std::memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) == 0,
+                   "kv_snapshot: not a snapshot file");
+    CHECK_ARGUMENT(header.version == SNAPSHOT_VERSION, "kv_snapshot: unsupported version");
+    CHECK_ARGUMENT(header.format == SNAPSHOT_RAW || header.format == SNAPSHOT_INT8, "kv_snapshot: unknown format");
+
+    auto keys = cache.keys(0);
+    llaisysDataType_t dtype = keys->dtype();
+    CHECK_ARGUMENT(header.nlayer == cache.nlayer() && header.nkvh == keys->shape()[1] && header.dh == keys->shape()[2],
+                   "kv_snapshot: snapshot does not match the model");
+    CHECK_ARGUMENT(header.format == SNAPSHOT_INT8 || header.dtype == static_cast<uint32_t>(dtype),
+                   "kv_snapshot: snapshot dtype does not match the cache");
+    CHECK_ARGUMENT(header.ntoken <= cache.capacity(), "kv_snapshot: snapshot exceeds the cache capacity");
+
+    size_t ntoken = header.ntoken;
+    size_t layer_bytes = rowsBytes(header, keys->elementSize());
+    size_t expected = sizeof(header) + ntoken * sizeof(int64_t) + 2 * header.nlayer * layer_bytes;
+    CHECK_ARGUMENT(size == expected, "kv_snapshot: file size does not match its header");
+
+    const std::byte *ptr = data + sizeof(header);
+    std::vector<int64_t> tokens(ntoken);
+    std::memcpy(tokens.data(), ptr, ntoken * sizeof(int64_t));
+    ptr += ntoken * sizeof(int64_t);
+
+    core::context().setDevice(keys->deviceType(), keys->deviceId());
+    auto api = core::context().runtime().api();
+    std::vector<std::byte> rows(header.format == SNAPSHOT_INT8 ? ntoken * cache.rowBytes() : 0);
+    for (size_t l = 0; l < cache.nlayer(); ++l) {
+        for (const auto &tensor : {cache.keys(l), cache.values(l)}) {
+            // Raw rows go straight from the mapping to the cache.
+            const std::byte *src = ptr;
+            if (header.format == SNAPSHOT_INT8) {
+                dequantize(rows.data(), ptr, dtype, ntoken * header.nkvh, header.dh);
+                src = rows.data();
+            }
+            api->memcpy_sync(tensor->data(), src, ntoken * cache.rowBytes(), LLAISYS_MEMCPY_H2D);
+            ptr += layer_bytes;
+        }
+    }
+    cache.setLength(ntoken);
+    return tokens;
+}
+
+void saveKVSnapshot(const std::string &path, const int64_t *tokens, size_t ntoken, const KVCache &cache,
+                    bool quantize) {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    CHECK_ARGUMENT(file.good(), "kv_snapshot: cannot create file");
+    writeKVSnapshot([&](const void *data, size_t size) { file.write(static_cast<const char *>(data), size); },
+                    tokens, ntoken, cache, quantize);
+    ASSERT(file.good(), "kv_snapshot: write failed");
+}
+
+std::vector<int64_t> loadKVSnapshot(const std::string &path, KVCache &cache) {
+    MappedFile file(path);
+    return readKVSnapshot(file.data(), file.size(), cache);
+}
+} // namespace llaisys::models
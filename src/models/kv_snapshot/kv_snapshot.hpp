@@ -0,0 +1,32 @@
+#pragma once
+
+#include "../kv_cache/kv_cache.hpp"
+
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace llaisys::models {
+// Session snapshots: the tokens of a sequence and the KV rows that belong to them, written to a flat file
+// that is memory-mapped on restore. Rows are stored either in the cache's own dtype or as int8 with one
+// float scale per token and KV head.
+//
+// Layout: header, int64 tokens[ntoken], then per layer the keys followed by the values. Quantized rows
+// store float scales[ntoken, nkvh] before int8 data[ntoken, nkvh, dh].
+
+// Size in bytes of a snapshot of `ntoken` rows of `cache`.
+size_t kvSnapshotBytes(size_t ntoken, const KVCache &cache, bool quantize);
+// Encodes a snapshot of `tokens` and the first `ntoken` rows of `cache`, passing it to `write` piece by piece.
+void writeKVSnapshot(const std::function<void(const void *, size_t)> &write, const int64_t *tokens, size_t ntoken,
+                     const KVCache &cache, bool quantize);
+// Decodes a snapshot held in memory into `cache`; see loadKVSnapshot.
+std::vector<int64_t> readKVSnapshot(const std::byte *data, size_t size, KVCache &cache);
+
+// Writes `tokens` and the first `ntoken` rows of every layer of `cache` to `path`.
+void saveKVSnapshot(const std::string &path, const int64_t *tokens, size_t ntoken, const KVCache &cache,
+                    bool quantize);
+
+// Copies a snapshot into the first rows of `cache`, sets its length and returns the snapshot's tokens.
+// The cache must have the same number of layers and KV heads, and the same head size.
+std::vector<int64_t> loadKVSnapshot(const std::string &path, KVCache &cache);
+} // namespace llaisys::models
@@ -0,0 +1,201 @@
+#include "prefix_cache.hpp"
+
+#include "../../core/llaisys_core.hpp"
+#include "../../utils.hpp"
+
+#include <algorithm>
+
+namespace llaisys::models {
+PrefixCache::PrefixCache(size_t capacity_tokens, size_t nlayer, size_t nkvh, size_t dh, llaisysDataType_t dtype,
+                         llaisysDeviceType_t device_type, int device_id)
+    : _capacity(capacity_tokens), _nlayer(nlayer), _row_elems(nkvh * dh), _dtype(dtype), _device_type(device_type),
+      _device_id(device_id), _root(new Node{{}, nullptr, nullptr, {}, 0, 0}), _clock(0), _stats{} {
+    CHECK_ARGUMENT(capacity_tokens > 0, "prefix_cache: capacity must be positive");
+}
+
+void PrefixCache::_touch(Node *node) {
+    uint64_t now = ++_clock;
+    for (; node != nullptr && node != _root.get(); node = node->parent) {
+        node->last_access = now;
+    }
+}
+
+void PrefixCache::_copyRows(const KVCache &cache, size_t cache_row, Node *node, size_t node_row, size_t count,
+                            bool to_cache) {
+    size_t row_bytes = cache.rowBytes();
+    size_t elem_size = node->kv->elementSize();
+    const auto &strides = node->kv->strides();
+    auto api = core::context().runtime().api();
+    for (size_t l = 0; l < _nlayer; ++l) {
+        for (size_t kv = 0; kv < 2; ++kv) {
+            std::byte *node_ptr = node->kv->data() + (l * strides[0] + kv * strides[1] + node_row * strides[2]) * elem_size;
+            std::byte *cache_ptr = (kv == 0 ? cache.keys(l) : cache.values(l))->data() + cache_row * row_bytes;
+            if (to_cache) {
+                api->memcpy_sync(cache_ptr, node_ptr, count * row_bytes, LLAISYS_MEMCPY_D2D);
+            } else {
+                api->memcpy_sync(node_ptr, cache_ptr, count * row_bytes, LLAISYS_MEMCPY_D2D);
+            }
+        }
+    }
+}
+
+// Splits `node` so that its first `at` tokens move into a new parent. The original node keeps the suffix,
+// which leaves pins held on it (and on its descendants) valid. Both halves are copied into storage of their
+// own: were they views of one storage, evicting either would free nothing while the other lives.
+void PrefixCache::_split(Node *node, size_t at) {
+    Node *parent = node->parent;
+    auto mid = std::unique_ptr<Node>(new Node{
+        std::vector<int64_t>(node->tokens.begin(), node->tokens.begin() + at),
+        node->kv->slice(2, 0, at)->contiguous(),
+        parent,
+        {},
+        node->ref_count,
+        node->last_access});
+    auto suffix = node->kv->slice(2, at, node->kv->shape()[2])->contiguous();
+    _stats.cached_bytes += mid->kv->storage()->size() + suffix->storage()->size();
+    _stats.cached_bytes -= node->kv->storage()->size();
+
+    auto &slot = parent->children[mid->tokens[0]];
+    std::unique_ptr<Node> owned = std::move(slot);
+    node->tokens.erase(node->tokens.begin(), node->tokens.begin() + at);
+    node->kv = suffix;
+    node->parent = mid.get();
+    mid->children[node->tokens[0]] = std::move(owned);
+    slot = std::move(mid);
+}
+
+void PrefixCache::_evict() {
+    while (_stats.cached_tokens > _capacity) {
+        Node *victim = nullptr;
+        std::vector<Node *> stack{_root.get()};
+        while (!stack.empty()) {
+            Node *node = stack.back();
+            stack.pop_back();
+            for (auto &child : node->children) {
+                stack.push_back(child.second.get());
+            }
+            if (node == _root.get() || !node->children.empty() || node->ref_count > 0) {
+                continue;
+            }
+            if (victim == nullptr || node->last_access < victim->last_access) {
+                victim = node;
+            }
+        }
+        if (victim == nullptr) {
+            return; // everything left is pinned by live sequences
+        }
+        _stats.cached_tokens -= victim->tokens.size();
+        _stats.cached_bytes -= victim->kv->storage()->size();
+        _stats.evicted_tokens += victim->tokens.size();
+        victim->parent->children.erase(victim->tokens[0]);
+    }
+}
+
+size_t PrefixCache::restore(const int64_t *tokens, size_t ntoken, KVCache &cache, Node *&pinned) {
+    core::context().setDevice(_device_type, _device_id);
+    size_t limit = ntoken > 0 ? ntoken - 1 : 0;
+    size_t matched = 0;
+    Node *node = _root.get();
+    Node *last = nullptr;
+    while (matched < limit) {
+        auto it = node->children.find(tokens[matched]);
+        if (it == node->children.end()) {
+            break;
+        }
+        Node *child = it->second.get();
+        size_t max_len = std::min(child->tokens.size(), limit - matched);
+        size_t len = 0;
+        while (len < max_len && child->tokens[len] == tokens[matched + len]) {
+            ++len;
+        }
+        _copyRows(cache, matched, child, 0, len, true);
+        matched += len;
+        last = child;
+        if (len < child->tokens.size()) {
+            break;
+        }
+        node = child;
+    }
+    cache.setLength(matched);
+
+    if (last != nullptr) {
+        for (Node *n = last; n != _root.get(); n = n->parent) {
+            ++n->ref_count;
+        }
+        _touch(last);
+        ++_stats.hits;
+        _stats.hit_tokens += matched;
+    } else {
+        ++_stats.misses;
+    }
+    _stats.miss_tokens += ntoken - matched;
+    pinned = last;
+    return matched;
+}
+
+PrefixCache::Node *PrefixCache::insert(const int64_t *tokens, size_t ntoken, const KVCache &cache) {
+    CHECK_ARGUMENT(ntoken <= cache.length(), "prefix_cache: tokens exceed cached rows");
+    core::context().setDevice(_device_type, _device_id);
+    ntoken = std::min(ntoken, _capacity);
+    if (ntoken == 0) {
+        return nullptr;
+    }
+
+    Node *node = _root.get();
+    size_t i = 0;
+    while (i < ntoken) {
+        auto it = node->children.find(tokens[i]);
+        if (it == node->children.end()) {
+            size_t len = ntoken - i;
+            auto leaf = std::unique_ptr<Node>(new Node{
+                std::vector<int64_t>(tokens + i, tokens + ntoken),
+                Tensor::create({_nlayer, 2, len, _row_elems}, _dtype, _device_type, _device_id),
+                node,
+                {},
+                0,
+                0});
+            _copyRows(cache, i, leaf.get(), 0, len, false);
+            _stats.cached_tokens += len;
+            _stats.cached_bytes += leaf->kv->storage()->size();
+            Node *raw = leaf.get();
+            node->children[tokens[i]] = std::move(leaf);
+            node = raw;
+            break;
+        }
+        Node *child = it->second.get();
+        size_t max_len = std::min(child->tokens.size(), ntoken - i);
+        size_t len = 0;
+        while (len < max_len && child->tokens[len] == tokens[i + len]) {
+            ++len;
+        }
+        if (len < child->tokens.size()) {
+            _split(child, len);
+            child = child->parent;
+        }
+        node = child;
+        i += len;
+    }
+
+    for (Node *n = node; n != _root.get(); n = n->parent) {
+        ++n->ref_count;
+    }
+    _touch(node);
+    _evict();
+    return node;
+}
+
+void PrefixCache::release(Node *node) {
+    for (; node != nullptr && node != _root.get(); node = node->parent) {
+        ASSERT(node->ref_count > 0, "prefix_cache: releasing an unpinned node");
+        --node->ref_count;
+    }
+}
+
+size_t PrefixCache::capacity() const {
+    return _capacity;
+}
+
+const PrefixCache::Stats &PrefixCache::stats() const {
+    return _stats;
+}
+} // namespace llaisys::models
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "../kv_cache/kv_cache.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace llaisys::models {
+// Radix tree over token-id sequences. Each edge owns the KV rows of its tokens for every layer, so a new
+// sequence whose prompt shares a cached prefix only has to prefill the unique suffix.
+//
+// Nodes are reference counted: a live sequence pins the path it restored from or inserted, and only
+// unpinned leaves are evicted (least recently used first) once the cached token count exceeds capacity.
+class PrefixCache {
+public:
+    struct Node {
+        std::vector<int64_t> tokens;
+        // [nlayer, 2, tokens.size(), nkvh * dh]: keys at [l, 0], values at [l, 1].
+        tensor_t kv;
+        Node *parent;
+        std::unordered_map<int64_t, std::unique_ptr<Node>> children;
+        size_t ref_count;
+        uint64_t last_access;
+    };
+
+    struct Stats {
+        uint64_t hits;           // lookups that reused at least one token
+        uint64_t misses;         // lookups that reused nothing
+        uint64_t hit_tokens;     // prompt tokens restored from the cache
+        uint64_t miss_tokens;    // prompt tokens that still had to be prefilled
+        uint64_t cached_tokens;  // tokens currently held by the tree
+        uint64_t evicted_tokens; // tokens dropped by LRU eviction
+        uint64_t cached_bytes;   // KV storage held by the tree; every node owns the storage of its rows
+    };
+
+private:
+    size_t _capacity;
+    size_t _nlayer;
+    size_t _row_elems;
+    llaisysDataType_t _dtype;
+    llaisysDeviceType_t _device_type;
+    int _device_id;
+    std::unique_ptr<Node> _root;
+    uint64_t _clock;
+    Stats _stats;
+
+    void _touch(Node *node);
+    void _split(Node *node, size_t at);
+    void _evict();
+    void _copyRows(const KVCache &cache, size_t cache_row, Node *node, size_t node_row, size_t count, bool to_cache);
+
+public:
+    PrefixCache(size_t capacity_tokens, size_t nlayer, size_t nkvh, size_t dh, llaisysDataType_t dtype,
+                llaisysDeviceType_t device_type, int device_id);
+    ~PrefixCache() = default;
+
+    // Copies the KV rows of the longest cached prefix of `tokens` into rows [0, n) of `cache` and returns n.
+    // At least one prompt token is always left for the caller to compute so that logits are produced.
+    // The matched node is pinned and returned through `pinned` (nullptr on a miss).
+    size_t restore(const int64_t *tokens, size_t ntoken, KVCache &cache, Node *&pinned);
+
+    // Inserts `tokens`, whose KV rows are rows [0, ntoken) of `cache`, and returns the pinned leaf.
+    Node *insert(const int64_t *tokens, size_t ntoken, const KVCache &cache);
+
+    // Drops a pin obtained from restore() or insert().
+    void release(Node *node);
+
+    size_t capacity() const;
+    const Stats &stats() const;
+};
+} // namespace llaisys::models
@@ -0,0 +1,652 @@
+#include "qwen2.hpp"
+
+#include "../../core/llaisys_core.hpp"
+#include "../../utils.hpp"
+
+#include "../../ops/add/op.hpp"
+#include "../../ops/argmax/op.hpp"
+#include "../../ops/embedding/op.hpp"
+#include "../../ops/linear/op.hpp"
+#include "../../ops/rearrange/op.hpp"
+#include "../../ops/rms_norm/op.hpp"
+#include "../../ops/rope/op.hpp"
+#include "../../ops/self_attention/op.hpp"
+#include "../../ops/swiglu/op.hpp"
+
+#include "../speculative/ngram_proposer.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <numeric>
+
+namespace llaisys::models {
+Qwen2::Qwen2(const LlaisysQwen2Meta &meta, llaisysDeviceType_t device_type, int device_id)
+    : _meta(meta), _device_type(device_type), _device_id(device_id),
+      _cache(meta.nlayer, meta.maxseq, meta.nkvh, meta.dh, meta.dtype, device_type, device_id),
+      _prefix_node(nullptr), _session(0), _workspace(0), _graph_enabled(true), _spec_stats{}, _draft(nullptr) {
+    CHECK_ARGUMENT(meta.nlayer > 0, "qwen2: nlayer must be positive");
+    CHECK_ARGUMENT(meta.nh > 0 && meta.nkvh > 0 && meta.nh % meta.nkvh == 0,
+                   "qwen2: nh must be a multiple of nkvh");
+
+    size_t hs = meta.hs, dq = meta.nh * meta.dh, dkv = meta.nkvh * meta.dh, di = meta.di;
+    auto create = [&](const std::vector<size_t> &shape) {
+        return Tensor::create(shape, meta.dtype, device_type, device_id);
+    };
+
+    _weights.in_embed = create({meta.voc, hs});
+    _weights.out_embed = create({meta.voc, hs});
+    _weights.out_norm_w = create({hs});
+    for (size_t i = 0; i < meta.nlayer; ++i) {
+        _weights.attn_norm_w.push_back(create({hs}));
+        auto qkv_w = create({dq + 2 * dkv, hs});
+        auto qkv_b = create({dq + 2 * dkv});
+        _weights.attn_qkv_w.push_back(qkv_w);
+        _weights.attn_qkv_b.push_back(qkv_b);
+        _weights.attn_q_w.push_back(qkv_w->slice(0, 0, dq));
+        _weights.attn_q_b.push_back(qkv_b->slice(0, 0, dq));
+        _weights.attn_k_w.push_back(qkv_w->slice(0, dq, dq + dkv));
+        _weights.attn_k_b.push_back(qkv_b->slice(0, dq, dq + dkv));
+        _weights.attn_v_w.push_back(qkv_w->slice(0, dq + dkv, dq + 2 * dkv));
+        _weights.attn_v_b.push_back(qkv_b->slice(0, dq + dkv, dq + 2 * dkv));
+        _weights.attn_o_w.push_back(create({hs, dq}));
+        _weights.mlp_norm_w.push_back(create({hs}));
+        _weights.mlp_gate_w.push_back(create({di, hs}));
+        _weights.mlp_up_w.push_back(create({di, hs}));
+        _weights.mlp_down_w.push_back(create({hs, di}));
+    }
+
+    _max_val = create({1});
+    _max_idx = Tensor::create({1}, LLAISYS_DTYPE_I64, device_type, device_id);
+}
+
+Qwen2::~Qwen2() {
+    _releasePrefix();
+}
+
+const LlaisysQwen2Meta &Qwen2::meta() const {
+    return _meta;
+}
+
+Qwen2Weights &Qwen2::weights() {
+    return _weights;
+}
+
+void Qwen2::_reserve(size_t ntoken, size_t nlogits) {
+    auto create = [&](const std::vector<size_t> &shape, llaisysDataType_t dtype) {
+        return Tensor::create(shape, dtype, _device_type, _device_id);
+    };
+    if (_logits == nullptr || _logits->shape()[0] < nlogits) {
+        _logits = create({nlogits, _meta.voc}, _meta.dtype);
+        _decode_graph.clear();
+    }
+    if (ntoken <= _workspace) {
+        return;
+    }
+    _decode_graph.clear();
+    _input_ids = create({ntoken}, LLAISYS_DTYPE_I64);
+    _pos_ids = create({ntoken}, LLAISYS_DTYPE_I64);
+    _x = create({ntoken, _meta.hs}, _meta.dtype);
+    _h = create({ntoken, _meta.hs}, _meta.dtype);
+    _qkv = create({ntoken, (_meta.nh + 2 * _meta.nkvh) * _meta.dh}, _meta.dtype);
+    _attn = create({ntoken, _meta.nh * _meta.dh}, _meta.dtype);
+    _gate = create({ntoken, _meta.di}, _meta.dtype);
+    _up = create({ntoken, _meta.di}, _meta.dtype);
+    _workspace = ntoken;
+}
+
+void Qwen2::_scatterRows(tensor_t cache, tensor_t rows, const std::vector<size_t> &slots) {
+    size_t row_bytes = _cache.rowBytes();
+    size_t pitch = rows->strides()[0] * rows->elementSize();
+    auto api = core::context().runtime().api();
+    for (size_t i = 0; i < slots.size();) {
+        // Slots are consecutive except where the window ring wraps; dense source rows go in one copy.
+        size_t n = 1;
+        while (pitch == row_bytes && i + n < slots.size() && slots[i + n] == slots[i] + n) {
+            ++n;
+        }
+        api->memcpy_sync(cache->data() + slots[i] * row_bytes, rows->data() + i * pitch, n * row_bytes,
+                         LLAISYS_MEMCPY_D2D);
+        i += n;
+    }
+}
+
+void Qwen2::_layers(size_t ntoken, size_t nlogits, size_t past) {
+    bool streaming = _cache.streaming();
+    bool heavy_hitter = _cache.heavyHitter();
+    size_t kv_len = past + ntoken;
+    size_t nh = _meta.nh, nkvh = _meta.nkvh, dh = _meta.dh;
+    auto input_ids = _input_ids->slice(0, 0, ntoken);
+    auto pos_ids = _pos_ids->slice(0, 0, ntoken);
+    auto x = _x->slice(0, 0, ntoken);
+    auto h = _h->slice(0, 0, ntoken);
+    // Q, K and V are column slices of the fused projection; the ops read them through their row stride.
+    auto qkv = _qkv->slice(0, 0, ntoken);
+    auto q = qkv->slice(1, 0, nh * dh);
+    auto k = qkv->slice(1, nh * dh, (nh + nkvh) * dh);
+    auto v = qkv->slice(1, (nh + nkvh) * dh, (nh + 2 * nkvh) * dh);
+    auto attn = _attn->slice(0, 0, ntoken);
+    auto gate = _gate->slice(0, 0, ntoken);
+    auto up = _up->slice(0, 0, ntoken);
+    auto q_heads = q->reshape({ntoken, nh, dh});
+    auto k_heads = k->reshape({ntoken, nkvh, dh});
+    auto v_heads = v->reshape({ntoken, nkvh, dh});
+    auto attn_heads = attn->view({ntoken, nh, dh});
+    float scale = 1.0f / std::sqrt(static_cast<float>(dh));
+
+    ops::embedding(x, input_ids, _weights.in_embed);
+    for (size_t l = 0; l < _meta.nlayer; ++l) {
+        auto k_cache = _cache.keys(l);
+        auto v_cache = _cache.values(l);
+
+        ops::rms_norm(h, x, _weights.attn_norm_w[l], _meta.epsilon);
+        ops::linear(qkv, h, _weights.attn_qkv_w[l], _weights.attn_qkv_b[l]);
+        ops::rope(q_heads, q_heads, pos_ids, _meta.theta);
+        if (streaming) {
+            // Self attention over ring slots. Keys are cached before RoPE, since eviction shifts the positions
+            // of the window, and rotated by their current position on every step.
+            _scatterRows(k_cache, k, _slots);
+            _scatterRows(v_cache, v, _slots);
+            auto k_rot = _k_rot->slice(0, 0, kv_len);
+            auto slot_pos = _slot_pos->slice(0, 0, kv_len);
+            ops::rope(k_rot, k_cache->slice(0, 0, kv_len), slot_pos, _meta.theta);
+            ops::self_attention(attn_heads, q_heads, k_rot, v_cache->slice(0, 0, kv_len), scale, pos_ids, slot_pos);
+        } else if (heavy_hitter) {
+            // Self attention. New keys are rotated straight into the cache. Heads have evicted different tokens;
+            // accumulate the attention each row receives.
+            ops::rearrange(v_cache->slice(0, past, kv_len), v_heads);
+            ops::rope(k_cache->slice(0, past, kv_len), k_heads, pos_ids, _meta.theta);
+            ops::self_attention(attn_heads, q_heads, k_cache->slice(0, 0, kv_len), v_cache->slice(0, 0, kv_len),
+                                scale, pos_ids, _cache.positions(l)->slice(0, 0, kv_len),
+                                _cache.attentionMass(l)->slice(0, 0, kv_len));
+        } else {
+            // Self attention. New keys are rotated straight into the cache. The rows written and read depend on
+            // the cache length, so a captured step looks them up again on every replay.
+            ops::hostNode([this, l, q_heads, k_heads, v_heads, attn_heads, pos_ids, scale] {
+                size_t past = _cache.length(), kv_len = past + q_heads->shape()[0];
+                auto k_cache = _cache.keys(l);
+                auto v_cache = _cache.values(l);
+                ops::rearrange(v_cache->slice(0, past, kv_len), v_heads);
+                ops::rope(k_cache->slice(0, past, kv_len), k_heads, pos_ids, _meta.theta);
+                ops::self_attention(attn_heads, q_heads, k_cache->slice(0, 0, kv_len), v_cache->slice(0, 0, kv_len),
+                                    scale);
+            });
+        }
+        ops::linear(h, attn, _weights.attn_o_w[l], nullptr);
+        ops::add(x, x, h);
+
+        // MLP
+        ops::rms_norm(h, x, _weights.mlp_norm_w[l], _meta.epsilon);
+        // Gate and up are independent GEMMs; at one token neither fills the pool alone, so they run together.
+        utils::TaskGraph projections;
+        projections.add([&] { ops::linear(gate, h, _weights.mlp_gate_w[l], nullptr); });
+        projections.add([&] { ops::linear(up, h, _weights.mlp_up_w[l], nullptr); });
+        ops::runTasks(projections);
+        ops::swiglu(gate, gate, up);
+        ops::linear(h, gate, _weights.mlp_down_w[l], nullptr);
+        ops::add(x, x, h);
+    }
+    // Only the trailing positions are needed for next-token prediction.
+    auto x_last = x->slice(0, ntoken - nlogits, ntoken);
+    auto h_last = h->slice(0, ntoken - nlogits, ntoken);
+    ops::rms_norm(h_last, x_last, _weights.out_norm_w, _meta.epsilon);
+    ops::linear(_logits->slice(0, 0, nlogits), h_last, _weights.out_embed, nullptr);
+}
+
+void Qwen2::_forward(const int64_t *token_ids, size_t ntoken, size_t nlogits) {
+    bool streaming = _cache.streaming();
+    bool heavy_hitter = _cache.heavyHitter();
+    size_t past = _cache.length();
+    if (streaming) {
+        CHECK_ARGUMENT(ntoken <= _cache.capacity() - _cache.sinks(), "qwen2: chunk exceeds the streaming window");
+    } else {
+        CHECK_ARGUMENT(past + ntoken <= _cache.capacity(), "qwen2: sequence exceeds maxseq");
+    }
+    CHECK_ARGUMENT(nlogits > 0 && nlogits <= ntoken, "qwen2: invalid number of logit rows");
+    auto start = std::chrono::steady_clock::now();
+    _reserve(ntoken, nlogits);
+    core::context().setDevice(_device_type, _device_id);
+
+    if (streaming) {
+        // Positions are taken among the retained tokens, so they stay below maxseq however long the sequence.
+        _cache.append(ntoken, _slots);
+        past = _cache.length() - ntoken;
+        _slot_pos->load(_cache.slotPositions().data());
+    }
+    size_t kv_len = past + ntoken;
+
+    auto input_ids = _input_ids->slice(0, 0, ntoken);
+    auto pos_ids = _pos_ids->slice(0, 0, ntoken);
+    std::vector<int64_t> pos(ntoken);
+    // With heavy-hitter eviction the cache holds fewer rows than the sequence has tokens.
+    std::iota(pos.begin(), pos.end(), static_cast<int64_t>(heavy_hitter ? _tokens.size() : past));
+    input_ids->load(token_ids);
+    pos_ids->load(pos.data());
+    if (heavy_hitter) {
+        _cache.prepareRows(pos.data(), ntoken);
+    }
+
+    // Plain single-token steps replay the ops captured from the first one, with only the token and position
+    // buffers reloaded in between.
+    bool replayable = _graph_enabled && ntoken == 1 && nlogits == 1 && !streaming && !heavy_hitter;
+    if (replayable && _decode_graph.ready()) {
+        _decode_graph.replay();
+    } else if (replayable) {
+        ops::GraphCapture capture(_decode_graph);
+        _layers(ntoken, nlogits, past);
+        capture.finish();
+    } else {
+        _layers(ntoken, nlogits, past);
+    }
+
+    if (!streaming) {
+        _cache.setLength(kv_len);
+    }
+    if (heavy_hitter) {
+        _cache.evict();
+    }
+    _tokens.insert(_tokens.end(), token_ids, token_ids + ntoken);
+
+    if (_session_pool != nullptr && ntoken > 1 && nlogits == 1) {
+        // Prefill throughput prices recomputing a preempted session.
+        _session_pool->recordPrefill(
+            ntoken, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    }
+}
+
+void Qwen2::_prefill(const int64_t *token_ids, size_t ntoken) {
+    CHECK_ARGUMENT(ntoken > 0, "qwen2: no input tokens");
+    if (_cache.evicts()) {
+        // Chunks fit in the room left after eviction. A streaming chunk evicts as many window rows before its
+        // attention runs, so it is kept to a quarter of the window and every token still sees recent context.
+        size_t chunk = _cache.capacity() - (_cache.streaming() ? _cache.sinks() : _cache.budget());
+        if (_cache.streaming()) {
+            chunk = std::max<size_t>(std::min<size_t>(chunk / 4, 512), 1);
+        }
+        for (size_t i = 0; i < ntoken; i += chunk) {
+            _forward(token_ids + i, std::min(chunk, ntoken - i), 1);
+        }
+        return;
+    }
+    if (_prefix_cache == nullptr || !_tokens.empty()) {
+        _forward(token_ids, ntoken, 1);
+        return;
+    }
+
+    PrefixCache::Node *pinned = nullptr;
+    size_t matched = _prefix_cache->restore(token_ids, ntoken, _cache, pinned);
+    _releasePrefix();
+    _prefix_node = pinned;
+    _tokens.assign(token_ids, token_ids + matched);
+    _forward(token_ids + matched, ntoken - matched, 1);
+
+    PrefixCache::Node *node = _prefix_cache->insert(_tokens.data(), _tokens.size(), _cache);
+    _releasePrefix();
+    _prefix_node = node;
+}
+
+int64_t Qwen2::_argmax(size_t row) {
+    ops::argmax(_max_idx, _max_val, _logits->slice(0, row, row + 1)->view({_meta.voc}));
+    int64_t token = 0;
+    core::context().setDevice(_device_type, _device_id);
+    core::context().runtime().api()->memcpy_sync(&token, _max_idx->data(), sizeof(token), LLAISYS_MEMCPY_D2H);
+    return token;
+}
+
+void Qwen2::_distribution(size_t row, const SamplingParams &params) {
+    size_t row_bytes = _meta.voc * utils::dsize(_meta.dtype);
+    _host_logits.resize(row_bytes);
+    core::context().setDevice(_device_type, _device_id);
+    core::context().runtime().api()->memcpy_sync(_host_logits.data(), _logits->data() + row * row_bytes, row_bytes,
+                                                 LLAISYS_MEMCPY_D2H);
+    _sampler.distribution(_host_logits.data(), _meta.dtype, _meta.voc, params, _probs);
+}
+
+int64_t Qwen2::_sample(size_t row, const SamplingParams &params) {
+    if (Sampler::isGreedy(params)) {
+        return _argmax(row);
+    }
+    _distribution(row, params);
+    return _sampler.sample(_probs);
+}
+
+int64_t Qwen2::_verify(size_t row, int64_t draft, const SamplingParams &params,
+                       const std::vector<float> *draft_probs) {
+    // Greedy targets and drafts are point masses, so the draft survives exactly when it is the argmax.
+    if (Sampler::isGreedy(params)) {
+        return _argmax(row);
+    }
+
+    // Rejection sampling: accept with probability min(1, p(draft) / q(draft)), otherwise sample from the
+    // normalized residual max(0, p - q). Every emitted token is then distributed exactly as p.
+    _distribution(row, params);
+    auto q = [&](size_t i) {
+        return draft_probs != nullptr ? (*draft_probs)[i] : (static_cast<int64_t>(i) == draft ? 1.0f : 0.0f);
+    };
+    if (_sampler.uniform() * q(draft) < _probs[draft]) {
+        return draft;
+    }
+    float sum = 0.0f;
+    for (size_t i = 0; i < _probs.size(); ++i) {
+        _probs[i] = std::max(0.0f, _probs[i] - q(i));
+        sum += _probs[i];
+    }
+    if (sum <= 0.0f) {
+        return draft; // p == q, where rejection has probability zero
+    }
+    for (auto &p : _probs) {
+        p /= sum;
+    }
+    return _sampler.sample(_probs);
+}
+
+void Qwen2::_proposeWithDraft(const std::vector<int64_t> &history, size_t max_draft, const SamplingParams &params,
+                              std::vector<int64_t> &drafts) {
+    Qwen2 &draft = *_draft;
+    // The draft holds KV for a prefix of `history`; feed it the rest, then one row per drafted token.
+    size_t have = draft._tokens.size();
+    size_t feed = history.size() - have;
+    size_t room = draft._cache.capacity() - have;
+    if (room < feed) {
+        return;
+    }
+    max_draft = std::min(max_draft, room - feed + 1);
+    if (max_draft == 0) {
+        return;
+    }
+
+    draft._prefill(history.data() + have, feed);
+    for (size_t i = 0; i < max_draft; ++i) {
+        int64_t token;
+        if (Sampler::isGreedy(params)) {
+            token = draft._argmax(0);
+        } else {
+            draft._distribution(0, params);
+            _draft_probs[i].swap(draft._probs);
+            token = _sampler.sample(_draft_probs[i]);
+        }
+        drafts.push_back(token);
+        if (i + 1 < max_draft) {
+            draft._forward(&token, 1, 1);
+        }
+    }
+}
+
+void Qwen2::_releasePrefix() {
+    if (_prefix_cache != nullptr && _prefix_node != nullptr) {
+        _prefix_cache->release(_prefix_node);
+    }
+    _prefix_node = nullptr;
+}
+
+int64_t Qwen2::infer(const int64_t *token_ids, size_t ntoken) {
+    _prefill(token_ids, ntoken);
+    return _argmax(0);
+}
+
+tensor_t Qwen2::logits() const {
+    return _logits;
+}
+
+void Qwen2::reset() {
+    if (_prefix_cache != nullptr && !_tokens.empty()) {
+        _prefix_cache->release(_prefix_cache->insert(_tokens.data(), _tokens.size(), _cache));
+    }
+    _releasePrefix();
+    _tokens.clear();
+    _cache.setLength(0);
+}
+
+void Qwen2::truncate(size_t ntoken) {
+    CHECK_ARGUMENT(ntoken <= _tokens.size(), "qwen2: cannot truncate beyond the sequence length");
+    if (ntoken == _tokens.size()) {
+        return;
+    }
+    CHECK_ARGUMENT(!_cache.evicts(), "qwen2: a cache that evicts tokens cannot be rolled back");
+    _tokens.resize(ntoken);
+    _cache.setLength(ntoken);
+}
+
+void Qwen2::tune(const std::vector<size_t> &ntokens) {
+    for (size_t ntoken : ntokens) {
+        CHECK_ARGUMENT(ntoken > 0, "qwen2: cannot tune for 0 tokens");
+        for (auto &weight : {_weights.attn_qkv_w[0], _weights.attn_o_w[0], _weights.mlp_gate_w[0],
+                             _weights.mlp_up_w[0], _weights.mlp_down_w[0], _weights.out_embed}) {
+            ops::tuneLinear(ntoken, weight);
+        }
+    }
+}
+
+size_t Qwen2::generate(const int64_t *token_ids, size_t ntoken, const LlaisysQwen2GenerateParams &params,
+                       const std::function<bool(int64_t)> &emit) {
+    SamplingParams sampling{params.temperature, params.top_k, params.top_p};
+    // Continue the current sequence if the prompt extends it, keeping at least one token to prefill.
+    if (!_tokens.empty() && _tokens.size() < ntoken && std::equal(_tokens.begin(), _tokens.end(), token_ids)) {
+        size_t kept = _tokens.size();
+        token_ids += kept;
+        ntoken -= kept;
+    } else {
+        reset();
+    }
+    if (_draft != nullptr) {
+        _draft->reset();
+    }
+    _sampler.seed(params.seed);
+    // Evicted rows cannot be restored, so a cache that evicts decodes one token at a time.
+    bool speculate = !_cache.evicts();
+    bool use_draft = speculate && _draft != nullptr && params.num_draft > 0;
+    bool draft_sampled = use_draft && !Sampler::isGreedy(sampling);
+    if (use_draft) {
+        _draft_probs.resize(std::max(_draft_probs.size(), params.num_draft));
+    }
+
+    if (params.max_new_tokens == 0) {
+        return 0;
+    }
+    _prefill(token_ids, ntoken);
+    int64_t next = _sample(0, sampling);
+    size_t generated = 1;
+    bool stopped = !emit(next);
+
+    NgramProposer proposer(std::max<size_t>(params.ngram, 1));
+    std::vector<int64_t> history(_tokens);
+    history.push_back(next);
+    std::vector<int64_t> feed, drafts;
+    while (!stopped && generated < params.max_new_tokens && next != _meta.end_token &&
+           (_cache.evicts() || _cache.length() < _cache.capacity())) {
+        // Leave room in the cache and the output for the token sampled after the last draft.
+        size_t budget = speculate ? std::min({params.num_draft, _cache.capacity() - _cache.length() - 1,
+                                              params.max_new_tokens - generated - 1})
+                                  : 0;
+        drafts.clear();
+        if (use_draft && budget > 0) {
+            _proposeWithDraft(history, budget, sampling, drafts);
+        } else if (params.ngram > 0 && budget > 0) {
+            proposer.propose(history, budget, drafts);
+        }
+
+        size_t past = _tokens.size();
+        feed.assign(1, next);
+        feed.insert(feed.end(), drafts.begin(), drafts.end());
+        _forward(feed.data(), feed.size(), feed.size());
+
+        // Row i predicts the token after feed[i]; stop at the first draft the model disagrees with.
+        size_t accepted = 0, emitted = 0;
+        for (size_t i = 0; i <= drafts.size(); ++i) {
+            next = i < drafts.size() ? _verify(i, drafts[i], sampling, draft_sampled ? &_draft_probs[i] : nullptr)
+                                     : _sample(i, sampling);
+            history.push_back(next);
+            ++emitted;
+            bool hit = i < drafts.size() && next == drafts[i];
+            accepted += hit;
+            stopped = !emit(next);
+            if (stopped || !hit || next == _meta.end_token) {
+                break;
+            }
+        }
+        // Keep KV only for `next` and the accepted drafts; the newest token is fed on the next step.
+        truncate(past + 1 + accepted);
+        if (use_draft) {
+            _draft->truncate(std::min(_draft->_tokens.size(), past + 1 + accepted));
+        }
+
+        generated += emitted;
+        _spec_stats.decode_steps += 1;
+        _spec_stats.decode_tokens += emitted;
+        _spec_stats.drafted_tokens += drafts.size();
+        _spec_stats.accepted_tokens += accepted;
+    }
+    return generated;
+}
+
+const SpeculativeStats &Qwen2::speculativeStats() const {
+    return _spec_stats;
+}
+
+void Qwen2::setDraft(Qwen2 *draft) {
+    CHECK_ARGUMENT(draft != this, "qwen2: a model cannot draft for itself");
+    CHECK_ARGUMENT(draft == nullptr || draft->_meta.voc == _meta.voc, "qwen2: draft model vocabulary differs");
+    _draft = draft;
+}
+
+void Qwen2::saveSnapshot(const std::string &path, bool quantize) const {
+    CHECK_ARGUMENT(!_cache.evicts(), "qwen2: snapshots of a cache that evicts tokens are not supported");
+    saveKVSnapshot(path, _tokens.data(), _tokens.size(), _cache, quantize);
+}
+
+size_t Qwen2::loadSnapshot(const std::string &path) {
+    CHECK_ARGUMENT(!_cache.evicts(), "qwen2: snapshots of a cache that evicts tokens are not supported");
+    reset();
+    _tokens = loadKVSnapshot(path, _cache);
+    return _tokens.size();
+}
+
+void Qwen2::enableStreaming(bool enabled, size_t sinks) {
+    CHECK_ARGUMENT(!enabled || _prefix_cache == nullptr, "qwen2: streaming cannot be combined with a prefix cache");
+    CHECK_ARGUMENT(!enabled || _session_pool == nullptr, "qwen2: streaming cannot be combined with sessions");
+    reset();
+    _cache.setStreaming(enabled, sinks);
+    if (enabled && _k_rot == nullptr) {
+        _k_rot = Tensor::create({_meta.maxseq, _meta.nkvh, _meta.dh}, _meta.dtype, _device_type, _device_id);
+        _slot_pos = Tensor::create({_meta.maxseq}, LLAISYS_DTYPE_I64, _device_type, _device_id);
+    }
+}
+
+void Qwen2::enableHeavyHitter(bool enabled, size_t budget, size_t recent) {
+    CHECK_ARGUMENT(!enabled || _prefix_cache == nullptr,
+                   "qwen2: heavy-hitter eviction cannot be combined with a prefix cache");
+    CHECK_ARGUMENT(!enabled || _session_pool == nullptr,
+                   "qwen2: heavy-hitter eviction cannot be combined with sessions");
+    reset();
+    _cache.setHeavyHitter(enabled, budget, recent);
+}
+
+const KVEvictionStats &Qwen2::evictionStats() const {
+    return _cache.evictionStats();
+}
+
+size_t Qwen2::cachedTokens() const {
+    return _cache.length();
+}
+
+void Qwen2::enableSessions(size_t max_resident, const std::string &spill_dir, bool quantize) {
+    CHECK_ARGUMENT(max_resident == 0 || !_cache.evicts(),
+                   "qwen2: sessions cannot be combined with a cache that evicts tokens");
+    reset();
+    _session = 0;
+    _session_pool.reset();
+    if (max_resident > 0) {
+        _session_pool = std::make_unique<SessionPool>(max_resident, spill_dir, quantize);
+        _session_pool->get(_session, 0);
+    }
+}
+
+void Qwen2::selectSession(uint64_t id, int priority) {
+    CHECK_ARGUMENT(_session_pool != nullptr, "qwen2: sessions are not enabled");
+    SessionPool &pool = *_session_pool;
+    if (id == _session) {
+        pool.get(id, priority);
+        return;
+    }
+    auto &current = pool.at(_session);
+    auto known = pool.find(id);
+
+    // Park the current sequence; its KV cache stays resident unless it loses to the target below.
+    _releasePrefix();
+    current.tokens.swap(_tokens);
+    current.cache = std::make_unique<KVCache>(std::move(_cache));
+
+    // Every resident session holds a cache, the target included once it is active. Pick the session that
+    // gives up its cache before creating or touching the target, so that a refusal leaves the pool as it was.
+    bool needs_cache = known == nullptr || known->cache == nullptr;
+    SessionPool::Session *victim = nullptr;
+    if (needs_cache && pool.parked() >= pool.maxResident()) {
+        victim = pool.victim(id, priority);
+        if (victim == nullptr) {
+            _cache = std::move(*current.cache);
+            current.cache.reset();
+            current.tokens.swap(_tokens);
+        }
+        CHECK_ARGUMENT(victim != nullptr, "qwen2: every resident session has a higher priority");
+    }
+
+    auto &target = pool.get(id, priority);
+    bool ready = true;
+    auto cache = std::move(target.cache);
+    if (cache == nullptr) {
+        if (victim == nullptr) {
+            cache = std::make_unique<KVCache>(_meta.nlayer, _meta.maxseq, _meta.nkvh, _meta.dh, _meta.dtype,
+                                              _device_type, _device_id);
+        } else {
+            cache = pool.preempt(*victim);
+            cache->setLength(0);
+        }
+        ready = pool.restore(target, *cache);
+    }
+    _cache = std::move(*cache);
+    _tokens.swap(target.tokens);
+    _session = id;
+
+    if (!ready) {
+        // Preempted without a spill: prefill its tokens again.
+        auto tokens = std::move(_tokens);
+        _tokens.clear();
+        _prefill(tokens.data(), tokens.size());
+        pool.recordRecompute(tokens.size());
+    }
+}
+
+void Qwen2::releaseSession(uint64_t id) {
+    CHECK_ARGUMENT(_session_pool != nullptr, "qwen2: sessions are not enabled");
+    if (id == _session) {
+        reset();
+    } else {
+        _session_pool->release(id);
+    }
+}
+
+const SessionPool *Qwen2::sessionPool() const {
+    return _session_pool.get();
+}
+
+void Qwen2::enableGraph(bool enabled) {
+    _graph_enabled = enabled;
+    _decode_graph.clear();
+}
+
+void Qwen2::enablePrefixCache(size_t capacity_tokens) {
+    CHECK_ARGUMENT(capacity_tokens == 0 || !_cache.evicts(),
+                   "qwen2: a prefix cache cannot be combined with a cache that evicts tokens");
+    _releasePrefix();
+    if (capacity_tokens == 0) {
+        _prefix_cache.reset();
+        return;
+    }
+    _prefix_cache = std::make_unique<PrefixCache>(capacity_tokens, _meta.nlayer, _meta.nkvh, _meta.dh, _meta.dtype,
+                                                  _device_type, _device_id);
+}
+
+const PrefixCache *Qwen2::prefixCache() const {
+    return _prefix_cache.get();
+}
+} // namespace llaisys::models
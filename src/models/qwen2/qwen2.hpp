@@ -0,0 +1,172 @@
+#pragma once
+
+#include "llaisys/models/qwen2.h"
+
+#include "../../ops/graph/graph.hpp"
+#include "../../tensor/tensor.hpp"
+#include "../kv_cache/kv_cache.hpp"
+#include "../kv_snapshot/kv_snapshot.hpp"
+#include "../prefix_cache/prefix_cache.hpp"
+#include "../sampler/sampler.hpp"
+#include "../session/session_pool.hpp"
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace llaisys::models {
+struct Qwen2Weights {
+    tensor_t in_embed;
+    tensor_t out_embed;
+    tensor_t out_norm_w;
+    std::vector<tensor_t> attn_norm_w;
+    // Q, K and V projections are row slices of one fused projection, so a layer makes one GEMM for all three.
+    std::vector<tensor_t> attn_qkv_w;
+    std::vector<tensor_t> attn_qkv_b;
+    std::vector<tensor_t> attn_q_w;
+    std::vector<tensor_t> attn_q_b;
+    std::vector<tensor_t> attn_k_w;
+    std::vector<tensor_t> attn_k_b;
+    std::vector<tensor_t> attn_v_w;
+    std::vector<tensor_t> attn_v_b;
+    std::vector<tensor_t> attn_o_w;
+    std::vector<tensor_t> mlp_norm_w;
+    std::vector<tensor_t> mlp_gate_w;
+    std::vector<tensor_t> mlp_up_w;
+    std::vector<tensor_t> mlp_down_w;
+};
+
+struct SpeculativeStats {
+    uint64_t decode_steps;    // forward passes made after prefill
+    uint64_t decode_tokens;   // tokens emitted by those passes
+    uint64_t drafted_tokens;  // draft tokens sent for verification
+    uint64_t accepted_tokens; // draft tokens that matched the model's own choice
+};
+
+class Qwen2 {
+private:
+    LlaisysQwen2Meta _meta;
+    llaisysDeviceType_t _device_type;
+    int _device_id;
+    Qwen2Weights _weights;
+
+    // State of the current sequence: the tokens whose KV rows are held in `_cache`.
+    KVCache _cache;
+    std::vector<int64_t> _tokens;
+
+    std::unique_ptr<PrefixCache> _prefix_cache;
+    PrefixCache::Node *_prefix_node;
+
+    // Other sequences taking turns on the model, and the id of the current one.
+    std::unique_ptr<SessionPool> _session_pool;
+    uint64_t _session;
+
+    // Activation workspace, sized for the longest chunk seen so far.
+    size_t _workspace;
+    tensor_t _input_ids, _pos_ids;
+    tensor_t _x, _h, _qkv, _attn, _gate, _up;
+    // Streaming mode: rotated keys of every retained slot, slot positions, and the slots of new tokens.
+    tensor_t _k_rot, _slot_pos;
+    std::vector<size_t> _slots;
+    tensor_t _logits, _max_idx, _max_val;
+    std::vector<std::byte> _host_logits;
+
+    // Ops of a plain single-token step, captured on the first one and replayed by the next.
+    bool _graph_enabled;
+    ops::Graph _decode_graph;
+
+    Sampler _sampler;
+    std::vector<float> _probs;
+    SpeculativeStats _spec_stats;
+
+    // Optional smaller model with the same vocabulary that drafts tokens for speculative decoding; not owned.
+    Qwen2 *_draft;
+    std::vector<std::vector<float>> _draft_probs;
+
+    void _reserve(size_t ntoken, size_t nlogits);
+    // Copies row i of `rows` to row slots[i] of a cache tensor.
+    void _scatterRows(tensor_t cache, tensor_t rows, const std::vector<size_t> &slots);
+    // The ops of _forward, from the loaded token and position buffers to the logits; `past` cached rows precede.
+    void _layers(size_t ntoken, size_t nlogits, size_t past);
+    // Runs `ntoken` tokens through the model and leaves the logits of the last `nlogits` in `_logits`.
+    void _forward(const int64_t *token_ids, size_t ntoken, size_t nlogits);
+    // Like _forward, but restores a cached prefix first when it starts a new sequence.
+    void _prefill(const int64_t *token_ids, size_t ntoken);
+    int64_t _argmax(size_t row);
+    // Copies logit row `row` to the host and leaves its filtered distribution in `_probs`.
+    void _distribution(size_t row, const SamplingParams &params);
+    int64_t _sample(size_t row, const SamplingParams &params);
+    // Samples from logit row `row` given that `draft` was proposed for it; returns `draft` if accepted.
+    // `draft_probs` is the distribution the draft was sampled from, or null for a deterministic draft.
+    int64_t _verify(size_t row, int64_t draft, const SamplingParams &params, const std::vector<float> *draft_probs);
+    // Runs the draft model autoregressively from `history`, keeping each step's distribution in `_draft_probs`.
+    void _proposeWithDraft(const std::vector<int64_t> &history, size_t max_draft, const SamplingParams &params,
+                           std::vector<int64_t> &drafts);
+    void _releasePrefix();
+
+public:
+    Qwen2(const LlaisysQwen2Meta &meta, llaisysDeviceType_t device_type, int device_id);
+    ~Qwen2();
+
+    const LlaisysQwen2Meta &meta() const;
+    Qwen2Weights &weights();
+
+    // Appends `ntoken` tokens to the current sequence and returns the argmax of the next-token logits.
+    int64_t infer(const int64_t *token_ids, size_t ntoken);
+    // The logits of the last forward pass; after infer, row 0 holds the next-token logits.
+    tensor_t logits() const;
+    // Ends the current sequence. With a prefix cache, its tokens are kept for later sequences to reuse.
+    void reset();
+    // Rolls the current sequence back to its first `ntoken` tokens.
+    void truncate(size_t ntoken);
+    // Autotunes the GEMM of every projection for forward passes of each of `ntokens` tokens, e.g. 1 for
+    // decode. Layers share shapes, so only the first layer's weights are benchmarked.
+    void tune(const std::vector<size_t> &ntokens);
+
+    // Decodes from the prompt until `end_token`, `max_new_tokens`, or `emit` returning false. Each token is
+    // passed to `emit` as soon as it is sampled; returns the number emitted. The current sequence is kept
+    // when the prompt extends it (e.g. the next turn of a chat, or a restored snapshot).
+    // Drafts come from the draft model when one is set, otherwise from prompt lookup when `params.ngram > 0`.
+    // They are verified in a single forward pass and the KV rows of rejected drafts are rolled back on both
+    // models; tokens follow the same distribution as plain decoding.
+    size_t generate(const int64_t *token_ids, size_t ntoken, const LlaisysQwen2GenerateParams &params,
+                    const std::function<bool(int64_t)> &emit);
+    const SpeculativeStats &speculativeStats() const;
+    // Pairs this model with a draft model, or detaches it when `draft` is null.
+    void setDraft(Qwen2 *draft);
+
+    // Writes the current sequence to a snapshot file, optionally with int8 KV rows.
+    void saveSnapshot(const std::string &path, bool quantize) const;
+    // Replaces the current sequence with one from a snapshot file and returns its length.
+    size_t loadSnapshot(const std::string &path);
+
+    // Keeps `sinks` leading tokens plus a sliding window over the rest of maxseq, for unbounded sequences.
+    // Ends the current sequence. Speculative decoding, prefix caching and snapshots are unavailable meanwhile.
+    void enableStreaming(bool enabled, size_t sinks);
+    // Bounds the cache to `budget` rows per KV head by evicting the tokens that received the least attention,
+    // keeping the `recent` newest. Ends the current sequence, with the same restrictions as streaming.
+    void enableHeavyHitter(bool enabled, size_t budget, size_t recent);
+    const KVEvictionStats &evictionStats() const;
+    // KV rows currently held per head.
+    size_t cachedTokens() const;
+
+    // Lets several sequences take turns on the model: up to `max_resident` keep their KV cache, the rest are
+    // preempted by priority and spilled to `spill_dir` (host memory when empty) or recomputed. Ends the current
+    // sequence and drops all sessions; 0 disables them. Unavailable together with streaming or heavy hitters.
+    void enableSessions(size_t max_resident, const std::string &spill_dir, bool quantize);
+    // Makes session `id` the current sequence, creating it if new and preempting sessions of no higher
+    // priority as needed. Throws when every other resident session has a higher priority.
+    void selectSession(uint64_t id, int priority);
+    // Frees a session's KV cache and spill; the current session is reset instead.
+    void releaseSession(uint64_t id);
+    const SessionPool *sessionPool() const;
+
+    // Replays decode steps from a graph of the ops captured on the first one, skipping their per-call
+    // validation and dispatch. On by default; steps in streaming or heavy-hitter mode always run op by op.
+    void enableGraph(bool enabled);
+
+    void enablePrefixCache(size_t capacity_tokens);
+    const PrefixCache *prefixCache() const;
+};
+} // namespace llaisys::models
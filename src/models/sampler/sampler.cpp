@@ -0,0 +1,120 @@
+#include "sampler.hpp"
+
+#include "../../utils.hpp"
+#include "../../utils/vec_math.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+template <typename T>
+void to_float_(float *out, const T *logits, size_t voc, float inv_temperature) {
+    for (size_t i = 0; i < voc; ++i) {
+        out[i] = llaisys::utils::cast<float>(logits[i]) * inv_temperature;
+    }
+}
+
+static void to_float(float *out, const std::byte *logits, llaisysDataType_t type, size_t voc, float inv_temperature) {
+    switch (type) {
+    case LLAISYS_DTYPE_F32:
+        return to_float_(out, reinterpret_cast<const float *>(logits), voc, inv_temperature);
+    case LLAISYS_DTYPE_BF16:
+        return to_float_(out, reinterpret_cast<const llaisys::bf16_t *>(logits), voc, inv_temperature);
+    case LLAISYS_DTYPE_F16:
+        return to_float_(out, reinterpret_cast<const llaisys::fp16_t *>(logits), voc, inv_temperature);
+    default:
+        EXCEPTION_UNSUPPORTED_DATATYPE(type);
+    }
+}
+
+namespace llaisys::models {
+Sampler::Sampler(uint64_t seed) : _rng(seed) {}
+
+void Sampler::seed(uint64_t seed) {
+    _rng.seed(seed);
+}
+
+bool Sampler::isGreedy(const SamplingParams &params) {
+    return params.top_k == 1 || params.temperature <= 0.0f;
+}
+
+void Sampler::distribution(const std::byte *logits, llaisysDataType_t dtype, size_t voc, const SamplingParams &params,
+                           std::vector<float> &probs) {
+    probs.resize(voc);
+    if (isGreedy(params)) {
+        // Degenerate distribution on the argmax, so that speculative acceptance tests stay exact.
+        _scratch.resize(voc);
+        to_float(_scratch.data(), logits, dtype, voc, 1.0f);
+        size_t best = std::max_element(_scratch.begin(), _scratch.end()) - _scratch.begin();
+        std::fill(probs.begin(), probs.end(), 0.0f);
+        probs[best] = 1.0f;
+        return;
+    }
+
+    to_float(probs.data(), logits, dtype, voc, 1.0f / params.temperature);
+
+    // Top-k: drop everything below the k-th largest logit.
+    float threshold = -std::numeric_limits<float>::infinity();
+    if (params.top_k > 0 && params.top_k < voc) {
+        _scratch.assign(probs.begin(), probs.end());
+        std::nth_element(_scratch.begin(), _scratch.begin() + (params.top_k - 1), _scratch.end(), std::greater<float>());
+        threshold = _scratch[params.top_k - 1];
+    }
+
+    float max_logit = *std::max_element(probs.begin(), probs.end());
+    for (auto &p : probs) {
+        if (p < threshold) {
+            p = -std::numeric_limits<float>::infinity();
+        }
+    }
+    float sum = utils::vec::expSum(probs.data(), voc, max_logit);
+    for (auto &p : probs) {
+        p /= sum;
+    }
+
+    // Top-p: keep the smallest set of most likely tokens whose mass reaches top_p.
+    if (params.top_p > 0.0f && params.top_p < 1.0f) {
+        _order.clear();
+        for (size_t i = 0; i < voc; ++i) {
+            if (probs[i] > 0.0f) {
+                _order.push_back(static_cast<int64_t>(i));
+            }
+        }
+        std::sort(_order.begin(), _order.end(), [&](int64_t a, int64_t b) { return probs[a] > probs[b]; });
+        float cumulative = 0.0f;
+        size_t keep = 0;
+        while (keep < _order.size() && cumulative < params.top_p) {
+            cumulative += probs[_order[keep++]];
+        }
+        for (size_t i = keep; i < _order.size(); ++i) {
+            probs[_order[i]] = 0.0f;
+        }
+        for (size_t i = 0; i < keep; ++i) {
+            probs[_order[i]] /= cumulative;
+        }
+    }
+}
+
+int64_t Sampler::sample(const std::vector<float> &probs) {
+    float r = uniform();
+    float cumulative = 0.0f;
+    int64_t last = -1;
+    for (size_t i = 0; i < probs.size(); ++i) {
+        if (probs[i] <= 0.0f) {
+            continue;
+        }
+        cumulative += probs[i];
+        last = static_cast<int64_t>(i);
+        if (r < cumulative) {
+            return last;
+        }
+    }
+    ASSERT(last >= 0, "sampler: empty distribution");
+    return last; // rounding left r just above the total mass
+}
+
+float Sampler::uniform() {
+    return std::uniform_real_distribution<float>(0.0f, 1.0f)(_rng);
+}
+} // namespace llaisys::models
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "llaisys.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+namespace llaisys::models {
+struct SamplingParams {
+    float temperature;
+    size_t top_k; // 0 keeps the whole vocabulary
+    float top_p;
+};
+
+// Host-side next-token sampling with temperature, top-k and top-p (nucleus) filtering.
+class Sampler {
+private:
+    std::mt19937_64 _rng;
+    std::vector<float> _scratch;
+    std::vector<int64_t> _order;
+
+public:
+    explicit Sampler(uint64_t seed = 0);
+
+    void seed(uint64_t seed);
+    static bool isGreedy(const SamplingParams &params);
+
+    // Writes the filtered, normalized distribution over `voc` host logits into `probs`.
+    void distribution(const std::byte *logits, llaisysDataType_t dtype, size_t voc, const SamplingParams &params,
+                      std::vector<float> &probs);
+    int64_t sample(const std::vector<float> &probs);
+    float uniform();
+};
+} // namespace llaisys::models
@@ -0,0 +1,190 @@
+#include "session_pool.hpp"
+
+#include "../../utils.hpp"
+#include "../kv_snapshot/kv_snapshot.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+
+namespace llaisys::models {
+namespace {
+// Starting estimates, replaced by measurements as soon as there are any.
+constexpr double DEFAULT_PREFILL_SECONDS_PER_TOKEN = 1e-3;
+constexpr double DEFAULT_SWAP_BYTES_PER_SECOND = 1e9;
+
+double seconds(std::chrono::steady_clock::time_point since) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - since).count();
+}
+
+void smooth(double &estimate, double sample) {
+    estimate = 0.75 * estimate + 0.25 * sample;
+}
+} // namespace
+
+SessionPool::SessionPool(size_t max_resident, const std::string &spill_dir, bool quantize)
+    : _max_resident(max_resident), _spill_dir(spill_dir), _to_file(!spill_dir.empty()), _quantize(quantize),
+      _clock(0), _stats{}, _prefill_seconds_per_token(DEFAULT_PREFILL_SECONDS_PER_TOKEN),
+      _swap_bytes_per_second(DEFAULT_SWAP_BYTES_PER_SECOND) {
+    CHECK_ARGUMENT(max_resident > 0, "session_pool: at least one session must be resident");
+    if (_to_file) {
+        // Tags this pool's spill files, so pools can share a directory.
+        _spill_dir += "/llaisys-kv-" + std::to_string(std::random_device()()) + "-";
+    }
+}
+
+SessionPool::~SessionPool() {
+    for (const auto &[id, session] : _sessions) {
+        if (!session.spill_path.empty()) {
+            std::remove(session.spill_path.c_str());
+        }
+    }
+}
+
+std::string SessionPool::_spillPath(uint64_t id) const {
+    return _spill_dir + std::to_string(id) + ".kv";
+}
+
+SessionPool::Session &SessionPool::get(uint64_t id, int priority) {
+    auto it = _sessions.find(id);
+    if (it == _sessions.end()) {
+        it = _sessions.emplace(id, Session{id, priority, 0, {}, nullptr, {}, {}, false}).first;
+    }
+    it->second.priority = priority;
+    it->second.last_used = ++_clock;
+    return it->second;
+}
+
+SessionPool::Session &SessionPool::at(uint64_t id) {
+    auto it = _sessions.find(id);
+    ASSERT(it != _sessions.end(), "session_pool: unknown session");
+    return it->second;
+}
+
+const SessionPool::Session *SessionPool::find(uint64_t id) const {
+    auto it = _sessions.find(id);
+    return it != _sessions.end() ? &it->second : nullptr;
+}
+
+void SessionPool::release(uint64_t id) {
+    auto it = _sessions.find(id);
+    if (it == _sessions.end()) {
+        return;
+    }
+    if (!it->second.spill_path.empty()) {
+        std::remove(it->second.spill_path.c_str());
+    }
+    _sessions.erase(it);
+}
+
+size_t SessionPool::parked() const {
+    size_t n = 0;
+    for (const auto &[id, session] : _sessions) {
+        n += session.cache != nullptr;
+    }
+    return n;
+}
+
+size_t SessionPool::maxResident() const {
+    return _max_resident;
+}
+
+SessionPool::Session *SessionPool::victim(uint64_t active, int priority) {
+    Session *victim = nullptr;
+    for (auto &[id, session] : _sessions) {
+        if (id == active || session.cache == nullptr || session.priority > priority) {
+            continue;
+        }
+        if (victim == nullptr || session.priority < victim->priority ||
+            (session.priority == victim->priority && session.last_used < victim->last_used)) {
+            victim = &session;
+        }
+    }
+    return victim;
+}
+
+std::unique_ptr<KVCache> SessionPool::preempt(Session &session) {
+    auto cache = std::move(session.cache);
+    ASSERT(cache != nullptr, "session_pool: preempting a session that is not resident");
+    _stats.preemptions += 1;
+    size_t ntoken = session.tokens.size();
+    if (ntoken == 0) {
+        return cache;
+    }
+
+    // A swap is paid twice, out now and in later; a recompute is one prefill of the whole sequence.
+    size_t bytes = kvSnapshotBytes(ntoken, *cache, _quantize);
+    double swap_cost = 2.0 * static_cast<double>(bytes) / _swap_bytes_per_second;
+    double recompute_cost = static_cast<double>(ntoken) * _prefill_seconds_per_token;
+    if (recompute_cost < swap_cost) {
+        return cache;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    if (_to_file) {
+        session.spill_path = _spillPath(session.id);
+        saveKVSnapshot(session.spill_path, session.tokens.data(), ntoken, *cache, _quantize);
+    } else {
+        session.spill.reserve(bytes);
+        writeKVSnapshot(
+            [&](const void *data, size_t size) {
+                auto ptr = static_cast<const std::byte *>(data);
+                session.spill.insert(session.spill.end(), ptr, ptr + size);
+            },
+            session.tokens.data(), ntoken, *cache, _quantize);
+    }
+    smooth(_swap_bytes_per_second, static_cast<double>(bytes) / std::max(seconds(start), 1e-9));
+    session.swapped = true;
+    _stats.swap_outs += 1;
+    _stats.swapped_bytes += bytes;
+    return cache;
+}
+
+bool SessionPool::restore(Session &session, KVCache &cache) {
+    if (!session.swapped) {
+        return session.tokens.empty();
+    }
+    auto start = std::chrono::steady_clock::now();
+    std::vector<int64_t> tokens;
+    size_t bytes;
+    if (_to_file) {
+        tokens = loadKVSnapshot(session.spill_path, cache);
+        std::remove(session.spill_path.c_str());
+        session.spill_path.clear();
+        bytes = kvSnapshotBytes(tokens.size(), cache, _quantize);
+    } else {
+        tokens = readKVSnapshot(session.spill.data(), session.spill.size(), cache);
+        bytes = session.spill.size();
+        std::vector<std::byte>().swap(session.spill);
+    }
+    smooth(_swap_bytes_per_second, static_cast<double>(bytes) / std::max(seconds(start), 1e-9));
+    ASSERT(tokens == session.tokens, "session_pool: spilled tokens do not match the session");
+    session.swapped = false;
+    _stats.swap_ins += 1;
+    return true;
+}
+
+void SessionPool::recordPrefill(size_t ntoken, double seconds) {
+    if (ntoken > 0) {
+        smooth(_prefill_seconds_per_token, seconds / static_cast<double>(ntoken));
+    }
+}
+
+void SessionPool::recordRecompute(size_t ntoken) {
+    _stats.recomputes += 1;
+    _stats.recomputed_tokens += ntoken;
+}
+
+const SessionStats &SessionPool::stats() const {
+    return _stats;
+}
+
+size_t SessionPool::swappedSessions() const {
+    size_t n = 0;
+    for (const auto &[id, session] : _sessions) {
+        n += session.swapped;
+    }
+    return n;
+}
+} // namespace llaisys::models
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "../kv_cache/kv_cache.hpp"
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace llaisys::models {
+struct SessionStats {
+    uint64_t preemptions;       // sessions that lost their KV cache to a higher-priority one
+    uint64_t swap_outs;         // preemptions that spilled the KV rows
+    uint64_t swap_ins;          // spilled sessions restored
+    uint64_t recomputes;        // dropped sessions prefilled again
+    uint64_t swapped_bytes;     // bytes spilled by swap-outs
+    uint64_t recomputed_tokens; // tokens prefilled by recomputes
+};
+
+// Sequences of one model that take turns on it. At most `max_resident` of them hold a KV cache; when another
+// needs one, the least recently used session of the lowest priority is preempted. Its rows are either spilled
+// to host memory (optionally int8) or an mmap-backed file, or dropped and recomputed from its tokens later,
+// whichever the cost model expects to be cheaper.
+class SessionPool {
+public:
+    struct Session {
+        uint64_t id;
+        int priority;
+        uint64_t last_used;
+        std::vector<int64_t> tokens;
+        std::unique_ptr<KVCache> cache; // set while the session is resident but not active
+        std::vector<std::byte> spill;   // spilled to host memory
+        std::string spill_path;         // spilled to a file
+        bool swapped;
+    };
+
+private:
+    size_t _max_resident;
+    std::string _spill_dir;
+    bool _to_file;
+    bool _quantize;
+    std::map<uint64_t, Session> _sessions;
+    uint64_t _clock;
+    SessionStats _stats;
+
+    // Cost model: throughputs measured on this host, smoothed over recent operations.
+    double _prefill_seconds_per_token;
+    double _swap_bytes_per_second;
+
+    std::string _spillPath(uint64_t id) const;
+
+public:
+    // Spills go to files in `spill_dir`, or to host memory when it is empty.
+    SessionPool(size_t max_resident, const std::string &spill_dir, bool quantize);
+    ~SessionPool();
+
+    // The session `id`, created empty when new. Marks it as the most recently used.
+    Session &get(uint64_t id, int priority);
+    Session &at(uint64_t id);
+    // The session `id`, or null if there is none.
+    const Session *find(uint64_t id) const;
+    void release(uint64_t id);
+    // Resident sessions other than the active one, which always holds the model's own cache.
+    size_t parked() const;
+    size_t maxResident() const;
+
+    // Picks a resident session to preempt for one of `priority`, other than `active`, or returns null if every
+    // candidate has a higher priority.
+    Session *victim(uint64_t active, int priority);
+    // Takes the KV cache of `session`, spilling its rows or leaving them to be recomputed.
+    std::unique_ptr<KVCache> preempt(Session &session);
+    // Refills `cache` from a spilled session. Returns false when its tokens must be recomputed instead.
+    // `cache` must be empty.
+    bool restore(Session &session, KVCache &cache);
+
+    void recordPrefill(size_t ntoken, double seconds);
+    void recordRecompute(size_t ntoken);
+    const SessionStats &stats() const;
+    size_t swappedSessions() const;
+};
+} // namespace llaisys::models
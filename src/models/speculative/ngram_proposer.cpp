@@ -0,0 +1,33 @@
+#include "ngram_proposer.hpp"
+
+#include "../../utils.hpp"
+
+#include <algorithm>
+
+namespace llaisys::models {
+NgramProposer::NgramProposer(size_t max_ngram, size_t min_ngram) : _max_ngram(max_ngram), _min_ngram(min_ngram) {
+    CHECK_ARGUMENT(min_ngram > 0 && min_ngram <= max_ngram, "ngram_proposer: invalid n-gram range");
+}
+
+void NgramProposer::propose(const std::vector<int64_t> &history, size_t max_draft,
+                            std::vector<int64_t> &drafts) const {
+    drafts.clear();
+    size_t len = history.size();
+    if (max_draft == 0) {
+        return;
+    }
+    for (size_t n = std::min(_max_ngram, len > 0 ? len - 1 : 0); n >= _min_ngram; --n) {
+        const int64_t *tail = history.data() + len - n;
+        // Scan backwards for the most recent match that still has a continuation.
+        for (size_t start = len - n; start-- > 0;) {
+            if (!std::equal(tail, tail + n, history.data() + start)) {
+                continue;
+            }
+            size_t from = start + n;
+            size_t count = std::min(max_draft, len - from);
+            drafts.assign(history.begin() + from, history.begin() + from + count);
+            return;
+        }
+    }
+}
+} // namespace llaisys::models
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace llaisys::models {
+// Prompt-lookup drafting: finds the most recent earlier occurrence of the sequence's trailing n-gram
+// (longest n first) and proposes the tokens that followed it. Costs no model evaluation, and pays off on
+// workloads that copy from their input such as summarization and code edits.
+class NgramProposer {
+private:
+    size_t _max_ngram;
+    size_t _min_ngram;
+
+public:
+    NgramProposer(size_t max_ngram, size_t min_ngram = 1);
+
+    // Proposes up to `max_draft` tokens to follow `history`.
+    void propose(const std::vector<int64_t> &history, size_t max_draft, std::vector<int64_t> &drafts) const;
+};
+} // namespace llaisys::models
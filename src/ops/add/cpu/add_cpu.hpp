@@ -1,8 +1,11 @@
 #pragma once
 #include "llaisys.h"
 
+#include "../../elementwise/cpu/elementwise_cpu.hpp"
+
 #include <cstddef>
 
 namespace llaisys::ops::cpu {
-void add(std::byte *c, const std::byte *a, const std::byte *b, llaisysDataType_t type, size_t size);
-}
\ No newline at end of file
+void add(std::byte *c, const std::byte *a, const std::byte *b, llaisysDataType_t type,
+         const ElementwiseLayout<2> &layout);
+}
@@ -2,34 +2,29 @@
 
 #include "../../core/llaisys_core.hpp"
 #include "../../utils.hpp"
+#include "../elementwise/elementwise.hpp"
+#include "../elementwise/fusion.hpp"
+#include "../graph/graph.hpp"
+#include "../registry/registry.hpp"
 
 #include "cpu/add_cpu.hpp"
 
 namespace llaisys::ops {
 void add(tensor_t c, tensor_t a, tensor_t b) {
     CHECK_SAME_DEVICE(c, a, b);
-    // Only support contiguous inputs with same shape for now.
-    CHECK_SAME_SHAPE(c->shape(), a->shape(), b->shape());
     CHECK_SAME_DTYPE(c->dtype(), a->dtype(), b->dtype());
-    ASSERT(c->isContiguous() && a->isContiguous() && b->isContiguous(), "Add: all tensors must be contiguous.");
+    // a and b are broadcast to the shape of c, which may be a or b itself.
+    auto a_strides = broadcastStrides(a, c->shape());
+    auto b_strides = broadcastStrides(b, c->shape());
 
-    // always support cpu calculation
-    if (c->deviceType() == LLAISYS_DEVICE_CPU) {
-        return cpu::add(c->data(), a->data(), b->data(), c->dtype(), c->numel());
-    }
-
-    llaisys::core::context().setDevice(c->deviceType(), c->deviceId());
-
-    switch (c->deviceType()) {
-    case LLAISYS_DEVICE_CPU:
-        return cpu::add(c->data(), a->data(), b->data(), c->dtype(), c->numel());
-#ifdef ENABLE_NVIDIA_API
-    case LLAISYS_DEVICE_NVIDIA:
-        TO_BE_IMPLEMENTED();
+    if (recordFused(cpu::FusedOp::Add, c, {a, b})) {
         return;
-#endif
-    default:
-        EXCEPTION_UNSUPPORTED_DEVICE;
     }
+
+    retainForCapture(c, a, b);
+    cpu::ElementwiseLayout<2> layout{c->ndim(), c->shape().data(), c->strides().data(),
+                                     {keepForCapture(a_strides).data(), keepForCapture(b_strides).data()}};
+    static KernelSite site("add", cpu::add);
+    site(c->deviceType(), c->deviceId(), c->dtype(), c->data(), a->data(), b->data(), c->dtype(), layout);
 }
 } // namespace llaisys::ops
@@ -1,49 +1,159 @@
+// Intrinsics go first: llaisys.h defines __C, which they use as a parameter name.
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 #include "argmax_cpu.hpp"
 
 #include "../../../utils.hpp"
+#include "../../../utils/thread_pool.hpp"
 
+#include <algorithm>
 #include <cstdint>
+#include <cstring>
+#include <limits>
 #include <type_traits>
+#include <vector>
+
+namespace {
+// Rows are scanned in chunks of this many elements. Each chunk records its maximum, so only the first chunk
+// holding the row maximum is scanned again for its position.
+constexpr size_t CHUNK = 4096;
+// Scans with fewer elements stay on the calling thread.
+constexpr size_t PARALLEL_NUMEL = 1 << 16;
+
+// Floats are compared as signed integers of the same width whose order is the float order: negative values get
+// their magnitude bits flipped, and -0 lands on +0. `inf` holds the bits of +inf; every NaN, whatever its sign
+// and payload, gets the largest key, so the first NaN wins like in torch.argmax.
+template <typename K>
+K key(K bits, K inf) {
+    constexpr K MAX = std::numeric_limits<K>::max();
+    if ((bits & MAX) > inf) {
+        return MAX;
+    }
+    K neg = bits < 0 ? K(-1) : K(0);
+    return static_cast<K>((bits ^ static_cast<K>(static_cast<std::make_unsigned_t<K>>(neg) >> 1)) - neg);
+}
+
+#ifdef __SSE2__
+__m128i key16(__m128i bits, int16_t inf) {
+    __m128i nan = _mm_cmpgt_epi16(_mm_and_si128(bits, _mm_set1_epi16(0x7fff)), _mm_set1_epi16(inf));
+    __m128i neg = _mm_srai_epi16(bits, 15);
+    __m128i k = _mm_sub_epi16(_mm_xor_si128(bits, _mm_srli_epi16(neg, 1)), neg);
+    return _mm_or_si128(_mm_andnot_si128(nan, k), _mm_srli_epi16(nan, 1));
+}
 
-template <typename T>
-void argmax_(int64_t *max_idx, T *max_val, const T *vals, size_t numel) {
-    int64_t best_idx = 0;
-    if constexpr (std::is_same_v<T, llaisys::bf16_t> || std::is_same_v<T, llaisys::fp16_t>) {
-        float best_val = llaisys::utils::cast<float>(vals[0]);
-        for (size_t i = 1; i < numel; ++i) {
-            float v = llaisys::utils::cast<float>(vals[i]);
-            if (v > best_val) {
-                best_val = v;
-                best_idx = static_cast<int64_t>(i);
+__m128i key32(__m128i bits, int32_t inf) {
+    __m128i nan = _mm_cmpgt_epi32(_mm_and_si128(bits, _mm_set1_epi32(0x7fffffff)), _mm_set1_epi32(inf));
+    __m128i neg = _mm_srai_epi32(bits, 31);
+    __m128i k = _mm_sub_epi32(_mm_xor_si128(bits, _mm_srli_epi32(neg, 1)), neg);
+    return _mm_or_si128(_mm_andnot_si128(nan, k), _mm_srli_epi32(nan, 1));
+}
+
+__m128i max32(__m128i a, __m128i b) {
+    __m128i gt = _mm_cmpgt_epi32(a, b);
+    return _mm_or_si128(_mm_and_si128(gt, a), _mm_andnot_si128(gt, b));
+}
+#endif
+
+template <typename K>
+K chunkMax(const K *bits, size_t n, K inf) {
+    K best = std::numeric_limits<K>::min();
+    size_t i = 0;
+#ifdef __SSE2__
+    constexpr size_t LANES = 16 / sizeof(K);
+    if (n >= LANES) {
+        __m128i acc = sizeof(K) == 2 ? _mm_set1_epi16(std::numeric_limits<int16_t>::min())
+                                     : _mm_set1_epi32(std::numeric_limits<int32_t>::min());
+        for (; i + LANES <= n; i += LANES) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(bits + i));
+            if constexpr (sizeof(K) == 2) {
+                acc = _mm_max_epi16(acc, key16(v, inf));
+            } else {
+                acc = max32(acc, key32(v, inf));
             }
         }
-        *max_idx = best_idx;
-        *max_val = llaisys::utils::cast<T>(best_val);
-    } else {
-        T best_val = vals[0];
-        for (size_t i = 1; i < numel; ++i) {
-            if (vals[i] > best_val) {
-                best_val = vals[i];
-                best_idx = static_cast<int64_t>(i);
-            }
+        K lanes[LANES];
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(lanes), acc);
+        best = *std::max_element(lanes, lanes + LANES);
+    }
+#endif
+    for (; i < n; ++i) {
+        best = std::max(best, key(bits[i], inf));
+    }
+    return best;
+}
+
+template <typename K>
+size_t findKey(const K *bits, size_t n, K target, K inf) {
+    size_t i = 0;
+#ifdef __SSE2__
+    constexpr size_t LANES = 16 / sizeof(K);
+    for (; i + LANES <= n; i += LANES) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(bits + i));
+        int mask;
+        if constexpr (sizeof(K) == 2) {
+            mask = _mm_movemask_epi8(_mm_cmpeq_epi16(key16(v, inf), _mm_set1_epi16(target)));
+        } else {
+            mask = _mm_movemask_epi8(_mm_cmpeq_epi32(key32(v, inf), _mm_set1_epi32(target)));
+        }
+        if (mask != 0) {
+            return i + static_cast<size_t>(__builtin_ctz(static_cast<unsigned>(mask))) / sizeof(K);
         }
-        *max_idx = best_idx;
-        *max_val = best_val;
+    }
+#endif
+    for (; i < n; ++i) {
+        if (key(bits[i], inf) == target) {
+            return i;
+        }
+    }
+    return n;
+}
+
+// K is a signed integer as wide as the element type; values are compared and copied as bits.
+template <typename K>
+void argmax_(int64_t *max_idx, K *max_val, const K *vals, size_t nrow, size_t numel, ptrdiff_t row_stride,
+             K inf) {
+    size_t nchunk = (numel + CHUNK - 1) / CHUNK;
+    std::vector<K> maxima(nrow * nchunk);
+    auto scan = [&](size_t begin, size_t end) {
+        for (size_t u = begin; u < end; ++u) {
+            size_t row = u / nchunk, start = (u % nchunk) * CHUNK;
+            const K *chunk = vals + static_cast<ptrdiff_t>(row) * row_stride + start;
+            maxima[u] = chunkMax(chunk, std::min(CHUNK, numel - start), inf);
+        }
+    };
+    if (nrow * nchunk > 1 && nrow * numel >= PARALLEL_NUMEL) {
+        llaisys::utils::threadPool().parallelFor(nrow * nchunk, scan, 1);
+    } else {
+        scan(0, nrow * nchunk);
+    }
+
+    for (size_t row = 0; row < nrow; ++row) {
+        const K *row_maxima = maxima.data() + row * nchunk;
+        size_t chunk = std::max_element(row_maxima, row_maxima + nchunk) - row_maxima;
+        size_t start = chunk * CHUNK;
+        const K *row_vals = vals + static_cast<ptrdiff_t>(row) * row_stride;
+        size_t index = start + findKey(row_vals + start, std::min(CHUNK, numel - start), row_maxima[chunk], inf);
+        max_idx[row] = static_cast<int64_t>(index);
+        max_val[row] = row_vals[index];
     }
 }
+} // namespace
 
 namespace llaisys::ops::cpu {
-void argmax(std::byte *max_idx, std::byte *max_val, const std::byte *vals, llaisysDataType_t type, size_t numel) {
+void argmax(std::byte *max_idx, std::byte *max_val, const std::byte *vals, llaisysDataType_t type, size_t nrow,
+            size_t numel, ptrdiff_t row_stride) {
     switch (type) {
     case LLAISYS_DTYPE_F32:
-        return argmax_(reinterpret_cast<int64_t *>(max_idx), reinterpret_cast<float *>(max_val),
-                       reinterpret_cast<const float *>(vals), numel);
+        return argmax_(reinterpret_cast<int64_t *>(max_idx), reinterpret_cast<int32_t *>(max_val),
+                       reinterpret_cast<const int32_t *>(vals), nrow, numel, row_stride, 0x7f800000);
     case LLAISYS_DTYPE_BF16:
-        return argmax_(reinterpret_cast<int64_t *>(max_idx), reinterpret_cast<llaisys::bf16_t *>(max_val),
-                       reinterpret_cast<const llaisys::bf16_t *>(vals), numel);
+        return argmax_(reinterpret_cast<int64_t *>(max_idx), reinterpret_cast<int16_t *>(max_val),
+                       reinterpret_cast<const int16_t *>(vals), nrow, numel, row_stride, int16_t(0x7f80));
     case LLAISYS_DTYPE_F16:
-        return argmax_(reinterpret_cast<int64_t *>(max_idx), reinterpret_cast<llaisys::fp16_t *>(max_val),
-                       reinterpret_cast<const llaisys::fp16_t *>(vals), numel);
+        return argmax_(reinterpret_cast<int64_t *>(max_idx), reinterpret_cast<int16_t *>(max_val),
+                       reinterpret_cast<const int16_t *>(vals), nrow, numel, row_stride, int16_t(0x7c00));
     default:
         EXCEPTION_UNSUPPORTED_DATATYPE(type);
     }
@@ -4,5 +4,7 @@
 #include <cstddef>
 
 namespace llaisys::ops::cpu {
-void argmax(std::byte *max_idx, std::byte *max_val, const std::byte *vals, llaisysDataType_t type, size_t numel);
+// Index and value of the first maximum of each of `nrow` rows of `numel` elements, `row_stride` elements apart.
+void argmax(std::byte *max_idx, std::byte *max_val, const std::byte *vals, llaisysDataType_t type, size_t nrow,
+            size_t numel, ptrdiff_t row_stride);
 }
@@ -2,38 +2,33 @@
 
 #include "../../core/llaisys_core.hpp"
 #include "../../utils.hpp"
+#include "../elementwise/fusion.hpp"
+#include "../graph/graph.hpp"
+#include "../registry/registry.hpp"
 
 #include "cpu/argmax_cpu.hpp"
 
 namespace llaisys::ops {
 void argmax(tensor_t max_idx, tensor_t max_val, tensor_t vals) {
     CHECK_SAME_DEVICE(max_idx, max_val, vals);
-    CHECK_ARGUMENT(vals->ndim() == 1, "argmax: vals must be 1D");
-    CHECK_ARGUMENT(max_idx->numel() == 1 && max_val->numel() == 1, "argmax: max_idx/max_val must be single element");
+    // vals is one row, or a batch of rows with one result each.
+    CHECK_ARGUMENT(vals->ndim() == 1 || vals->ndim() == 2, "argmax: vals must be 1D or 2D");
+    size_t nrow = vals->ndim() == 2 ? vals->shape()[0] : 1;
+    size_t numel = vals->shape().back();
+    CHECK_ARGUMENT(max_idx->numel() == nrow && max_val->numel() == nrow,
+                   "argmax: max_idx/max_val must have one element per row");
     CHECK_ARGUMENT(max_idx->dtype() == LLAISYS_DTYPE_I64, "argmax: max_idx must be int64");
     CHECK_ARGUMENT(max_val->dtype() == vals->dtype(), "argmax: max_val dtype mismatch");
-    ASSERT(max_idx->isContiguous() && max_val->isContiguous() && vals->isContiguous(), "Argmax: all tensors must be contiguous.");
+    CHECK_ARGUMENT(numel > 0, "argmax: vals must be non-empty");
+    ASSERT(max_idx->isContiguous() && max_val->isContiguous() && vals->strides().back() == 1,
+           "Argmax: outputs and rows must be contiguous.");
+    ptrdiff_t row_stride = vals->ndim() == 2 ? vals->strides()[0] : 0;
 
-    if (vals->numel() == 0) {
-        CHECK_ARGUMENT(false, "argmax: vals must be non-empty");
-    }
+    flushFusion();
 
-    if (vals->deviceType() == LLAISYS_DEVICE_CPU) {
-        return cpu::argmax(max_idx->data(), max_val->data(), vals->data(), vals->dtype(), vals->numel());
-    }
-
-    llaisys::core::context().setDevice(vals->deviceType(), vals->deviceId());
-
-    switch (vals->deviceType()) {
-    case LLAISYS_DEVICE_CPU:
-        return cpu::argmax(max_idx->data(), max_val->data(), vals->data(), vals->dtype(), vals->numel());
-#ifdef ENABLE_NVIDIA_API
-    case LLAISYS_DEVICE_NVIDIA:
-        TO_BE_IMPLEMENTED();
-        return;
-#endif
-    default:
-        EXCEPTION_UNSUPPORTED_DEVICE;
-    }
+    retainForCapture(max_idx, max_val, vals);
+    static KernelSite site("argmax", cpu::argmax);
+    site(vals->deviceType(), vals->deviceId(), vals->dtype(), max_idx->data(), max_val->data(), vals->data(),
+         vals->dtype(), nrow, numel, row_stride);
 }
 } // namespace llaisys::ops
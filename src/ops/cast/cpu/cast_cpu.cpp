@@ -0,0 +1,10 @@
+#include "cast_cpu.hpp"
+
+#include "../../elementwise/cpu/functors.hpp"
+
+namespace llaisys::ops::cpu {
+void cast(std::byte *out, const std::byte *in, llaisysDataType_t out_type, llaisysDataType_t in_type,
+          const ElementwiseLayout<1> &layout) {
+    elementwise_<1>(elementwise::Identity{}, out, out_type, {in}, {in_type}, layout);
+}
+} // namespace llaisys::ops::cpu
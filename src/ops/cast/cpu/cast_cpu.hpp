@@ -0,0 +1,11 @@
+#pragma once
+#include "llaisys.h"
+
+#include "../../elementwise/cpu/elementwise_cpu.hpp"
+
+#include <cstddef>
+
+namespace llaisys::ops::cpu {
+void cast(std::byte *out, const std::byte *in, llaisysDataType_t out_type, llaisysDataType_t in_type,
+          const ElementwiseLayout<1> &layout);
+}
@@ -0,0 +1,27 @@
+#include "op.hpp"
+
+#include "../../core/llaisys_core.hpp"
+#include "../../utils.hpp"
+#include "../elementwise/elementwise.hpp"
+#include "../elementwise/fusion.hpp"
+#include "../graph/graph.hpp"
+#include "../registry/registry.hpp"
+
+#include "cpu/cast_cpu.hpp"
+
+namespace llaisys::ops {
+void cast(tensor_t out, tensor_t in) {
+    CHECK_SAME_DEVICE(out, in);
+    auto in_strides = broadcastStrides(in, out->shape());
+
+    if (recordFused(cpu::FusedOp::Cast, out, {in})) {
+        return;
+    }
+
+    retainForCapture(out, in);
+    cpu::ElementwiseLayout<1> layout{out->ndim(), out->shape().data(), out->strides().data(),
+                                     {keepForCapture(in_strides).data()}};
+    static KernelSite site("cast", cpu::cast);
+    site(out->deviceType(), out->deviceId(), out->dtype(), out->data(), in->data(), out->dtype(), in->dtype(), layout);
+}
+} // namespace llaisys::ops
@@ -0,0 +1,8 @@
+#pragma once
+
+#include "../../tensor/tensor.hpp"
+
+namespace llaisys::ops {
+// Converts `in` to the dtype of `out`, broadcasting it to the shape of `out`. Supports F32, BF16 and F16.
+void cast(tensor_t out, tensor_t in);
+}
@@ -0,0 +1,235 @@
+#pragma once
+#include "llaisys.h"
+
+#include "../../../utils.hpp"
+#include "../../../utils/thread_pool.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace llaisys::ops::cpu {
+// Layout of an elementwise op over `shape`: element strides of the output and of each of its N inputs.
+// Inputs are broadcast by zero strides.
+template <size_t N>
+struct ElementwiseLayout {
+    size_t ndim;
+    const size_t *shape;
+    const ptrdiff_t *out_strides;
+    std::array<const ptrdiff_t *, N> in_strides;
+};
+
+namespace elementwise {
+// Operands are converted to and from float in blocks of this many elements, which stay in L1.
+constexpr size_t BLOCK = 256;
+// Ops with fewer elements stay on the calling thread.
+constexpr size_t PARALLEL_NUMEL = 1 << 16;
+
+// Inline so the block loops vectorize; rounding matches utils::cast.
+inline float bf16ToF32(bf16_t val) {
+    uint32_t bits = static_cast<uint32_t>(val._v) << 16;
+    float out;
+    std::memcpy(&out, &bits, sizeof(out));
+    return out;
+}
+
+inline bf16_t f32ToBf16(float val) {
+    uint32_t bits;
+    std::memcpy(&bits, &val, sizeof(bits));
+    return bf16_t{static_cast<uint16_t>((bits + 0x7FFF + ((bits >> 16) & 1)) >> 16)};
+}
+
+template <typename T>
+float toFloat(T val) {
+    if constexpr (std::is_same_v<T, bf16_t>) {
+        return bf16ToF32(val);
+    } else {
+        return utils::cast<float>(val);
+    }
+}
+
+template <typename T>
+T fromFloat(float val) {
+    if constexpr (std::is_same_v<T, bf16_t>) {
+        return f32ToBf16(val);
+    } else {
+        return utils::cast<T>(val);
+    }
+}
+
+template <typename T>
+void load_(float *dst, const T *src, size_t n, ptrdiff_t stride) {
+    if (stride == 1) {
+        for (size_t i = 0; i < n; ++i) {
+            dst[i] = toFloat(src[i]);
+        }
+    } else if (stride == 0) {
+        std::fill_n(dst, n, toFloat(src[0]));
+    } else {
+        for (size_t i = 0; i < n; ++i) {
+            dst[i] = toFloat(src[i * stride]);
+        }
+    }
+}
+
+template <typename T>
+void store_(T *dst, const float *src, size_t n, ptrdiff_t stride) {
+    if (stride == 1) {
+        for (size_t i = 0; i < n; ++i) {
+            dst[i] = fromFloat<T>(src[i]);
+        }
+    } else {
+        for (size_t i = 0; i < n; ++i) {
+            dst[i * stride] = fromFloat<T>(src[i]);
+        }
+    }
+}
+
+inline void load(float *dst, const std::byte *src, llaisysDataType_t type, size_t n, ptrdiff_t stride) {
+    switch (type) {
+    case LLAISYS_DTYPE_F32:
+        return load_(dst, reinterpret_cast<const float *>(src), n, stride);
+    case LLAISYS_DTYPE_BF16:
+        return load_(dst, reinterpret_cast<const bf16_t *>(src), n, stride);
+    case LLAISYS_DTYPE_F16:
+        return load_(dst, reinterpret_cast<const fp16_t *>(src), n, stride);
+    default:
+        EXCEPTION_UNSUPPORTED_DATATYPE(type);
+    }
+}
+
+inline void store(std::byte *dst, const float *src, llaisysDataType_t type, size_t n, ptrdiff_t stride) {
+    switch (type) {
+    case LLAISYS_DTYPE_F32:
+        return store_(reinterpret_cast<float *>(dst), src, n, stride);
+    case LLAISYS_DTYPE_BF16:
+        return store_(reinterpret_cast<bf16_t *>(dst), src, n, stride);
+    case LLAISYS_DTYPE_F16:
+        return store_(reinterpret_cast<fp16_t *>(dst), src, n, stride);
+    default:
+        EXCEPTION_UNSUPPORTED_DATATYPE(type);
+    }
+}
+
+template <typename F, size_t N, size_t... Is>
+void apply(F &f, float *out, const std::array<const float *, N> &in, size_t n, std::index_sequence<Is...>) {
+    if constexpr (std::is_invocable_v<F &, float *, decltype(in[Is])..., size_t>) {
+        f(out, in[Is]..., n);
+    } else {
+        for (size_t i = 0; i < n; ++i) {
+            out[i] = f(in[Is][i]...);
+        }
+    }
+}
+} // namespace elementwise
+
+// out = f(in...) elementwise, with f taking and returning float. Operands may have different dtypes (F32, BF16
+// or F16) and any strides; the output may be one of the inputs, but must not partially overlap them.
+template <size_t N, typename F>
+void elementwise_(F f, std::byte *out, llaisysDataType_t out_type, const std::array<const std::byte *, N> &in,
+                  const std::array<llaisysDataType_t, N> &in_types, const ElementwiseLayout<N> &layout) {
+    using namespace elementwise;
+    using Strides = std::array<ptrdiff_t, N + 1>; // output first
+
+    // Drop unit dimensions and merge dimensions that are contiguous in every operand.
+    std::vector<size_t> shape;
+    std::vector<Strides> strides;
+    for (size_t d = 0; d < layout.ndim; ++d) {
+        size_t size = layout.shape[d];
+        if (size == 0) {
+            return;
+        }
+        if (size == 1) {
+            continue;
+        }
+        Strides s;
+        s[0] = layout.out_strides[d];
+        for (size_t k = 0; k < N; ++k) {
+            s[k + 1] = layout.in_strides[k][d];
+        }
+        bool merge = !shape.empty();
+        for (size_t k = 0; merge && k <= N; ++k) {
+            merge = strides.back()[k] == s[k] * static_cast<ptrdiff_t>(size);
+        }
+        if (merge) {
+            shape.back() *= size;
+            strides.back() = s;
+        } else {
+            shape.push_back(size);
+            strides.push_back(s);
+        }
+    }
+    if (shape.empty()) {
+        shape.push_back(1);
+        strides.push_back(Strides{});
+    }
+
+    // Work is split into blocks of the innermost dimension.
+    size_t ndim = shape.size();
+    size_t inner = shape.back();
+    size_t nblock = (inner + BLOCK - 1) / BLOCK;
+    size_t nouter = 1;
+    for (size_t d = 0; d + 1 < ndim; ++d) {
+        nouter *= shape[d];
+    }
+    std::array<size_t, N + 1> esize;
+    esize[0] = utils::dsize(out_type);
+    for (size_t k = 0; k < N; ++k) {
+        esize[k + 1] = utils::dsize(in_types[k]);
+    }
+
+    // Dense F32 blocks are computed in place, without going through the conversion buffers.
+    bool direct = out_type == LLAISYS_DTYPE_F32 && strides.back()[0] == 1;
+    for (size_t k = 0; k < N; ++k) {
+        direct = direct && in_types[k] == LLAISYS_DTYPE_F32 && strides.back()[k + 1] == 1;
+    }
+
+    auto run = [&](size_t begin, size_t end) {
+        float out_buf[BLOCK];
+        std::array<std::array<float, BLOCK>, N> in_buf;
+        std::array<const float *, N> in_ptr;
+        for (size_t u = begin; u < end; ++u) {
+            size_t start = (u % nblock) * BLOCK;
+            size_t n = std::min(BLOCK, inner - start);
+            Strides offset;
+            for (size_t k = 0; k <= N; ++k) {
+                offset[k] = static_cast<ptrdiff_t>(start) * strides.back()[k];
+            }
+            size_t rem = u / nblock;
+            for (size_t d = ndim - 1; d > 0; --d) {
+                size_t index = rem % shape[d - 1];
+                rem /= shape[d - 1];
+                for (size_t k = 0; k <= N; ++k) {
+                    offset[k] += static_cast<ptrdiff_t>(index) * strides[d - 1][k];
+                }
+            }
+            std::byte *out_data = out + offset[0] * static_cast<ptrdiff_t>(esize[0]);
+            for (size_t k = 0; k < N; ++k) {
+                const std::byte *in_data = in[k] + offset[k + 1] * static_cast<ptrdiff_t>(esize[k + 1]);
+                if (direct) {
+                    in_ptr[k] = reinterpret_cast<const float *>(in_data);
+                } else {
+                    load(in_buf[k].data(), in_data, in_types[k], n, strides.back()[k + 1]);
+                    in_ptr[k] = in_buf[k].data();
+                }
+            }
+            if (direct) {
+                apply(f, reinterpret_cast<float *>(out_data), in_ptr, n, std::make_index_sequence<N>());
+            } else {
+                apply(f, out_buf, in_ptr, n, std::make_index_sequence<N>());
+                store(out_data, out_buf, out_type, n, strides.back()[0]);
+            }
+        }
+    };
+    size_t nunit = nouter * nblock;
+    if (nunit > 1 && nouter * inner >= PARALLEL_NUMEL) {
+        utils::threadPool().parallelFor(nunit, run, 16);
+    } else {
+        run(0, nunit);
+    }
+}
+} // namespace llaisys::ops::cpu
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "../../../utils/vec_math.hpp"
+
+#include <cstddef>
+
+// Float functors of the elementwise ops, shared by their kernels and by fused chains so both round alike.
+// Functors may instead take a whole block, f(out, in..., n), to run vector code over it.
+namespace llaisys::ops::cpu::elementwise {
+struct Add {
+    float operator()(float x, float y) const { return x + y; }
+};
+
+struct Mul {
+    float operator()(float x, float y) const { return x * y; }
+};
+
+struct Scale {
+    float scale;
+    float operator()(float x) const { return x * scale; }
+};
+
+struct Identity {
+    float operator()(float x) const { return x; }
+};
+
+// up * gate * sigmoid(gate)
+struct SwiGLU {
+    void operator()(float *out, const float *gate, const float *up, size_t n) const {
+        utils::vec::swiglu(out, gate, up, n);
+    }
+};
+} // namespace llaisys::ops::cpu::elementwise
@@ -0,0 +1,153 @@
+#include "fusion_cpu.hpp"
+
+#include "elementwise_cpu.hpp"
+#include "functors.hpp"
+
+namespace {
+using namespace llaisys::ops::cpu::elementwise;
+
+template <typename F>
+void map(F f, float *out, const float *x, size_t n) {
+    apply(f, out, std::array<const float *, 1>{x}, n, std::make_index_sequence<1>());
+}
+
+template <typename F>
+void map(F f, float *out, const float *x, const float *y, size_t n) {
+    apply(f, out, std::array<const float *, 2>{x, y}, n, std::make_index_sequence<2>());
+}
+
+void round(float *val, size_t n, llaisysDataType_t dtype) {
+    switch (dtype) {
+    case LLAISYS_DTYPE_F32:
+        return;
+    case LLAISYS_DTYPE_BF16:
+        for (size_t i = 0; i < n; ++i) {
+            val[i] = bf16ToF32(f32ToBf16(val[i]));
+        }
+        return;
+    case LLAISYS_DTYPE_F16:
+        for (size_t i = 0; i < n; ++i) {
+            val[i] = llaisys::utils::cast<float>(llaisys::utils::cast<llaisys::fp16_t>(val[i]));
+        }
+        return;
+    default:
+        EXCEPTION_UNSUPPORTED_DATATYPE(dtype);
+    }
+}
+} // namespace
+
+namespace llaisys::ops::cpu {
+void fused(const size_t *shape_, size_t ndim_, const std::vector<FusedValue> &values) {
+    // Operands are the values that touch memory; their strides are kept per dimension, operand-major.
+    std::vector<size_t> operands;
+    for (size_t v = 0; v < values.size(); ++v) {
+        if (values[v].data != nullptr) {
+            operands.push_back(v);
+        }
+    }
+    if (operands.empty()) {
+        return;
+    }
+    size_t nop = operands.size();
+
+    // Drop unit dimensions and merge dimensions that are contiguous in every operand.
+    std::vector<size_t> shape;
+    std::vector<ptrdiff_t> strides;
+    for (size_t d = 0; d < ndim_; ++d) {
+        size_t size = shape_[d];
+        if (size == 0) {
+            return;
+        }
+        if (size == 1) {
+            continue;
+        }
+        bool merge = !shape.empty();
+        for (size_t k = 0; merge && k < nop; ++k) {
+            merge = strides[strides.size() - nop + k] == values[operands[k]].strides[d] * static_cast<ptrdiff_t>(size);
+        }
+        if (merge) {
+            shape.back() *= size;
+            strides.resize(strides.size() - nop);
+        } else {
+            shape.push_back(size);
+        }
+        for (size_t k = 0; k < nop; ++k) {
+            strides.push_back(values[operands[k]].strides[d]);
+        }
+    }
+    if (shape.empty()) {
+        shape.push_back(1);
+        strides.assign(nop, 0);
+    }
+
+    size_t ndim = shape.size();
+    size_t inner = shape.back();
+    size_t nblock = (inner + BLOCK - 1) / BLOCK;
+    size_t nouter = 1;
+    for (size_t d = 0; d + 1 < ndim; ++d) {
+        nouter *= shape[d];
+    }
+    const ptrdiff_t *inner_strides = strides.data() + (ndim - 1) * nop;
+
+    auto run = [&](size_t begin, size_t end) {
+        std::vector<float> buf(values.size() * BLOCK);
+        std::vector<ptrdiff_t> offset(nop);
+        for (size_t u = begin; u < end; ++u) {
+            size_t start = (u % nblock) * BLOCK;
+            size_t n = std::min(BLOCK, inner - start);
+            for (size_t k = 0; k < nop; ++k) {
+                offset[k] = static_cast<ptrdiff_t>(start) * inner_strides[k];
+            }
+            size_t rem = u / nblock;
+            for (size_t d = ndim - 1; d > 0; --d) {
+                size_t index = rem % shape[d - 1];
+                rem /= shape[d - 1];
+                for (size_t k = 0; k < nop; ++k) {
+                    offset[k] += static_cast<ptrdiff_t>(index) * strides[(d - 1) * nop + k];
+                }
+            }
+
+            for (size_t v = 0, k = 0; v < values.size(); ++v) {
+                const FusedValue &value = values[v];
+                float *out = buf.data() + v * BLOCK;
+                const float *x = buf.data() + value.args[0] * BLOCK;
+                const float *y = buf.data() + value.args[1] * BLOCK;
+                std::byte *data = nullptr;
+                if (value.data != nullptr) {
+                    data = value.data + offset[k] * static_cast<ptrdiff_t>(utils::dsize(value.dtype));
+                }
+                switch (value.op) {
+                case FusedOp::Input:
+                    load(out, data, value.dtype, n, inner_strides[k++]);
+                    continue;
+                case FusedOp::Add:
+                    map(Add{}, out, x, y, n);
+                    break;
+                case FusedOp::Mul:
+                    map(Mul{}, out, x, y, n);
+                    break;
+                case FusedOp::Scale:
+                    map(Scale{value.scale}, out, x, n);
+                    break;
+                case FusedOp::Cast:
+                    map(Identity{}, out, x, n);
+                    break;
+                case FusedOp::SwiGLU:
+                    map(SwiGLU{}, out, x, y, n);
+                    break;
+                }
+                round(out, n, value.dtype);
+                if (data != nullptr) {
+                    store(data, out, value.dtype, n, inner_strides[k++]);
+                }
+            }
+        }
+    };
+    size_t nunit = nouter * nblock;
+    if (nunit > 1 && nouter * inner >= PARALLEL_NUMEL) {
+        utils::threadPool().parallelFor(nunit, run, 16);
+    } else {
+        run(0, nunit);
+    }
+}
+} // namespace llaisys::ops::cpu
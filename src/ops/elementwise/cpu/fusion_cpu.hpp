@@ -0,0 +1,27 @@
+#pragma once
+#include "llaisys.h"
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+namespace llaisys::ops::cpu {
+enum class FusedOp { Input, Add, Mul, Scale, Cast, SwiGLU };
+
+// One value of a fused chain: an input read from memory, or the result of an op on earlier values.
+struct FusedValue {
+    FusedOp op;
+    std::array<size_t, 2> args; // indices of earlier values
+    float scale;
+    // Results are rounded to this dtype, as if they were stored and read back.
+    llaisysDataType_t dtype;
+    // Where the input is read from or the result written to, with element strides over the chain's shape.
+    // nullptr for results that are not stored.
+    std::byte *data;
+    const ptrdiff_t *strides;
+};
+
+// Evaluates the values in order over `shape`, one block of elements at a time, so every input is read once,
+// every stored result written once, and nothing else touches memory.
+void fused(const size_t *shape, size_t ndim, const std::vector<FusedValue> &values);
+} // namespace llaisys::ops::cpu
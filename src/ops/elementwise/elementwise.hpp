@@ -0,0 +1,20 @@
+#pragma once
+
+#include "../../tensor/tensor.hpp"
+#include "../../utils.hpp"
+
+namespace llaisys::ops {
+// Strides that read `in` as a tensor of `shape`, NumPy style: `in` is aligned to the trailing dimensions, and
+// its missing or size-1 dimensions are repeated with stride 0.
+inline TensorStrides broadcastStrides(const tensor_t &in, const TensorShape &shape) {
+    CHECK_ARGUMENT(in->ndim() <= shape.size(), "broadcast: input has more dimensions than the output");
+    TensorStrides strides(shape.size(), 0);
+    size_t lead = shape.size() - in->ndim();
+    for (size_t i = 0; i < in->ndim(); ++i) {
+        size_t size = in->shape()[i];
+        CHECK_ARGUMENT(size == shape[lead + i] || size == 1, "broadcast: shapes are not compatible");
+        strides[lead + i] = size == 1 ? 0 : in->strides()[i];
+    }
+    return strides;
+}
+} // namespace llaisys::ops
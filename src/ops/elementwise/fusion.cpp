@@ -0,0 +1,186 @@
+#include "fusion.hpp"
+
+#include "elementwise.hpp"
+
+#include "../graph/graph.hpp"
+
+#include <memory>
+#include <vector>
+
+namespace llaisys::ops {
+namespace {
+// Longer chains are run and a new one is started.
+constexpr size_t MAX_VALUES = 32;
+
+struct Chain {
+    bool enabled = false;
+    TensorShape shape;
+    std::vector<cpu::FusedValue> values;
+    // Per value: the memory it is read from or written to, for inputs broadcast to the chain's shape.
+    std::vector<TensorView> views;
+    // Per result: its output storage, which is only written if still alive when the chain runs.
+    std::vector<std::weak_ptr<core::Storage>> storages;
+    // Per result: false once a later result overwrites the same elements.
+    std::vector<bool> stored;
+    std::vector<tensor_t> inputs;
+};
+
+Chain &chain() {
+    thread_local Chain thread_chain;
+    return thread_chain;
+}
+
+bool fusable(llaisysDataType_t dtype) {
+    return dtype == LLAISYS_DTYPE_F32 || dtype == LLAISYS_DTYPE_BF16 || dtype == LLAISYS_DTYPE_F16;
+}
+
+// First and one past the last byte a view can touch.
+std::pair<const std::byte *, const std::byte *> extent(const TensorView &view) {
+    ptrdiff_t lo = 0, hi = 0;
+    for (size_t d = 0; d < view.shape.size(); ++d) {
+        ptrdiff_t span = view.strides[d] * static_cast<ptrdiff_t>(view.shape[d] - 1);
+        (span < 0 ? lo : hi) += span;
+    }
+    auto esize = static_cast<ptrdiff_t>(utils::dsize(view.dtype));
+    return {view.data + lo * esize, view.data + (hi + 1) * esize};
+}
+
+bool same(const TensorView &a, const TensorView &b) {
+    return a.data == b.data && a.dtype == b.dtype && a.strides == b.strides;
+}
+
+bool overlap(const TensorView &a, const TensorView &b) {
+    auto [a_lo, a_hi] = extent(a);
+    auto [b_lo, b_hi] = extent(b);
+    return a_lo < b_hi && b_lo < a_hi;
+}
+
+bool live(const Chain &c, size_t v) {
+    return c.values[v].op == cpu::FusedOp::Input || !c.storages[v].expired();
+}
+
+// Whether elements can be read from (or written to) `view` inside the chain: every pending value it overlaps
+// must cover exactly the same elements, so each block reads and writes only its own.
+bool compatible(const Chain &c, const TensorView &view, bool write) {
+    for (size_t v = 0; v < c.values.size(); ++v) {
+        if ((write || c.values[v].op != cpu::FusedOp::Input) && live(c, v) && overlap(c.views[v], view)
+            && !same(c.views[v], view)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+TensorView broadcastView(const tensor_t &t, const TensorShape &shape) {
+    return TensorView{t->data(), t->dtype(), shape, broadcastStrides(t, shape)};
+}
+} // namespace
+
+void enableFusion(bool enable) {
+    if (!enable) {
+        flushFusion();
+    }
+    chain().enabled = enable;
+}
+
+void flushFusion() {
+    Chain &c = chain();
+    if (c.values.empty()) {
+        return;
+    }
+    TensorShape shape = c.shape;
+    auto values = std::move(c.values);
+    auto views = std::move(c.views);
+    auto inputs = std::move(c.inputs);
+    // Outputs that are written, kept alive with the graph being captured like the tensors of any other op.
+    std::vector<std::shared_ptr<core::Storage>> outputs;
+    for (size_t v = 0; v < values.size(); ++v) {
+        values[v].strides = views[v].strides.data();
+        if (values[v].op != cpu::FusedOp::Input && (!c.stored[v] || c.storages[v].expired())) {
+            values[v].data = nullptr;
+        } else if (values[v].op != cpu::FusedOp::Input) {
+            outputs.push_back(c.storages[v].lock());
+        }
+    }
+    c.values.clear();
+    c.views.clear();
+    c.storages.clear();
+    c.stored.clear();
+    c.inputs.clear();
+    cpu::fused(shape.data(), shape.size(), values);
+
+    if (Graph *graph = capturingGraph()) {
+        // Copies of the node point their values at their own copy of the strides.
+        auto run = [shape, values, views = std::move(views)]() mutable {
+            for (size_t v = 0; v < values.size(); ++v) {
+                values[v].strides = views[v].strides.data();
+            }
+            cpu::fused(shape.data(), shape.size(), values);
+        };
+        graph->add(LLAISYS_DEVICE_CPU, 0, std::move(run));
+        graph->retain(std::move(inputs), std::move(outputs));
+    }
+}
+
+bool recordFused(cpu::FusedOp op, const tensor_t &out, std::initializer_list<tensor_t> args, float scale) {
+    Chain &c = chain();
+    if (!c.enabled) {
+        return false;
+    }
+    bool ok = out->deviceType() == LLAISYS_DEVICE_CPU && fusable(out->dtype());
+    for (const auto &arg : args) {
+        ok = ok && fusable(arg->dtype());
+    }
+    if (!ok) {
+        flushFusion();
+        return false;
+    }
+
+    TensorView out_view = out->asView();
+    std::vector<TensorView> arg_views;
+    for (const auto &arg : args) {
+        arg_views.push_back(broadcastView(arg, out->shape()));
+    }
+    bool join = c.values.empty()
+             || (c.shape == out->shape() && c.values.size() + args.size() + 1 <= MAX_VALUES
+                 && compatible(c, out_view, true));
+    for (const auto &view : arg_views) {
+        join = join && compatible(c, view, false);
+    }
+    if (!join) {
+        flushFusion();
+    }
+    c.shape = out->shape();
+
+    auto push = [&](const cpu::FusedValue &value, const TensorView &view) {
+        c.values.push_back(value);
+        c.views.push_back(view);
+        c.storages.emplace_back();
+        c.stored.push_back(true);
+        return c.values.size() - 1;
+    };
+    cpu::FusedValue value{op, {0, 0}, scale, out->dtype(), out->data(), nullptr};
+    auto arg = args.begin();
+    for (size_t i = 0; i < args.size(); ++i, ++arg) {
+        // The latest value holding these elements, or a new input.
+        size_t v = c.values.size();
+        while (v > 0 && !(live(c, v - 1) && same(c.views[v - 1], arg_views[i]))) {
+            --v;
+        }
+        if (v == 0) {
+            c.inputs.push_back(*arg);
+            v = push({cpu::FusedOp::Input, {0, 0}, 0.0f, arg_views[i].dtype, arg_views[i].data, nullptr},
+                     arg_views[i]) + 1;
+        }
+        value.args[i] = v - 1;
+    }
+    for (size_t v = 0; v < c.values.size(); ++v) {
+        if (c.values[v].op != cpu::FusedOp::Input && same(c.views[v], out_view)) {
+            c.stored[v] = false;
+        }
+    }
+    push(value, out_view);
+    c.storages.back() = out->storage();
+    return true;
+}
+} // namespace llaisys::ops
@@ -0,0 +1,20 @@
+#pragma once
+
+#include "../../tensor/tensor.hpp"
+
+#include "cpu/fusion_cpu.hpp"
+
+#include <initializer_list>
+
+namespace llaisys::ops {
+// Lazy elementwise fusion. While it is enabled on a thread, CPU calls to add, mul, scale, cast and swiglu on that
+// thread are recorded instead of run, and the recorded chain runs as one loop that reads each input once and
+// writes each output once. The chain runs at the next call to any other op, at flushFusion(), or when fusion is
+// disabled; until then the outputs hold stale data. Outputs whose storage is freed before that are never written.
+void enableFusion(bool enable);
+void flushFusion();
+
+// Adds out = op(args...) to the chain of the calling thread, running the chain first if the op cannot join it.
+// Returns false, with nothing left pending, if fusion is disabled or the op cannot be fused and must run now.
+bool recordFused(cpu::FusedOp op, const tensor_t &out, std::initializer_list<tensor_t> args, float scale = 0.0f);
+} // namespace llaisys::ops
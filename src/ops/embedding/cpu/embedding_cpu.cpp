@@ -1,36 +1,88 @@
 #include "embedding_cpu.hpp"
 
 #include "../../../utils.hpp"
+#include "../../../utils/thread_pool.hpp"
 
+#include <algorithm>
 #include <cstring>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
-template <typename T>
-void embedding_(T *out, const int64_t *index, const T *weight, size_t vocab_size, size_t embedding_dim,
-                size_t seq_len) {
-    for (size_t i = 0; i < seq_len; ++i) {
-        int64_t idx = index[i];
-        if (idx < 0 || idx >= static_cast<int64_t>(vocab_size)) {
-            continue; // Skip invalid indices
+namespace {
+// Gathers smaller than this stay on the calling thread.
+constexpr size_t PARALLEL_BYTES = 1 << 20;
+// Smallest share of a parallel gather handed to one thread.
+constexpr size_t GRAIN_BYTES = 1 << 18;
+// Source rows are prefetched this many rows ahead of the one being copied.
+constexpr size_t PREFETCH_ROWS = 4;
+constexpr size_t CACHE_LINE = 64;
+
+void prefetch(const std::byte *row, size_t bytes) {
+#if defined(__GNUC__)
+    for (size_t offset = 0; offset < bytes; offset += CACHE_LINE) {
+        __builtin_prefetch(row + offset);
+    }
+#else
+    (void)row;
+    (void)bytes;
+#endif
+}
+
+// Copies rows[k].second to rows[k].first for every k, in parallel when large.
+void copyRows(const std::vector<std::pair<std::byte *, const std::byte *>> &rows, size_t row_bytes) {
+    auto copy = [&](size_t begin, size_t end) {
+        for (size_t k = begin; k < end; ++k) {
+            if (k + PREFETCH_ROWS < end) {
+                prefetch(rows[k + PREFETCH_ROWS].second, row_bytes);
+            }
+            std::memcpy(rows[k].first, rows[k].second, row_bytes);
         }
-        std::memcpy(out + i * embedding_dim, weight + idx * embedding_dim, embedding_dim * sizeof(T));
+    };
+    if (rows.size() > 1 && rows.size() * row_bytes >= PARALLEL_BYTES) {
+        size_t grain = std::max<size_t>(1, GRAIN_BYTES / std::max<size_t>(1, row_bytes));
+        llaisys::utils::threadPool().parallelFor(rows.size(), copy, grain);
+    } else {
+        copy(0, rows.size());
     }
 }
+} // namespace
 
 namespace llaisys::ops::cpu {
 void embedding(std::byte *out, const std::byte *index, const std::byte *weight, size_t vocab_size,
-               size_t embedding_dim, llaisysDataType_t type, size_t seq_len) {
-    switch (type) {
-    case LLAISYS_DTYPE_F32:
-        return embedding_(reinterpret_cast<float *>(out), reinterpret_cast<const int64_t *>(index),
-                          reinterpret_cast<const float *>(weight), vocab_size, embedding_dim, seq_len);
-    case LLAISYS_DTYPE_BF16:
-        return embedding_(reinterpret_cast<llaisys::bf16_t *>(out), reinterpret_cast<const int64_t *>(index),
-                          reinterpret_cast<const llaisys::bf16_t *>(weight), vocab_size, embedding_dim, seq_len);
-    case LLAISYS_DTYPE_F16:
-        return embedding_(reinterpret_cast<llaisys::fp16_t *>(out), reinterpret_cast<const int64_t *>(index),
-                          reinterpret_cast<const llaisys::fp16_t *>(weight), vocab_size, embedding_dim, seq_len);
-    default:
-        EXCEPTION_UNSUPPORTED_DATATYPE(type);
+               size_t embedding_dim, llaisysDataType_t type, size_t seq_len, ptrdiff_t out_stride,
+               ptrdiff_t weight_stride) {
+    auto ids = reinterpret_cast<const int64_t *>(index);
+    for (size_t i = 0; i < seq_len; ++i) {
+        CHECK_ARGUMENT(ids[i] >= 0 && ids[i] < static_cast<int64_t>(vocab_size),
+                       "embedding: index " + std::to_string(ids[i]) + " at position " + std::to_string(i)
+                           + " is out of range");
+    }
+
+    auto esize = static_cast<ptrdiff_t>(utils::dsize(type));
+    size_t row_bytes = embedding_dim * static_cast<size_t>(esize);
+    auto out_row = [&](size_t i) { return out + static_cast<ptrdiff_t>(i) * out_stride * esize; };
+    auto weight_row = [&](int64_t id) { return weight + id * weight_stride * esize; };
+
+    // Each distinct id is gathered from the table once; repeats are copied from its first output row afterwards,
+    // which is still in cache.
+    std::vector<std::pair<std::byte *, const std::byte *>> gather, repeat;
+    gather.reserve(seq_len);
+    if (seq_len == 1) {
+        gather.emplace_back(out_row(0), weight_row(ids[0]));
+    } else {
+        std::unordered_map<int64_t, size_t> first;
+        first.reserve(seq_len);
+        for (size_t i = 0; i < seq_len; ++i) {
+            auto [it, inserted] = first.emplace(ids[i], i);
+            if (inserted) {
+                gather.emplace_back(out_row(i), weight_row(ids[i]));
+            } else {
+                repeat.emplace_back(out_row(i), out_row(it->second));
+            }
+        }
     }
+    copyRows(gather, row_bytes);
+    copyRows(repeat, row_bytes);
 }
 } // namespace llaisys::ops::cpu
@@ -4,6 +4,8 @@
 #include <cstddef>
 
 namespace llaisys::ops::cpu {
+// Row strides are in elements. Throws if an index is out of range, before writing anything.
 void embedding(std::byte *out, const std::byte *index, const std::byte *weight, size_t vocab_size,
-               size_t embedding_dim, llaisysDataType_t type, size_t seq_len);
+               size_t embedding_dim, llaisysDataType_t type, size_t seq_len, ptrdiff_t out_stride,
+               ptrdiff_t weight_stride);
 }
@@ -2,6 +2,9 @@
 
 #include "../../core/llaisys_core.hpp"
 #include "../../utils.hpp"
+#include "../elementwise/fusion.hpp"
+#include "../graph/graph.hpp"
+#include "../registry/registry.hpp"
 
 #include "cpu/embedding_cpu.hpp"
 
@@ -15,27 +18,15 @@ void embedding(tensor_t out, tensor_t index, tensor_t weight) {
     CHECK_ARGUMENT(out->shape()[0] == index->shape()[0] && out->shape()[1] == weight->shape()[1],
                    "embedding: shape mismatch");
     CHECK_ARGUMENT(out->dtype() == weight->dtype(), "embedding: dtype mismatch");
-    ASSERT(out->isContiguous() && index->isContiguous() && weight->isContiguous(),
-           "Embedding: all tensors must be contiguous.");
+    // Rows may be strided, e.g. a slot of a packed batch buffer.
+    ASSERT(index->isContiguous() && out->strides()[1] == 1 && weight->strides()[1] == 1,
+           "Embedding: index and rows must be contiguous.");
 
-    if (out->deviceType() == LLAISYS_DEVICE_CPU) {
-        return cpu::embedding(out->data(), index->data(), weight->data(), weight->shape()[0], weight->shape()[1],
-                              out->dtype(), index->numel());
-    }
+    flushFusion();
 
-    llaisys::core::context().setDevice(out->deviceType(), out->deviceId());
-
-    switch (out->deviceType()) {
-    case LLAISYS_DEVICE_CPU:
-        return cpu::embedding(out->data(), index->data(), weight->data(), weight->shape()[0], weight->shape()[1],
-                              out->dtype(), index->numel());
-#ifdef ENABLE_NVIDIA_API
-    case LLAISYS_DEVICE_NVIDIA:
-        TO_BE_IMPLEMENTED();
-        return;
-#endif
-    default:
-        EXCEPTION_UNSUPPORTED_DEVICE;
-    }
+    retainForCapture(out, index, weight);
+    static KernelSite site("embedding", cpu::embedding);
+    site(out->deviceType(), out->deviceId(), out->dtype(), out->data(), index->data(), weight->data(),
+         weight->shape()[0], weight->shape()[1], out->dtype(), index->numel(), out->strides()[0], weight->strides()[0]);
 }
 } // namespace llaisys::ops
@@ -0,0 +1,125 @@
+#include "graph.hpp"
+
+#include "../../core/llaisys_core.hpp"
+#include "../elementwise/fusion.hpp"
+#include "../registry/registry.hpp"
+
+namespace llaisys::ops {
+namespace {
+Graph *&capturing() {
+    thread_local Graph *graph = nullptr;
+    return graph;
+}
+} // namespace
+
+Graph::Graph() : _generation(0) {}
+
+bool Graph::ready() const {
+    return !_nodes.empty() && _generation == registry::generation();
+}
+
+size_t Graph::size() const {
+    return _nodes.size();
+}
+
+void Graph::clear() {
+    _nodes.clear();
+    _retained.clear();
+    _generation = 0;
+}
+
+void Graph::replay() const {
+    // The device only needs setting where it changes, and never for the CPU.
+    const Node *last = nullptr;
+    for (const auto &node : _nodes) {
+        if (node.device != LLAISYS_DEVICE_CPU
+            && (last == nullptr || last->device != node.device || last->device_id != node.device_id)) {
+            core::context().setDevice(node.device, node.device_id);
+        }
+        node.run();
+        last = &node;
+    }
+}
+
+void Graph::add(llaisysDeviceType_t device, int device_id, std::function<void()> run) {
+    _nodes.push_back({device, device_id, std::move(run)});
+}
+
+Graph *capturingGraph() {
+    return capturing();
+}
+
+GraphCapture::GraphCapture(Graph &graph) : _graph(graph), _outer(capturing()), _finished(false) {
+    _graph.clear();
+    capturing() = &_graph;
+}
+
+GraphCapture::~GraphCapture() {
+    capturing() = _outer;
+    if (!_finished) {
+        _graph.clear();
+    }
+}
+
+void GraphCapture::finish() {
+    // An elementwise chain still pending belongs to the capture.
+    flushFusion();
+    // Taken at the end, as ops first called during the capture register their kernels.
+    _graph._generation = registry::generation();
+    _finished = true;
+}
+
+void hostNode(std::function<void()> fn) {
+    // Ops the caller left pending would otherwise be captured after the node that reads their outputs.
+    flushFusion();
+    Graph *graph = capturing();
+    if (graph == nullptr) {
+        return fn();
+    }
+    capturing() = nullptr;
+    try {
+        fn();
+    } catch (...) {
+        capturing() = graph;
+        throw;
+    }
+    capturing() = graph;
+    graph->add(LLAISYS_DEVICE_CPU, 0, std::move(fn));
+}
+
+void runTasks(const utils::TaskGraph &tasks) {
+    // Ops the caller left pending would otherwise run after the tasks that read their outputs.
+    flushFusion();
+    Graph *graph = capturing();
+    if (graph == nullptr) {
+        auto &runtime = core::context().runtime();
+        llaisysDeviceType_t device = runtime.deviceType();
+        int device_id = runtime.deviceId();
+        utils::TaskGraph on_device;
+        for (size_t i = 0; i < tasks.size(); ++i) {
+            on_device.add(
+                [&tasks, i, device, device_id] {
+                    core::context().setDevice(device, device_id);
+                    tasks.fn(i)();
+                    // A task run on the caller's thread must not leave its elementwise ops pending.
+                    flushFusion();
+                },
+                tasks.deps(i));
+        }
+        return on_device.run();
+    }
+
+    // Captured one after another on this thread, as capture state is per thread.
+    auto parts = std::make_shared<std::vector<Graph>>(tasks.size());
+    for (size_t i = 0; i < tasks.size(); ++i) {
+        GraphCapture capture((*parts)[i]);
+        tasks.fn(i)();
+        capture.finish();
+    }
+    utils::TaskGraph replay;
+    for (size_t i = 0; i < tasks.size(); ++i) {
+        replay.add([parts, i] { (*parts)[i].replay(); }, tasks.deps(i));
+    }
+    graph->add(LLAISYS_DEVICE_CPU, 0, [replay] { replay.run(); });
+}
+} // namespace llaisys::ops
@@ -0,0 +1,106 @@
+#pragma once
+#include "llaisys.h"
+
+#include "../../utils/thread_pool.hpp"
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Op graphs. While a graph is being captured on a thread, every op called on that thread still runs, and is also
+// appended to the graph as the kernel it resolved to, bound to the raw pointers, sizes and strides of that call.
+// Replaying the graph runs the same kernels on the same memory without validating arguments, building views or
+// dispatching again, so it suits steps that repeat with identical shapes, like decoding one token. Only the
+// contents of the bound buffers may change between replays; anything else that varies goes in a host node.
+namespace llaisys::ops {
+class Graph {
+private:
+    struct Node {
+        llaisysDeviceType_t device;
+        int device_id;
+        std::function<void()> run;
+    };
+
+    std::vector<Node> _nodes;
+    // Tensors and metadata the bound pointers refer to.
+    std::vector<std::shared_ptr<void>> _retained;
+    // Registry generation at capture; kernels chosen under another one may no longer be the preferred ones.
+    uint64_t _generation;
+
+public:
+    Graph();
+
+    // Whether the graph holds a capture that is still valid to replay.
+    bool ready() const;
+    size_t size() const;
+    void clear();
+    void replay() const;
+
+    void add(llaisysDeviceType_t device, int device_id, std::function<void()> run);
+
+    // Keeps `objects` alive as long as the graph.
+    template <typename... Ts>
+    void retain(Ts &&...objects) {
+        _retained.push_back(std::make_shared<std::tuple<std::decay_t<Ts>...>>(std::forward<Ts>(objects)...));
+    }
+
+    // A copy of `value` owned by the graph.
+    template <typename T>
+    T &keep(const T &value) {
+        auto kept = std::make_shared<T>(value);
+        _retained.push_back(kept);
+        return *kept;
+    }
+
+    friend class GraphCapture;
+};
+
+// The graph being captured on the calling thread, or nullptr.
+Graph *capturingGraph();
+
+// Captures the ops called on this thread into `graph`, replacing what it held, until destroyed. The capture is
+// kept only if finish() is called first, so a step that throws leaves the graph empty.
+class GraphCapture {
+private:
+    Graph &_graph;
+    Graph *_outer;
+    bool _finished;
+
+public:
+    explicit GraphCapture(Graph &graph);
+    ~GraphCapture();
+    GraphCapture(const GraphCapture &) = delete;
+    GraphCapture &operator=(const GraphCapture &) = delete;
+
+    void finish();
+};
+
+// Keeps the tensors an op passes to its kernel, and so their storage and metadata, alive with the graph being
+// captured, if any.
+template <typename... Ts>
+void retainForCapture(Ts &&...objects) {
+    if (Graph *graph = capturingGraph()) {
+        graph->retain(std::forward<Ts>(objects)...);
+    }
+}
+
+// For metadata an op computes and passes to its kernel by pointer: the graph's copy while capturing, else `local`.
+template <typename T>
+T &keepForCapture(T &local) {
+    Graph *graph = capturingGraph();
+    return graph != nullptr ? graph->keep(local) : local;
+}
+
+// Runs `fn`. While capturing, `fn` is recorded as one node in place of the ops it calls, and so runs again on
+// every replay; it is for steps whose arguments change between replays.
+void hostNode(std::function<void()> fn);
+
+// Runs a graph of independent ops, e.g. the gate and up projections of a layer, concurrently on the thread pool.
+// Every task runs on the caller's device. While capturing, each task is captured into a graph of its own, and
+// replaying runs those graphs with the same dependencies.
+void runTasks(const utils::TaskGraph &tasks);
+} // namespace llaisys::ops
@@ -1,66 +1,226 @@
+// Intrinsics go first: llaisys.h defines __C, which they use as a parameter name.
+#if defined(__AVX2__) && defined(__FMA__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 #include "linear_cpu.hpp"
+#include "linear_tuning.hpp"
 
 #include "../../../utils.hpp"
+#include "../../../utils/thread_pool.hpp"
+#include "../../elementwise/cpu/elementwise_cpu.hpp"
+
+#include <algorithm>
+#include <type_traits>
+#include <vector>
+
+namespace {
+using llaisys::ops::cpu::GemmConfig;
+using llaisys::ops::cpu::elementwise::fromFloat;
+using llaisys::ops::cpu::elementwise::load_;
+using llaisys::ops::cpu::elementwise::toFloat;
+
+// Each dot product is accumulated in one vector register of partial sums.
+#if defined(__AVX2__) && defined(__FMA__)
+struct Lanes {
+    using V = __m256;
+    static constexpr size_t WIDTH = 8;
+    static V zero() { return _mm256_setzero_ps(); }
+    static V load(const float *p) { return _mm256_loadu_ps(p); }
+    static V fma(V a, V b, V c) { return _mm256_fmadd_ps(a, b, c); }
+    static float sum(V v) {
+        __m128 x = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+        x = _mm_add_ps(x, _mm_movehl_ps(x, x));
+        return _mm_cvtss_f32(_mm_add_ss(x, _mm_shuffle_ps(x, x, 1)));
+    }
+};
+#elif defined(__SSE2__)
+struct Lanes {
+    using V = __m128;
+    static constexpr size_t WIDTH = 4;
+    static V zero() { return _mm_setzero_ps(); }
+    static V load(const float *p) { return _mm_loadu_ps(p); }
+    static V fma(V a, V b, V c) { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+    static float sum(V x) {
+        x = _mm_add_ps(x, _mm_movehl_ps(x, x));
+        return _mm_cvtss_f32(_mm_add_ss(x, _mm_shuffle_ps(x, x, 1)));
+    }
+};
+#else
+struct Lanes {
+    using V = float;
+    static constexpr size_t WIDTH = 1;
+    static V zero() { return 0.0f; }
+    static V load(const float *p) { return *p; }
+    static V fma(V a, V b, V c) { return a * b + c; }
+    static float sum(V v) { return v; }
+};
+#endif
+
+// acc[r * acc_stride + c] += dot(a row r, b row c) over kc elements, for an MR x NR tile.
+template <size_t MR, size_t NR>
+void tile_(float *acc, size_t acc_stride, const float *a, ptrdiff_t a_stride, const float *b, ptrdiff_t b_stride,
+           size_t kc) {
+    typename Lanes::V sum[MR][NR];
+    for (size_t r = 0; r < MR; ++r) {
+        for (size_t c = 0; c < NR; ++c) {
+            sum[r][c] = Lanes::zero();
+        }
+    }
+    const size_t body = kc - kc % Lanes::WIDTH;
+    for (size_t k = 0; k < body; k += Lanes::WIDTH) {
+        typename Lanes::V a_k[MR];
+        for (size_t r = 0; r < MR; ++r) {
+            a_k[r] = Lanes::load(a + r * a_stride + k);
+        }
+        for (size_t c = 0; c < NR; ++c) {
+            typename Lanes::V b_k = Lanes::load(b + c * b_stride + k);
+            for (size_t r = 0; r < MR; ++r) {
+                sum[r][c] = Lanes::fma(a_k[r], b_k, sum[r][c]);
+            }
+        }
+    }
+    for (size_t r = 0; r < MR; ++r) {
+        for (size_t c = 0; c < NR; ++c) {
+            float total = Lanes::sum(sum[r][c]);
+            for (size_t k = body; k < kc; ++k) {
+                total += a[r * a_stride + k] * b[c * b_stride + k];
+            }
+            acc[r * acc_stride + c] += total;
+        }
+    }
+}
+
+using TileFn = void (*)(float *, size_t, const float *, ptrdiff_t, const float *, ptrdiff_t, size_t);
 
-#include <cstring>
+// Indexed by [rows - 1][features 1, 4 or 8].
+constexpr TileFn TILES[4][3] = {
+    {tile_<1, 1>, tile_<1, 4>, tile_<1, 8>},
+    {tile_<2, 1>, tile_<2, 4>, tile_<2, 8>},
+    {tile_<3, 1>, tile_<3, 4>, tile_<3, 8>},
+    {tile_<4, 1>, tile_<4, 4>, tile_<4, 8>},
+};
 
 template <typename T>
 void linear_(T *out, const T *in, const T *weight, const T *bias, size_t seq_len, size_t in_features,
-             size_t out_features) {
+             size_t out_features, ptrdiff_t out_stride, ptrdiff_t in_stride, ptrdiff_t weight_stride,
+             const GemmConfig &config) {
     // out = in @ weight^T + bias
     // out[i, j] = sum(in[i, k] * weight[j, k] for k in range(in_features)) + bias[j]
-    for (size_t i = 0; i < seq_len; ++i) {
-        for (size_t j = 0; j < out_features; ++j) {
-            float result = 0.0f;
-            const T *in_row = in + i * in_features;
-            const T *weight_row = weight + j * in_features;
-
-            // Compute dot product
-            for (size_t k = 0; k < in_features; ++k) {
-                if constexpr (std::is_same_v<T, llaisys::bf16_t> || std::is_same_v<T, llaisys::fp16_t>) {
-                    result += llaisys::utils::cast<float>(in_row[k]) * llaisys::utils::cast<float>(weight_row[k]);
-                } else {
-                    result += in_row[k] * weight_row[k];
-                }
-            }
+    const size_t m = seq_len, k = in_features, n = out_features;
+    const size_t mr = std::clamp<size_t>(config.mr, 1, 4);
+    const size_t nr_index = config.nr >= 8 ? 2 : 1;
+    const size_t nr = nr_index == 2 ? 8 : 4;
+    const size_t kc = std::max<size_t>(config.kc, Lanes::WIDTH);
+    const size_t nc = std::max<size_t>(config.nc, 1);
+    const size_t mc = config.mc == 0 ? m : std::max(config.mc, mr);
+
+    // F32 input is read in place; other dtypes are converted once, since every task reads all of it.
+    const float *a;
+    ptrdiff_t a_stride;
+    std::vector<float> a_buf;
+    if constexpr (std::is_same_v<T, float>) {
+        a = in;
+        a_stride = in_stride;
+    } else {
+        a_buf.resize(m * k);
+        for (size_t i = 0; i < m; ++i) {
+            load_(a_buf.data() + i * k, in + i * in_stride, k, 1);
+        }
+        a = a_buf.data();
+        a_stride = static_cast<ptrdiff_t>(k);
+    }
+
+    // Each task owns `nc` output features, so every weight row is read by one thread only.
+    size_t ntask = (n + nc - 1) / nc;
+    llaisys::utils::threadPool().parallelFor(ntask, [&](size_t t_begin, size_t t_end) {
+        thread_local std::vector<float> acc_buf, b_buf;
+        for (size_t t = t_begin; t < t_end; ++t) {
+            const size_t j0 = t * nc;
+            const size_t width = std::min(nc, n - j0);
+            for (size_t i0 = 0; i0 < m; i0 += mc) {
+                const size_t mb = std::min(mc, m - i0);
+                acc_buf.assign(mb * width, 0.0f);
 
-            // Add bias if present
-            if (bias != nullptr) {
-                if constexpr (std::is_same_v<T, llaisys::bf16_t> || std::is_same_v<T, llaisys::fp16_t>) {
-                    result += llaisys::utils::cast<float>(bias[j]);
-                } else {
-                    result += bias[j];
+                for (size_t k0 = 0; k0 < k; k0 += kc) {
+                    const size_t kb = std::min(kc, k - k0);
+                    // A panel of `width` weight rows, read in place or converted to float.
+                    const float *b;
+                    ptrdiff_t b_stride;
+                    if constexpr (std::is_same_v<T, float>) {
+                        b = weight + j0 * weight_stride + k0;
+                        b_stride = weight_stride;
+                    } else {
+                        b_buf.resize(width * kb);
+                        for (size_t jj = 0; jj < width; ++jj) {
+                            load_(b_buf.data() + jj * kb, weight + (j0 + jj) * weight_stride + k0, kb, 1);
+                        }
+                        b = b_buf.data();
+                        b_stride = static_cast<ptrdiff_t>(kb);
+                    }
+
+                    for (size_t i = 0; i < mb; i += mr) {
+                        const TileFn *tiles = TILES[std::min(mr, mb - i) - 1];
+                        const float *a_rows = a + (i0 + i) * a_stride + k0;
+                        float *acc = acc_buf.data() + i * width;
+                        size_t j = 0;
+                        for (; j + nr <= width; j += nr) {
+                            tiles[nr_index](acc + j, width, a_rows, a_stride, b + j * b_stride, b_stride, kb);
+                        }
+                        for (; j + 4 <= width; j += 4) {
+                            tiles[1](acc + j, width, a_rows, a_stride, b + j * b_stride, b_stride, kb);
+                        }
+                        for (; j < width; ++j) {
+                            tiles[0](acc + j, width, a_rows, a_stride, b + j * b_stride, b_stride, kb);
+                        }
+                    }
                 }
-            }
 
-            // Store result
-            if constexpr (std::is_same_v<T, llaisys::bf16_t> || std::is_same_v<T, llaisys::fp16_t>) {
-                out[i * out_features + j] = llaisys::utils::cast<T>(result);
-            } else {
-                out[i * out_features + j] = result;
+                for (size_t i = 0; i < mb; ++i) {
+                    const float *acc = acc_buf.data() + i * width;
+                    T *out_row = out + (i0 + i) * out_stride + j0;
+                    for (size_t jj = 0; jj < width; ++jj) {
+                        float result = acc[jj];
+                        if (bias != nullptr) {
+                            result += toFloat(bias[j0 + jj]);
+                        }
+                        out_row[jj] = fromFloat<T>(result);
+                    }
+                }
             }
         }
-    }
+    });
 }
+} // namespace
 
 namespace llaisys::ops::cpu {
-void linear(std::byte *out, const std::byte *in, const std::byte *weight, const std::byte *bias, size_t seq_len,
-            size_t in_features, size_t out_features, llaisysDataType_t type) {
+void linearBlocked(std::byte *out, const std::byte *in, const std::byte *weight, const std::byte *bias,
+                   size_t seq_len, size_t in_features, size_t out_features, llaisysDataType_t type,
+                   ptrdiff_t out_stride, ptrdiff_t in_stride, ptrdiff_t weight_stride, const GemmConfig &config) {
     switch (type) {
     case LLAISYS_DTYPE_F32:
         return linear_(reinterpret_cast<float *>(out), reinterpret_cast<const float *>(in),
                        reinterpret_cast<const float *>(weight), reinterpret_cast<const float *>(bias), seq_len,
-                       in_features, out_features);
+                       in_features, out_features, out_stride, in_stride, weight_stride, config);
     case LLAISYS_DTYPE_BF16:
         return linear_(reinterpret_cast<llaisys::bf16_t *>(out), reinterpret_cast<const llaisys::bf16_t *>(in),
                        reinterpret_cast<const llaisys::bf16_t *>(weight), reinterpret_cast<const llaisys::bf16_t *>(bias),
-                       seq_len, in_features, out_features);
+                       seq_len, in_features, out_features, out_stride, in_stride, weight_stride, config);
     case LLAISYS_DTYPE_F16:
         return linear_(reinterpret_cast<llaisys::fp16_t *>(out), reinterpret_cast<const llaisys::fp16_t *>(in),
                        reinterpret_cast<const llaisys::fp16_t *>(weight), reinterpret_cast<const llaisys::fp16_t *>(bias),
-                       seq_len, in_features, out_features);
+                       seq_len, in_features, out_features, out_stride, in_stride, weight_stride, config);
     default:
         EXCEPTION_UNSUPPORTED_DATATYPE(type);
     }
 }
+
+void linear(std::byte *out, const std::byte *in, const std::byte *weight, const std::byte *bias, size_t seq_len,
+            size_t in_features, size_t out_features, llaisysDataType_t type, ptrdiff_t out_stride,
+            ptrdiff_t in_stride, ptrdiff_t weight_stride) {
+    linearBlocked(out, in, weight, bias, seq_len, in_features, out_features, type, out_stride, in_stride,
+                  weight_stride, gemmConfig(seq_len, out_features, in_features, type));
+}
 } // namespace llaisys::ops::cpu
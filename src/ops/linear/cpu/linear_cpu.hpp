@@ -4,6 +4,26 @@
 #include <cstddef>
 
 namespace llaisys::ops::cpu {
+// Blocking of the GEMM behind linear. Output features are split into tasks of `nc` features spread over the
+// thread pool. A task walks the rows in blocks of `mc` (0 takes them all at once), so that a block's input rows
+// and accumulators stay in cache on long prefills. For each row block it walks K in blocks of `kc` and computes
+// each block in tiles of `mr` rows by `nr` features held in registers, with mr in 1..4 and nr 4 or 8.
+struct GemmConfig {
+    size_t mr;
+    size_t nr;
+    size_t kc;
+    size_t nc;
+    size_t mc;
+};
+
+// Rows of out, in and weight are `*_stride` elements apart; each row itself is dense. Uses the tuned blocking
+// for the shape when there is one.
 void linear(std::byte *out, const std::byte *in, const std::byte *weight, const std::byte *bias, size_t seq_len,
-            size_t in_features, size_t out_features, llaisysDataType_t type);
-}
+            size_t in_features, size_t out_features, llaisysDataType_t type, ptrdiff_t out_stride,
+            ptrdiff_t in_stride, ptrdiff_t weight_stride);
+
+// linear with an explicit blocking.
+void linearBlocked(std::byte *out, const std::byte *in, const std::byte *weight, const std::byte *bias,
+                   size_t seq_len, size_t in_features, size_t out_features, llaisysDataType_t type,
+                   ptrdiff_t out_stride, ptrdiff_t in_stride, ptrdiff_t weight_stride, const GemmConfig &config);
+} // namespace llaisys::ops::cpu
@@ -0,0 +1,290 @@
+#include "linear_tuning.hpp"
+
+#include "../../../utils.hpp"
+#include "../../../utils/thread_pool.hpp"
+#include "../../elementwise/cpu/elementwise_cpu.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace llaisys::ops::cpu {
+namespace {
+// Rows are benchmarked up to this many; longer prefills use the same blocking.
+constexpr size_t MAX_BUCKET = 64;
+// Each candidate runs at least this many times, and more while under MIN_SECONDS.
+constexpr size_t MIN_RUNS = 2;
+constexpr double MIN_SECONDS = 0.05;
+
+using ShapeKey = std::tuple<llaisysDataType_t, size_t, size_t, size_t>;
+using Configs = std::map<ShapeKey, GemmConfig>;
+
+// gemmConfig runs on every linear call, so it reads an immutable snapshot of the configs without locking. The
+// mutex only serializes loading and tuning, which publish a new snapshot; old ones are kept alive for readers
+// that may still hold them.
+struct Tuning {
+    std::mutex mutex;
+    std::string cpu;
+    size_t threads = 0;
+    std::filesystem::path path;
+    std::atomic<const Configs *> configs{nullptr};
+    std::vector<std::unique_ptr<const Configs>> snapshots;
+};
+
+// Never destroyed, so linear stays callable from other static destructors.
+Tuning &tuning() {
+    static Tuning *state = new Tuning();
+    return *state;
+}
+
+size_t bucket(size_t m) {
+    size_t b = 1;
+    while (b < m && b < MAX_BUCKET) {
+        b *= 2;
+    }
+    return b;
+}
+
+std::string cpuModel() {
+    std::ifstream cpuinfo("/proc/cpuinfo");
+    std::string line;
+    while (std::getline(cpuinfo, line)) {
+        if (line.rfind("model name", 0) == 0) {
+            auto colon = line.find(':');
+            if (colon != std::string::npos) {
+                return line.substr(line.find_first_not_of(' ', colon + 1));
+            }
+        }
+    }
+    return "unknown";
+}
+
+std::filesystem::path cachePath() {
+    if (const char *path = std::getenv("LLAISYS_GEMM_CACHE")) {
+        return path;
+    }
+    if (const char *xdg = std::getenv("XDG_CACHE_HOME"); xdg != nullptr && *xdg != '\0') {
+        return std::filesystem::path(xdg) / "llaisys" / "gemm_tuning.tsv";
+    }
+    if (const char *home = std::getenv("HOME"); home != nullptr && *home != '\0') {
+        return std::filesystem::path(home) / ".cache" / "llaisys" / "gemm_tuning.tsv";
+    }
+    return {};
+}
+
+// Requires the mutex.
+const Configs *publish(Tuning &state, Configs configs) {
+    state.snapshots.push_back(std::make_unique<const Configs>(std::move(configs)));
+    const Configs *snapshot = state.snapshots.back().get();
+    state.configs.store(snapshot, std::memory_order_release);
+    return snapshot;
+}
+
+// The entries of the cache file, for every host: cpu model, threads, then the shape.
+using FileKey = std::tuple<std::string, size_t, ShapeKey>;
+
+// Lines are: cpu model, threads, dtype, m bucket, n, k, mr, nr, kc, nc, mc, separated by tabs. Later lines win,
+// and malformed lines are dropped.
+std::map<FileKey, GemmConfig> readCache(const std::filesystem::path &path) {
+    std::map<FileKey, GemmConfig> entries;
+    std::ifstream file(path);
+    std::string line;
+    while (std::getline(file, line)) {
+        std::istringstream fields(line);
+        std::string cpu;
+        size_t threads, m, n, k;
+        int dtype;
+        GemmConfig config;
+        if (!std::getline(fields, cpu, '\t')
+            || !(fields >> threads >> dtype >> m >> n >> k >> config.mr >> config.nr >> config.kc >> config.nc
+                  >> config.mc)) {
+            continue;
+        }
+        entries[{cpu, threads, {static_cast<llaisysDataType_t>(dtype), m, n, k}}] = config;
+    }
+    return entries;
+}
+
+// Returns the published configs, loading the cache on first use. Requires the mutex.
+const Configs *load(Tuning &state) {
+    if (const Configs *configs = state.configs.load(std::memory_order_relaxed)) {
+        return configs;
+    }
+    state.cpu = cpuModel();
+    state.threads = utils::threadPool().size();
+    state.path = cachePath();
+    Configs configs;
+    if (!state.path.empty()) {
+        for (const auto &[key, config] : readCache(state.path)) {
+            const auto &[cpu, threads, shape] = key;
+            if (cpu == state.cpu && threads == state.threads) {
+                configs[shape] = config;
+            }
+        }
+    }
+    return publish(state, std::move(configs));
+}
+
+// Rewrites the cache with `config` for `key`, one line per entry. The file is read again first, to keep what
+// other processes saved since, and replaced by renaming a temporary file so that readers never see it partly
+// written. Requires the mutex.
+void save(const Tuning &state, const ShapeKey &key, const GemmConfig &config) {
+    if (state.path.empty()) {
+        return;
+    }
+    std::error_code error;
+    if (state.path.has_parent_path()) {
+        std::filesystem::create_directories(state.path.parent_path(), error);
+    }
+    auto entries = readCache(state.path);
+    entries[{state.cpu, state.threads, key}] = config;
+
+    auto temporary = state.path;
+    temporary += ".tmp" + std::to_string(std::random_device()());
+    {
+        std::ofstream file(temporary, std::ios::trunc);
+        for (const auto &[entry, c] : entries) {
+            const auto &[cpu, threads, shape] = entry;
+            auto [dtype, m, n, k] = shape;
+            file << cpu << '\t' << threads << '\t' << static_cast<int>(dtype) << '\t' << m << '\t' << n << '\t' << k
+                 << '\t' << c.mr << '\t' << c.nr << '\t' << c.kc << '\t' << c.nc << '\t' << c.mc << '\n';
+        }
+        if (!file.flush()) {
+            error = std::make_error_code(std::errc::io_error);
+        }
+    }
+    if (!error) {
+        std::filesystem::rename(temporary, state.path, error);
+    }
+    if (error) {
+        std::filesystem::remove(temporary, error);
+        std::cerr << "[WARNING] linear: cannot write GEMM tuning cache " << state.path << std::endl;
+    }
+}
+
+GemmConfig defaultConfig(size_t m, size_t n) {
+    GemmConfig config;
+    config.mr = m >= 2 ? 2 : 1;
+    config.nr = m >= 2 ? 4 : 8;
+    config.kc = 512;
+    // About four tasks per thread, in whole register tiles.
+    size_t tasks = 4 * utils::threadPool().size();
+    config.nc = std::clamp<size_t>((n / tasks + 7) / 8 * 8, 8, 128);
+    config.mc = 0;
+    return config;
+}
+
+std::vector<std::byte> scratch(size_t numel, llaisysDataType_t type) {
+    std::vector<std::byte> data(numel * utils::dsize(type));
+    std::vector<float> values(numel);
+    for (size_t i = 0; i < numel; ++i) {
+        values[i] = static_cast<float>(i % 17) * 0.01f - 0.08f;
+    }
+    elementwise::store(data.data(), values.data(), type, numel, 1);
+    return data;
+}
+} // namespace
+
+GemmConfig gemmConfig(size_t m, size_t n, size_t k, llaisysDataType_t type) {
+    auto &state = tuning();
+    const Configs *configs = state.configs.load(std::memory_order_acquire);
+    if (configs == nullptr) {
+        std::lock_guard<std::mutex> lock(state.mutex);
+        configs = load(state);
+    }
+    auto it = configs->find({type, bucket(m), n, k});
+    return it != configs->end() ? it->second : defaultConfig(m, n);
+}
+
+GemmConfig tuneGemm(size_t m, size_t n, size_t k, llaisysDataType_t type, const std::byte *weight,
+                    ptrdiff_t weight_stride) {
+    CHECK_ARGUMENT(m > 0 && n > 0 && k > 0, "tuneGemm: empty shape");
+    size_t rows = bucket(m);
+    auto in = scratch(rows * k, type);
+    auto out = scratch(rows * n, type);
+    std::vector<std::byte> weight_buf;
+    if (weight == nullptr) {
+        weight_buf = scratch(n * k, type);
+        weight = weight_buf.data();
+        weight_stride = static_cast<ptrdiff_t>(k);
+    }
+
+    auto seconds = [&](const GemmConfig &config) {
+        using clock = std::chrono::steady_clock;
+        auto run = [&] {
+            linearBlocked(out.data(), in.data(), weight, nullptr, rows, k, n, type, static_cast<ptrdiff_t>(n),
+                          static_cast<ptrdiff_t>(k), weight_stride, config);
+        };
+        run();
+        double best = std::numeric_limits<double>::infinity(), total = 0.0;
+        for (size_t i = 0; i < MIN_RUNS || total < MIN_SECONDS; ++i) {
+            auto start = clock::now();
+            run();
+            double elapsed = std::chrono::duration<double>(clock::now() - start).count();
+            best = std::min(best, elapsed);
+            total += elapsed;
+        }
+        return best;
+    };
+
+    // Coordinate search: the register tile first, then the K block, the task size and the row block.
+    GemmConfig best = defaultConfig(rows, n);
+    double best_seconds = seconds(best);
+    auto consider = [&](GemmConfig config) {
+        double elapsed = seconds(config);
+        if (elapsed < best_seconds) {
+            best = config;
+            best_seconds = elapsed;
+        }
+    };
+    for (size_t mr = 1; mr <= std::min<size_t>(rows, 4); ++mr) {
+        for (size_t nr : {4, 8}) {
+            if (mr != best.mr || nr != best.nr) {
+                consider({mr, nr, best.kc, best.nc, best.mc});
+            }
+        }
+    }
+    GemmConfig tiled = best;
+    for (size_t kc : {128, 256, 1024, 2048}) {
+        if (kc < k && kc != tiled.kc) {
+            consider({tiled.mr, tiled.nr, kc, tiled.nc, tiled.mc});
+        }
+    }
+    if (tiled.kc < k) {
+        consider({tiled.mr, tiled.nr, k, tiled.nc, tiled.mc});
+    }
+    GemmConfig blocked = best;
+    for (size_t nc : {8, 16, 32, 64, 128, 256}) {
+        if (nc != blocked.nc && nc < n + 8) {
+            consider({blocked.mr, blocked.nr, blocked.kc, nc, blocked.mc});
+        }
+    }
+    GemmConfig split = best;
+    for (size_t mc : {8, 16, 32}) {
+        if (mc < rows && mc >= split.mr) {
+            consider({split.mr, split.nr, split.kc, split.nc, mc});
+        }
+    }
+
+    auto &state = tuning();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    Configs configs = *load(state);
+    ShapeKey key{type, rows, n, k};
+    configs[key] = best;
+    publish(state, std::move(configs));
+    save(state, key, best);
+    return best;
+}
+} // namespace llaisys::ops::cpu
@@ -0,0 +1,23 @@
+#pragma once
+#include "llaisys.h"
+
+#include "linear_cpu.hpp"
+
+#include <cstddef>
+
+// Autotuning of the GEMM blocking. Winners are kept per process and saved to a tuning cache file, read on
+// first use by later processes. Entries are keyed by CPU model and thread count, so one file can be shared by
+// different hosts. The file is LLAISYS_GEMM_CACHE if set (empty disables it), else
+// $XDG_CACHE_HOME/llaisys/gemm_tuning.tsv or ~/.cache/llaisys/gemm_tuning.tsv.
+//
+// Shapes are keyed by dtype, N, K and the number of rows M rounded up to a power of two, capped at 64: decode
+// shapes are tuned exactly and prefill shapes share the largest bucket.
+namespace llaisys::ops::cpu {
+// The blocking for out[m, n] = in[m, k] @ weight[n, k]^T: the tuned one if known, otherwise a default.
+GemmConfig gemmConfig(size_t m, size_t n, size_t k, llaisysDataType_t type);
+
+// Benchmarks blockings for the shape and keeps the fastest. Runs on `weight` if given, on scratch data
+// otherwise.
+GemmConfig tuneGemm(size_t m, size_t n, size_t k, llaisysDataType_t type, const std::byte *weight = nullptr,
+                    ptrdiff_t weight_stride = 0);
+} // namespace llaisys::ops::cpu
@@ -2,8 +2,12 @@
 
 #include "../../core/llaisys_core.hpp"
 #include "../../utils.hpp"
+#include "../elementwise/fusion.hpp"
+#include "../graph/graph.hpp"
+#include "../registry/registry.hpp"
 
 #include "cpu/linear_cpu.hpp"
+#include "cpu/linear_tuning.hpp"
 
 namespace llaisys::ops {
 void linear(tensor_t out, tensor_t in, tensor_t weight, tensor_t bias) {
@@ -26,8 +30,9 @@ void linear(tensor_t out, tensor_t in, tensor_t weight, tensor_t bias) {
     if (bias != nullptr) {
         CHECK_ARGUMENT(out->dtype() == bias->dtype(), "linear: bias dtype mismatch");
     }
-    ASSERT(out->isContiguous() && in->isContiguous() && weight->isContiguous(),
-           "Linear: output, input and weight tensors must be contiguous.");
+    // Rows may be strided, e.g. column slices of a wider output, but each row must be dense.
+    ASSERT(out->strides()[1] == 1 && in->strides()[1] == 1 && weight->strides()[1] == 1,
+           "Linear: output, input and weight rows must be contiguous.");
     if (bias != nullptr) {
         ASSERT(bias->isContiguous(), "Linear: bias tensor must be contiguous.");
     }
@@ -36,24 +41,23 @@ void linear(tensor_t out, tensor_t in, tensor_t weight, tensor_t bias) {
     size_t in_features = in->shape()[1];
     size_t out_features = out->shape()[1];
 
-    if (out->deviceType() == LLAISYS_DEVICE_CPU) {
-        return cpu::linear(out->data(), in->data(), weight->data(), bias != nullptr ? bias->data() : nullptr,
-                           seq_len, in_features, out_features, out->dtype());
-    }
+    flushFusion();
 
-    llaisys::core::context().setDevice(out->deviceType(), out->deviceId());
+    retainForCapture(out, in, weight, bias);
+    static KernelSite site("linear", cpu::linear);
+    site(out->deviceType(), out->deviceId(), out->dtype(), out->data(), in->data(), weight->data(),
+         bias != nullptr ? bias->data() : nullptr, seq_len, in_features, out_features, out->dtype(), out->strides()[0],
+         in->strides()[0], weight->strides()[0]);
+}
 
-    switch (out->deviceType()) {
-    case LLAISYS_DEVICE_CPU:
-        return cpu::linear(out->data(), in->data(), weight->data(), bias != nullptr ? bias->data() : nullptr,
-                           seq_len, in_features, out_features, out->dtype());
-#ifdef ENABLE_NVIDIA_API
-    case LLAISYS_DEVICE_NVIDIA:
-        TO_BE_IMPLEMENTED();
+void tuneLinear(size_t ntoken, tensor_t weight) {
+    CHECK_ARGUMENT(ntoken > 0, "tuneLinear: no rows");
+    CHECK_ARGUMENT(weight->ndim() == 2, "tuneLinear: weight must be 2D");
+    ASSERT(weight->strides()[1] == 1, "Linear: weight rows must be contiguous.");
+    if (weight->deviceType() != LLAISYS_DEVICE_CPU) {
         return;
-#endif
-    default:
-        EXCEPTION_UNSUPPORTED_DEVICE;
     }
+    cpu::tuneGemm(ntoken, weight->shape()[0], weight->shape()[1], weight->dtype(), weight->data(),
+                  weight->strides()[0]);
 }
 } // namespace llaisys::ops
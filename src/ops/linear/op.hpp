@@ -4,4 +4,7 @@
 
 namespace llaisys::ops {
 void linear(tensor_t out, tensor_t in, tensor_t weight, tensor_t bias);
+// Benchmarks GEMM blockings for linear with `ntoken` input rows and this weight, and keeps the fastest for this
+// machine, also in the tuning cache file. CPU only; a no-op on other devices.
+void tuneLinear(size_t ntoken, tensor_t weight);
 }
@@ -0,0 +1,10 @@
+#include "mul_cpu.hpp"
+
+#include "../../elementwise/cpu/functors.hpp"
+
+namespace llaisys::ops::cpu {
+void mul(std::byte *c, const std::byte *a, const std::byte *b, llaisysDataType_t type,
+         const ElementwiseLayout<2> &layout) {
+    elementwise_<2>(elementwise::Mul{}, c, type, {a, b}, {type, type}, layout);
+}
+} // namespace llaisys::ops::cpu
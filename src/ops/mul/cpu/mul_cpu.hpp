@@ -0,0 +1,11 @@
+#pragma once
+#include "llaisys.h"
+
+#include "../../elementwise/cpu/elementwise_cpu.hpp"
+
+#include <cstddef>
+
+namespace llaisys::ops::cpu {
+void mul(std::byte *c, const std::byte *a, const std::byte *b, llaisysDataType_t type,
+         const ElementwiseLayout<2> &layout);
+}
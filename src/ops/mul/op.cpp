@@ -0,0 +1,30 @@
+#include "op.hpp"
+
+#include "../../core/llaisys_core.hpp"
+#include "../../utils.hpp"
+#include "../elementwise/elementwise.hpp"
+#include "../elementwise/fusion.hpp"
+#include "../graph/graph.hpp"
+#include "../registry/registry.hpp"
+
+#include "cpu/mul_cpu.hpp"
+
+namespace llaisys::ops {
+void mul(tensor_t c, tensor_t a, tensor_t b) {
+    CHECK_SAME_DEVICE(c, a, b);
+    CHECK_SAME_DTYPE(c->dtype(), a->dtype(), b->dtype());
+    // a and b are broadcast to the shape of c, which may be a or b itself.
+    auto a_strides = broadcastStrides(a, c->shape());
+    auto b_strides = broadcastStrides(b, c->shape());
+
+    if (recordFused(cpu::FusedOp::Mul, c, {a, b})) {
+        return;
+    }
+
+    retainForCapture(c, a, b);
+    cpu::ElementwiseLayout<2> layout{c->ndim(), c->shape().data(), c->strides().data(),
+                                     {keepForCapture(a_strides).data(), keepForCapture(b_strides).data()}};
+    static KernelSite site("mul", cpu::mul);
+    site(c->deviceType(), c->deviceId(), c->dtype(), c->data(), a->data(), b->data(), c->dtype(), layout);
+}
+} // namespace llaisys::ops
@@ -0,0 +1,7 @@
+#pragma once
+
+#include "../../tensor/tensor.hpp"
+
+namespace llaisys::ops {
+void mul(tensor_t c, tensor_t a, tensor_t b);
+}
@@ -1,70 +1,259 @@
+// Intrinsics go first: llaisys.h defines __C, which they use as a parameter name.
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 #include "rearrange_cpu.hpp"
 
 #include "../../../utils.hpp"
+#include "../../../utils/thread_pool.hpp"
 
+#include <algorithm>
+#include <cstdint>
 #include <cstring>
+#include <type_traits>
+#include <vector>
 
-template <typename T>
-void rearrange_(T *out, const T *in, const std::vector<size_t> &shape, const std::vector<ptrdiff_t> &out_strides,
-                const std::vector<ptrdiff_t> &in_strides, size_t ndim) {
-    // Handle scalar case
-    if (ndim == 0) {
-        *out = *in;
-        return;
-    }
+namespace {
+// Copies smaller than this stay on the calling thread.
+constexpr size_t PARALLEL_BYTES = 1 << 20;
+// Smallest share of a parallel copy handed to one thread.
+constexpr size_t GRAIN_BYTES = 1 << 18;
+// Edge of the square blocks a transpose is split into, in elements.
+constexpr size_t TILE = 32;
+
+struct Dim {
+    size_t size;
+    ptrdiff_t out_stride;
+    ptrdiff_t in_stride;
+};
 
-    // Calculate total number of elements
-    size_t numel = 1;
+template <size_t N>
+struct Bytes {
+    unsigned char data[N];
+};
+
+// Elements are moved by size only, so every dtype of the same width shares one instantiation.
+template <size_t N>
+using Element = std::conditional_t<
+    N == 1, uint8_t,
+    std::conditional_t<N == 2, uint16_t,
+                       std::conditional_t<N == 4, uint32_t, std::conditional_t<N == 8, uint64_t, Bytes<N>>>>>;
+
+// Drops unit dimensions, orders the rest by decreasing output stride so the innermost one is written
+// sequentially, and merges neighbours that are contiguous in both tensors.
+std::vector<Dim> coalesce(const size_t *shape, const ptrdiff_t *out_strides, const ptrdiff_t *in_strides,
+                          size_t ndim) {
+    std::vector<Dim> dims;
     for (size_t i = 0; i < ndim; ++i) {
-        numel *= shape[i];
+        if (shape[i] != 1) {
+            dims.push_back({shape[i], out_strides[i], in_strides[i]});
+        }
     }
+    std::stable_sort(dims.begin(), dims.end(), [](const Dim &a, const Dim &b) { return a.out_stride > b.out_stride; });
 
-    // Create multi-dimensional index array
-    std::vector<size_t> indices(ndim, 0);
-
-    // Iterate over all elements
-    for (size_t elem_idx = 0; elem_idx < numel; ++elem_idx) {
-        // Calculate byte offsets
-        ptrdiff_t out_offset = 0;
-        ptrdiff_t in_offset = 0;
-        for (size_t i = 0; i < ndim; ++i) {
-            out_offset += indices[i] * out_strides[i];
-            in_offset += indices[i] * in_strides[i];
+    std::vector<Dim> merged;
+    for (const auto &dim : dims) {
+        if (!merged.empty()) {
+            auto &outer = merged.back();
+            if (outer.out_stride == dim.out_stride * static_cast<ptrdiff_t>(dim.size)
+                && outer.in_stride == dim.in_stride * static_cast<ptrdiff_t>(dim.size)) {
+                outer.size *= dim.size;
+                outer.out_stride = dim.out_stride;
+                outer.in_stride = dim.in_stride;
+                continue;
+            }
         }
+        merged.push_back(dim);
+    }
+    return merged;
+}
 
-        // Copy element
-        out[out_offset / static_cast<ptrdiff_t>(sizeof(T))] = in[in_offset / static_cast<ptrdiff_t>(sizeof(T))];
+template <typename T>
+void copyStrided(T *out, const T *in, size_t n, ptrdiff_t out_stride, ptrdiff_t in_stride) {
+    for (size_t i = 0; i < n; ++i) {
+        out[i * out_stride] = in[i * in_stride];
+    }
+}
 
-        // Increment indices (like nested loops)
-        size_t dim = ndim - 1;
-        while (dim < ndim) {
-            indices[dim]++;
-            if (indices[dim] < shape[dim]) {
+// out[r * out_row + c] = in[r + c * in_col] for rows [r0, r1) and every column, one TILE x TILE block at a
+// time so the lines read and written by a block stay in cache.
+template <typename T>
+void transposeRows(T *out, const T *in, size_t r0, size_t r1, size_t ncol, ptrdiff_t out_row, ptrdiff_t in_col) {
+    for (size_t c0 = 0; c0 < ncol; c0 += TILE) {
+        size_t c1 = std::min(c0 + TILE, ncol);
+        size_t r = r0;
+#ifdef __SSE2__
+        if constexpr (sizeof(T) == 4) {
+            for (; r + 4 <= r1; r += 4) {
+                size_t c = c0;
+                for (; c + 4 <= c1; c += 4) {
+                    __m128 v0 = _mm_loadu_ps(reinterpret_cast<const float *>(in + r + (c + 0) * in_col));
+                    __m128 v1 = _mm_loadu_ps(reinterpret_cast<const float *>(in + r + (c + 1) * in_col));
+                    __m128 v2 = _mm_loadu_ps(reinterpret_cast<const float *>(in + r + (c + 2) * in_col));
+                    __m128 v3 = _mm_loadu_ps(reinterpret_cast<const float *>(in + r + (c + 3) * in_col));
+                    _MM_TRANSPOSE4_PS(v0, v1, v2, v3);
+                    _mm_storeu_ps(reinterpret_cast<float *>(out + (r + 0) * out_row + c), v0);
+                    _mm_storeu_ps(reinterpret_cast<float *>(out + (r + 1) * out_row + c), v1);
+                    _mm_storeu_ps(reinterpret_cast<float *>(out + (r + 2) * out_row + c), v2);
+                    _mm_storeu_ps(reinterpret_cast<float *>(out + (r + 3) * out_row + c), v3);
+                }
+                for (; c < c1; ++c) {
+                    copyStrided(out + r * out_row + c, in + r + c * in_col, 4, out_row, 1);
+                }
+            }
+        } else if constexpr (sizeof(T) == 2) {
+            for (; r + 8 <= r1; r += 8) {
+                size_t c = c0;
+                for (; c + 8 <= c1; c += 8) {
+                    __m128i a[8];
+                    for (size_t k = 0; k < 8; ++k) {
+                        a[k] = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + r + (c + k) * in_col));
+                    }
+                    __m128i b[8], d[8];
+                    for (size_t k = 0; k < 4; ++k) {
+                        b[2 * k] = _mm_unpacklo_epi16(a[2 * k], a[2 * k + 1]);
+                        b[2 * k + 1] = _mm_unpackhi_epi16(a[2 * k], a[2 * k + 1]);
+                    }
+                    for (size_t k = 0; k < 2; ++k) {
+                        d[4 * k + 0] = _mm_unpacklo_epi32(b[4 * k + 0], b[4 * k + 2]);
+                        d[4 * k + 1] = _mm_unpackhi_epi32(b[4 * k + 0], b[4 * k + 2]);
+                        d[4 * k + 2] = _mm_unpacklo_epi32(b[4 * k + 1], b[4 * k + 3]);
+                        d[4 * k + 3] = _mm_unpackhi_epi32(b[4 * k + 1], b[4 * k + 3]);
+                    }
+                    for (size_t k = 0; k < 4; ++k) {
+                        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + (r + 2 * k) * out_row + c),
+                                         _mm_unpacklo_epi64(d[k], d[k + 4]));
+                        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + (r + 2 * k + 1) * out_row + c),
+                                         _mm_unpackhi_epi64(d[k], d[k + 4]));
+                    }
+                }
+                for (; c < c1; ++c) {
+                    copyStrided(out + r * out_row + c, in + r + c * in_col, 8, out_row, 1);
+                }
+            }
+        }
+#endif
+        for (; r < r1; ++r) {
+            copyStrided(out + r * out_row + c0, in + r + c0 * in_col, c1 - c0, 1, in_col);
+        }
+    }
+}
+
+void parallelize(size_t nunit, size_t unit_bytes, const std::function<void(size_t, size_t)> &fn) {
+    if (nunit > 1 && nunit * unit_bytes >= PARALLEL_BYTES) {
+        size_t grain = std::max<size_t>(1, GRAIN_BYTES / std::max<size_t>(1, unit_bytes));
+        llaisys::utils::threadPool().parallelFor(nunit, fn, grain);
+    } else {
+        fn(0, nunit);
+    }
+}
+
+template <size_t N>
+void rearrange_(std::byte *out_, const std::byte *in_, std::vector<Dim> dims) {
+    using T = Element<N>;
+    auto out = reinterpret_cast<T *>(out_);
+    auto in = reinterpret_cast<const T *>(in_);
+    if (dims.empty()) {
+        *out = *in;
+        return;
+    }
+
+    const Dim inner = dims.back();
+    if (inner.out_stride == 1 && inner.in_stride == 1 && dims.size() == 1) {
+        // Both sides contiguous: one memcpy, split across threads when large.
+        parallelize(inner.size, N, [&](size_t begin, size_t end) {
+            std::memcpy(out + begin, in + begin, (end - begin) * N);
+        });
+        return;
+    }
+
+    // The innermost dimension is written sequentially. When another dimension is read sequentially, the
+    // pair is copied as a blocked transpose; that dimension moves next to the innermost one.
+    bool transpose = false;
+    if (inner.out_stride == 1 && inner.in_stride != 1 && dims.size() >= 2) {
+        for (size_t i = 0; i + 1 < dims.size(); ++i) {
+            if (dims[i].in_stride == 1) {
+                std::rotate(dims.begin() + i, dims.begin() + i + 1, dims.end() - 1);
+                transpose = true;
                 break;
             }
-            indices[dim] = 0;
-            dim--;
         }
     }
+    size_t nkernel = transpose ? 2 : 1;
+    size_t nouter_dims = dims.size() - nkernel;
+    size_t nouter = 1;
+    for (size_t i = 0; i < nouter_dims; ++i) {
+        nouter *= dims[i].size;
+    }
+    // Transposes are further split into blocks of TILE rows so single large matrices use every thread.
+    const Dim rows = transpose ? dims[dims.size() - 2] : Dim{1, 0, 0};
+    size_t ntile = transpose ? (rows.size + TILE - 1) / TILE : 1;
+    size_t unit_bytes = (transpose ? std::min(rows.size, TILE) : 1) * inner.size * N;
+
+    parallelize(nouter * ntile, unit_bytes, [&](size_t begin, size_t end) {
+        // Offsets of the first outer index, then advanced incrementally.
+        std::vector<size_t> index(nouter_dims);
+        ptrdiff_t out_offset = 0, in_offset = 0;
+        size_t rem = begin / ntile;
+        for (size_t d = nouter_dims; d > 0; --d) {
+            index[d - 1] = rem % dims[d - 1].size;
+            rem /= dims[d - 1].size;
+            out_offset += static_cast<ptrdiff_t>(index[d - 1]) * dims[d - 1].out_stride;
+            in_offset += static_cast<ptrdiff_t>(index[d - 1]) * dims[d - 1].in_stride;
+        }
+        size_t tile = begin % ntile;
+        for (size_t u = begin; u < end; ++u) {
+            if (transpose) {
+                size_t r0 = tile * TILE;
+                transposeRows(out + out_offset, in + in_offset, r0, std::min(r0 + TILE, rows.size), inner.size,
+                              rows.out_stride, inner.in_stride);
+            } else if (inner.out_stride == 1 && inner.in_stride == 1) {
+                std::memcpy(out + out_offset, in + in_offset, inner.size * N);
+            } else {
+                copyStrided(out + out_offset, in + in_offset, inner.size, inner.out_stride, inner.in_stride);
+            }
+            if (++tile < ntile) {
+                continue;
+            }
+            tile = 0;
+            for (size_t d = nouter_dims; d > 0; --d) {
+                const Dim &dim = dims[d - 1];
+                if (++index[d - 1] < dim.size) {
+                    out_offset += dim.out_stride;
+                    in_offset += dim.in_stride;
+                    break;
+                }
+                out_offset -= static_cast<ptrdiff_t>(index[d - 1] - 1) * dim.out_stride;
+                in_offset -= static_cast<ptrdiff_t>(index[d - 1] - 1) * dim.in_stride;
+                index[d - 1] = 0;
+            }
+        }
+    });
 }
+} // namespace
 
 namespace llaisys::ops::cpu {
-void rearrange(std::byte *out, const std::byte *in, const std::vector<size_t> &shape,
-               const std::vector<ptrdiff_t> &out_strides, const std::vector<ptrdiff_t> &in_strides, size_t ndim,
+void rearrange(std::byte *out, const std::byte *in, const size_t *shape,
+               const ptrdiff_t *out_strides, const ptrdiff_t *in_strides, size_t ndim,
                llaisysDataType_t type) {
-    switch (type) {
-    case LLAISYS_DTYPE_F32:
-        return rearrange_(reinterpret_cast<float *>(out), reinterpret_cast<const float *>(in), shape, out_strides,
-                          in_strides, ndim);
-    case LLAISYS_DTYPE_BF16:
-        return rearrange_(reinterpret_cast<llaisys::bf16_t *>(out), reinterpret_cast<const llaisys::bf16_t *>(in),
-                          shape, out_strides, in_strides, ndim);
-    case LLAISYS_DTYPE_F16:
-        return rearrange_(reinterpret_cast<llaisys::fp16_t *>(out), reinterpret_cast<const llaisys::fp16_t *>(in),
-                          shape, out_strides, in_strides, ndim);
-    case LLAISYS_DTYPE_I64:
-        return rearrange_(reinterpret_cast<int64_t *>(out), reinterpret_cast<const int64_t *>(in), shape,
-                          out_strides, in_strides, ndim);
+    for (size_t i = 0; i < ndim; ++i) {
+        if (shape[i] == 0) {
+            return;
+        }
+    }
+    auto dims = coalesce(shape, out_strides, in_strides, ndim);
+    switch (llaisys::utils::dsize(type)) {
+    case 1:
+        return rearrange_<1>(out, in, std::move(dims));
+    case 2:
+        return rearrange_<2>(out, in, std::move(dims));
+    case 4:
+        return rearrange_<4>(out, in, std::move(dims));
+    case 8:
+        return rearrange_<8>(out, in, std::move(dims));
+    case 16:
+        return rearrange_<16>(out, in, std::move(dims));
     default:
         EXCEPTION_UNSUPPORTED_DATATYPE(type);
     }
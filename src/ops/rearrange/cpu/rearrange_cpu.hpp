@@ -5,7 +5,7 @@
 #include <vector>
 
 namespace llaisys::ops::cpu {
-void rearrange(std::byte *out, const std::byte *in, const std::vector<size_t> &shape,
-               const std::vector<ptrdiff_t> &out_strides, const std::vector<ptrdiff_t> &in_strides, size_t ndim,
+void rearrange(std::byte *out, const std::byte *in, const size_t *shape,
+               const ptrdiff_t *out_strides, const ptrdiff_t *in_strides, size_t ndim,
                llaisysDataType_t type);
 }
@@ -2,6 +2,9 @@
 
 #include "../../core/llaisys_core.hpp"
 #include "../../utils.hpp"
+#include "../elementwise/fusion.hpp"
+#include "../graph/graph.hpp"
+#include "../registry/registry.hpp"
 
 #include "cpu/rearrange_cpu.hpp"
 
@@ -11,24 +14,11 @@ void rearrange(tensor_t out, tensor_t in) {
     CHECK_SAME_SHAPE(out->shape(), in->shape());
     CHECK_SAME_DTYPE(out->dtype(), in->dtype());
 
-    if (out->deviceType() == LLAISYS_DEVICE_CPU) {
-        return cpu::rearrange(out->data(), in->data(), out->shape(), out->strides(), in->strides(), out->ndim(),
-                              out->dtype());
-    }
+    flushFusion();
 
-    llaisys::core::context().setDevice(out->deviceType(), out->deviceId());
-
-    switch (out->deviceType()) {
-    case LLAISYS_DEVICE_CPU:
-        return cpu::rearrange(out->data(), in->data(), out->shape(), out->strides(), in->strides(), out->ndim(),
-                              out->dtype());
-#ifdef ENABLE_NVIDIA_API
-    case LLAISYS_DEVICE_NVIDIA:
-        TO_BE_IMPLEMENTED();
-        return;
-#endif
-    default:
-        EXCEPTION_UNSUPPORTED_DEVICE;
-    }
+    retainForCapture(out, in);
+    static KernelSite site("rearrange", cpu::rearrange);
+    site(out->deviceType(), out->deviceId(), out->dtype(), out->data(), in->data(), out->shape().data(),
+         out->strides().data(), in->strides().data(), out->ndim(), out->dtype());
 }
 } // namespace llaisys::ops
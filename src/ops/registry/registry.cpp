@@ -0,0 +1,80 @@
+#include "registry.hpp"
+
+#include <atomic>
+#include <unordered_map>
+
+namespace llaisys::ops {
+bool isaSupported(Isa isa) {
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+    switch (isa) {
+    case Isa::ANY:
+        return true;
+    case Isa::SSE2:
+        return __builtin_cpu_supports("sse2");
+    case Isa::AVX2:
+        return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    case Isa::AVX512F:
+        return __builtin_cpu_supports("avx512f");
+    }
+    return false;
+#else
+    return isa == Isa::ANY;
+#endif
+}
+
+namespace registry {
+namespace {
+struct Registry {
+    std::mutex mutex;
+    std::unordered_map<std::string, std::pair<std::type_index, std::unique_ptr<Table>>> tables;
+    std::unordered_map<std::string, std::string> preferred;
+    std::atomic<uint64_t> generation{1};
+};
+
+// Never destroyed, so ops stay callable from other static destructors.
+Registry &instance() {
+    static Registry *registry = new Registry();
+    return *registry;
+}
+} // namespace
+
+uint64_t generation() {
+    return instance().generation.load(std::memory_order_acquire);
+}
+
+void invalidate() {
+    instance().generation.fetch_add(1, std::memory_order_acq_rel);
+}
+
+std::string preferred(const std::string &op) {
+    auto &registry = instance();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    auto it = registry.preferred.find(op);
+    return it != registry.preferred.end() ? it->second : std::string();
+}
+
+Table &table(const std::string &op, std::type_index signature, std::unique_ptr<Table> (*make)()) {
+    auto &registry = instance();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    auto it = registry.tables.find(op);
+    if (it == registry.tables.end()) {
+        it = registry.tables.emplace(op, std::make_pair(signature, make())).first;
+    }
+    CHECK_ARGUMENT(it->second.first == signature, "kernel registry: " + op + " is registered with other arguments");
+    return *it->second.second;
+}
+} // namespace registry
+
+void preferKernel(const std::string &op, const std::string &name) {
+    auto &registry = registry::instance();
+    {
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        if (name.empty()) {
+            registry.preferred.erase(op);
+        } else {
+            registry.preferred[op] = name;
+        }
+    }
+    registry::invalidate();
+}
+} // namespace llaisys::ops
@@ -0,0 +1,213 @@
+#pragma once
+#include "llaisys.h"
+
+#include "../../core/llaisys_core.hpp"
+#include "../../utils.hpp"
+#include "../graph/graph.hpp"
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <typeindex>
+#include <utility>
+#include <vector>
+
+// Kernel registry. Every op has a table of kernels, keyed by op name, that all share the signature of its CPU
+// kernel. A kernel is registered for one device, one dtype or all of them, the instruction set it needs, and
+// optionally a predicate on its arguments. Each call runs the best kernel that accepts it: the preferred one of
+// the op if set, else the one with the highest priority. Ties go to kernels added with registerKernel() over the
+// built-in ones, whenever the op first ran, and then to the most recently registered one.
+//
+// Ops register their built-in kernels through the KernelSite at their entry point, which also caches which
+// kernels apply to each device and dtype it sees. Faster kernels can be added with registerKernel() and compared
+// against the built-in ones with preferKernel() without touching the op.
+namespace llaisys::ops {
+// Instruction sets a kernel may require. Kernels the running CPU lacks are never selected.
+enum class Isa {
+    ANY,
+    SSE2,
+    AVX2,
+    AVX512F,
+};
+
+bool isaSupported(Isa isa);
+
+template <typename... Args>
+struct Kernel {
+    std::string name;
+    llaisysDeviceType_t device;
+    // LLAISYS_DTYPE_INVALID accepts every dtype.
+    llaisysDataType_t dtype = LLAISYS_DTYPE_INVALID;
+    Isa isa = Isa::ANY;
+    int priority = 0;
+    // Shape or layout condition; nullptr accepts every call.
+    bool (*supports)(Args...) = nullptr;
+    void (*run)(Args...) = nullptr;
+    // Set for the kernels ops register themselves.
+    bool builtin = false;
+};
+
+// Runs `name` first for `op` whenever it accepts the call, so kernels can be A/B tested. An empty name restores
+// the priority order.
+void preferKernel(const std::string &op, const std::string &name);
+
+namespace registry {
+struct Table {
+    virtual ~Table() = default;
+};
+
+// Bumped by every registration and preference change, so call sites know when to resolve again.
+uint64_t generation();
+void invalidate();
+std::string preferred(const std::string &op);
+// The table of `op`, created by `make` on first use. Throws if `op` is already registered with other arguments.
+Table &table(const std::string &op, std::type_index signature, std::unique_ptr<Table> (*make)());
+
+template <typename... Args>
+struct TypedTable : Table {
+    std::mutex mutex;
+    std::vector<Kernel<Args...>> kernels;
+};
+
+template <typename... Args>
+TypedTable<Args...> &typedTable(const std::string &op) {
+    auto make = []() -> std::unique_ptr<Table> { return std::make_unique<TypedTable<Args...>>(); };
+    return static_cast<TypedTable<Args...> &>(table(op, typeid(void (*)(Args...)), make));
+}
+} // namespace registry
+
+template <typename... Args>
+void registerKernel(const std::string &op, Kernel<Args...> kernel) {
+    CHECK_ARGUMENT(kernel.run != nullptr, "registerKernel: " + op + "/" + kernel.name + " has no run function");
+    auto &table = registry::typedTable<Args...>(op);
+    {
+        std::lock_guard<std::mutex> lock(table.mutex);
+        table.kernels.push_back(std::move(kernel));
+    }
+    registry::invalidate();
+}
+
+// The entry point of an op. Registers `cpu_kernel` as the op's built-in CPU kernel, then picks the kernel for
+// every call. Meant to be a function-local static.
+template <typename... Args>
+class KernelSite {
+private:
+    using Candidates = std::vector<Kernel<Args...>>;
+
+    struct Resolution {
+        llaisysDeviceType_t device;
+        llaisysDataType_t dtype;
+        // Kernels for `device` and `dtype` in the order they are tried.
+        Candidates candidates;
+    };
+
+    // Resolutions valid while the registry is at `generation`. Snapshots are immutable once published; each call
+    // holds a reference to the one it read, so a snapshot replaced meanwhile is freed once no call uses it.
+    struct Snapshot {
+        uint64_t generation;
+        std::vector<Resolution> resolved;
+    };
+    using SnapshotPtr = std::shared_ptr<const Snapshot>;
+
+    std::string _op;
+    registry::TypedTable<Args...> &_table;
+    // Serializes resolving; `_snapshot` is read and published with std::atomic_load and std::atomic_store.
+    std::mutex _mutex;
+    SnapshotPtr _snapshot;
+
+    static const Candidates *find(const SnapshotPtr &snapshot, uint64_t generation, llaisysDeviceType_t device,
+                                  llaisysDataType_t dtype) {
+        if (snapshot == nullptr || snapshot->generation != generation) {
+            return nullptr;
+        }
+        for (const auto &resolution : snapshot->resolved) {
+            if (resolution.device == device && resolution.dtype == dtype) {
+                return &resolution.candidates;
+            }
+        }
+        return nullptr;
+    }
+
+    Candidates candidates(llaisysDeviceType_t device, llaisysDataType_t dtype) {
+        Candidates candidates;
+        {
+            std::lock_guard<std::mutex> lock(_table.mutex);
+            for (const auto &kernel : _table.kernels) {
+                if (kernel.device == device && (kernel.dtype == LLAISYS_DTYPE_INVALID || kernel.dtype == dtype)
+                    && isaSupported(kernel.isa)) {
+                    candidates.push_back(kernel);
+                }
+            }
+        }
+        std::reverse(candidates.begin(), candidates.end());
+        std::stable_sort(candidates.begin(), candidates.end(), [](const Kernel<Args...> &a, const Kernel<Args...> &b) {
+            return a.priority != b.priority ? a.priority > b.priority : !a.builtin && b.builtin;
+        });
+        std::string preferred = registry::preferred(_op);
+        std::stable_partition(candidates.begin(), candidates.end(),
+                              [&](const Kernel<Args...> &kernel) { return kernel.name == preferred; });
+        return candidates;
+    }
+
+    // The candidates for `device` and `dtype`, valid while the caller holds `snapshot`.
+    const Candidates &resolve(llaisysDeviceType_t device, llaisysDataType_t dtype, SnapshotPtr &snapshot) {
+        uint64_t generation = registry::generation();
+        snapshot = std::atomic_load(&_snapshot);
+        if (auto found = find(snapshot, generation, device, dtype)) {
+            return *found;
+        }
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        snapshot = std::atomic_load(&_snapshot);
+        if (auto found = find(snapshot, generation, device, dtype)) {
+            return *found;
+        }
+        auto next = std::make_shared<Snapshot>();
+        next->generation = generation;
+        if (snapshot != nullptr && snapshot->generation == generation) {
+            next->resolved = snapshot->resolved;
+        }
+        next->resolved.push_back({device, dtype, candidates(device, dtype)});
+        snapshot = next;
+        std::atomic_store(&_snapshot, snapshot);
+        return next->resolved.back().candidates;
+    }
+
+public:
+    KernelSite(std::string op, void (*cpu_kernel)(Args...))
+        : _op(std::move(op)), _table(registry::typedTable<Args...>(_op)) {
+        registerKernel<Args...>(_op, {"cpu", LLAISYS_DEVICE_CPU, LLAISYS_DTYPE_INVALID, Isa::ANY, 0, nullptr,
+                                      cpu_kernel, true});
+    }
+
+    // Runs the selected kernel for an op on `device` whose tensors have type `dtype`, and records it in the graph
+    // being captured, if any.
+    void operator()(llaisysDeviceType_t device, int device_id, llaisysDataType_t dtype, Args... args) {
+        SnapshotPtr snapshot;
+        const Candidates &candidates = resolve(device, dtype, snapshot);
+        if (candidates.empty()) {
+            EXCEPTION_UNSUPPORTED_DEVICE;
+        }
+        if (device != LLAISYS_DEVICE_CPU) {
+            core::context().setDevice(device, device_id);
+        }
+        for (const auto &kernel : candidates) {
+            if (kernel.supports == nullptr || kernel.supports(args...)) {
+                if (Graph *graph = capturingGraph()) {
+                    // Arguments passed by reference, like layouts, are bound by value.
+                    std::tuple<std::decay_t<Args>...> bound(args...);
+                    graph->add(device, device_id, [run = kernel.run, bound] { std::apply(run, bound); });
+                }
+                return kernel.run(args...);
+            }
+        }
+        CHECK_ARGUMENT(false, _op + ": no kernel accepts these arguments");
+    }
+};
+
+template <typename... Args>
+KernelSite(std::string, void (*)(Args...)) -> KernelSite<Args...>;
+} // namespace llaisys::ops
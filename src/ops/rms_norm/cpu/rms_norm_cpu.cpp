@@ -1,29 +1,42 @@
 #include "rms_norm_cpu.hpp"
 
 #include "../../../utils.hpp"
+#include "../../../utils/dispatch.hpp"
 
 #include <cmath>
 
-template <typename T>
-void rms_norm_(T *out, const T *in, const T *weight, size_t rows, size_t cols, float eps) {
+// The sum of squares is accumulated in this many independent partial sums.
+constexpr size_t SUM_LANES = 8;
+
+// COLS is the row length when known at compile time, 0 when it is taken from `cols`.
+template <typename T, size_t COLS>
+void rms_norm_(T *out, const T *in, const T *weight, size_t rows, size_t cols_, float eps, ptrdiff_t out_stride,
+               ptrdiff_t in_stride) {
+    const size_t cols = COLS != 0 ? COLS : cols_;
     // For each row:
     // Y_i = (W_i * X_i) / sqrt(mean(X_i^2) + eps)
     // where mean(X_i^2) = (1/d) * sum(X_i[j]^2 for j in 0..d-1)
     for (size_t i = 0; i < rows; ++i) {
-        const T *in_row = in + i * cols;
-        T *out_row = out + i * cols;
+        const T *in_row = in + i * in_stride;
+        T *out_row = out + i * out_stride;
 
-        // Compute sum of squares
-        float sum_sq = 0.0f;
-        for (size_t j = 0; j < cols; ++j) {
-            float val;
-            if constexpr (std::is_same_v<T, llaisys::bf16_t> || std::is_same_v<T, llaisys::fp16_t>) {
-                val = llaisys::utils::cast<float>(in_row[j]);
-            } else {
-                val = in_row[j];
+        // Compute sum of squares, in independent partial sums so the loop vectorizes
+        const size_t body = cols - cols % SUM_LANES;
+        float lanes[SUM_LANES] = {};
+        for (size_t j = 0; j < body; j += SUM_LANES) {
+            for (size_t l = 0; l < SUM_LANES; ++l) {
+                float val = llaisys::utils::cast<float>(in_row[j + l]);
+                lanes[l] += val * val;
             }
+        }
+        float sum_sq = 0.0f;
+        for (size_t j = body; j < cols; ++j) {
+            float val = llaisys::utils::cast<float>(in_row[j]);
             sum_sq += val * val;
         }
+        for (size_t l = 0; l < SUM_LANES; ++l) {
+            sum_sq += lanes[l];
+        }
 
         // Compute RMS normalization
         // mean = sum_sq / cols
@@ -59,19 +72,26 @@ void rms_norm_(T *out, const T *in, const T *weight, size_t rows, size_t cols, f
     }
 }
 
+template <typename T>
+void rms_norm_cols_(std::byte *out, const std::byte *in, const std::byte *weight, size_t rows, size_t cols,
+                    float eps, ptrdiff_t out_stride, ptrdiff_t in_stride) {
+    // Hidden sizes of common models get a kernel with the row length fixed.
+    llaisys::utils::dispatchSize<1536, 2048, 3584, 4096>(cols, [&](auto COLS) {
+        rms_norm_<T, COLS>(reinterpret_cast<T *>(out), reinterpret_cast<const T *>(in),
+                           reinterpret_cast<const T *>(weight), rows, cols, eps, out_stride, in_stride);
+    });
+}
+
 namespace llaisys::ops::cpu {
 void rms_norm(std::byte *out, const std::byte *in, const std::byte *weight, size_t rows, size_t cols,
-              llaisysDataType_t type, float eps) {
+              llaisysDataType_t type, float eps, ptrdiff_t out_stride, ptrdiff_t in_stride) {
     switch (type) {
     case LLAISYS_DTYPE_F32:
-        return rms_norm_(reinterpret_cast<float *>(out), reinterpret_cast<const float *>(in),
-                         reinterpret_cast<const float *>(weight), rows, cols, eps);
+        return rms_norm_cols_<float>(out, in, weight, rows, cols, eps, out_stride, in_stride);
     case LLAISYS_DTYPE_BF16:
-        return rms_norm_(reinterpret_cast<llaisys::bf16_t *>(out), reinterpret_cast<const llaisys::bf16_t *>(in),
-                         reinterpret_cast<const llaisys::bf16_t *>(weight), rows, cols, eps);
+        return rms_norm_cols_<llaisys::bf16_t>(out, in, weight, rows, cols, eps, out_stride, in_stride);
     case LLAISYS_DTYPE_F16:
-        return rms_norm_(reinterpret_cast<llaisys::fp16_t *>(out), reinterpret_cast<const llaisys::fp16_t *>(in),
-                         reinterpret_cast<const llaisys::fp16_t *>(weight), rows, cols, eps);
+        return rms_norm_cols_<llaisys::fp16_t>(out, in, weight, rows, cols, eps, out_stride, in_stride);
     default:
         EXCEPTION_UNSUPPORTED_DATATYPE(type);
     }
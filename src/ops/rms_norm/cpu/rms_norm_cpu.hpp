@@ -4,6 +4,7 @@
 #include <cstddef>
 
 namespace llaisys::ops::cpu {
+// Rows of out and in are `*_stride` elements apart; each row itself is dense.
 void rms_norm(std::byte *out, const std::byte *in, const std::byte *weight, size_t rows, size_t cols,
-              llaisysDataType_t type, float eps);
+              llaisysDataType_t type, float eps, ptrdiff_t out_stride, ptrdiff_t in_stride);
 }
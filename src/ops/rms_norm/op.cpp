@@ -2,6 +2,9 @@
 
 #include "../../core/llaisys_core.hpp"
 #include "../../utils.hpp"
+#include "../elementwise/fusion.hpp"
+#include "../graph/graph.hpp"
+#include "../registry/registry.hpp"
 
 #include "cpu/rms_norm_cpu.hpp"
 
@@ -14,28 +17,17 @@ void rms_norm(tensor_t out, tensor_t in, tensor_t weight, float eps) {
     CHECK_SAME_SHAPE(out->shape(), in->shape());
     CHECK_ARGUMENT(weight->shape()[0] == in->shape()[1], "rms_norm: weight size must match input last dimension");
     CHECK_ARGUMENT(out->dtype() == in->dtype() && out->dtype() == weight->dtype(), "rms_norm: dtype mismatch");
-    ASSERT(out->isContiguous() && in->isContiguous() && weight->isContiguous(),
-           "RMSNorm: all tensors must be contiguous.");
+    ASSERT(out->strides()[1] == 1 && in->strides()[1] == 1 && weight->isContiguous(),
+           "RMSNorm: rows and weight must be contiguous.");
 
     size_t rows = in->shape()[0];
     size_t cols = in->shape()[1];
 
-    if (out->deviceType() == LLAISYS_DEVICE_CPU) {
-        return cpu::rms_norm(out->data(), in->data(), weight->data(), rows, cols, out->dtype(), eps);
-    }
+    flushFusion();
 
-    llaisys::core::context().setDevice(out->deviceType(), out->deviceId());
-
-    switch (out->deviceType()) {
-    case LLAISYS_DEVICE_CPU:
-        return cpu::rms_norm(out->data(), in->data(), weight->data(), rows, cols, out->dtype(), eps);
-#ifdef ENABLE_NVIDIA_API
-    case LLAISYS_DEVICE_NVIDIA:
-        TO_BE_IMPLEMENTED();
-        return;
-#endif
-    default:
-        EXCEPTION_UNSUPPORTED_DEVICE;
-    }
+    retainForCapture(out, in, weight);
+    static KernelSite site("rms_norm", cpu::rms_norm);
+    site(out->deviceType(), out->deviceId(), out->dtype(), out->data(), in->data(), weight->data(), rows, cols,
+         out->dtype(), eps, out->strides()[0], in->strides()[0]);
 }
 } // namespace llaisys::ops
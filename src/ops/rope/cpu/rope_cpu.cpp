@@ -1,35 +1,51 @@
 #include "rope_cpu.hpp"
 
 #include "../../../utils.hpp"
+#include "../../../utils/dispatch.hpp"
 
+#include <array>
 #include <cmath>
+#include <type_traits>
+#include <vector>
 
-template <typename T>
-void rope_(T *out, const T *in, const int64_t *pos_ids, size_t seq_len, size_t n_heads, size_t head_dim,
-           float theta) {
+// HEAD_DIM is the head size when known at compile time, 0 when it is taken from `head_dim`.
+template <typename T, size_t HEAD_DIM>
+void rope_(T *out, const T *in, const int64_t *pos_ids, size_t seq_len, size_t n_heads, size_t head_dim_,
+           float theta, const ptrdiff_t *out_strides, const ptrdiff_t *in_strides) {
     // out shape: [seq_len, n_heads, head_dim]
     // in shape: [seq_len, n_heads, head_dim]
     // pos_ids shape: [seq_len]
     // head_dim must be even
-    size_t half_dim = head_dim / 2;
+    const size_t head_dim = HEAD_DIM != 0 ? HEAD_DIM : head_dim_;
+    const size_t half_dim = head_dim / 2;
+
+    // The angles depend only on the position, so they are computed once and shared by every head.
+    using Table = std::conditional_t<HEAD_DIM != 0, std::array<float, HEAD_DIM / 2>, std::vector<float>>;
+    Table cos_table{}, sin_table{};
+    if constexpr (HEAD_DIM == 0) {
+        cos_table.resize(half_dim);
+        sin_table.resize(half_dim);
+    }
 
     for (size_t s = 0; s < seq_len; ++s) {
         float pos = static_cast<float>(pos_ids[s]);
+        for (size_t j = 0; j < half_dim; ++j) {
+            // Compute frequency: theta^(2j/d)
+            float freq_exp = 2.0f * j / static_cast<float>(head_dim);
+            float freq = pos / std::pow(theta, freq_exp);
+            cos_table[j] = std::cos(freq);
+            sin_table[j] = std::sin(freq);
+        }
 
         for (size_t h = 0; h < n_heads; ++h) {
             // Get pointers to current sequence and head
-            const T *in_head = in + (s * n_heads + h) * head_dim;
-            T *out_head = out + (s * n_heads + h) * head_dim;
+            const T *in_head = in + s * in_strides[0] + h * in_strides[1];
+            T *out_head = out + s * out_strides[0] + h * out_strides[1];
 
             // Apply RoPE to each pair (a, b)
             for (size_t j = 0; j < half_dim; ++j) {
-                // Compute frequency: theta^(2j/d)
-                float freq_exp = 2.0f * j / static_cast<float>(head_dim);
-                float freq = pos / std::pow(theta, freq_exp);
-
-                // Compute sin and cos
-                float cos_freq = std::cos(freq);
-                float sin_freq = std::sin(freq);
+                float cos_freq = cos_table[j];
+                float sin_freq = sin_table[j];
 
                 // Get a and b values
                 float a, b;
@@ -60,19 +76,30 @@ void rope_(T *out, const T *in, const int64_t *pos_ids, size_t seq_len, size_t n
     }
 }
 
+template <typename T>
+void rope_head_dim_(std::byte *out, const std::byte *in, const std::byte *pos_ids, size_t seq_len, size_t n_heads,
+                    size_t head_dim, float theta, const ptrdiff_t *out_strides, const ptrdiff_t *in_strides) {
+    // Common head sizes get a kernel with the head fixed.
+    llaisys::utils::dispatchSize<64, 128>(head_dim, [&](auto HEAD_DIM) {
+        rope_<T, HEAD_DIM>(reinterpret_cast<T *>(out), reinterpret_cast<const T *>(in),
+                           reinterpret_cast<const int64_t *>(pos_ids), seq_len, n_heads, head_dim, theta,
+                           out_strides, in_strides);
+    });
+}
+
 namespace llaisys::ops::cpu {
 void rope(std::byte *out, const std::byte *in, const std::byte *pos_ids, size_t seq_len, size_t n_heads,
-          size_t head_dim, llaisysDataType_t type, float theta) {
+          size_t head_dim, llaisysDataType_t type, float theta, const ptrdiff_t *out_strides,
+          const ptrdiff_t *in_strides) {
     switch (type) {
     case LLAISYS_DTYPE_F32:
-        return rope_(reinterpret_cast<float *>(out), reinterpret_cast<const float *>(in),
-                     reinterpret_cast<const int64_t *>(pos_ids), seq_len, n_heads, head_dim, theta);
+        return rope_head_dim_<float>(out, in, pos_ids, seq_len, n_heads, head_dim, theta, out_strides, in_strides);
     case LLAISYS_DTYPE_BF16:
-        return rope_(reinterpret_cast<llaisys::bf16_t *>(out), reinterpret_cast<const llaisys::bf16_t *>(in),
-                     reinterpret_cast<const int64_t *>(pos_ids), seq_len, n_heads, head_dim, theta);
+        return rope_head_dim_<llaisys::bf16_t>(out, in, pos_ids, seq_len, n_heads, head_dim, theta, out_strides,
+                                               in_strides);
     case LLAISYS_DTYPE_F16:
-        return rope_(reinterpret_cast<llaisys::fp16_t *>(out), reinterpret_cast<const llaisys::fp16_t *>(in),
-                     reinterpret_cast<const int64_t *>(pos_ids), seq_len, n_heads, head_dim, theta);
+        return rope_head_dim_<llaisys::fp16_t>(out, in, pos_ids, seq_len, n_heads, head_dim, theta, out_strides,
+                                               in_strides);
     default:
         EXCEPTION_UNSUPPORTED_DATATYPE(type);
     }
@@ -4,6 +4,9 @@
 #include <cstddef>
 
 namespace llaisys::ops::cpu {
+// `out_strides` and `in_strides` are the element strides of the [seq_len, n_heads, head_dim] tensors; the last
+// one must be 1.
 void rope(std::byte *out, const std::byte *in, const std::byte *pos_ids, size_t seq_len, size_t n_heads,
-          size_t head_dim, llaisysDataType_t type, float theta);
+          size_t head_dim, llaisysDataType_t type, float theta, const ptrdiff_t *out_strides,
+          const ptrdiff_t *in_strides);
 }
@@ -2,6 +2,9 @@
 
 #include "../../core/llaisys_core.hpp"
 #include "../../utils.hpp"
+#include "../elementwise/fusion.hpp"
+#include "../graph/graph.hpp"
+#include "../registry/registry.hpp"
 
 #include "cpu/rope_cpu.hpp"
 
@@ -16,31 +19,18 @@ void rope(tensor_t out, tensor_t in, tensor_t pos_ids, float theta) {
     CHECK_ARGUMENT(in->shape()[2] % 2 == 0, "rope: head_dim must be even");
     CHECK_ARGUMENT(out->dtype() == in->dtype(), "rope: dtype mismatch");
     CHECK_ARGUMENT(pos_ids->dtype() == LLAISYS_DTYPE_I64, "rope: pos_ids must be int64");
-    ASSERT(out->isContiguous() && in->isContiguous() && pos_ids->isContiguous(),
-           "Rope: all tensors must be contiguous.");
+    ASSERT(out->strides()[2] == 1 && in->strides()[2] == 1 && pos_ids->isContiguous(),
+           "Rope: head vectors and pos_ids must be contiguous.");
 
     size_t seq_len = in->shape()[0];
     size_t n_heads = in->shape()[1];
     size_t head_dim = in->shape()[2];
 
-    if (out->deviceType() == LLAISYS_DEVICE_CPU) {
-        return cpu::rope(out->data(), in->data(), pos_ids->data(), seq_len, n_heads, head_dim, out->dtype(),
-                         theta);
-    }
+    flushFusion();
 
-    llaisys::core::context().setDevice(out->deviceType(), out->deviceId());
-
-    switch (out->deviceType()) {
-    case LLAISYS_DEVICE_CPU:
-        return cpu::rope(out->data(), in->data(), pos_ids->data(), seq_len, n_heads, head_dim, out->dtype(),
-                         theta);
-#ifdef ENABLE_NVIDIA_API
-    case LLAISYS_DEVICE_NVIDIA:
-        TO_BE_IMPLEMENTED();
-        return;
-#endif
-    default:
-        EXCEPTION_UNSUPPORTED_DEVICE;
-    }
+    retainForCapture(out, in, pos_ids);
+    static KernelSite site("rope", cpu::rope);
+    site(out->deviceType(), out->deviceId(), out->dtype(), out->data(), in->data(), pos_ids->data(), seq_len, n_heads,
+         head_dim, out->dtype(), theta, out->strides().data(), in->strides().data());
 }
 } // namespace llaisys::ops
@@ -0,0 +1,10 @@
+#include "scale_cpu.hpp"
+
+#include "../../elementwise/cpu/functors.hpp"
+
+namespace llaisys::ops::cpu {
+void scale(std::byte *out, const std::byte *in, llaisysDataType_t type, float scale,
+           const ElementwiseLayout<1> &layout) {
+    elementwise_<1>(elementwise::Scale{scale}, out, type, {in}, {type}, layout);
+}
+} // namespace llaisys::ops::cpu
@@ -0,0 +1,11 @@
+#pragma once
+#include "llaisys.h"
+
+#include "../../elementwise/cpu/elementwise_cpu.hpp"
+
+#include <cstddef>
+
+namespace llaisys::ops::cpu {
+void scale(std::byte *out, const std::byte *in, llaisysDataType_t type, float scale,
+           const ElementwiseLayout<1> &layout);
+}
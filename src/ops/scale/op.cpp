@@ -0,0 +1,28 @@
+#include "op.hpp"
+
+#include "../../core/llaisys_core.hpp"
+#include "../../utils.hpp"
+#include "../elementwise/elementwise.hpp"
+#include "../elementwise/fusion.hpp"
+#include "../graph/graph.hpp"
+#include "../registry/registry.hpp"
+
+#include "cpu/scale_cpu.hpp"
+
+namespace llaisys::ops {
+void scale(tensor_t out, tensor_t in, float scale) {
+    CHECK_SAME_DEVICE(out, in);
+    CHECK_SAME_DTYPE(out->dtype(), in->dtype());
+    auto in_strides = broadcastStrides(in, out->shape());
+
+    if (recordFused(cpu::FusedOp::Scale, out, {in}, scale)) {
+        return;
+    }
+
+    retainForCapture(out, in);
+    cpu::ElementwiseLayout<1> layout{out->ndim(), out->shape().data(), out->strides().data(),
+                                     {keepForCapture(in_strides).data()}};
+    static KernelSite site("scale", cpu::scale);
+    site(out->deviceType(), out->deviceId(), out->dtype(), out->data(), in->data(), out->dtype(), scale, layout);
+}
+} // namespace llaisys::ops
@@ -0,0 +1,8 @@
+#pragma once
+
+#include "../../tensor/tensor.hpp"
+
+namespace llaisys::ops {
+// out = in * scale, with `in` broadcast to the shape of `out`.
+void scale(tensor_t out, tensor_t in, float scale);
+}
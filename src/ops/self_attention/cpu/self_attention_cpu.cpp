@@ -1,16 +1,45 @@
 #include "self_attention_cpu.hpp"
 
 #include "../../../utils.hpp"
+#include "../../../utils/dispatch.hpp"
+#include "../../../utils/vec_math.hpp"
 
 #include <algorithm>
+#include <array>
 #include <cmath>
 #include <cstring>
 #include <limits>
+#include <type_traits>
 #include <vector>
 
+// Dot products are accumulated in this many independent partial sums, which lets the loop vectorize.
+constexpr size_t DOT_LANES = 8;
+
 template <typename T>
+inline float dot_(const T *a, const T *b, size_t n) {
+    const size_t body = n - n % DOT_LANES;
+    float lanes[DOT_LANES] = {};
+    for (size_t d = 0; d < body; d += DOT_LANES) {
+        for (size_t l = 0; l < DOT_LANES; ++l) {
+            lanes[l] += llaisys::utils::cast<float>(a[d + l]) * llaisys::utils::cast<float>(b[d + l]);
+        }
+    }
+    float sum = 0.0f;
+    for (size_t d = body; d < n; ++d) {
+        sum += llaisys::utils::cast<float>(a[d]) * llaisys::utils::cast<float>(b[d]);
+    }
+    for (size_t l = 0; l < DOT_LANES; ++l) {
+        sum += lanes[l];
+    }
+    return sum;
+}
+
+// HEAD_DIM is the head size when known at compile time, 0 when it is taken from `head_dim`.
+template <typename T, size_t HEAD_DIM>
 void self_attention_(T *attn_val, const T *q, const T *k, const T *v, size_t q_len, size_t kv_len, size_t n_heads,
-                     size_t n_kv_heads, size_t head_dim, float scale) {
+                     size_t n_kv_heads, size_t head_dim_, float scale, const ptrdiff_t *attn_val_strides,
+                     const ptrdiff_t *q_strides, const ptrdiff_t *k_strides, const ptrdiff_t *v_strides,
+                     const int64_t *q_pos, const int64_t *k_pos, bool k_pos_per_head, float *attn_mass) {
     // Shape: q [q_len, n_heads, head_dim]
     //        k [kv_len, n_kv_heads, head_dim]
     //        v [kv_len, n_kv_heads, head_dim]
@@ -21,7 +50,12 @@ void self_attention_(T *attn_val, const T *q, const T *k, const T *v, size_t q_l
     // 2. Apply causal mask (set future positions to -inf)
     // 3. Apply softmax
     // 4. Multiply by V to get output
+    //
+    // Sequence and head strides come from the tensors, so Q/K/V may be slices of wider rows.
+    // k_pos is [kv_len] or, per KV head, [kv_len, n_kv_heads]. attn_mass [kv_len, n_kv_heads] accumulates the
+    // attention weight every key receives from all queries of its group.
 
+    const size_t head_dim = HEAD_DIM != 0 ? HEAD_DIM : head_dim_;
     size_t heads_per_kv = n_heads / n_kv_heads; // For GQA support
 
     // Allocate temporary space for attention scores
@@ -32,25 +66,12 @@ void self_attention_(T *attn_val, const T *q, const T *k, const T *v, size_t q_l
         for (size_t h = 0; h < n_heads; ++h) {
             size_t kv_h = h / heads_per_kv; // Map query head to KV head
 
-            const T *q_vec = q + (i * n_heads + h) * head_dim;
+            const T *q_vec = q + i * q_strides[0] + h * q_strides[1];
 
             for (size_t j = 0; j < kv_len; ++j) {
-                const T *k_vec = k + (j * n_kv_heads + kv_h) * head_dim;
-
-                // Compute dot product
-                float score = 0.0f;
-                for (size_t d = 0; d < head_dim; ++d) {
-                    float q_val, k_val;
-                    if constexpr (std::is_same_v<T, llaisys::bf16_t> || std::is_same_v<T, llaisys::fp16_t>) {
-                        q_val = llaisys::utils::cast<float>(q_vec[d]);
-                        k_val = llaisys::utils::cast<float>(k_vec[d]);
-                    } else {
-                        q_val = q_vec[d];
-                        k_val = k_vec[d];
-                    }
-                    score += q_val * k_val;
-                }
-                score *= scale;
+                const T *k_vec = k + j * k_strides[0] + kv_h * k_strides[1];
+
+                float score = dot_(q_vec, k_vec, head_dim) * scale;
                 attn_scores[(i * n_heads + h) * kv_len + j] = score;
             }
         }
@@ -61,12 +82,20 @@ void self_attention_(T *attn_val, const T *q, const T *k, const T *v, size_t q_l
         for (size_t h = 0; h < n_heads; ++h) {
             float *scores = attn_scores.data() + (i * n_heads + h) * kv_len;
 
-            // Apply causal mask: mask out positions j > i
-            // In generative models, position i can only attend to positions <= i
-            // But here we need to consider: can current position attend to future in KV cache?
-            // The mask should prevent attending to positions after the current one
-            for (size_t j = i + 1; j < kv_len; ++j) {
-                scores[j] = -std::numeric_limits<float>::infinity();
+            // Apply causal mask: query i sits at absolute position (kv_len - q_len + i) and may only attend
+            // to keys at or before it. With explicit positions, rows need not be in sequence order.
+            if (q_pos != nullptr) {
+                size_t kv_h = h / heads_per_kv;
+                for (size_t j = 0; j < kv_len; ++j) {
+                    int64_t pos = k_pos_per_head ? k_pos[j * n_kv_heads + kv_h] : k_pos[j];
+                    if (pos > q_pos[i]) {
+                        scores[j] = -std::numeric_limits<float>::infinity();
+                    }
+                }
+            } else {
+                for (size_t j = kv_len - q_len + i + 1; j < kv_len; ++j) {
+                    scores[j] = -std::numeric_limits<float>::infinity();
+                }
             }
 
             // Compute softmax
@@ -78,15 +107,12 @@ void self_attention_(T *attn_val, const T *q, const T *k, const T *v, size_t q_l
                 }
             }
 
-            // Compute exp and sum
+            // Compute exp and sum; masked scores become 0
             float sum_exp = 0.0f;
-            for (size_t j = 0; j < kv_len; ++j) {
-                if (std::isfinite(scores[j])) {
-                    scores[j] = std::exp(scores[j] - max_score);
-                    sum_exp += scores[j];
-                } else {
-                    scores[j] = 0.0f;
-                }
+            if (std::isfinite(max_score)) {
+                sum_exp = llaisys::utils::vec::expSum(scores, kv_len, max_score);
+            } else {
+                std::fill_n(scores, kv_len, 0.0f);
             }
 
             // Normalize
@@ -98,65 +124,82 @@ void self_attention_(T *attn_val, const T *q, const T *k, const T *v, size_t q_l
         }
     }
 
-    // Step 3: Multiply attention weights by V
+    if (attn_mass != nullptr) {
+        for (size_t i = 0; i < q_len; ++i) {
+            for (size_t h = 0; h < n_heads; ++h) {
+                size_t kv_h = h / heads_per_kv;
+                const float *weights = attn_scores.data() + (i * n_heads + h) * kv_len;
+                for (size_t j = 0; j < kv_len; ++j) {
+                    attn_mass[j * n_kv_heads + kv_h] += weights[j];
+                }
+            }
+        }
+    }
+
+    // Step 3: Multiply attention weights by V, accumulating one output head in float
+    using Head = std::conditional_t<HEAD_DIM != 0, std::array<float, HEAD_DIM>, std::vector<float>>;
+    Head acc{};
+    if constexpr (HEAD_DIM == 0) {
+        acc.resize(head_dim);
+    }
     for (size_t i = 0; i < q_len; ++i) {
         for (size_t h = 0; h < n_heads; ++h) {
             size_t kv_h = h / heads_per_kv;
 
             const float *weights = attn_scores.data() + (i * n_heads + h) * kv_len;
-            T *output = attn_val + (i * n_heads + h) * head_dim;
+            T *output = attn_val + i * attn_val_strides[0] + h * attn_val_strides[1];
 
             // output = sum_j(weights[j] * v[j])
-            for (size_t d = 0; d < head_dim; ++d) {
-                if constexpr (std::is_same_v<T, llaisys::bf16_t> || std::is_same_v<T, llaisys::fp16_t>) {
-                    output[d] = llaisys::utils::cast<T>(0.0f);
-                } else {
-                    output[d] = T(0);
-                }
-            }
-
+            std::fill(acc.begin(), acc.end(), 0.0f);
             for (size_t j = 0; j < kv_len; ++j) {
                 if (weights[j] > 0.0f) {
-                    const T *v_vec = v + (j * n_kv_heads + kv_h) * head_dim;
-
+                    const T *v_vec = v + j * v_strides[0] + kv_h * v_strides[1];
                     for (size_t d = 0; d < head_dim; ++d) {
-                        float v_val;
-                        if constexpr (std::is_same_v<T, llaisys::bf16_t> || std::is_same_v<T, llaisys::fp16_t>) {
-                            v_val = llaisys::utils::cast<float>(v_vec[d]);
-                            float out_val = llaisys::utils::cast<float>(output[d]);
-                            out_val += weights[j] * v_val;
-                            output[d] = llaisys::utils::cast<T>(out_val);
-                        } else {
-                            output[d] += weights[j] * v_vec[d];
-                        }
+                        acc[d] += weights[j] * llaisys::utils::cast<float>(v_vec[d]);
                     }
                 }
             }
+            for (size_t d = 0; d < head_dim; ++d) {
+                output[d] = llaisys::utils::cast<T>(acc[d]);
+            }
         }
     }
 }
 
+template <typename T>
+void self_attention_head_dim_(std::byte *attn_val, const std::byte *q, const std::byte *k, const std::byte *v,
+                              size_t q_len, size_t kv_len, size_t n_heads, size_t n_kv_heads, size_t head_dim,
+                              float scale, const ptrdiff_t *attn_val_strides, const ptrdiff_t *q_strides,
+                              const ptrdiff_t *k_strides, const ptrdiff_t *v_strides, const int64_t *q_pos,
+                              const int64_t *k_pos, bool k_pos_per_head, float *attn_mass) {
+    // Common head sizes get a kernel with the head fixed.
+    llaisys::utils::dispatchSize<64, 128>(head_dim, [&](auto HEAD_DIM) {
+        self_attention_<T, HEAD_DIM>(reinterpret_cast<T *>(attn_val), reinterpret_cast<const T *>(q),
+                                     reinterpret_cast<const T *>(k), reinterpret_cast<const T *>(v), q_len, kv_len,
+                                     n_heads, n_kv_heads, head_dim, scale, attn_val_strides, q_strides, k_strides,
+                                     v_strides, q_pos, k_pos, k_pos_per_head, attn_mass);
+    });
+}
+
 namespace llaisys::ops::cpu {
 void self_attention(std::byte *attn_val, const std::byte *q, const std::byte *k, const std::byte *v,
                     size_t q_len, size_t kv_len, size_t n_heads, size_t n_kv_heads, size_t head_dim,
-                    llaisysDataType_t type, float scale) {
+                    llaisysDataType_t type, float scale, const ptrdiff_t *attn_val_strides,
+                    const ptrdiff_t *q_strides, const ptrdiff_t *k_strides, const ptrdiff_t *v_strides,
+                    const int64_t *q_pos, const int64_t *k_pos, bool k_pos_per_head, float *attn_mass) {
     switch (type) {
     case LLAISYS_DTYPE_F32:
-        return self_attention_(reinterpret_cast<float *>(attn_val), reinterpret_cast<const float *>(q),
-                               reinterpret_cast<const float *>(k), reinterpret_cast<const float *>(v), q_len,
-                               kv_len, n_heads, n_kv_heads, head_dim, scale);
+        return self_attention_head_dim_<float>(attn_val, q, k, v, q_len, kv_len, n_heads, n_kv_heads, head_dim,
+                                               scale, attn_val_strides, q_strides, k_strides, v_strides, q_pos,
+                                               k_pos, k_pos_per_head, attn_mass);
     case LLAISYS_DTYPE_BF16:
-        return self_attention_(reinterpret_cast<llaisys::bf16_t *>(attn_val),
-                               reinterpret_cast<const llaisys::bf16_t *>(q),
-                               reinterpret_cast<const llaisys::bf16_t *>(k),
-                               reinterpret_cast<const llaisys::bf16_t *>(v), q_len, kv_len, n_heads,
-                               n_kv_heads, head_dim, scale);
+        return self_attention_head_dim_<llaisys::bf16_t>(attn_val, q, k, v, q_len, kv_len, n_heads, n_kv_heads,
+                                                         head_dim, scale, attn_val_strides, q_strides, k_strides,
+                                                         v_strides, q_pos, k_pos, k_pos_per_head, attn_mass);
     case LLAISYS_DTYPE_F16:
-        return self_attention_(reinterpret_cast<llaisys::fp16_t *>(attn_val),
-                               reinterpret_cast<const llaisys::fp16_t *>(q),
-                               reinterpret_cast<const llaisys::fp16_t *>(k),
-                               reinterpret_cast<const llaisys::fp16_t *>(v), q_len, kv_len, n_heads,
-                               n_kv_heads, head_dim, scale);
+        return self_attention_head_dim_<llaisys::fp16_t>(attn_val, q, k, v, q_len, kv_len, n_heads, n_kv_heads,
+                                                         head_dim, scale, attn_val_strides, q_strides, k_strides,
+                                                         v_strides, q_pos, k_pos, k_pos_per_head, attn_mass);
     default:
         EXCEPTION_UNSUPPORTED_DATATYPE(type);
     }
@@ -2,9 +2,14 @@
 #include "llaisys.h"
 
 #include <cstddef>
+#include <cstdint>
 
 namespace llaisys::ops::cpu {
+// `*_strides` are the element strides of the [len, heads, head_dim] tensors; the last one must be 1.
 void self_attention(std::byte *attn_val, const std::byte *q, const std::byte *k, const std::byte *v,
                     size_t q_len, size_t kv_len, size_t n_heads, size_t n_kv_heads, size_t head_dim,
-                    llaisysDataType_t type, float scale);
+                    llaisysDataType_t type, float scale, const ptrdiff_t *attn_val_strides,
+                    const ptrdiff_t *q_strides, const ptrdiff_t *k_strides, const ptrdiff_t *v_strides,
+                    const int64_t *q_pos = nullptr,
+                    const int64_t *k_pos = nullptr, bool k_pos_per_head = false, float *attn_mass = nullptr);
 }
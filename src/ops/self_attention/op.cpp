@@ -2,11 +2,19 @@
 
 #include "../../core/llaisys_core.hpp"
 #include "../../utils.hpp"
+#include "../elementwise/fusion.hpp"
+#include "../graph/graph.hpp"
+#include "../registry/registry.hpp"
 
 #include "cpu/self_attention_cpu.hpp"
 
 namespace llaisys::ops {
 void self_attention(tensor_t attn_val, tensor_t q, tensor_t k, tensor_t v, float scale) {
+    self_attention(attn_val, q, k, v, scale, nullptr, nullptr);
+}
+
+void self_attention(tensor_t attn_val, tensor_t q, tensor_t k, tensor_t v, float scale, tensor_t q_pos,
+                    tensor_t k_pos, tensor_t attn_mass) {
     CHECK_SAME_DEVICE(attn_val, q, k, v);
     CHECK_ARGUMENT(q->ndim() == 3, "self_attention: q must be 3D");
     CHECK_ARGUMENT(k->ndim() == 3, "self_attention: k must be 3D");
@@ -22,32 +30,47 @@ void self_attention(tensor_t attn_val, tensor_t q, tensor_t k, tensor_t v, float
     CHECK_ARGUMENT(q->shape()[2] == k->shape()[2], "self_attention: q and k head_dim must match");
     CHECK_ARGUMENT(k->shape()[2] == v->shape()[2], "self_attention: k and v head_dim must match");
     CHECK_ARGUMENT(k->shape()[0] == v->shape()[0], "self_attention: k and v seq_len must match");
+    CHECK_ARGUMENT((q_pos == nullptr) == (k_pos == nullptr), "self_attention: q_pos and k_pos go together");
+    const int64_t *q_pos_data = nullptr, *k_pos_data = nullptr;
+    bool k_pos_per_head = false;
+    if (q_pos != nullptr) {
+        CHECK_SAME_DEVICE(attn_val, q_pos, k_pos);
+        CHECK_ARGUMENT(q_pos->dtype() == LLAISYS_DTYPE_I64 && k_pos->dtype() == LLAISYS_DTYPE_I64,
+                       "self_attention: positions must be int64");
+        k_pos_per_head = k_pos->ndim() == 2;
+        CHECK_ARGUMENT(q_pos->ndim() == 1 && q_pos->shape()[0] == q_len && k_pos->shape()[0] == kv_len &&
+                           (k_pos->ndim() == 1 || (k_pos_per_head && k_pos->shape()[1] == n_kv_heads)),
+                       "self_attention: positions must match q and k seq_len");
+        ASSERT(q_pos->isContiguous() && k_pos->isContiguous(), "SelfAttention: positions must be contiguous.");
+        q_pos_data = reinterpret_cast<const int64_t *>(q_pos->data());
+        k_pos_data = reinterpret_cast<const int64_t *>(k_pos->data());
+    } else {
+        CHECK_ARGUMENT(kv_len >= q_len, "self_attention: kv seq_len must not be shorter than q seq_len");
+    }
+    float *attn_mass_data = nullptr;
+    if (attn_mass != nullptr) {
+        CHECK_SAME_DEVICE(attn_val, attn_mass);
+        CHECK_ARGUMENT(attn_mass->dtype() == LLAISYS_DTYPE_F32, "self_attention: attn_mass must be float32");
+        CHECK_ARGUMENT(attn_mass->ndim() == 2 && attn_mass->shape()[0] == kv_len && attn_mass->shape()[1] == n_kv_heads,
+                       "self_attention: attn_mass must be [kv_len, n_kv_heads]");
+        ASSERT(attn_mass->isContiguous(), "SelfAttention: attn_mass must be contiguous.");
+        attn_mass_data = reinterpret_cast<float *>(attn_mass->data());
+    }
     CHECK_ARGUMENT(k->shape()[1] == v->shape()[1], "self_attention: k and v n_heads must match");
     CHECK_ARGUMENT(attn_val->shape()[0] == q_len && attn_val->shape()[1] == n_heads && attn_val->shape()[2] == head_dim,
                    "self_attention: attn_val shape mismatch");
     CHECK_ARGUMENT(q->dtype() == k->dtype() && q->dtype() == v->dtype() && q->dtype() == attn_val->dtype(),
                    "self_attention: dtype mismatch");
-    ASSERT(attn_val->isContiguous() && q->isContiguous() && k->isContiguous() && v->isContiguous(),
-           "SelfAttention: all tensors must be contiguous.");
+    ASSERT(attn_val->strides()[2] == 1 && q->strides()[2] == 1 && k->strides()[2] == 1 && v->strides()[2] == 1,
+           "SelfAttention: head vectors must be contiguous.");
 
-    if (attn_val->deviceType() == LLAISYS_DEVICE_CPU) {
-        return cpu::self_attention(attn_val->data(), q->data(), k->data(), v->data(), q_len, kv_len, n_heads,
-                                   n_kv_heads, head_dim, attn_val->dtype(), scale);
-    }
+    flushFusion();
 
-    llaisys::core::context().setDevice(attn_val->deviceType(), attn_val->deviceId());
-
-    switch (attn_val->deviceType()) {
-    case LLAISYS_DEVICE_CPU:
-        return cpu::self_attention(attn_val->data(), q->data(), k->data(), v->data(), q_len, kv_len, n_heads,
-                                   n_kv_heads, head_dim, attn_val->dtype(), scale);
-#ifdef ENABLE_NVIDIA_API
-    case LLAISYS_DEVICE_NVIDIA:
-        TO_BE_IMPLEMENTED();
-        return;
-#endif
-    default:
-        EXCEPTION_UNSUPPORTED_DEVICE;
-    }
+    retainForCapture(attn_val, q, k, v, q_pos, k_pos, attn_mass);
+    static KernelSite site("self_attention", cpu::self_attention);
+    site(attn_val->deviceType(), attn_val->deviceId(), attn_val->dtype(), attn_val->data(), q->data(), k->data(),
+         v->data(), q_len, kv_len, n_heads, n_kv_heads, head_dim, attn_val->dtype(), scale, attn_val->strides().data(),
+         q->strides().data(), k->strides().data(), v->strides().data(), q_pos_data, k_pos_data, k_pos_per_head,
+         attn_mass_data);
 }
 } // namespace llaisys::ops
@@ -4,4 +4,9 @@
 
 namespace llaisys::ops {
 void self_attention(tensor_t attn_val, tensor_t q, tensor_t k, tensor_t v, float scale);
+// Masks by explicit I64 positions instead of row order: key j is visible to query i iff k_pos[j] <= q_pos[i].
+// k_pos is [kv_len], or [kv_len, n_kv_heads] when each KV head holds different tokens. If given, the F32
+// tensor attn_mass [kv_len, n_kv_heads] accumulates the attention weight each key receives.
+void self_attention(tensor_t attn_val, tensor_t q, tensor_t k, tensor_t v, float scale, tensor_t q_pos,
+                    tensor_t k_pos, tensor_t attn_mass = nullptr);
 }
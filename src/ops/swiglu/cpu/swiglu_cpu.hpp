@@ -1,8 +1,11 @@
 #pragma once
 #include "llaisys.h"
 
+#include "../../elementwise/cpu/elementwise_cpu.hpp"
+
 #include <cstddef>
 
 namespace llaisys::ops::cpu {
-void swiglu(std::byte *out, const std::byte *gate, const std::byte *up, llaisysDataType_t type, size_t numel);
+void swiglu(std::byte *out, const std::byte *gate, const std::byte *up, llaisysDataType_t type,
+            const ElementwiseLayout<2> &layout);
 }
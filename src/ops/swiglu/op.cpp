@@ -2,6 +2,10 @@
 
 #include "../../core/llaisys_core.hpp"
 #include "../../utils.hpp"
+#include "../elementwise/elementwise.hpp"
+#include "../elementwise/fusion.hpp"
+#include "../graph/graph.hpp"
+#include "../registry/registry.hpp"
 
 #include "cpu/swiglu_cpu.hpp"
 
@@ -10,25 +14,15 @@ void swiglu(tensor_t out, tensor_t gate, tensor_t up) {
     CHECK_SAME_DEVICE(out, gate, up);
     CHECK_SAME_SHAPE(out->shape(), gate->shape(), up->shape());
     CHECK_SAME_DTYPE(out->dtype(), gate->dtype(), up->dtype());
-    ASSERT(out->isContiguous() && gate->isContiguous() && up->isContiguous(),
-           "SwiGLU: all tensors must be contiguous.");
+    cpu::ElementwiseLayout<2> layout{out->ndim(), out->shape().data(), out->strides().data(),
+                                     {gate->strides().data(), up->strides().data()}};
 
-    if (out->deviceType() == LLAISYS_DEVICE_CPU) {
-        return cpu::swiglu(out->data(), gate->data(), up->data(), out->dtype(), out->numel());
-    }
-
-    llaisys::core::context().setDevice(out->deviceType(), out->deviceId());
-
-    switch (out->deviceType()) {
-    case LLAISYS_DEVICE_CPU:
-        return cpu::swiglu(out->data(), gate->data(), up->data(), out->dtype(), out->numel());
-#ifdef ENABLE_NVIDIA_API
-    case LLAISYS_DEVICE_NVIDIA:
-        TO_BE_IMPLEMENTED();
+    if (recordFused(cpu::FusedOp::SwiGLU, out, {gate, up})) {
         return;
-#endif
-    default:
-        EXCEPTION_UNSUPPORTED_DEVICE;
     }
+
+    retainForCapture(out, gate, up);
+    static KernelSite site("swiglu", cpu::swiglu);
+    site(out->deviceType(), out->deviceId(), out->dtype(), out->data(), gate->data(), up->data(), out->dtype(), layout);
 }
 } // namespace llaisys::ops
@@ -8,32 +8,174 @@
 
 namespace llaisys {
 
-Tensor::Tensor(TensorMeta meta, core::storage_t storage, size_t offset)
+namespace {
+TensorStrides contiguousStrides(const TensorShape &shape) {
+    TensorStrides strides(shape.size());
+    ptrdiff_t stride = 1;
+    for (size_t i = shape.size(); i > 0; --i) {
+        strides[i - 1] = stride;
+        stride *= static_cast<ptrdiff_t>(shape[i - 1]);
+    }
+    return strides;
+}
+
+size_t product(const TensorShape &shape) {
+    return std::accumulate(shape.begin(), shape.end(), size_t(1), std::multiplies<size_t>());
+}
+
+bool isContiguousLayout(const TensorShape &shape, const TensorStrides &strides) {
+    ptrdiff_t expected_stride = 1;
+    for (size_t i = shape.size(); i > 0; --i) {
+        size_t dim = i - 1;
+        if (shape[dim] == 1) {
+            continue;
+        }
+        if (strides[dim] != expected_stride) {
+            return false;
+        }
+        expected_stride *= static_cast<ptrdiff_t>(shape[dim]);
+    }
+    return true;
+}
+// Strides that let a tensor with `shape` and `strides` be viewed as `new_shape`, if any. Dimensions are split
+// and merged within chunks of the old layout that are contiguous with respect to each other.
+bool viewStrides(const TensorShape &shape, const TensorStrides &strides, const TensorShape &new_shape,
+                 TensorStrides &new_strides) {
+    new_strides = TensorStrides(new_shape.size());
+    if (shape.empty() || product(shape) == 0) {
+        new_strides = contiguousStrides(new_shape);
+        return true;
+    }
+    ptrdiff_t view_d = static_cast<ptrdiff_t>(new_shape.size()) - 1;
+    ptrdiff_t chunk_base_stride = strides.back();
+    size_t tensor_numel = 1, view_numel = 1;
+    for (ptrdiff_t tensor_d = static_cast<ptrdiff_t>(shape.size()) - 1; tensor_d >= 0; --tensor_d) {
+        tensor_numel *= shape[tensor_d];
+        // A chunk ends where the next outer dimension does not continue it.
+        if (tensor_d == 0
+            || (shape[tensor_d - 1] != 1
+                && strides[tensor_d - 1] != static_cast<ptrdiff_t>(tensor_numel) * chunk_base_stride)) {
+            while (view_d >= 0 && (view_numel < tensor_numel || new_shape[view_d] == 1)) {
+                new_strides[view_d] = static_cast<ptrdiff_t>(view_numel) * chunk_base_stride;
+                view_numel *= new_shape[view_d];
+                --view_d;
+            }
+            if (view_numel != tensor_numel) {
+                return false;
+            }
+            if (tensor_d > 0) {
+                chunk_base_stride = strides[tensor_d - 1];
+                tensor_numel = 1;
+                view_numel = 1;
+            }
+        }
+    }
+    return view_d == -1;
+}
+
+// Copies the elements of `src` into the contiguous buffer `dst` with `copy(dst, src, bytes)`, one call per
+// contiguous run.
+template <typename Copy>
+void copyToContiguous(std::byte *dst, const TensorView &src, Copy copy) {
+    // Drop unit dimensions and merge dimensions that are contiguous with respect to each other.
+    size_t esize = utils::dsize(src.dtype);
+    TensorShape shape;
+    TensorStrides strides;
+    for (size_t i = 0; i < src.ndim(); ++i) {
+        if (src.shape[i] == 1) {
+            continue;
+        }
+        if (!shape.empty() && strides.back() == src.strides[i] * static_cast<ptrdiff_t>(src.shape[i])) {
+            shape.back() *= src.shape[i];
+            strides.back() = src.strides[i];
+        } else {
+            shape.push_back(src.shape[i]);
+            strides.push_back(src.strides[i]);
+        }
+    }
+    size_t numel = product(shape);
+    if (numel == 0) {
+        return;
+    }
+    // Runs span the innermost dimension when it is dense, otherwise single elements.
+    size_t run = 1;
+    if (!shape.empty() && strides.back() == 1) {
+        run = shape.back();
+        shape.back() = 1;
+    }
+    size_t ndim = shape.size();
+    TensorShape index(ndim, 0);
+    const std::byte *in = src.data;
+    for (size_t done = 0; done < numel; done += run) {
+        copy(dst + done * esize, in, run * esize);
+        // Advance the multi-index over the outer dimensions.
+        for (size_t d = ndim; d > 0; --d) {
+            size_t dim = d - 1;
+            if (++index[dim] < shape[dim]) {
+                in += strides[dim] * static_cast<ptrdiff_t>(esize);
+                break;
+            }
+            in -= static_cast<ptrdiff_t>(index[dim] - 1) * strides[dim] * static_cast<ptrdiff_t>(esize);
+            index[dim] = 0;
+        }
+    }
+}
+} // namespace
+
+size_t TensorView::ndim() const {
+    return shape.size();
+}
+
+size_t TensorView::numel() const {
+    return product(shape);
+}
+
+bool TensorView::isContiguous() const {
+    return isContiguousLayout(shape, strides);
+}
+
+TensorView TensorView::permute(const TensorShape &order) const {
+    CHECK_ARGUMENT(order.size() == shape.size(), "permute: order size mismatch");
+    TensorView out{data, dtype, TensorShape(order.size()), TensorStrides(order.size())};
+    unsigned seen = 0;
+    for (size_t i = 0; i < order.size(); ++i) {
+        CHECK_ARGUMENT(order[i] < shape.size(), "permute: index out of range");
+        CHECK_ARGUMENT(!(seen & (1u << order[i])), "permute: duplicate dimension");
+        seen |= 1u << order[i];
+        out.shape[i] = shape[order[i]];
+        out.strides[i] = strides[order[i]];
+    }
+    return out;
+}
+
+TensorView TensorView::slice(size_t dim, size_t start, size_t end) const {
+    CHECK_ARGUMENT(dim < shape.size(), "slice: dim out of range");
+    CHECK_ARGUMENT(start <= end && end <= shape[dim], "slice: invalid range");
+    TensorView out = *this;
+    out.shape[dim] = end - start;
+    out.data += start * strides[dim] * static_cast<ptrdiff_t>(utils::dsize(dtype));
+    return out;
+}
+
+Tensor::Tensor(Key, TensorMeta meta, core::storage_t storage, size_t offset)
     : _meta(std::move(meta)), _storage(std::move(storage)), _offset(offset) {}
 
-tensor_t Tensor::create(const std::vector<size_t> &shape,
+tensor_t Tensor::create(const TensorShape &shape,
                         llaisysDataType_t dtype,
                         llaisysDeviceType_t device_type,
                         int device) {
     // 创建一个新的张量
-    size_t ndim_ = shape.size();
-    std::vector<ptrdiff_t> strides(ndim_);
-    size_t stride = 1;
-    for (size_t i = 1; i <= ndim_; i++) {
-        strides[ndim_ - i] = stride;
-        stride *= shape[ndim_ - i];
-    }
-    TensorMeta meta{dtype, shape, strides};
-    size_t total_elems = stride;
+    TensorMeta meta{dtype, shape, contiguousStrides(shape)};
+    size_t total_elems = product(shape);
     size_t dtype_size = utils::dsize(dtype);
 
     if (device_type == LLAISYS_DEVICE_CPU && core::context().runtime().deviceType() != LLAISYS_DEVICE_CPU) {
         auto storage = core::context().runtime().allocateHostStorage(total_elems * dtype_size);
-        return std::shared_ptr<Tensor>(new Tensor(meta, storage));
+        return std::make_shared<Tensor>(Key(), meta, storage);
     } else {
         core::context().setDevice(device_type, device);
         auto storage = core::context().runtime().allocateDeviceStorage(total_elems * dtype_size);
-        return std::shared_ptr<Tensor>(new Tensor(meta, storage));
+        return std::make_shared<Tensor>(Key(), meta, storage);
     }
 }
 
@@ -49,11 +191,11 @@ size_t Tensor::ndim() const {
     return _meta.shape.size();
 }
 
-const std::vector<size_t> &Tensor::shape() const {
+const TensorShape &Tensor::shape() const {
     return _meta.shape;
 }
 
-const std::vector<ptrdiff_t> &Tensor::strides() const {
+const TensorStrides &Tensor::strides() const {
     return _meta.strides;
 }
 
@@ -70,13 +212,17 @@ int Tensor::deviceId() const {
 }
 
 size_t Tensor::numel() const {
-    return std::accumulate(_meta.shape.begin(), _meta.shape.end(), size_t(1), std::multiplies<size_t>());
+    return product(_meta.shape);
 }
 
 size_t Tensor::elementSize() const {
     return utils::dsize(_meta.dtype);
 }
 
+const core::storage_t &Tensor::storage() const {
+    return _storage;
+}
+
 std::string Tensor::info() const {
     std::stringstream ss;
 
@@ -95,7 +241,7 @@ std::string Tensor::info() const {
 }
 
 template <typename T>
-void print_data(const T *data, const std::vector<size_t> &shape, const std::vector<ptrdiff_t> &strides, size_t dim) {
+void print_data(const T *data, const TensorShape &shape, const TensorStrides &strides, size_t dim) {
     if (dim == shape.size() - 1) {
         for (size_t i = 0; i < shape[dim]; i++) {
             if constexpr (std::is_same_v<T, bf16_t> || std::is_same_v<T, fp16_t>) {
@@ -112,7 +258,7 @@ void print_data(const T *data, const std::vector<size_t> &shape, const std::vect
     }
 }
 
-void debug_print(const std::byte *data, const std::vector<size_t> &shape, const std::vector<ptrdiff_t> &strides, llaisysDataType_t dtype) {
+void debug_print(const std::byte *data, const TensorShape &shape, const TensorStrides &strides, llaisysDataType_t dtype) {
     switch (dtype) {
     case LLAISYS_DTYPE_BYTE:
         return print_data(reinterpret_cast<const char *>(data), shape, strides, 0);
@@ -166,55 +312,26 @@ void Tensor::debug() const {
 
 bool Tensor::isContiguous() const {
     // 就是检查stride是否符合连续存储的要求。连续存储的张量，其stride应该是从最后一个维度开始，依次乘以前一个维度的大小。
-    if (_meta.shape.empty()) {
-        return true;
-    }
-    ptrdiff_t expected_stride = 1;
-    for (size_t i = _meta.shape.size(); i > 0; --i) {
-        size_t dim = i - 1;
-        if (_meta.shape[dim] == 1) {
-            continue;
-        }
-        if (_meta.strides[dim] != expected_stride) {
-            return false;
-        }
-        expected_stride *= static_cast<ptrdiff_t>(_meta.shape[dim]);
-    }
-    return true;
+    return isContiguousLayout(_meta.shape, _meta.strides);
+}
+
+TensorView Tensor::asView() const {
+    return TensorView{const_cast<std::byte *>(data()), _meta.dtype, _meta.shape, _meta.strides};
 }
 
-tensor_t Tensor::permute(const std::vector<size_t> &order) const {
+tensor_t Tensor::permute(const TensorShape &order) const {
     // 只需要重新排列shape和strides即可，不需要移动数据。
-    CHECK_ARGUMENT(order.size() == _meta.shape.size(), "permute: order size mismatch");
-    std::vector<size_t> new_shape(order.size());
-    std::vector<ptrdiff_t> new_strides(order.size());
-    std::vector<bool> seen(order.size(), false);
-    for (size_t i = 0; i < order.size(); ++i) {
-        CHECK_ARGUMENT(order[i] < _meta.shape.size(), "permute: index out of range");
-        CHECK_ARGUMENT(!seen[order[i]], "permute: duplicate dimension");
-        seen[order[i]] = true;
-        new_shape[i] = _meta.shape[order[i]];
-        new_strides[i] = _meta.strides[order[i]];
-    }
-    TensorMeta meta{_meta.dtype, std::move(new_shape), std::move(new_strides)};
-    return std::shared_ptr<Tensor>(new Tensor(std::move(meta), _storage, _offset));
+    auto view = asView().permute(order);
+    TensorMeta meta{_meta.dtype, view.shape, view.strides};
+    return std::make_shared<Tensor>(Key(), meta, _storage, _offset);
 }
 
-tensor_t Tensor::view(const std::vector<size_t> &shape) const {
+tensor_t Tensor::view(const TensorShape &shape) const {
     // 重新计算strides就可以了，但要确保元素数量不变且tensor是连续的。
-    size_t total_elems = std::accumulate(shape.begin(), shape.end(), size_t(1), std::multiplies<size_t>());
-    CHECK_ARGUMENT(total_elems == this->numel(), "view: number of elements mismatch");
+    CHECK_ARGUMENT(product(shape) == this->numel(), "view: number of elements mismatch");
     CHECK_ARGUMENT(this->isContiguous(), "view: tensor is not contiguous");
-
-    std::vector<ptrdiff_t> new_strides(shape.size());
-    ptrdiff_t stride = 1;
-    for (size_t i = shape.size(); i > 0; --i) {
-        size_t dim = i - 1;
-        new_strides[dim] = stride;
-        stride *= static_cast<ptrdiff_t>(shape[dim]);
-    }
-    TensorMeta meta{_meta.dtype, shape, std::move(new_strides)};
-    return std::shared_ptr<Tensor>(new Tensor(std::move(meta), _storage, _offset));
+    TensorMeta meta{_meta.dtype, shape, contiguousStrides(shape)};
+    return std::make_shared<Tensor>(Key(), meta, _storage, _offset);
 }
 
 tensor_t Tensor::slice(size_t dim, size_t start, size_t end) const {
@@ -222,12 +339,11 @@ tensor_t Tensor::slice(size_t dim, size_t start, size_t end) const {
     CHECK_ARGUMENT(dim < _meta.shape.size(), "slice: dim out of range");
     CHECK_ARGUMENT(start <= end && end <= _meta.shape[dim], "slice: invalid range");
 
-    std::vector<size_t> new_shape = _meta.shape;
-    new_shape[dim] = end - start;
-    TensorMeta meta{_meta.dtype, std::move(new_shape), _meta.strides};
+    TensorMeta meta = _meta;
+    meta.shape[dim] = end - start;
 
     size_t new_offset = _offset + start * static_cast<size_t>(_meta.strides[dim]) * this->elementSize();
-    return std::shared_ptr<Tensor>(new Tensor(std::move(meta), _storage, new_offset));
+    return std::make_shared<Tensor>(Key(), meta, _storage, new_offset);
 }
 
 void Tensor::load(const void *src_) {
@@ -248,18 +364,67 @@ void Tensor::load(const void *src_) {
 }
 
 tensor_t Tensor::contiguous() const {
-    TO_BE_IMPLEMENTED();
-    return std::shared_ptr<Tensor>(new Tensor(_meta, _storage));
+    if (this->isContiguous()) {
+        return std::make_shared<Tensor>(Key(), _meta, _storage, _offset);
+    }
+    auto out = create(_meta.shape, _meta.dtype, this->deviceType(), this->deviceId());
+    if (this->deviceType() == LLAISYS_DEVICE_CPU) {
+        copyToContiguous(out->data(), asView(),
+                         [](std::byte *dst, const std::byte *src, size_t size) { std::memcpy(dst, src, size); });
+    } else {
+        core::context().setDevice(this->deviceType(), this->deviceId());
+        auto api = core::context().runtime().api();
+        copyToContiguous(out->data(), asView(), [&](std::byte *dst, const std::byte *src, size_t size) {
+            api->memcpy_sync(dst, src, size, LLAISYS_MEMCPY_D2D);
+        });
+    }
+    return out;
 }
 
-tensor_t Tensor::reshape(const std::vector<size_t> &shape) const {
-    TO_BE_IMPLEMENTED();
-    return std::shared_ptr<Tensor>(new Tensor(_meta, _storage));
+tensor_t Tensor::reshape(const TensorShape &shape) const {
+    // 步幅兼容时直接返回视图，否则先拷贝成连续张量。
+    CHECK_ARGUMENT(product(shape) == this->numel(), "reshape: number of elements mismatch");
+    TensorStrides strides;
+    if (viewStrides(_meta.shape, _meta.strides, shape, strides)) {
+        TensorMeta meta{_meta.dtype, shape, strides};
+        return std::make_shared<Tensor>(Key(), meta, _storage, _offset);
+    }
+    return contiguous()->view(shape);
 }
 
 tensor_t Tensor::to(llaisysDeviceType_t device_type, int device) const {
-    TO_BE_IMPLEMENTED();
-    return std::shared_ptr<Tensor>(new Tensor(_meta, _storage));
+    if (device < 0) {
+        device = device_type == this->deviceType() ? this->deviceId() : 0;
+    }
+    if (device_type == this->deviceType() && device == this->deviceId()) {
+        return std::make_shared<Tensor>(Key(), _meta, _storage, _offset);
+    }
+    // Strided tensors are gathered straight into the destination, one copy per contiguous run.
+    auto out = create(_meta.shape, _meta.dtype, device_type, device);
+    if (device_type == LLAISYS_DEVICE_CPU && this->deviceType() == LLAISYS_DEVICE_CPU) {
+        // Host memory is shared by every CPU device id.
+        copyToContiguous(out->data(), asView(),
+                         [](std::byte *dst, const std::byte *src, size_t size) { std::memcpy(dst, src, size); });
+        return out;
+    }
+    llaisysMemcpyKind_t kind;
+    if (this->deviceType() == LLAISYS_DEVICE_CPU) {
+        kind = LLAISYS_MEMCPY_H2D;
+        core::context().setDevice(device_type, device);
+    } else if (device_type == LLAISYS_DEVICE_CPU) {
+        kind = LLAISYS_MEMCPY_D2H;
+        core::context().setDevice(this->deviceType(), this->deviceId());
+    } else {
+        CHECK_ARGUMENT(device_type == this->deviceType(),
+                       "to: copies between different device types go through the host");
+        kind = LLAISYS_MEMCPY_D2D;
+        core::context().setDevice(device_type, device);
+    }
+    auto api = core::context().runtime().api();
+    copyToContiguous(out->data(), asView(), [&](std::byte *dst, const std::byte *src, size_t size) {
+        api->memcpy_sync(dst, src, size, kind);
+    });
+    return out;
 }
 
 } // namespace llaisys
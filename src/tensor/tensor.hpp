@@ -1,28 +1,104 @@
 #pragma once
 #include "../core/llaisys_core.hpp"
+#include "../utils/check.hpp"
 
+#include <algorithm>
+#include <array>
+#include <initializer_list>
 #include <vector>
 namespace llaisys {
 class Tensor;
 using tensor_t = std::shared_ptr<Tensor>;
 
+constexpr size_t TENSOR_MAX_NDIM = 8;
+
+// Shape or strides of a tensor, stored inline so that creating views does not touch the heap.
+template <typename T>
+class TensorDims {
+private:
+    std::array<T, TENSOR_MAX_NDIM> _data;
+    size_t _size;
+
+public:
+    TensorDims() : _data{}, _size(0) {}
+    explicit TensorDims(size_t size, T value = T{}) : _data{}, _size(size) {
+        CHECK_ARGUMENT(size <= TENSOR_MAX_NDIM, "tensor: too many dimensions");
+        std::fill_n(_data.begin(), size, value);
+    }
+    template <typename It>
+    TensorDims(It first, It last) : _data{}, _size(0) {
+        for (; first != last; ++first) {
+            CHECK_ARGUMENT(_size < TENSOR_MAX_NDIM, "tensor: too many dimensions");
+            _data[_size++] = static_cast<T>(*first);
+        }
+    }
+    TensorDims(std::initializer_list<T> dims) : TensorDims(dims.begin(), dims.end()) {}
+    TensorDims(const std::vector<T> &dims) : TensorDims(dims.begin(), dims.end()) {}
+
+    size_t size() const { return _size; }
+    bool empty() const { return _size == 0; }
+    T *data() { return _data.data(); }
+    const T *data() const { return _data.data(); }
+    T *begin() { return _data.data(); }
+    T *end() { return _data.data() + _size; }
+    const T *begin() const { return _data.data(); }
+    const T *end() const { return _data.data() + _size; }
+    T &operator[](size_t i) { return _data[i]; }
+    const T &operator[](size_t i) const { return _data[i]; }
+    T &back() { return _data[_size - 1]; }
+    const T &back() const { return _data[_size - 1]; }
+    void push_back(T value) {
+        CHECK_ARGUMENT(_size < TENSOR_MAX_NDIM, "tensor: too many dimensions");
+        _data[_size++] = value;
+    }
+
+    bool operator==(const TensorDims &other) const {
+        return _size == other._size && std::equal(begin(), end(), other.begin());
+    }
+    bool operator!=(const TensorDims &other) const { return !(*this == other); }
+};
+
+using TensorShape = TensorDims<size_t>;
+using TensorStrides = TensorDims<ptrdiff_t>;
+
 // 张量元数据结构体
 struct TensorMeta {
-    llaisysDataType_t dtype;        // 本质上是一个枚举，从0到19，共20种数据类型
-    std::vector<size_t> shape;      // 张量的形状，每个维度的大小
-    std::vector<ptrdiff_t> strides; // 张量的步幅，用于计算内存地址
+    llaisysDataType_t dtype; // 本质上是一个枚举，从0到19，共20种数据类型
+    TensorShape shape;       // 张量的形状，每个维度的大小
+    TensorStrides strides;   // 张量的步幅，用于计算内存地址
+};
+
+// Non-owning description of a tensor's elements, cheap to pass and transform by value. The memory must
+// outlive the view.
+struct TensorView {
+    std::byte *data;
+    llaisysDataType_t dtype;
+    TensorShape shape;
+    TensorStrides strides;
+
+    size_t ndim() const;
+    size_t numel() const;
+    bool isContiguous() const;
+    TensorView permute(const TensorShape &order) const;
+    TensorView slice(size_t dim, size_t start, size_t end) const;
 };
 
 class Tensor {
 private:
+    // Lets make_shared reach the constructor while keeping it out of reach of everyone else.
+    struct Key {
+        explicit Key() = default;
+    };
+
     TensorMeta _meta;
     core::storage_t _storage;
     size_t _offset;
-    Tensor(TensorMeta meta, core::storage_t storage, size_t offset = 0);
 
 public:
+    Tensor(Key, TensorMeta meta, core::storage_t storage, size_t offset = 0);
+
     static tensor_t create(
-        const std::vector<size_t> &shape,
+        const TensorShape &shape,
         llaisysDataType_t dtype,
         llaisysDeviceType_t device_type = LLAISYS_DEVICE_CPU,
         int device = 0);
@@ -31,30 +107,33 @@ public:
     std::byte *data();
     const std::byte *data() const;
     size_t ndim() const;
-    const std::vector<size_t> &shape() const;
-    const std::vector<ptrdiff_t> &strides() const;
+    const TensorShape &shape() const;
+    const TensorStrides &strides() const;
     llaisysDataType_t dtype() const;
     llaisysDeviceType_t deviceType() const;
     int deviceId() const;
     size_t numel() const;
     size_t elementSize() const;
+    const core::storage_t &storage() const;
 
     std::string info() const;
     void debug() const;
 
     bool isContiguous() const;
+    // The elements of this tensor as a view.
+    TensorView asView() const;
 
     // Meta Transform
-    tensor_t permute(const std::vector<size_t> &order) const;
+    tensor_t permute(const TensorShape &order) const;
     tensor_t slice(size_t dim, size_t start, size_t end) const;
-    tensor_t view(const std::vector<size_t> &shape) const;
+    tensor_t view(const TensorShape &shape) const;
 
     // Load data from host memory
     void load(const void *src);
 
     // Challenging features
     tensor_t contiguous() const;
-    tensor_t reshape(const std::vector<size_t> &shape) const;
+    tensor_t reshape(const TensorShape &shape) const;
     tensor_t to(llaisysDeviceType_t device_type, int device = -1) const;
 };
 
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstddef>
+#include <type_traits>
+
+namespace llaisys::utils {
+template <size_t N>
+using Size = std::integral_constant<size_t, N>;
+
+// Calls f(Size<S>{}) for the entry S of SIZES equal to `size`, or f(Size<0>{}) when none is. Kernels are
+// instantiated for the sizes models commonly use, with 0 standing for the runtime-sized fallback:
+//
+//     dispatchSize<64, 128>(head_dim, [&](auto D) { kernel_<T, D>(..., head_dim); });
+template <size_t... SIZES, typename F>
+void dispatchSize(size_t size, F &&f) {
+    static_assert(((SIZES != 0) && ...), "dispatchSize: 0 is reserved for the runtime-sized kernel");
+    if (!((size == SIZES && (f(Size<SIZES>{}), true)) || ...)) {
+        f(Size<0>{});
+    }
+}
+} // namespace llaisys::utils
@@ -0,0 +1,241 @@
+#include "thread_pool.hpp"
+
+#include "check.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <memory>
+
+namespace llaisys::utils {
+// Set while a thread runs a loop chunk, so that nested parallel loops run inline instead of deadlocking.
+static thread_local bool t_in_pool = false;
+
+ThreadPool::ThreadPool(size_t nthread) : _stop(false) {
+    for (size_t i = 1; i < nthread; ++i) {
+        _workers.emplace_back([this] { _work(); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stop = true;
+    }
+    _changed.notify_all();
+    for (auto &worker : _workers) {
+        worker.join();
+    }
+}
+
+size_t ThreadPool::size() const {
+    return _workers.size() + 1;
+}
+
+bool ThreadPool::_runOne(std::unique_lock<std::mutex> &lock, bool tasks) {
+    if (!_loops.empty()) {
+        Loop *loop = _loops.front();
+        size_t c = loop->next++;
+        if (loop->next == loop->nchunk) {
+            _loops.pop_front();
+        }
+        lock.unlock();
+        std::exception_ptr error;
+        bool outer = t_in_pool;
+        t_in_pool = true;
+        try {
+            (*loop->fn)(loop->n * c / loop->nchunk, loop->n * (c + 1) / loop->nchunk);
+        } catch (...) {
+            error = std::current_exception();
+        }
+        t_in_pool = outer;
+        lock.lock();
+        if (error && !loop->error) {
+            loop->error = error;
+        }
+        // The loop's caller may return as soon as this is seen.
+        if (++loop->finished == loop->nchunk) {
+            _changed.notify_all();
+        }
+        return true;
+    }
+    if (tasks && !_tasks.empty()) {
+        auto task = std::move(_tasks.front());
+        _tasks.pop_front();
+        lock.unlock();
+        task();
+        task = nullptr;
+        lock.lock();
+        _changed.notify_all();
+        return true;
+    }
+    return false;
+}
+
+void ThreadPool::_work() {
+    std::unique_lock<std::mutex> lock(_mutex);
+    while (true) {
+        _changed.wait(lock, [&] { return _stop || !_loops.empty() || !_tasks.empty(); });
+        if (_stop) {
+            return;
+        }
+        _runOne(lock, true);
+    }
+}
+
+void ThreadPool::parallelFor(size_t n, const std::function<void(size_t, size_t)> &fn, size_t grain) {
+    if (n == 0) {
+        return;
+    }
+    size_t nchunk = std::min((n + std::max<size_t>(grain, 1) - 1) / std::max<size_t>(grain, 1), size());
+    if (nchunk <= 1 || t_in_pool) {
+        fn(0, n);
+        return;
+    }
+
+    Loop loop{&fn, n, nchunk, 0, 0, nullptr};
+    std::unique_lock<std::mutex> lock(_mutex);
+    _loops.push_back(&loop);
+    _changed.notify_all();
+    // Help with this and any other running loop until every chunk of this one has finished.
+    while (loop.finished < loop.nchunk) {
+        if (!_runOne(lock, false)) {
+            _changed.wait(lock);
+        }
+    }
+    if (loop.error) {
+        std::rethrow_exception(loop.error);
+    }
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _tasks.push_back(std::move(task));
+    }
+    _changed.notify_all();
+}
+
+void ThreadPool::helpUntil(const std::function<bool()> &done) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    while (!done()) {
+        if (!_runOne(lock, true)) {
+            _changed.wait(lock);
+        }
+    }
+}
+
+ThreadPool &threadPool() {
+    static ThreadPool pool([] {
+        const char *env = std::getenv("LLAISYS_NUM_THREADS");
+        long n = env != nullptr ? std::atol(env) : 0;
+        if (n <= 0) {
+            n = static_cast<long>(std::max(1u, std::thread::hardware_concurrency()));
+        }
+        return static_cast<size_t>(n);
+    }());
+    return pool;
+}
+
+size_t TaskGraph::add(std::function<void()> fn, std::vector<size_t> deps) {
+    for (size_t dep : deps) {
+        CHECK_ARGUMENT(dep < _nodes.size(), "TaskGraph: a task can only depend on earlier ones");
+    }
+    _nodes.push_back({std::move(fn), std::move(deps)});
+    return _nodes.size() - 1;
+}
+
+size_t TaskGraph::size() const {
+    return _nodes.size();
+}
+
+const std::function<void()> &TaskGraph::fn(size_t node) const {
+    return _nodes[node].fn;
+}
+
+const std::vector<size_t> &TaskGraph::deps(size_t node) const {
+    return _nodes[node].deps;
+}
+
+void TaskGraph::run() const {
+    size_t n = _nodes.size();
+    auto &pool = threadPool();
+    if (n <= 1 || t_in_pool || pool.size() == 1) {
+        // Tasks were added after their dependencies, so insertion order is a valid order.
+        std::vector<bool> failed(n, false);
+        std::exception_ptr error;
+        for (size_t i = 0; i < n; ++i) {
+            for (size_t dep : _nodes[i].deps) {
+                failed[i] = failed[i] || failed[dep];
+            }
+            if (failed[i]) {
+                continue;
+            }
+            try {
+                _nodes[i].fn();
+            } catch (...) {
+                failed[i] = true;
+                error = error ? error : std::current_exception();
+            }
+        }
+        if (error) {
+            std::rethrow_exception(error);
+        }
+        return;
+    }
+
+    struct State {
+        std::vector<std::vector<size_t>> dependents;
+        // Per task: dependencies not finished yet, and whether it or one of them threw.
+        std::unique_ptr<std::atomic<size_t>[]> waiting;
+        std::unique_ptr<std::atomic<bool>[]> failed;
+        std::atomic<size_t> remaining;
+        std::mutex mutex;
+        std::exception_ptr error;
+        std::function<void(size_t)> start;
+    } state;
+    state.dependents.resize(n);
+    state.waiting.reset(new std::atomic<size_t>[n]);
+    state.failed.reset(new std::atomic<bool>[n]);
+    state.remaining = n;
+    for (size_t i = 0; i < n; ++i) {
+        state.waiting[i] = _nodes[i].deps.size();
+        state.failed[i] = false;
+        for (size_t dep : _nodes[i].deps) {
+            state.dependents[dep].push_back(i);
+        }
+    }
+    state.start = [&](size_t i) {
+        pool.submit([&, i] {
+            if (!state.failed[i]) {
+                try {
+                    _nodes[i].fn();
+                } catch (...) {
+                    state.failed[i] = true;
+                    std::lock_guard<std::mutex> lock(state.mutex);
+                    state.error = state.error ? state.error : std::current_exception();
+                }
+            }
+            for (size_t d : state.dependents[i]) {
+                if (state.failed[i]) {
+                    state.failed[d] = true;
+                }
+                if (--state.waiting[d] == 0) {
+                    state.start(d);
+                }
+            }
+            // Last touch of `state`: run() may return once every task is counted.
+            --state.remaining;
+        });
+    };
+    for (size_t i = 0; i < n; ++i) {
+        if (_nodes[i].deps.empty()) {
+            state.start(i);
+        }
+    }
+    pool.helpUntil([&] { return state.remaining == 0; });
+    if (state.error) {
+        std::rethrow_exception(state.error);
+    }
+}
+} // namespace llaisys::utils
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace llaisys::utils {
+// Pool of threads for CPU kernels, shared by data-parallel loops and tasks. The thread that starts a loop takes
+// part in it, so a pool of size N owns N - 1 workers. Several loops may run at once, started by tasks or by
+// different threads; an idle thread takes the next chunk of the oldest loop that has some left, so the loops
+// share the pool instead of each wanting all of it. Loops nested in a chunk run inline.
+class ThreadPool {
+private:
+    // One parallelFor call. Lives on its caller's stack until every chunk has finished.
+    struct Loop {
+        const std::function<void(size_t, size_t)> *fn;
+        size_t n, nchunk;
+        size_t next, finished;
+        std::exception_ptr error;
+    };
+
+    std::vector<std::thread> _workers;
+    std::mutex _mutex;
+    // Signalled when work is queued, a chunk or task finishes, or the pool stops.
+    std::condition_variable _changed;
+    bool _stop;
+    // Loops with chunks left to hand out, oldest first, and tasks ready to run.
+    std::deque<Loop *> _loops;
+    std::deque<std::function<void()>> _tasks;
+
+    // Runs one chunk, or one task if `tasks` and there is no chunk. Called and returns with `lock` held; false
+    // if there was nothing to run.
+    bool _runOne(std::unique_lock<std::mutex> &lock, bool tasks);
+    void _work();
+
+public:
+    explicit ThreadPool(size_t nthread);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    size_t size() const;
+
+    // Calls fn(begin, end) over disjoint, non-empty ranges covering [0, n): at most one per thread, and at most
+    // n / grain rounded up, so that no range is much shorter than `grain`.
+    void parallelFor(size_t n, const std::function<void(size_t, size_t)> &fn, size_t grain = 1);
+
+    // Queues `task` to run on some thread of the pool. Unlike loop chunks, tasks may start parallel loops. A
+    // task must not throw.
+    void submit(std::function<void()> task);
+    // Runs queued chunks and tasks on the calling thread until `done()`, which is checked with the pool locked
+    // whenever a chunk or task finishes.
+    void helpUntil(const std::function<bool()> &done);
+};
+
+// Process-wide pool shared by every model and op. Sized by LLAISYS_NUM_THREADS, or the hardware concurrency.
+ThreadPool &threadPool();
+
+// A small dependency graph of tasks, e.g. the independent ops of a decoder layer. run() starts every task once
+// the tasks it depends on have finished, on the calling thread and the pool's, so independent tasks overlap
+// and each may still use the pool for its own loops.
+class TaskGraph {
+private:
+    struct Node {
+        std::function<void()> fn;
+        std::vector<size_t> deps;
+    };
+    std::vector<Node> _nodes;
+
+public:
+    // Adds a task that runs after the tasks `deps` and returns its index.
+    size_t add(std::function<void()> fn, std::vector<size_t> deps = {});
+    size_t size() const;
+    const std::function<void()> &fn(size_t node) const;
+    const std::vector<size_t> &deps(size_t node) const;
+
+    // Runs every task and rethrows the first exception; tasks depending on one that threw are skipped. Runs
+    // them in order on the calling thread when that is inside a loop chunk or the pool has one thread.
+    void run() const;
+};
+} // namespace llaisys::utils
@@ -0,0 +1,215 @@
+// Intrinsics go first: llaisys.h defines __C, which they use as a parameter name.
+#if defined(__AVX2__) && defined(__FMA__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "vec_math.hpp"
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+namespace {
+// The same algorithm serves every instruction set through one of these lane types.
+#if defined(__AVX2__) && defined(__FMA__)
+struct Lanes {
+    using V = __m256;
+    using I = __m256i;
+    static constexpr size_t WIDTH = 8;
+    static V load(const float *p) { return _mm256_loadu_ps(p); }
+    static void store(float *p, V v) { _mm256_storeu_ps(p, v); }
+    static V set(float x) { return _mm256_set1_ps(x); }
+    static V add(V a, V b) { return _mm256_add_ps(a, b); }
+    static V sub(V a, V b) { return _mm256_sub_ps(a, b); }
+    static V mul(V a, V b) { return _mm256_mul_ps(a, b); }
+    static V div(V a, V b) { return _mm256_div_ps(a, b); }
+    static V fma(V a, V b, V c) { return _mm256_fmadd_ps(a, b, c); }
+    static V min(V a, V b) { return _mm256_min_ps(a, b); }
+    static V max(V a, V b) { return _mm256_max_ps(a, b); }
+    static V less(V a, V b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+    static V greater(V a, V b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+    static V isnan(V a) { return _mm256_cmp_ps(a, a, _CMP_UNORD_Q); }
+    static V select(V mask, V a, V b) { return _mm256_blendv_ps(b, a, mask); }
+    static I round(V a) { return _mm256_cvtps_epi32(a); }
+    static V toFloat(I a) { return _mm256_cvtepi32_ps(a); }
+    // 2^n for n in [-126, 127].
+    static V pow2(I n) {
+        return _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_add_epi32(n, _mm256_set1_epi32(127)), 23));
+    }
+    static I dec(I n) { return _mm256_sub_epi32(n, _mm256_set1_epi32(1)); }
+};
+#elif defined(__SSE2__)
+struct Lanes {
+    using V = __m128;
+    using I = __m128i;
+    static constexpr size_t WIDTH = 4;
+    static V load(const float *p) { return _mm_loadu_ps(p); }
+    static void store(float *p, V v) { _mm_storeu_ps(p, v); }
+    static V set(float x) { return _mm_set1_ps(x); }
+    static V add(V a, V b) { return _mm_add_ps(a, b); }
+    static V sub(V a, V b) { return _mm_sub_ps(a, b); }
+    static V mul(V a, V b) { return _mm_mul_ps(a, b); }
+    static V div(V a, V b) { return _mm_div_ps(a, b); }
+    static V fma(V a, V b, V c) { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+    static V min(V a, V b) { return _mm_min_ps(a, b); }
+    static V max(V a, V b) { return _mm_max_ps(a, b); }
+    static V less(V a, V b) { return _mm_cmplt_ps(a, b); }
+    static V greater(V a, V b) { return _mm_cmpgt_ps(a, b); }
+    static V isnan(V a) { return _mm_cmpunord_ps(a, a); }
+    static V select(V mask, V a, V b) { return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); }
+    static I round(V a) { return _mm_cvtps_epi32(a); }
+    static V toFloat(I a) { return _mm_cvtepi32_ps(a); }
+    static V pow2(I n) { return _mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(n, _mm_set1_epi32(127)), 23)); }
+    static I dec(I n) { return _mm_sub_epi32(n, _mm_set1_epi32(1)); }
+};
+#else
+struct Lanes {
+    using V = float;
+    using I = int32_t;
+    static constexpr size_t WIDTH = 1;
+    static V load(const float *p) { return *p; }
+    static void store(float *p, V v) { *p = v; }
+    static V set(float x) { return x; }
+    static V add(V a, V b) { return a + b; }
+    static V sub(V a, V b) { return a - b; }
+    static V mul(V a, V b) { return a * b; }
+    static V div(V a, V b) { return a / b; }
+    static V fma(V a, V b, V c) { return a * b + c; }
+    static V min(V a, V b) { return b < a ? b : a; }
+    static V max(V a, V b) { return b > a ? b : a; }
+    // Masks are all-ones or zero, as in the vector versions.
+    static V mask(bool m) {
+        uint32_t bits = m ? 0xFFFFFFFFu : 0u;
+        V out;
+        std::memcpy(&out, &bits, sizeof(out));
+        return out;
+    }
+    static V less(V a, V b) { return mask(a < b); }
+    static V greater(V a, V b) { return mask(a > b); }
+    static V isnan(V a) { return mask(a != a); }
+    static V select(V mask, V a, V b) {
+        uint32_t bits;
+        std::memcpy(&bits, &mask, sizeof(bits));
+        return bits != 0 ? a : b;
+    }
+    static I round(V a) { return static_cast<I>(std::nearbyint(a)); }
+    static V toFloat(I a) { return static_cast<V>(a); }
+    static V pow2(I n) {
+        uint32_t bits = static_cast<uint32_t>(n + 127) << 23;
+        V out;
+        std::memcpy(&out, &bits, sizeof(out));
+        return out;
+    }
+    static I dec(I n) { return n - 1; }
+};
+#endif
+
+using L = Lanes;
+using V = L::V;
+
+constexpr float EXP_LO = -86.6f; // keeps 2^(n - 1) normal
+constexpr float EXP_HI = 88.72283935546875f;
+
+V expV(V x) {
+    V clamped = L::min(L::max(x, L::set(EXP_LO)), L::set(EXP_HI));
+    L::I n = L::round(L::mul(clamped, L::set(1.44269504088896341f)));
+    V nf = L::toFloat(n);
+    // r = x - n ln2, with ln2 split in two so the first product is exact.
+    V r = L::fma(nf, L::set(-0.693359375f), clamped);
+    r = L::fma(nf, L::set(2.12194440e-4f), r);
+
+    V p = L::set(1.9875691500e-4f);
+    p = L::fma(p, r, L::set(1.3981999507e-3f));
+    p = L::fma(p, r, L::set(8.3334519073e-3f));
+    p = L::fma(p, r, L::set(4.1665795894e-2f));
+    p = L::fma(p, r, L::set(1.6666665459e-1f));
+    p = L::fma(p, r, L::set(5.0000001201e-1f));
+    p = L::add(L::fma(p, L::mul(r, r), r), L::set(1.0f));
+
+    // Scaled by 2^(n - 1) then by 2, so n = 128 does not overflow the exponent field.
+    V out = L::mul(L::mul(p, L::pow2(L::dec(n))), L::set(2.0f));
+    out = L::select(L::less(x, L::set(EXP_LO)), L::set(0.0f), out);
+    out = L::select(L::greater(x, L::set(EXP_HI)), L::set(std::numeric_limits<float>::infinity()), out);
+    return L::select(L::isnan(x), x, out);
+}
+
+V swigluV(V gate, V up) {
+    V e = expV(L::sub(L::set(0.0f), gate));
+    return L::div(L::mul(up, gate), L::add(L::set(1.0f), e));
+}
+
+// Runs f over whole vectors, and over the tail through zero-padded buffers so that it takes the same path.
+template <typename F>
+void forEach(size_t n, F f) {
+    size_t i = 0;
+    for (; i + L::WIDTH <= n; i += L::WIDTH) {
+        f(i, L::WIDTH);
+    }
+    if (i < n) {
+        f(i, n - i);
+    }
+}
+
+// Loads `count` lanes starting at p, zero-filling the rest.
+V loadPartial(const float *p, size_t count) {
+    if (count == L::WIDTH) {
+        return L::load(p);
+    }
+    float buf[L::WIDTH] = {};
+    std::memcpy(buf, p, count * sizeof(float));
+    return L::load(buf);
+}
+
+void storePartial(float *p, V v, size_t count) {
+    if (count == L::WIDTH) {
+        return L::store(p, v);
+    }
+    float buf[L::WIDTH];
+    L::store(buf, v);
+    std::memcpy(p, buf, count * sizeof(float));
+}
+} // namespace
+
+namespace llaisys::utils::vec {
+void exp(float *out, const float *in, size_t n) {
+    forEach(n, [&](size_t i, size_t count) { storePartial(out + i, expV(loadPartial(in + i, count)), count); });
+}
+
+float expSum(float *x, size_t n, float shift) {
+    V acc = L::set(0.0f);
+    float tail = 0.0f;
+    forEach(n, [&](size_t i, size_t count) {
+        V e = expV(L::sub(loadPartial(x + i, count), L::set(shift)));
+        storePartial(x + i, e, count);
+        if (count == L::WIDTH) {
+            acc = L::add(acc, e);
+        } else {
+            for (size_t k = 0; k < count; ++k) {
+                tail += x[i + k];
+            }
+        }
+    });
+    float lanes[L::WIDTH];
+    L::store(lanes, acc);
+    for (size_t k = 0; k < L::WIDTH; ++k) {
+        tail += lanes[k];
+    }
+    return tail;
+}
+
+void silu(float *out, const float *x, size_t n) {
+    forEach(n, [&](size_t i, size_t count) {
+        V v = loadPartial(x + i, count);
+        storePartial(out + i, swigluV(v, L::set(1.0f)), count);
+    });
+}
+
+void swiglu(float *out, const float *gate, const float *up, size_t n) {
+    forEach(n, [&](size_t i, size_t count) {
+        storePartial(out + i, swigluV(loadPartial(gate + i, count), loadPartial(up + i, count)), count);
+    });
+}
+} // namespace llaisys::utils::vec
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstddef>
+
+// Vectorized float math for CPU kernels, using the widest of AVX2+FMA, SSE2 or scalar code the build targets.
+//
+// exp reduces x = n ln2 + r with |r| <= ln2 / 2 and evaluates e^r with a degree-6 polynomial (Cephes expf). Over
+// every float in [-86.6, 88.7] its error is at most 1 ULP, measured with SSE2 and with AVX2+FMA. Below that range
+// it returns 0 (true results are under 2.4e-38), above it +inf, and NaN stays NaN. Results do not depend on the
+// position of an element in the array.
+namespace llaisys::utils::vec {
+// out[i] = exp(in[i]). out may be in.
+void exp(float *out, const float *in, size_t n);
+// x[i] = exp(x[i] - shift), returning the sum of the results; -inf maps to 0. For softmax.
+float expSum(float *x, size_t n, float shift);
+// out[i] = x[i] * sigmoid(x[i]). out may be x.
+void silu(float *out, const float *x, size_t n);
+// out[i] = up[i] * silu(gate[i]). out may be either input.
+void swiglu(float *out, const float *gate, const float *up, size_t n);
+} // namespace llaisys::utils::vec
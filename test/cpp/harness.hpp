@@ -0,0 +1,34 @@
+#pragma once
+
+// Shared by the C++ tests of library internals. Every test_*.cpp is a program of its own; build and run them
+// with `xmake build -g tests` and `xmake run -g tests`.
+
+#include <cstdio>
+#include <cstdlib>
+
+#define EXPECT(condition)                                                                  \
+    do {                                                                                   \
+        if (!(condition)) {                                                                \
+            std::fprintf(stderr, "%s:%d: expected %s\n", __FILE__, __LINE__, #condition);  \
+            std::exit(1);                                                                  \
+        }                                                                                  \
+    } while (0)
+
+#define EXPECT_THROWS(statement)                                                           \
+    do {                                                                                   \
+        bool thrown = false;                                                               \
+        try {                                                                              \
+            statement;                                                                     \
+        } catch (...) {                                                                    \
+            thrown = true;                                                                 \
+        }                                                                                  \
+        if (!thrown) {                                                                     \
+            std::fprintf(stderr, "%s:%d: expected %s to throw\n", __FILE__, __LINE__, #statement); \
+            std::exit(1);                                                                  \
+        }                                                                                  \
+    } while (0)
+
+inline int testPassed() {
+    std::printf("\033[92mTest passed!\033[0m\n");
+    return 0;
+}
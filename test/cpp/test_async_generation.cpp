@@ -0,0 +1,214 @@
+#include "harness.hpp"
+#include "tiny_qwen2.hpp"
+
+#include "models/generation/async_generation.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+using llaisys::models::AsyncGeneration;
+using llaisys::models::TokenRing;
+
+namespace {
+void testRingSingleThread() {
+    TokenRing ring(3); // rounded up to 4
+    int64_t out[8];
+    EXPECT(ring.empty() && !ring.full());
+    for (int64_t t = 0; t < 4; ++t) {
+        EXPECT(ring.tryPush(t));
+    }
+    EXPECT(ring.full() && !ring.tryPush(4));
+    EXPECT(ring.tryPop(out, 3) == 3 && out[0] == 0 && out[2] == 2);
+    // Positions wrap around the buffer.
+    EXPECT(ring.tryPush(4) && ring.tryPush(5) && ring.tryPush(6));
+    EXPECT(ring.tryPop(out, 8) == 4 && out[0] == 3 && out[3] == 6);
+    EXPECT(ring.empty() && ring.tryPop(out, 8) == 0);
+    ring.tryPush(7);
+    ring.clear();
+    EXPECT(ring.empty());
+}
+
+// A producer and a consumer on different threads see every token once and in order.
+void testRingTwoThreads() {
+    constexpr int64_t N = 200000;
+    TokenRing ring(16);
+    std::thread producer([&] {
+        for (int64_t t = 0; t < N; ++t) {
+            while (!ring.tryPush(t)) {
+                std::this_thread::yield();
+            }
+        }
+    });
+    int64_t expected = 0, out[7];
+    while (expected < N) {
+        size_t n = ring.tryPop(out, 7);
+        for (size_t i = 0; i < n; ++i) {
+            EXPECT(out[i] == expected++);
+        }
+        if (n == 0) {
+            std::this_thread::yield();
+        }
+    }
+    producer.join();
+    EXPECT(ring.empty());
+}
+
+// Emits 0, 1, 2, ... until told to stop.
+size_t countForever(const std::function<bool(int64_t)> &emit) {
+    size_t n = 0;
+    while (emit(static_cast<int64_t>(n))) {
+        ++n;
+    }
+    return n;
+}
+
+// A reader slower than the generation holds it back through the ring, and gets every token in order.
+void testReadBackpressure() {
+    AsyncGeneration generation(4);
+    generation.start(
+        [](const std::function<bool(int64_t)> &emit) {
+            for (int64_t t = 0; t < 100; ++t) {
+                emit(t);
+            }
+            return size_t(100);
+        },
+        nullptr, nullptr);
+    int64_t out[3], expected = 0;
+    while (size_t n = generation.read(out, 3)) {
+        for (size_t i = 0; i < n; ++i) {
+            EXPECT(out[i] == expected++);
+        }
+    }
+    EXPECT(expected == 100 && generation.wait() == 100);
+}
+
+// Cancelling releases a generation blocked on a full ring, and the next one starts afresh.
+void testCancel() {
+    AsyncGeneration generation(4);
+    generation.start(countForever, nullptr, nullptr);
+    int64_t out[2];
+    EXPECT(generation.read(out, 1) == 1 && out[0] == 0);
+    generation.cancel();
+    EXPECT(generation.wait() >= 1);
+    while (generation.read(out, 2) > 0) {
+    }
+
+    // A token the cancel kept out of a full ring is not counted.
+    std::atomic<size_t> attempts{0};
+    generation.start(
+        [&](const std::function<bool(int64_t)> &emit) {
+            size_t n = 0;
+            while (++attempts, emit(static_cast<int64_t>(n))) {
+                ++n;
+            }
+            return n;
+        },
+        nullptr, nullptr);
+    // Four tokens fill the ring and the fifth waits for room.
+    while (attempts < 5) {
+        std::this_thread::yield();
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    generation.cancel();
+    size_t read = 0;
+    while (size_t n = generation.read(out, 2)) {
+        read += n;
+    }
+    EXPECT(read == 4 && generation.wait() == 4);
+
+    // From the callback, on the generation thread.
+    struct Counter {
+        AsyncGeneration *generation;
+        int64_t last = -1;
+    } counter{&generation};
+    generation.start(
+        countForever,
+        [](int64_t token, void *userdata) {
+            auto *c = static_cast<Counter *>(userdata);
+            c->last = token;
+            if (token == 9) {
+                c->generation->cancel();
+            }
+        },
+        &counter);
+    EXPECT(generation.wait() == 10 && counter.last == 9);
+
+    // Destroying a running generation cancels and waits for it.
+    {
+        AsyncGeneration running(4);
+        running.start(countForever, nullptr, nullptr);
+    }
+}
+
+void testErrorRethrown() {
+    AsyncGeneration generation;
+    generation.start([](const std::function<bool(int64_t)> &) -> size_t { throw std::runtime_error("boom"); },
+                     nullptr, nullptr);
+    EXPECT_THROWS(generation.wait());
+    // The error is reported once and the generation can be reused.
+    generation.start([](const std::function<bool(int64_t)> &) { return size_t(0); }, nullptr, nullptr);
+    EXPECT(generation.wait() == 0);
+}
+
+// Each model generates on its own thread: the first model's callback blocks until the second model has
+// produced a token, which only happens if both run at once.
+struct Rendezvous {
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool second_started = false;
+    bool timed_out = false;
+    std::vector<int64_t> tokens[2];
+};
+
+void testModelsGenerateConcurrently() {
+    auto *first = tinyQwen2(64, 1), *second = tinyQwen2(64, 2);
+    std::vector<int64_t> prompt{1, 2, 3, 4, 5};
+    auto expected_first = greedyDecode(first, prompt, 8), expected_second = greedyDecode(second, prompt, 8);
+
+    Rendezvous r;
+    LlaisysQwen2GenerateParams params{8, 0.f, 1, 1.f, 0, 0, 4};
+    llaisysQwen2ModelGenerate(
+        first, prompt.data(), prompt.size(), &params,
+        [](int64_t token, void *userdata) {
+            auto *r = static_cast<Rendezvous *>(userdata);
+            std::unique_lock<std::mutex> lock(r->mutex);
+            if (!r->cv.wait_for(lock, std::chrono::seconds(30), [&] { return r->second_started; })) {
+                r->timed_out = true;
+            }
+            r->tokens[0].push_back(token);
+        },
+        &r);
+    llaisysQwen2ModelGenerate(
+        second, prompt.data(), prompt.size(), &params,
+        [](int64_t token, void *userdata) {
+            auto *r = static_cast<Rendezvous *>(userdata);
+            {
+                std::lock_guard<std::mutex> lock(r->mutex);
+                r->second_started = true;
+                r->tokens[1].push_back(token);
+            }
+            r->cv.notify_all();
+        },
+        &r);
+    EXPECT(llaisysQwen2ModelWait(second) == 8);
+    EXPECT(llaisysQwen2ModelWait(first) == 8);
+    EXPECT(!r.timed_out);
+    EXPECT(r.tokens[0] == expected_first && r.tokens[1] == expected_second);
+    llaisysQwen2ModelDestroy(first);
+    llaisysQwen2ModelDestroy(second);
+}
+} // namespace
+
+int main() {
+    testRingSingleThread();
+    testRingTwoThreads();
+    testReadBackpressure();
+    testCancel();
+    testErrorRethrown();
+    testModelsGenerateConcurrently();
+    return testPassed();
+}
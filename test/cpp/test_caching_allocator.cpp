@@ -0,0 +1,218 @@
+#include "harness.hpp"
+
+#include "core/allocator/caching_allocator.hpp"
+
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+using llaisys::core::allocators::CachingAllocator;
+
+namespace {
+constexpr size_t KIB = size_t(1) << 10, MIB = size_t(1) << 20;
+
+// A device that counts what is allocated on it and fails beyond `capacity` bytes.
+struct FakeDevice {
+    std::mutex mutex;
+    std::unordered_map<void *, size_t> blocks;
+    size_t live = 0;
+    size_t mallocs = 0;
+    size_t capacity = SIZE_MAX;
+} device;
+
+void *fakeMalloc(size_t size) {
+    std::lock_guard<std::mutex> lock(device.mutex);
+    if (device.live + size > device.capacity) {
+        return nullptr;
+    }
+    void *memory = std::malloc(size);
+    device.blocks[memory] = size;
+    device.live += size;
+    ++device.mallocs;
+    return memory;
+}
+
+void fakeFree(void *memory) {
+    std::lock_guard<std::mutex> lock(device.mutex);
+    auto it = device.blocks.find(memory);
+    EXPECT(it != device.blocks.end());
+    device.live -= it->second;
+    device.blocks.erase(it);
+    std::free(memory);
+}
+
+size_t live() {
+    std::lock_guard<std::mutex> lock(device.mutex);
+    return device.live;
+}
+
+size_t mallocs() {
+    std::lock_guard<std::mutex> lock(device.mutex);
+    return device.mallocs;
+}
+
+LlaisysRuntimeAPI makeApi() {
+    LlaisysRuntimeAPI api{};
+    api.malloc_device = fakeMalloc;
+    api.free_device = fakeFree;
+    return api;
+}
+const LlaisysRuntimeAPI API = makeApi();
+
+// Runs `fn` on a thread of its own, whose cache goes back to the shared pool when it exits. The allocator must
+// outlive the threads that used it, so the tests never allocate on the main thread.
+template <typename Fn>
+void onThread(Fn fn) {
+    std::thread(fn).join();
+}
+
+// A thread reuses the small blocks it freed without going to the device, and keeps only a few of each class.
+void testThreadCache() {
+    CachingAllocator allocator(&API, 64 * MIB);
+    onThread([&] {
+        std::byte *a = allocator.allocate(1000);
+        allocator.release(a, 1000);
+        size_t before = mallocs();
+        // Same class of 1 KiB blocks.
+        EXPECT(allocator.allocate(900) == a);
+        EXPECT(mallocs() == before);
+        allocator.release(a, 900);
+
+        std::vector<std::byte *> blocks;
+        for (size_t i = 0; i < 6; ++i) {
+            blocks.push_back(allocator.allocate(4 * KIB));
+        }
+        for (std::byte *block : blocks) {
+            allocator.release(block, 4 * KIB);
+        }
+        // Four stay with the thread and the rest go to the shared pool; all six come back without the device.
+        before = mallocs();
+        for (size_t i = 0; i < 6; ++i) {
+            allocator.allocate(4 * KIB);
+        }
+        EXPECT(mallocs() == before);
+        EXPECT(allocator.allocate(4 * KIB) != nullptr && mallocs() == before + 1);
+    });
+}
+
+// A block freed on another thread is reused by a third once the freeing thread exits.
+void testCrossThreadFree() {
+    CachingAllocator allocator(&API, 64 * MIB);
+    std::byte *block = nullptr;
+    onThread([&] { block = allocator.allocate(64 * KIB); });
+    onThread([&] { allocator.release(block, 64 * KIB); });
+    onThread([&] {
+        size_t before = mallocs();
+        EXPECT(allocator.allocate(60 * KIB) == block);
+        EXPECT(mallocs() == before);
+        allocator.release(block, 60 * KIB);
+    });
+}
+
+// Blocks beyond 1 MiB are allocated at their exact size, below the size of the class they are kept in. The
+// budget holds for what they actually take, also when a smaller request reused them.
+void testBudget() {
+    size_t base = live();
+    {
+        CachingAllocator allocator(&API, 4 * MIB);
+        onThread([&] {
+            std::vector<std::byte *> blocks;
+            for (size_t i = 0; i < 8; ++i) {
+                blocks.push_back(allocator.allocate(1300 * KIB));
+            }
+            for (std::byte *block : blocks) {
+                allocator.release(block, 1300 * KIB);
+            }
+            EXPECT(live() - base <= 4 * MIB);
+            // Three fit the budget.
+            EXPECT(live() - base == 3 * 1300 * KIB);
+
+            allocator.trim();
+            EXPECT(live() == base);
+            blocks.clear();
+            for (size_t i = 0; i < 4; ++i) {
+                blocks.push_back(allocator.allocate(1600 * KIB));
+            }
+            for (std::byte *block : blocks) {
+                allocator.release(block, 1600 * KIB);
+            }
+            // Smaller requests of the same class reuse the 1600 KiB blocks and release them with their own size.
+            for (size_t round = 0; round < 4; ++round) {
+                blocks.clear();
+                for (size_t i = 0; i < 2; ++i) {
+                    blocks.push_back(allocator.allocate(1500 * KIB));
+                }
+                for (std::byte *block : blocks) {
+                    allocator.release(block, 1500 * KIB);
+                }
+                EXPECT(live() - base <= 4 * MIB);
+            }
+        });
+    }
+    EXPECT(live() == base);
+}
+
+// When the device runs out, cached blocks of other sizes are freed and the allocation retried.
+void testTrimOnOutOfMemory() {
+    size_t base = live();
+    device.capacity = base + 8 * MIB;
+    {
+        CachingAllocator allocator(&API, 64 * MIB);
+        onThread([&] {
+            std::vector<std::byte *> blocks;
+            for (size_t i = 0; i < 3; ++i) {
+                blocks.push_back(allocator.allocate(2 * MIB));
+            }
+            for (std::byte *block : blocks) {
+                allocator.release(block, 2 * MIB);
+            }
+            EXPECT(live() - base == 6 * MIB);
+            std::byte *large = allocator.allocate(5 * MIB);
+            EXPECT(large != nullptr);
+            EXPECT(live() - base == 5 * MIB);
+            allocator.release(large, 5 * MIB);
+        });
+    }
+    device.capacity = SIZE_MAX;
+    EXPECT(live() == base);
+}
+
+// Thread caches go back to the shared pool, and the allocator frees the pool when destroyed.
+void testNothingLeaks() {
+    size_t base = live();
+    {
+        CachingAllocator allocator(&API, 64 * MIB);
+        std::vector<std::thread> threads;
+        for (size_t t = 0; t < 4; ++t) {
+            threads.emplace_back([&, t] {
+                for (size_t i = 0; i < 200; ++i) {
+                    size_t size = (t + 1) * (i % 7 + 1) * 300 * KIB / 7 + 1;
+                    allocator.release(allocator.allocate(size), size);
+                }
+            });
+        }
+        for (auto &thread : threads) {
+            thread.join();
+        }
+        // Sizes beyond the cached range go straight back to the device.
+        onThread([&] {
+            size_t before = live();
+            std::byte *huge = allocator.allocate(65 * MIB);
+            allocator.release(huge, 65 * MIB);
+            EXPECT(live() == before);
+        });
+    }
+    EXPECT(live() == base);
+}
+} // namespace
+
+int main() {
+    testThreadCache();
+    testCrossThreadFree();
+    testBudget();
+    testTrimOnOutOfMemory();
+    testNothingLeaks();
+    return testPassed();
+}
@@ -0,0 +1,88 @@
+#include "harness.hpp"
+
+#include "device/cpu/cpu_stream.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+
+using llaisys::device::cpu::Stream;
+using llaisys::device::cpu::synchronizeStreams;
+
+namespace {
+// Runs `fn` on a thread and fails the test if it has not returned within a few seconds, e.g. on a deadlock.
+template <typename Fn>
+void withinDeadline(Fn fn) {
+    auto done = std::async(std::launch::async, fn);
+    if (done.wait_for(std::chrono::seconds(10)) != std::future_status::ready) {
+        std::fprintf(stderr, "%s:%d: timed out\n", __FILE__, __LINE__);
+        std::_Exit(1);
+    }
+    done.get();
+}
+
+// Work on a stream creates and destroys another stream while a second thread waits for every stream.
+void testStreamCreatedDuringSynchronize() {
+    withinDeadline([] {
+        Stream stream;
+        std::atomic<bool> syncing{false}, inner_ran{false};
+        stream.enqueue([&] {
+            while (!syncing) {
+                std::this_thread::yield();
+            }
+            // Let synchronizeStreams() start waiting on this stream.
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            Stream inner;
+            inner.enqueue([&] { inner_ran = true; });
+            inner.synchronize();
+        });
+        std::thread waiter([&] {
+            syncing = true;
+            synchronizeStreams();
+        });
+        waiter.join();
+        EXPECT(inner_ran);
+    });
+}
+
+// An exception from one stream is rethrown only after the others have drained.
+void testErrorAfterEveryStreamDrains() {
+    withinDeadline([] {
+        auto failing = std::make_unique<Stream>();
+        auto slow = std::make_unique<Stream>();
+        std::atomic<bool> slow_done{false};
+        failing->enqueue([] { throw std::runtime_error("stream"); });
+        slow->enqueue([&] {
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            slow_done = true;
+        });
+        EXPECT_THROWS(synchronizeStreams());
+        EXPECT(slow_done);
+        // The error was reported once.
+        synchronizeStreams();
+    });
+}
+
+// Streams destroyed while another thread waits for every stream.
+void testDestroyDuringSynchronize() {
+    withinDeadline([] {
+        for (size_t rep = 0; rep < 100; ++rep) {
+            auto stream = std::make_unique<Stream>();
+            stream->enqueue([] { std::this_thread::sleep_for(std::chrono::microseconds(200)); });
+            std::thread waiter([] { synchronizeStreams(); });
+            stream.reset();
+            waiter.join();
+        }
+    });
+}
+} // namespace
+
+int main() {
+    testStreamCreatedDuringSynchronize();
+    testErrorAfterEveryStreamDrains();
+    testDestroyDuringSynchronize();
+    return testPassed();
+}
@@ -0,0 +1,132 @@
+#include "harness.hpp"
+
+#include "models/qwen2/qwen2.hpp"
+#include "ops/add/op.hpp"
+#include "ops/elementwise/fusion.hpp"
+#include "ops/graph/graph.hpp"
+
+#include <cstring>
+#include <random>
+#include <vector>
+
+using llaisys::Tensor;
+using llaisys::tensor_t;
+using llaisys::models::Qwen2;
+
+namespace {
+void fill(const tensor_t &tensor, float scale, std::mt19937 &rng) {
+    size_t numel = 1;
+    for (size_t d : tensor->shape()) {
+        numel *= d;
+    }
+    std::vector<float> values(numel);
+    std::uniform_real_distribution<float> uniform(-scale, scale);
+    for (float &v : values) {
+        v = uniform(rng);
+    }
+    tensor->load(values.data());
+}
+
+// The model of tinyQwen2, built directly so that its logits can be read.
+std::unique_ptr<Qwen2> tinyModel(unsigned seed) {
+    LlaisysQwen2Meta meta{LLAISYS_DTYPE_F32, 2, 32, 4, 2, 8, 48, 64, 50, 1e-6f, 10000.f, 49};
+    auto model = std::make_unique<Qwen2>(meta, LLAISYS_DEVICE_CPU, 0);
+    auto &w = model->weights();
+    std::mt19937 rng(seed);
+    fill(w.in_embed, 1.0f, rng);
+    fill(w.out_embed, 0.5f, rng);
+    fill(w.out_norm_w, 1.0f, rng);
+    for (size_t l = 0; l < meta.nlayer; ++l) {
+        fill(w.attn_norm_w[l], 1.0f, rng);
+        fill(w.attn_q_w[l], 0.3f, rng);
+        fill(w.attn_q_b[l], 0.1f, rng);
+        fill(w.attn_k_w[l], 0.3f, rng);
+        fill(w.attn_k_b[l], 0.1f, rng);
+        fill(w.attn_v_w[l], 0.3f, rng);
+        fill(w.attn_v_b[l], 0.1f, rng);
+        fill(w.attn_o_w[l], 0.3f, rng);
+        fill(w.mlp_norm_w[l], 1.0f, rng);
+        fill(w.mlp_gate_w[l], 0.3f, rng);
+        fill(w.mlp_up_w[l], 0.3f, rng);
+        fill(w.mlp_down_w[l], 0.3f, rng);
+    }
+    return model;
+}
+
+std::vector<float> nextLogits(const Qwen2 &model) {
+    std::vector<float> logits(model.meta().voc);
+    std::memcpy(logits.data(), model.logits()->data(), logits.size() * sizeof(float));
+    return logits;
+}
+
+// Greedy decoding from `prompt`, recording the tokens and the logits of every step.
+void decode(Qwen2 &model, std::vector<int64_t> prompt, size_t n, std::vector<int64_t> &tokens,
+            std::vector<std::vector<float>> &logits) {
+    model.reset();
+    int64_t next = model.infer(prompt.data(), prompt.size());
+    for (size_t i = 0; i < n; ++i) {
+        tokens.push_back(next);
+        logits.push_back(nextLogits(model));
+        next = model.infer(&next, 1);
+    }
+}
+
+// Decode steps replayed from the captured graph must give exactly what running the ops one by one gives.
+void testReplayMatchesEager(bool fusion) {
+    llaisys::ops::enableFusion(fusion);
+    for (unsigned seed = 1; seed <= 3; ++seed) {
+        auto model = tinyModel(seed);
+        std::vector<int64_t> prompt{3, 1, 4, 1, 5, 9, 2, 6};
+        std::vector<int64_t> eager_tokens, replay_tokens;
+        std::vector<std::vector<float>> eager_logits, replay_logits;
+        model->enableGraph(false);
+        decode(*model, prompt, 24, eager_tokens, eager_logits);
+        model->enableGraph(true);
+        decode(*model, prompt, 24, replay_tokens, replay_logits);
+        EXPECT(replay_tokens == eager_tokens);
+        EXPECT(replay_logits == eager_logits);
+        // A second sequence replays the graph captured on the first.
+        replay_tokens.clear();
+        replay_logits.clear();
+        decode(*model, prompt, 24, replay_tokens, replay_logits);
+        EXPECT(replay_tokens == eager_tokens);
+        EXPECT(replay_logits == eager_logits);
+    }
+    llaisys::ops::enableFusion(false);
+}
+
+// An elementwise op left pending before a host node runs before it, both when captured and on replay.
+void testHostNodeAfterFusedOp() {
+    llaisys::ops::enableFusion(true);
+    auto a = Tensor::create({4}, LLAISYS_DTYPE_F32);
+    auto b = Tensor::create({4}, LLAISYS_DTYPE_F32);
+    auto c = Tensor::create({4}, LLAISYS_DTYPE_F32);
+    std::vector<float> seen(4, 0.0f), values{1, 2, 3, 4}, ones(4, 1.0f);
+    a->load(values.data());
+    b->load(ones.data());
+    c->load(std::vector<float>(4, 0.0f).data());
+    auto copy_out = [&] { std::memcpy(seen.data(), c->data(), sizeof(float) * 4); };
+
+    llaisys::ops::Graph graph;
+    {
+        llaisys::ops::GraphCapture capture(graph);
+        llaisys::ops::add(c, a, b);
+        llaisys::ops::hostNode(copy_out);
+        capture.finish();
+    }
+    EXPECT((seen == std::vector<float>{2, 3, 4, 5}));
+
+    values = {10, 20, 30, 40};
+    a->load(values.data());
+    graph.replay();
+    EXPECT((seen == std::vector<float>{11, 21, 31, 41}));
+    llaisys::ops::enableFusion(false);
+}
+} // namespace
+
+int main() {
+    testReplayMatchesEager(false);
+    testReplayMatchesEager(true);
+    testHostNodeAfterFusedOp();
+    return testPassed();
+}
@@ -0,0 +1,140 @@
+#include "harness.hpp"
+
+#include "models/kv_cache/kv_cache.hpp"
+
+#include <algorithm>
+#include <set>
+#include <vector>
+
+using llaisys::models::KVCache;
+
+namespace {
+constexpr size_t NLAYER = 2, CAPACITY = 12, NKVH = 2, DH = 4;
+
+KVCache makeCache() {
+    return KVCache(NLAYER, CAPACITY, NKVH, DH, LLAISYS_DTYPE_F32, LLAISYS_DEVICE_CPU, 0);
+}
+
+// A value that identifies the token position, layer, keys or values, head and element.
+float rowValue(int64_t pos, size_t layer, size_t kv, size_t head, size_t d) {
+    return static_cast<float>(pos * 1000 + layer * 100 + kv * 50 + head * 10 + d);
+}
+
+// Each head ranks the same tokens differently: head 0 by (7 pos) mod 10, head 1 by position.
+float mass(int64_t pos, size_t head) {
+    return static_cast<float>(head == 0 ? pos * 7 % 10 : pos);
+}
+
+// Appends tokens at `positions` the way attention would leave them: rows written, mass accumulated.
+void append(KVCache &cache, const std::vector<int64_t> &positions) {
+    size_t first = cache.length();
+    cache.prepareRows(positions.data(), positions.size());
+    for (size_t l = 0; l < NLAYER; ++l) {
+        for (size_t kv = 0; kv < 2; ++kv) {
+            auto *data = reinterpret_cast<float *>((kv == 0 ? cache.keys(l) : cache.values(l))->data());
+            for (size_t i = 0; i < positions.size(); ++i) {
+                for (size_t h = 0; h < NKVH; ++h) {
+                    for (size_t d = 0; d < DH; ++d) {
+                        data[((first + i) * NKVH + h) * DH + d] = rowValue(positions[i], l, kv, h, d);
+                    }
+                }
+            }
+        }
+        auto *pos = reinterpret_cast<const int64_t *>(cache.positions(l)->data());
+        auto *row_mass = reinterpret_cast<float *>(cache.attentionMass(l)->data());
+        for (size_t i = 0; i < positions.size(); ++i) {
+            for (size_t h = 0; h < NKVH; ++h) {
+                size_t slot = (first + i) * NKVH + h;
+                EXPECT(pos[slot] == positions[i] && row_mass[slot] == 0.0f);
+                row_mass[slot] = mass(positions[i], h);
+            }
+        }
+    }
+    cache.setLength(first + positions.size());
+}
+
+// Checks that every head of every layer holds exactly the tokens `expected[head]`, each with its own rows
+// and mass wherever compaction put it.
+void expectHeads(const KVCache &cache, const std::vector<std::set<int64_t>> &expected) {
+    for (size_t l = 0; l < NLAYER; ++l) {
+        auto *pos = reinterpret_cast<const int64_t *>(cache.positions(l)->data());
+        auto *row_mass = reinterpret_cast<const float *>(cache.attentionMass(l)->data());
+        for (size_t h = 0; h < NKVH; ++h) {
+            std::set<int64_t> held;
+            for (size_t s = 0; s < cache.length(); ++s) {
+                int64_t p = pos[s * NKVH + h];
+                held.insert(p);
+                EXPECT(row_mass[s * NKVH + h] == mass(p, h));
+                for (size_t kv = 0; kv < 2; ++kv) {
+                    auto *data = reinterpret_cast<const float *>((kv == 0 ? cache.keys(l) : cache.values(l))->data());
+                    for (size_t d = 0; d < DH; ++d) {
+                        EXPECT(data[(s * NKVH + h) * DH + d] == rowValue(p, l, kv, h, d));
+                    }
+                }
+            }
+            EXPECT(held == expected[h]);
+        }
+    }
+}
+
+void testHeavyHitterEviction() {
+    auto cache = makeCache();
+    EXPECT_THROWS(cache.prepareRows(nullptr, 0));
+    EXPECT_THROWS(cache.setHeavyHitter(true, CAPACITY, 2));
+    EXPECT_THROWS(cache.setHeavyHitter(true, 6, 7));
+    cache.setHeavyHitter(true, 6, 2);
+    EXPECT(cache.evicts() && cache.budget() == 6);
+
+    std::vector<int64_t> positions(10);
+    for (size_t i = 0; i < positions.size(); ++i) {
+        positions[i] = static_cast<int64_t>(i);
+    }
+    append(cache, positions);
+    cache.evict();
+    // The two newest tokens stay; of the rest, head 0 keeps the masses 7, 8, 5, 9 and head 1 the latest four.
+    EXPECT(cache.length() == 6);
+    expectHeads(cache, {{1, 4, 5, 7, 8, 9}, {4, 5, 6, 7, 8, 9}});
+    EXPECT(cache.evictionStats().evictions == 1 && cache.evictionStats().evicted_entries == 4 * NLAYER * NKVH);
+
+    // Heads now hold different tokens at the same rows; new rows go after them in every head.
+    append(cache, {10, 11, 12});
+    cache.evict();
+    expectHeads(cache, {{1, 4, 7, 8, 11, 12}, {7, 8, 9, 10, 11, 12}});
+    EXPECT(cache.evictionStats().evictions == 2 && cache.evictionStats().evicted_entries == 7 * NLAYER * NKVH);
+
+    // Within the budget nothing goes.
+    cache.setLength(0);
+    append(cache, {0, 1, 2});
+    cache.evict();
+    expectHeads(cache, {{0, 1, 2}, {0, 1, 2}});
+    EXPECT_THROWS(cache.setStreaming(true, 2));
+}
+
+void testStreamingSlots() {
+    auto cache = KVCache(NLAYER, 6, NKVH, DH, LLAISYS_DTYPE_F32, LLAISYS_DEVICE_CPU, 0);
+    std::vector<size_t> slots;
+    EXPECT_THROWS(cache.append(1, slots));
+    cache.setStreaming(true, 2);
+    cache.append(4, slots);
+    EXPECT((slots == std::vector<size_t>{0, 1, 2, 3}));
+    // Two free rows, then the oldest window row is reused; sinks are never evicted.
+    cache.append(3, slots);
+    EXPECT((slots == std::vector<size_t>{4, 5, 2}));
+    EXPECT((cache.slotPositions() == std::vector<int64_t>{0, 1, 5, 2, 3, 4}));
+    EXPECT(cache.evictionStats().evicted_entries == NLAYER * NKVH);
+    cache.append(4, slots);
+    EXPECT((slots == std::vector<size_t>{3, 4, 5, 2}));
+    EXPECT((cache.slotPositions() == std::vector<int64_t>{0, 1, 5, 2, 3, 4}));
+    EXPECT_THROWS(cache.append(5, slots));
+    EXPECT_THROWS(cache.setLength(3));
+    cache.setLength(0);
+    cache.append(1, slots);
+    EXPECT((slots == std::vector<size_t>{0}));
+}
+} // namespace
+
+int main() {
+    testHeavyHitterEviction();
+    testStreamingSlots();
+    return testPassed();
+}
@@ -0,0 +1,168 @@
+#include "harness.hpp"
+#include "tiny_qwen2.hpp"
+
+#include "models/kv_snapshot/kv_snapshot.hpp"
+#include "utils.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+
+using llaisys::models::KVCache;
+
+namespace {
+constexpr size_t NLAYER = 2, CAPACITY = 16, NKVH = 2, DH = 8;
+
+KVCache makeCache(llaisysDataType_t dtype, size_t nkvh = NKVH) {
+    return KVCache(NLAYER, CAPACITY, nkvh, DH, dtype, LLAISYS_DEVICE_CPU, 0);
+}
+
+template <typename T>
+void fillRows(KVCache &cache, size_t ntoken, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::normal_distribution<float> normal(0.0f, 2.0f);
+    for (size_t l = 0; l < NLAYER; ++l) {
+        for (const auto &tensor : {cache.keys(l), cache.values(l)}) {
+            auto *data = reinterpret_cast<T *>(tensor->data());
+            for (size_t i = 0; i < ntoken * NKVH * DH; ++i) {
+                data[i] = llaisys::utils::cast<T>(normal(rng));
+            }
+        }
+    }
+    cache.setLength(ntoken);
+}
+
+std::vector<std::byte> encode(const std::vector<int64_t> &tokens, const KVCache &cache, bool quantize) {
+    std::vector<std::byte> bytes;
+    llaisys::models::writeKVSnapshot(
+        [&](const void *data, size_t size) {
+            auto *begin = static_cast<const std::byte *>(data);
+            bytes.insert(bytes.end(), begin, begin + size);
+        },
+        tokens.data(), tokens.size(), cache, quantize);
+    EXPECT(bytes.size() == llaisys::models::kvSnapshotBytes(tokens.size(), cache, quantize));
+    return bytes;
+}
+
+bool sameRows(const KVCache &a, const KVCache &b, size_t ntoken) {
+    for (size_t l = 0; l < NLAYER; ++l) {
+        if (std::memcmp(a.keys(l)->data(), b.keys(l)->data(), ntoken * a.rowBytes()) != 0
+            || std::memcmp(a.values(l)->data(), b.values(l)->data(), ntoken * a.rowBytes()) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Rows stored in the cache's dtype come back bit for bit.
+void testExactRoundTrip() {
+    std::vector<int64_t> tokens{3, 1, 4, 1, 5, 9, 2, 6, 5, 3};
+    for (auto dtype : {LLAISYS_DTYPE_F32, LLAISYS_DTYPE_BF16}) {
+        auto cache = makeCache(dtype);
+        if (dtype == LLAISYS_DTYPE_F32) {
+            fillRows<float>(cache, tokens.size(), 1);
+        } else {
+            fillRows<llaisys::bf16_t>(cache, tokens.size(), 1);
+        }
+        auto bytes = encode(tokens, cache, false);
+        auto restored = makeCache(dtype);
+        EXPECT(llaisys::models::readKVSnapshot(bytes.data(), bytes.size(), restored) == tokens);
+        EXPECT(restored.length() == tokens.size());
+        EXPECT(sameRows(cache, restored, tokens.size()));
+    }
+
+    // Through a file.
+    auto cache = makeCache(LLAISYS_DTYPE_F32);
+    fillRows<float>(cache, tokens.size(), 2);
+    auto path = (std::filesystem::temp_directory_path() / "llaisys_test_kv_snapshot.bin").string();
+    llaisys::models::saveKVSnapshot(path, tokens.data(), tokens.size(), cache, false);
+    auto restored = makeCache(LLAISYS_DTYPE_F32);
+    EXPECT(llaisys::models::loadKVSnapshot(path, restored) == tokens);
+    EXPECT(sameRows(cache, restored, tokens.size()));
+    std::filesystem::remove(path);
+}
+
+// Int8 rows carry one scale per token and head, amax / 127, so rounding is off by at most half a step.
+void testQuantizedErrorBound() {
+    std::vector<int64_t> tokens(CAPACITY);
+    for (size_t i = 0; i < tokens.size(); ++i) {
+        tokens[i] = static_cast<int64_t>(i);
+    }
+    auto cache = makeCache(LLAISYS_DTYPE_F32);
+    fillRows<float>(cache, tokens.size(), 3);
+    auto bytes = encode(tokens, cache, true);
+    EXPECT(bytes.size() * 2 < encode(tokens, cache, false).size());
+
+    auto restored = makeCache(LLAISYS_DTYPE_F32);
+    EXPECT(llaisys::models::readKVSnapshot(bytes.data(), bytes.size(), restored) == tokens);
+    for (size_t l = 0; l < NLAYER; ++l) {
+        for (bool keys : {true, false}) {
+            auto *original = reinterpret_cast<const float *>((keys ? cache.keys(l) : cache.values(l))->data());
+            auto *decoded = reinterpret_cast<const float *>((keys ? restored.keys(l) : restored.values(l))->data());
+            for (size_t row = 0; row < tokens.size() * NKVH; ++row) {
+                const float *x = original + row * DH, *y = decoded + row * DH;
+                float amax = 0.0f;
+                for (size_t d = 0; d < DH; ++d) {
+                    amax = std::max(amax, std::fabs(x[d]));
+                }
+                for (size_t d = 0; d < DH; ++d) {
+                    EXPECT(std::fabs(x[d] - y[d]) <= amax / 254.0f * 1.001f);
+                }
+            }
+        }
+    }
+
+    // A quantized snapshot can be restored into a cache of another float dtype.
+    auto half = makeCache(LLAISYS_DTYPE_F16);
+    EXPECT(llaisys::models::readKVSnapshot(bytes.data(), bytes.size(), half).size() == tokens.size());
+}
+
+void testRejectsMismatch() {
+    std::vector<int64_t> tokens{1, 2, 3};
+    auto cache = makeCache(LLAISYS_DTYPE_F32);
+    fillRows<float>(cache, tokens.size(), 4);
+    auto bytes = encode(tokens, cache, false);
+
+    auto other_heads = makeCache(LLAISYS_DTYPE_F32, 1);
+    EXPECT_THROWS(llaisys::models::readKVSnapshot(bytes.data(), bytes.size(), other_heads));
+    auto other_dtype = makeCache(LLAISYS_DTYPE_BF16);
+    EXPECT_THROWS(llaisys::models::readKVSnapshot(bytes.data(), bytes.size(), other_dtype));
+    auto restored = makeCache(LLAISYS_DTYPE_F32);
+    EXPECT_THROWS(llaisys::models::readKVSnapshot(bytes.data(), bytes.size() - 1, restored));
+    bytes[0] = std::byte{0};
+    EXPECT_THROWS(llaisys::models::readKVSnapshot(bytes.data(), bytes.size(), restored));
+}
+
+// A model restored from an exact snapshot continues as if it had never stopped.
+void testModelResumes() {
+    auto *model = tinyQwen2();
+    std::vector<int64_t> prompt{1, 2, 3, 4, 5, 6, 7, 8};
+    auto expected = greedyDecode(model, prompt, 12);
+
+    llaisysQwen2ModelReset(model);
+    int64_t next = llaisysQwen2ModelInfer(model, prompt.data(), prompt.size());
+    auto path = (std::filesystem::temp_directory_path() / "llaisys_test_model_snapshot.bin").string();
+    llaisysQwen2ModelSaveSnapshot(model, path.c_str(), 0);
+    llaisysQwen2ModelReset(model);
+    llaisysQwen2ModelInfer(model, expected.data(), expected.size());
+
+    EXPECT(llaisysQwen2ModelLoadSnapshot(model, path.c_str()) == prompt.size());
+    std::vector<int64_t> resumed;
+    for (size_t i = 0; i < expected.size(); ++i) {
+        resumed.push_back(next);
+        next = llaisysQwen2ModelInfer(model, &next, 1);
+    }
+    EXPECT(resumed == expected);
+    std::filesystem::remove(path);
+    llaisysQwen2ModelDestroy(model);
+}
+} // namespace
+
+int main() {
+    testExactRoundTrip();
+    testQuantizedErrorBound();
+    testRejectsMismatch();
+    testModelResumes();
+    return testPassed();
+}
@@ -0,0 +1,147 @@
+#include "harness.hpp"
+
+#include "ops/linear/cpu/linear_tuning.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+using llaisys::ops::cpu::GemmConfig;
+using llaisys::ops::cpu::gemmConfig;
+using llaisys::ops::cpu::tuneGemm;
+
+namespace {
+// Configs written into the cache by hand, distinct from anything the defaults produce.
+constexpr GemmConfig EARLIER{3, 8, 256, 16, 8};
+constexpr GemmConfig LATER{1, 4, 128, 24, 0};
+constexpr GemmConfig OTHER_THREADS{4, 8, 64, 8, 16};
+constexpr GemmConfig OTHER_CPU{2, 8, 64, 8, 0};
+constexpr GemmConfig PREFILL{4, 4, 1024, 32, 32};
+
+bool same(const GemmConfig &a, const GemmConfig &b) {
+    return a.mr == b.mr && a.nr == b.nr && a.kc == b.kc && a.nc == b.nc && a.mc == b.mc;
+}
+
+// Untuned shapes get a default that depends only on m and n, and F16 is never tuned here.
+bool isDefault(size_t m, size_t n, size_t k) {
+    return same(gemmConfig(m, n, k, LLAISYS_DTYPE_F32), gemmConfig(m, n, k, LLAISYS_DTYPE_F16));
+}
+
+std::string line(const std::string &cpu, size_t threads, size_t m, size_t n, size_t k, const GemmConfig &c) {
+    std::ostringstream out;
+    out << cpu << '\t' << threads << '\t' << static_cast<int>(LLAISYS_DTYPE_F32) << '\t' << m << '\t' << n << '\t'
+        << k << '\t' << c.mr << '\t' << c.nr << '\t' << c.kc << '\t' << c.nc << '\t' << c.mc << '\n';
+    return out.str();
+}
+
+std::vector<std::string> lines(const std::filesystem::path &path) {
+    std::vector<std::string> result;
+    std::ifstream file(path);
+    for (std::string text; std::getline(file, text);) {
+        result.push_back(text + '\n');
+    }
+    return result;
+}
+
+// Runs in a fresh process over the cache written by main, with `threads` in the pool.
+int check(size_t threads) {
+    if (threads == 3) {
+        EXPECT(same(gemmConfig(3, 24, 48, LLAISYS_DTYPE_F32), OTHER_THREADS));
+        EXPECT(isDefault(3, 24, 40));
+        return 0;
+    }
+    // The hand-written line for the tuned shape comes last, so it wins over the tuned one and EARLIER.
+    EXPECT(same(gemmConfig(3, 24, 40, LLAISYS_DTYPE_F32), LATER));
+    EXPECT(same(gemmConfig(4, 24, 40, LLAISYS_DTYPE_F32), LATER));
+    EXPECT(isDefault(3, 24, 48));
+    EXPECT(isDefault(3, 24, 56));
+    EXPECT(isDefault(3, 24, 64));
+    // Prefill shapes share the largest bucket.
+    EXPECT(same(gemmConfig(100, 16, 32, LLAISYS_DTYPE_F32), PREFILL));
+    EXPECT(same(gemmConfig(33, 16, 32, LLAISYS_DTYPE_F32), PREFILL));
+    EXPECT(isDefault(32, 16, 32));
+    return 0;
+}
+} // namespace
+
+int main(int argc, char **argv) {
+    if (argc == 3 && std::string(argv[1]) == "check") {
+        return check(std::stoul(argv[2]));
+    }
+
+    auto path = std::filesystem::temp_directory_path() / ("llaisys_gemm_tuning_" + std::to_string(getpid()) + ".tsv");
+    std::filesystem::remove(path);
+    setenv("LLAISYS_GEMM_CACHE", path.c_str(), 1);
+    setenv("LLAISYS_NUM_THREADS", "2", 1);
+
+    EXPECT(isDefault(3, 24, 40));
+    GemmConfig tuned = tuneGemm(3, 24, 40, LLAISYS_DTYPE_F32);
+    EXPECT(tuned.mr >= 1 && tuned.mr <= 4 && (tuned.nr == 4 || tuned.nr == 8));
+    EXPECT(tuned.mc == 0 || (tuned.mc >= tuned.mr && tuned.mc < 4));
+    // Decode row counts are bucketed to powers of two: 3 and 4 share the tuned config, 2 does not.
+    EXPECT(same(gemmConfig(3, 24, 40, LLAISYS_DTYPE_F32), tuned));
+    EXPECT(same(gemmConfig(4, 24, 40, LLAISYS_DTYPE_F32), tuned));
+    EXPECT(isDefault(2, 24, 40));
+    EXPECT(isDefault(5, 24, 40));
+
+    // The winner was saved to the cache, keyed by this CPU and thread count.
+    auto saved = lines(path);
+    EXPECT(saved.size() == 1);
+    std::string cpu = saved[0].substr(0, saved[0].find('\t'));
+    EXPECT(!cpu.empty() && saved[0] == line(cpu, 2, 4, 24, 40, tuned));
+    // Tuning the shape again replaces its line.
+    tuned = tuneGemm(3, 24, 40, LLAISYS_DTYPE_F32);
+    EXPECT((lines(path) == std::vector<std::string>{line(cpu, 2, 4, 24, 40, tuned)}));
+
+    // Lookups read a published snapshot while another shape is tuned.
+    std::atomic<bool> tuning{true};
+    std::atomic<size_t> lookups{0};
+    std::thread reader([&] {
+        while (tuning.load() || lookups.load() == 0) {
+            EXPECT(same(gemmConfig(3, 24, 40, LLAISYS_DTYPE_F32), tuned));
+            lookups.fetch_add(1);
+        }
+    });
+    GemmConfig other = tuneGemm(1, 16, 24, LLAISYS_DTYPE_F32);
+    tuning.store(false);
+    reader.join();
+    EXPECT(same(gemmConfig(1, 16, 24, LLAISYS_DTYPE_F32), other));
+    EXPECT(same(gemmConfig(3, 24, 40, LLAISYS_DTYPE_F32), tuned));
+
+    {
+        std::ofstream file(path, std::ios::app);
+        file << line(cpu, 2, 4, 24, 40, EARLIER) << line(cpu, 2, 4, 24, 40, LATER)
+             << line(cpu, 3, 4, 24, 48, OTHER_THREADS) << line("Other CPU", 2, 4, 24, 56, OTHER_CPU)
+             << line(cpu, 2, 64, 16, 32, PREFILL);
+        // A line without the mc column, from an older cache, and garbage are skipped.
+        std::string old = line(cpu, 2, 4, 24, 64, OTHER_CPU);
+        file << old.substr(0, old.rfind('\t')) << '\n' << "not a tuning line\n";
+    }
+    std::string self = argv[0];
+    EXPECT(std::system(("LLAISYS_NUM_THREADS=2 '" + self + "' check 2").c_str()) == 0);
+    EXPECT(std::system(("LLAISYS_NUM_THREADS=3 '" + self + "' check 3").c_str()) == 0);
+
+    // Saving rewrites the file with one line per entry, keeps the entries of other hosts and processes, drops
+    // malformed lines and leaves no temporary file behind.
+    tuned = tuneGemm(3, 24, 40, LLAISYS_DTYPE_F32);
+    auto rewritten = lines(path);
+    std::sort(rewritten.begin(), rewritten.end());
+    std::vector<std::string> expected{line(cpu, 2, 4, 24, 40, tuned), line(cpu, 2, 1, 16, 24, other),
+                                      line(cpu, 3, 4, 24, 48, OTHER_THREADS),
+                                      line("Other CPU", 2, 4, 24, 56, OTHER_CPU), line(cpu, 2, 64, 16, 32, PREFILL)};
+    std::sort(expected.begin(), expected.end());
+    EXPECT(rewritten == expected);
+    for (const auto &entry : std::filesystem::directory_iterator(path.parent_path())) {
+        EXPECT(entry.path().filename().string().rfind(path.filename().string() + ".tmp", 0) != 0);
+    }
+
+    std::filesystem::remove(path);
+    return testPassed();
+}
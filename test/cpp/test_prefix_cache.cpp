@@ -0,0 +1,159 @@
+#include "harness.hpp"
+
+#include "models/prefix_cache/prefix_cache.hpp"
+
+#include <vector>
+
+using llaisys::models::KVCache;
+using llaisys::models::PrefixCache;
+
+namespace {
+constexpr size_t NLAYER = 2, NKVH = 2, DH = 4, ROW = NKVH * DH;
+// Bytes of KV a cached token takes: keys and values of every layer.
+constexpr size_t TOKEN_BYTES = NLAYER * 2 * ROW * sizeof(float);
+
+KVCache makeCache() {
+    return KVCache(NLAYER, 32, NKVH, DH, LLAISYS_DTYPE_F32, LLAISYS_DEVICE_CPU, 0);
+}
+
+// A value that identifies the token, layer, keys or values, and element.
+float rowValue(int64_t token, size_t layer, size_t kv, size_t i) {
+    return static_cast<float>(token * 1000 + layer * 100 + kv * 10 + i);
+}
+
+// Fills rows [0, n) of `cache` as if `tokens` had been computed.
+void compute(KVCache &cache, const std::vector<int64_t> &tokens) {
+    for (size_t l = 0; l < NLAYER; ++l) {
+        for (size_t kv = 0; kv < 2; ++kv) {
+            auto *data = reinterpret_cast<float *>((kv == 0 ? cache.keys(l) : cache.values(l))->data());
+            for (size_t t = 0; t < tokens.size(); ++t) {
+                for (size_t i = 0; i < ROW; ++i) {
+                    data[t * ROW + i] = rowValue(tokens[t], l, kv, i);
+                }
+            }
+        }
+    }
+    cache.setLength(tokens.size());
+}
+
+bool holds(const KVCache &cache, const std::vector<int64_t> &tokens, size_t n) {
+    for (size_t l = 0; l < NLAYER; ++l) {
+        for (size_t kv = 0; kv < 2; ++kv) {
+            auto *data = reinterpret_cast<const float *>((kv == 0 ? cache.keys(l) : cache.values(l))->data());
+            for (size_t t = 0; t < n; ++t) {
+                for (size_t i = 0; i < ROW; ++i) {
+                    if (data[t * ROW + i] != rowValue(tokens[t], l, kv, i)) {
+                        return false;
+                    }
+                }
+            }
+        }
+    }
+    return true;
+}
+
+PrefixCache::Node *insert(PrefixCache &prefixes, const std::vector<int64_t> &tokens) {
+    KVCache cache = makeCache();
+    compute(cache, tokens);
+    return prefixes.insert(tokens.data(), tokens.size(), cache);
+}
+
+size_t restore(PrefixCache &prefixes, const std::vector<int64_t> &tokens, bool check = true) {
+    KVCache cache = makeCache();
+    PrefixCache::Node *pinned = nullptr;
+    size_t n = prefixes.restore(tokens.data(), tokens.size(), cache, pinned);
+    EXPECT(cache.length() == n);
+    if (check) {
+        EXPECT(holds(cache, tokens, n));
+    }
+    prefixes.release(pinned);
+    return n;
+}
+
+void expectBytesMatchTokens(const PrefixCache &prefixes) {
+    EXPECT(prefixes.stats().cached_bytes == prefixes.stats().cached_tokens * TOKEN_BYTES);
+}
+
+void testInsertRestore() {
+    PrefixCache prefixes(64, NLAYER, NKVH, DH, LLAISYS_DTYPE_F32, LLAISYS_DEVICE_CPU, 0);
+    prefixes.release(insert(prefixes, {1, 2, 3, 4, 5, 6}));
+    EXPECT(prefixes.stats().cached_tokens == 6);
+    expectBytesMatchTokens(prefixes);
+
+    // The last prompt token is always left to compute.
+    EXPECT(restore(prefixes, {1, 2, 3, 4, 5, 6}) == 5);
+    EXPECT(restore(prefixes, {1, 2, 3, 4, 5, 6, 7}) == 6);
+    EXPECT(restore(prefixes, {1, 2, 9}) == 2);
+    EXPECT(restore(prefixes, {7, 8}) == 0);
+    EXPECT(prefixes.stats().hits == 3 && prefixes.stats().misses == 1);
+}
+
+void testSplitOwnsStorage() {
+    PrefixCache prefixes(64, NLAYER, NKVH, DH, LLAISYS_DTYPE_F32, LLAISYS_DEVICE_CPU, 0);
+    PrefixCache::Node *first = insert(prefixes, {1, 2, 3, 4, 5, 6});
+    PrefixCache::Node *second = insert(prefixes, {1, 2, 3, 9, 9});
+
+    // {1, 2, 3} split off into a parent shared by both; every node holds exactly its own rows.
+    PrefixCache::Node *mid = first->parent;
+    EXPECT(mid == second->parent);
+    EXPECT(mid->tokens == (std::vector<int64_t>{1, 2, 3}));
+    EXPECT(first->tokens == (std::vector<int64_t>{4, 5, 6}));
+    for (PrefixCache::Node *node : {mid, first, second}) {
+        EXPECT(node->kv->storage()->size() == node->tokens.size() * TOKEN_BYTES);
+    }
+    EXPECT(prefixes.stats().cached_tokens == 8);
+    expectBytesMatchTokens(prefixes);
+
+    prefixes.release(first);
+    prefixes.release(second);
+    EXPECT(restore(prefixes, {1, 2, 3, 4, 5, 6, 0}) == 6);
+    EXPECT(restore(prefixes, {1, 2, 3, 9, 9, 0}) == 5);
+}
+
+void testEvictionBoundsMemory() {
+    PrefixCache prefixes(9, NLAYER, NKVH, DH, LLAISYS_DTYPE_F32, LLAISYS_DEVICE_CPU, 0);
+    prefixes.release(insert(prefixes, {1, 2, 3, 4, 5, 6}));
+    prefixes.release(insert(prefixes, {1, 2, 3, 9, 9}));
+    // {1, 2, 3, 4, 5, 6} is now the most recent path; {9, 9} is the least recently used leaf.
+    EXPECT(restore(prefixes, {1, 2, 3, 4, 5, 6, 0}) == 6);
+
+    prefixes.release(insert(prefixes, {20, 21, 22}));
+    EXPECT(prefixes.stats().cached_tokens <= prefixes.capacity());
+    EXPECT(prefixes.stats().evicted_tokens == 2);
+    expectBytesMatchTokens(prefixes);
+    EXPECT(restore(prefixes, {1, 2, 3, 9, 9, 0}) == 3);
+    EXPECT(restore(prefixes, {20, 21, 22, 0}) == 3);
+
+    // Evicting the rest of the split path frees the split-off prefix too.
+    prefixes.release(insert(prefixes, {30, 31, 32, 33, 34}));
+    EXPECT(prefixes.stats().cached_tokens <= prefixes.capacity());
+    expectBytesMatchTokens(prefixes);
+}
+
+void testPinnedNodesSurvive() {
+    PrefixCache prefixes(4, NLAYER, NKVH, DH, LLAISYS_DTYPE_F32, LLAISYS_DEVICE_CPU, 0);
+    PrefixCache::Node *pinned = insert(prefixes, {1, 2, 3, 4});
+
+    // Over capacity, but the only candidate is pinned by a live sequence.
+    PrefixCache::Node *other = insert(prefixes, {5, 6});
+    EXPECT(prefixes.stats().cached_tokens == 6);
+    prefixes.release(other);
+    EXPECT(restore(prefixes, {1, 2, 3, 4, 0}) == 4);
+
+    // Once released it is the least recently used leaf, and goes at the next insert.
+    prefixes.release(pinned);
+    EXPECT(restore(prefixes, {5, 6, 0}) == 2);
+    prefixes.release(insert(prefixes, {7}));
+    EXPECT(restore(prefixes, {1, 2, 3, 4, 0}, false) == 0);
+    EXPECT(prefixes.stats().cached_tokens <= prefixes.capacity());
+    expectBytesMatchTokens(prefixes);
+}
+} // namespace
+
+int main() {
+    testInsertRestore();
+    testSplitOwnsStorage();
+    testEvictionBoundsMemory();
+    testPinnedNodesSurvive();
+    return testPassed();
+}
@@ -0,0 +1,174 @@
+#include "harness.hpp"
+
+#include "ops/registry/registry.hpp"
+
+#include <string>
+
+using llaisys::ops::Isa;
+using llaisys::ops::KernelSite;
+using llaisys::ops::preferKernel;
+using llaisys::ops::registerKernel;
+namespace registry = llaisys::ops::registry;
+
+namespace {
+// Test ops take an output for the id of the kernel that ran and a size that predicates can look at.
+using Site = KernelSite<int *, int>;
+using TestKernel = llaisys::ops::Kernel<int *, int>;
+
+template <int ID>
+void kernel(int *out, int) {
+    *out = ID;
+}
+
+bool even(int *, int n) {
+    return n % 2 == 0;
+}
+
+int run(Site &site, int n = 2, llaisysDataType_t dtype = LLAISYS_DTYPE_F32) {
+    int id = -1;
+    site(LLAISYS_DEVICE_CPU, 0, dtype, &id, n);
+    return id;
+}
+
+TestKernel make(const std::string &name, void (*fn)(int *, int), int priority,
+                llaisysDataType_t dtype = LLAISYS_DTYPE_INVALID, Isa isa = Isa::ANY,
+                bool (*supports)(int *, int) = nullptr) {
+    return {name, LLAISYS_DEVICE_CPU, dtype, isa, priority, supports, fn};
+}
+
+// Kernels registered after the site resolved a call are picked up on the next one, as every registration bumps
+// the generation.
+void testPriorityAndTies() {
+    Site site("test_priority", kernel<0>);
+    EXPECT(run(site) == 0);
+    uint64_t generation = registry::generation();
+    registerKernel("test_priority", make("low", kernel<1>, -1));
+    EXPECT(registry::generation() > generation);
+    EXPECT(run(site) == 0);
+    registerKernel("test_priority", make("high", kernel<2>, 5));
+    EXPECT(run(site) == 2);
+    // Most recent wins among equal priorities.
+    registerKernel("test_priority", make("high_again", kernel<3>, 5));
+    EXPECT(run(site) == 3);
+    registerKernel("test_priority", make("high_once_more", kernel<4>, 5));
+    EXPECT(run(site) == 4);
+}
+
+// A registered kernel wins a tie with the built-in one, whether it came before or after the op first ran.
+void testRegisteredOverBuiltin() {
+    registerKernel("test_early", make("early", kernel<1>, 0));
+    Site early("test_early", kernel<0>);
+    EXPECT(run(early) == 1);
+
+    Site late("test_late", kernel<0>);
+    EXPECT(run(late) == 0);
+    registerKernel("test_late", make("late", kernel<1>, 0));
+    EXPECT(run(late) == 1);
+    registerKernel("test_late", make("later", kernel<2>, 0));
+    EXPECT(run(late) == 2);
+}
+
+// Toggling preferences replaces the site's snapshot every time; calls keep working on whichever they read.
+void testPreferenceToggling() {
+    Site site("test_toggle", kernel<0>);
+    registerKernel("test_toggle", make("alt", kernel<1>, -1));
+    for (size_t i = 0; i < 10000; ++i) {
+        preferKernel("test_toggle", i % 2 == 0 ? "alt" : "");
+        EXPECT(run(site) == (i % 2 == 0 ? 1 : 0));
+        EXPECT(run(site, 2, LLAISYS_DTYPE_F16) == (i % 2 == 0 ? 1 : 0));
+    }
+}
+
+// A kernel whose predicate rejects the call falls back to the next one in order.
+void testSupportsFallback() {
+    Site site("test_supports", kernel<0>);
+    registerKernel("test_supports", make("even", kernel<1>, 10, LLAISYS_DTYPE_INVALID, Isa::ANY, even));
+    EXPECT(run(site, 2) == 1);
+    EXPECT(run(site, 3) == 0);
+    registerKernel("test_supports", make("middle", kernel<2>, 5));
+    EXPECT(run(site, 4) == 1);
+    EXPECT(run(site, 5) == 2);
+}
+
+// Kernels needing an instruction set the CPU lacks are never selected, even when preferred.
+void testIsaFiltering() {
+    Site site("test_isa", kernel<0>);
+    registerKernel("test_isa", make("any", kernel<1>, 1, LLAISYS_DTYPE_INVALID, Isa::ANY));
+    EXPECT(run(site) == 1);
+    for (Isa isa : {Isa::SSE2, Isa::AVX2, Isa::AVX512F}) {
+        auto name = "isa" + std::to_string(static_cast<int>(isa));
+        registerKernel("test_isa", make(name, kernel<2>, 10, LLAISYS_DTYPE_INVALID, isa));
+        EXPECT(run(site) == (llaisys::ops::isaSupported(isa) ? 2 : 1));
+        registerKernel("test_isa", make(name + "_low", kernel<3>, -10, LLAISYS_DTYPE_INVALID, isa));
+        preferKernel("test_isa", name + "_low");
+        EXPECT(run(site) == (llaisys::ops::isaSupported(isa) ? 3 : 1));
+        preferKernel("test_isa", "");
+    }
+    EXPECT(llaisys::ops::isaSupported(Isa::ANY));
+}
+
+// A kernel for one dtype serves only calls of that dtype; the others fall to kernels for all dtypes.
+void testDtypeMatching() {
+    Site site("test_dtype", kernel<0>);
+    registerKernel("test_dtype", make("f16", kernel<1>, 10, LLAISYS_DTYPE_F16));
+    registerKernel("test_dtype", make("any", kernel<2>, 5));
+    EXPECT(run(site, 2, LLAISYS_DTYPE_F16) == 1);
+    EXPECT(run(site, 2, LLAISYS_DTYPE_F32) == 2);
+    EXPECT(run(site, 2, LLAISYS_DTYPE_BF16) == 2);
+    // Each dtype is resolved and cached on its own; a registration invalidates all of them.
+    registerKernel("test_dtype", make("bf16", kernel<3>, 20, LLAISYS_DTYPE_BF16));
+    EXPECT(run(site, 2, LLAISYS_DTYPE_F16) == 1);
+    EXPECT(run(site, 2, LLAISYS_DTYPE_F32) == 2);
+    EXPECT(run(site, 2, LLAISYS_DTYPE_BF16) == 3);
+}
+
+// A preferred kernel runs first whenever it accepts the call, and switching back and forth takes effect at once.
+void testPreferKernel() {
+    Site site("test_prefer", kernel<0>);
+    registerKernel("test_prefer", make("alt", kernel<1>, -5));
+    EXPECT(run(site) == 0);
+    uint64_t generation = registry::generation();
+    preferKernel("test_prefer", "alt");
+    EXPECT(registry::generation() > generation && registry::preferred("test_prefer") == "alt");
+    EXPECT(run(site) == 1);
+    preferKernel("test_prefer", "cpu");
+    EXPECT(run(site) == 0);
+    preferKernel("test_prefer", "alt");
+    EXPECT(run(site) == 1);
+    // A preference for another op or a missing kernel changes nothing here.
+    preferKernel("test_other", "cpu");
+    EXPECT(run(site) == 1);
+    preferKernel("test_prefer", "missing");
+    EXPECT(run(site) == 0);
+    // A preferred kernel that rejects the call falls back to the priority order.
+    registerKernel("test_prefer", make("even", kernel<2>, -10, LLAISYS_DTYPE_INVALID, Isa::ANY, even));
+    preferKernel("test_prefer", "even");
+    EXPECT(run(site, 2) == 2);
+    EXPECT(run(site, 3) == 0);
+    preferKernel("test_prefer", "");
+    EXPECT(registry::preferred("test_prefer").empty());
+    EXPECT(run(site, 2) == 0);
+}
+
+void testRejectedRegistrations() {
+    Site site("test_rejected", kernel<0>);
+    EXPECT_THROWS(registerKernel("test_rejected", make("no_run", nullptr, 0)));
+    // The table of an op holds kernels of one signature.
+    EXPECT_THROWS(registerKernel("test_rejected", llaisys::ops::Kernel<int>{"other", LLAISYS_DEVICE_CPU,
+                                                                            LLAISYS_DTYPE_INVALID, Isa::ANY, 0,
+                                                                            nullptr, +[](int) {}}));
+    EXPECT(run(site) == 0);
+}
+} // namespace
+
+int main() {
+    testPriorityAndTies();
+    testRegisteredOverBuiltin();
+    testPreferenceToggling();
+    testSupportsFallback();
+    testIsaFiltering();
+    testDtypeMatching();
+    testPreferKernel();
+    testRejectedRegistrations();
+    return testPassed();
+}
@@ -0,0 +1,171 @@
+#include "harness.hpp"
+#include "tiny_qwen2.hpp"
+
+#include "models/qwen2/qwen2.hpp"
+#include "models/session/session_pool.hpp"
+
+#include <cstring>
+#include <filesystem>
+
+using llaisys::models::KVCache;
+using llaisys::models::SessionPool;
+
+namespace {
+constexpr size_t NLAYER = 2, CAPACITY = 16, NKVH = 2, DH = 8;
+
+std::unique_ptr<KVCache> makeCache() {
+    return std::make_unique<KVCache>(NLAYER, CAPACITY, NKVH, DH, LLAISYS_DTYPE_F32, LLAISYS_DEVICE_CPU, 0);
+}
+
+// A cache holding `ntoken` rows, each element a value derived from `seed`.
+std::unique_ptr<KVCache> filledCache(size_t ntoken, float seed) {
+    auto cache = makeCache();
+    for (size_t l = 0; l < NLAYER; ++l) {
+        for (const auto &tensor : {cache->keys(l), cache->values(l)}) {
+            auto *data = reinterpret_cast<float *>(tensor->data());
+            for (size_t i = 0; i < ntoken * NKVH * DH; ++i) {
+                data[i] = seed + static_cast<float>(l * 1000 + i);
+            }
+        }
+    }
+    cache->setLength(ntoken);
+    return cache;
+}
+
+void makeResident(SessionPool::Session &session, const std::vector<int64_t> &tokens, float seed) {
+    session.tokens = tokens;
+    session.cache = filledCache(tokens.size(), seed);
+}
+
+bool sameRows(const KVCache &a, const KVCache &b, size_t ntoken) {
+    for (size_t l = 0; l < NLAYER; ++l) {
+        if (std::memcmp(a.keys(l)->data(), b.keys(l)->data(), ntoken * a.rowBytes()) != 0
+            || std::memcmp(a.values(l)->data(), b.values(l)->data(), ntoken * a.rowBytes()) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void testVictimOrder() {
+    SessionPool pool(4, "", false);
+    makeResident(pool.get(1, 0), {1}, 0.0f);
+    makeResident(pool.get(2, 0), {2}, 0.0f);
+    makeResident(pool.get(3, 5), {3}, 0.0f);
+    pool.get(4, 0);
+    EXPECT(pool.parked() == 3 && pool.find(5) == nullptr);
+
+    // Lowest priority first, then least recently used; never the active session or one without a cache.
+    EXPECT(pool.victim(4, 0)->id == 1);
+    pool.get(1, 0);
+    EXPECT(pool.victim(4, 0)->id == 2);
+    EXPECT(pool.victim(2, 0)->id == 1);
+    EXPECT(pool.victim(4, -1) == nullptr);
+    pool.get(1, 7);
+    pool.get(2, 7);
+    EXPECT(pool.victim(4, 9)->id == 3);
+    EXPECT(pool.victim(4, 4) == nullptr);
+
+    pool.release(3);
+    EXPECT(pool.find(3) == nullptr && pool.parked() == 2);
+}
+
+// Preempted rows are spilled and restored bit for bit, to memory or to a file.
+void testSwap(const std::string &spill_dir) {
+    SessionPool pool(1, spill_dir, false);
+    auto &session = pool.get(1, 0);
+    std::vector<int64_t> tokens{4, 8, 15, 16, 23, 42};
+    makeResident(session, tokens, 0.5f);
+    auto original = filledCache(tokens.size(), 0.5f);
+
+    auto cache = pool.preempt(session);
+    EXPECT(cache != nullptr && session.cache == nullptr && session.swapped);
+    EXPECT(pool.stats().swap_outs == 1 && pool.stats().swapped_bytes > 0 && pool.swappedSessions() == 1);
+    std::string path = session.spill_path;
+    EXPECT(spill_dir.empty() == path.empty());
+    EXPECT(path.empty() || std::filesystem::exists(path));
+
+    cache->setLength(0);
+    std::memset(cache->keys(0)->data(), 0, cache->rowBytes());
+    EXPECT(pool.restore(session, *cache));
+    EXPECT(cache->length() == tokens.size() && sameRows(*original, *cache, tokens.size()));
+    EXPECT(!session.swapped && session.spill.empty() && session.spill_path.empty());
+    EXPECT(path.empty() || !std::filesystem::exists(path));
+    EXPECT(pool.stats().swap_ins == 1 && pool.stats().recomputes == 0);
+}
+
+// Once prefill is measured to be cheaper than moving the rows twice, preemption drops them.
+void testRecompute() {
+    SessionPool pool(1, "", false);
+    auto &session = pool.get(1, 0);
+    makeResident(session, {1, 2, 3, 4}, 0.0f);
+    for (int i = 0; i < 100; ++i) {
+        pool.recordPrefill(1000, 1e-12);
+    }
+    auto cache = pool.preempt(session);
+    EXPECT(!session.swapped && session.spill.empty() && pool.stats().swap_outs == 0);
+    EXPECT(pool.stats().preemptions == 1);
+    cache->setLength(0);
+    EXPECT(!pool.restore(session, *cache));
+
+    // An empty session has nothing to spill or recompute.
+    auto &empty = pool.get(2, 0);
+    empty.cache = makeCache();
+    cache = pool.preempt(empty);
+    EXPECT(pool.restore(empty, *cache) && pool.stats().preemptions == 2);
+}
+
+// Sessions that lose their cache continue decoding exactly as if they had kept it.
+void testModelSwitchesSessions() {
+    auto *model = tinyQwen2();
+    std::vector<int64_t> a{1, 2, 3, 4, 5, 6, 7, 8}, b{9, 8, 7, 6};
+    auto expected_a = greedyDecode(model, a, 6), expected_b = greedyDecode(model, b, 6);
+
+    llaisysQwen2ModelSetSessions(model, 1, "", 0);
+    std::vector<int64_t> out_a, out_b;
+    llaisysQwen2ModelSelectSession(model, 1, 0);
+    int64_t next_a = llaisysQwen2ModelInfer(model, a.data(), a.size());
+    llaisysQwen2ModelSelectSession(model, 2, 0);
+    int64_t next_b = llaisysQwen2ModelInfer(model, b.data(), b.size());
+    for (size_t i = 0; i < 6; ++i) {
+        llaisysQwen2ModelSelectSession(model, 1, 0);
+        out_a.push_back(next_a);
+        next_a = llaisysQwen2ModelInfer(model, &next_a, 1);
+        llaisysQwen2ModelSelectSession(model, 2, 0);
+        out_b.push_back(next_b);
+        next_b = llaisysQwen2ModelInfer(model, &next_b, 1);
+    }
+    EXPECT(out_a == expected_a && out_b == expected_b);
+    LlaisysQwen2SessionStats stats;
+    llaisysQwen2ModelSessionStats(model, &stats);
+    EXPECT(stats.preemptions >= 12 && stats.swap_outs + stats.recomputes >= 12);
+    EXPECT(stats.resident_sessions == 1);
+    llaisysQwen2ModelDestroy(model);
+}
+
+// A session that cannot get a cache is refused without a trace: it is not created and the current sequence
+// carries on.
+void testRefusedSelect() {
+    LlaisysQwen2Meta meta{LLAISYS_DTYPE_F32, 1, 32, 4, 2, 8, 48, 16, 50, 1e-6f, 10000.f, 49};
+    llaisys::models::Qwen2 model(meta, LLAISYS_DEVICE_CPU, 0);
+    model.enableSessions(1, "", false);
+    model.selectSession(1, 5);
+    EXPECT_THROWS(model.selectSession(2, 0));
+    EXPECT(model.sessionPool()->find(2) == nullptr);
+    EXPECT(model.sessionPool()->find(1)->priority == 5);
+    EXPECT(model.sessionPool()->parked() == 0);
+    // At a high enough priority it preempts the current session.
+    model.selectSession(2, 5);
+    EXPECT(model.sessionPool()->find(2) != nullptr && model.sessionPool()->find(1)->cache == nullptr);
+}
+} // namespace
+
+int main() {
+    testVictimOrder();
+    testSwap("");
+    testSwap(std::filesystem::temp_directory_path().string());
+    testRecompute();
+    testModelSwitchesSessions();
+    testRefusedSelect();
+    return testPassed();
+}
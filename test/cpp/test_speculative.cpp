@@ -0,0 +1,234 @@
+#include "harness.hpp"
+#include "tiny_qwen2.hpp"
+
+#include "models/sampler/sampler.hpp"
+#include "models/speculative/ngram_proposer.hpp"
+
+#include <cmath>
+
+using llaisys::models::NgramProposer;
+using llaisys::models::Sampler;
+using llaisys::models::SamplingParams;
+
+namespace {
+std::vector<int64_t> propose(const NgramProposer &proposer, const std::vector<int64_t> &history, size_t max_draft) {
+    std::vector<int64_t> drafts{-1};
+    proposer.propose(history, max_draft, drafts);
+    return drafts;
+}
+
+void testNgramProposer() {
+    NgramProposer proposer(3);
+    // The trailing 3-gram 1 2 3 matches at the start; its continuation is proposed up to max_draft.
+    EXPECT((propose(proposer, {1, 2, 3, 4, 5, 6, 1, 2, 3}, 2) == std::vector<int64_t>{4, 5}));
+    EXPECT((propose(proposer, {1, 2, 3, 4, 5, 6, 1, 2, 3}, 10) == std::vector<int64_t>{4, 5, 6, 1, 2, 3}));
+    // The most recent occurrence wins.
+    EXPECT((propose(proposer, {7, 8, 1, 7, 8, 2, 7, 8}, 1) == std::vector<int64_t>{2}));
+    // Longer n-grams take precedence over a more recent shorter match.
+    EXPECT((propose(proposer, {4, 5, 6, 9, 1, 6, 8, 4, 5, 6}, 1) == std::vector<int64_t>{9}));
+    // Falls back to shorter n-grams.
+    EXPECT((propose(proposer, {5, 9, 1, 2, 5}, 3) == std::vector<int64_t>{9, 1, 2}));
+    // No match, an empty or single-token history, or no room leaves no drafts.
+    EXPECT(propose(proposer, {1, 2, 3, 4}, 4).empty());
+    EXPECT(propose(proposer, {}, 4).empty());
+    EXPECT(propose(proposer, {1}, 4).empty());
+    EXPECT(propose(proposer, {1, 2, 1}, 0).empty());
+
+    NgramProposer bigrams(3, 2);
+    EXPECT(propose(bigrams, {5, 9, 1, 2, 5}, 3).empty());
+    EXPECT((propose(bigrams, {5, 9, 1, 5, 9}, 3) == std::vector<int64_t>{1, 5, 9}));
+    EXPECT_THROWS(NgramProposer(2, 3));
+    EXPECT_THROWS(NgramProposer(2, 0));
+}
+
+std::vector<float> distribution(Sampler &sampler, const std::vector<float> &logits, SamplingParams params) {
+    std::vector<float> probs;
+    sampler.distribution(reinterpret_cast<const std::byte *>(logits.data()), LLAISYS_DTYPE_F32, logits.size(),
+                         params, probs);
+    return probs;
+}
+
+bool near(float a, float b) {
+    return std::fabs(a - b) < 1e-5f;
+}
+
+void testSamplerDistribution() {
+    Sampler sampler;
+    std::vector<float> logits{1.0f, 3.0f, 2.0f, 0.0f};
+
+    EXPECT(Sampler::isGreedy({0.0f, 0, 1.0f}) && Sampler::isGreedy({1.0f, 1, 1.0f}));
+    EXPECT((distribution(sampler, logits, {0.0f, 0, 1.0f}) == std::vector<float>{0, 1, 0, 0}));
+
+    // Softmax of logits / temperature.
+    auto probs = distribution(sampler, logits, {2.0f, 0, 1.0f});
+    float sum = 0.0f;
+    for (float l : logits) {
+        sum += std::exp(l / 2.0f);
+    }
+    for (size_t i = 0; i < logits.size(); ++i) {
+        EXPECT(near(probs[i], std::exp(logits[i] / 2.0f) / sum));
+    }
+
+    // Top-k keeps the k largest logits.
+    probs = distribution(sampler, logits, {1.0f, 2, 1.0f});
+    float e3 = std::exp(3.0f), e2 = std::exp(2.0f);
+    EXPECT(probs[0] == 0.0f && probs[3] == 0.0f);
+    EXPECT(near(probs[1], e3 / (e3 + e2)) && near(probs[2], e2 / (e3 + e2)));
+
+    // Top-p keeps the most likely tokens until their mass reaches p: 0.64 alone falls short of 0.7.
+    std::vector<float> flat{std::log(0.64f), std::log(0.26f), std::log(0.1f)};
+    probs = distribution(sampler, flat, {1.0f, 0, 0.7f});
+    EXPECT(probs[2] == 0.0f && near(probs[0], 0.64f / 0.9f) && near(probs[1], 0.26f / 0.9f));
+    probs = distribution(sampler, flat, {1.0f, 0, 0.6f});
+    EXPECT(near(probs[0], 1.0f) && probs[1] == 0.0f);
+}
+
+void testSamplerSample() {
+    std::vector<float> probs{0.5f, 0.0f, 0.3f, 0.2f};
+    Sampler sampler(3);
+    constexpr int N = 20000;
+    std::vector<int> counts(probs.size());
+    for (int i = 0; i < N; ++i) {
+        ++counts[sampler.sample(probs)];
+    }
+    EXPECT(counts[1] == 0);
+    for (size_t i = 0; i < probs.size(); ++i) {
+        EXPECT(std::fabs(counts[i] / float(N) - probs[i]) < 0.02f);
+    }
+
+    // The same seed replays the same draws.
+    Sampler a(11), b(11);
+    for (int i = 0; i < 100; ++i) {
+        EXPECT(a.sample(probs) == b.sample(probs));
+    }
+}
+
+std::vector<int64_t> generate(LlaisysQwen2Model *model, std::vector<int64_t> prompt,
+                              LlaisysQwen2GenerateParams params) {
+    std::vector<int64_t> tokens;
+    llaisysQwen2ModelGenerate(model, prompt.data(), prompt.size(), &params,
+                              [](int64_t token, void *userdata) {
+                                  static_cast<std::vector<int64_t> *>(userdata)->push_back(token);
+                              },
+                              &tokens);
+    EXPECT(llaisysQwen2ModelWait(model) == tokens.size());
+    return tokens;
+}
+
+// A prompt that repeats itself, so that prompt lookup finds drafts the model is likely to accept.
+std::vector<int64_t> repetitivePrompt(LlaisysQwen2Model *model) {
+    std::vector<int64_t> start{5, 6, 7, 8};
+    auto prompt = start;
+    auto continuation = greedyDecode(model, start, 12);
+    prompt.insert(prompt.end(), continuation.begin(), continuation.end());
+    prompt.insert(prompt.end(), start.begin(), start.end());
+    return prompt;
+}
+
+// Greedy verification only keeps drafts that are the argmax, so the output is exactly plain greedy decoding.
+void testGreedyPromptLookupMatchesGreedy() {
+    auto *model = tinyQwen2();
+    auto prompt = repetitivePrompt(model);
+    auto expected = greedyDecode(model, prompt, 24);
+    EXPECT(generate(model, prompt, {24, 0.0f, 1, 1.0f, 0, 0, 4}) == expected);
+    EXPECT(generate(model, prompt, {24, 0.0f, 1, 1.0f, 0, 3, 4}) == expected);
+    LlaisysQwen2SpeculativeStats stats;
+    llaisysQwen2ModelSpeculativeStats(model, &stats);
+    EXPECT(stats.drafted_tokens > 0 && stats.accepted_tokens > 0);
+    EXPECT(stats.decode_tokens > stats.decode_steps);
+    llaisysQwen2ModelDestroy(model);
+}
+
+// Empirical distribution of the first `positions` tokens over `runs` seeds.
+std::vector<std::vector<double>> tokenFrequencies(LlaisysQwen2Model *model, const std::vector<int64_t> &prompt,
+                                                  LlaisysQwen2GenerateParams params, int runs) {
+    std::vector<std::vector<double>> freq(params.max_new_tokens, std::vector<double>(50));
+    for (int seed = 0; seed < runs; ++seed) {
+        params.seed = static_cast<uint64_t>(seed);
+        auto tokens = generate(model, prompt, params);
+        for (size_t i = 0; i < tokens.size(); ++i) {
+            freq[i][tokens[i]] += 1.0 / runs;
+        }
+    }
+    return freq;
+}
+
+double totalVariation(const std::vector<double> &p, const std::vector<double> &q) {
+    double tv = 0.0;
+    for (size_t i = 0; i < p.size(); ++i) {
+        tv += std::fabs(p[i] - q[i]) / 2;
+    }
+    return tv;
+}
+
+// Rejection sampling makes every token distributed as the target's, however drafts are proposed. With
+// 10000 runs, sampling noise keeps the distance near 0.02; sampling a rejected token from the target instead
+// of the residual already gives 0.05-0.07.
+void expectSameDistribution(LlaisysQwen2Model *model, const std::vector<int64_t> &prompt,
+                            LlaisysQwen2GenerateParams speculative) {
+    LlaisysQwen2GenerateParams plain = speculative;
+    plain.ngram = 0;
+    plain.num_draft = 0;
+    auto expected = tokenFrequencies(model, prompt, plain, 10000);
+    auto actual = tokenFrequencies(model, prompt, speculative, 10000);
+    for (size_t i = 0; i < expected.size(); ++i) {
+        EXPECT(totalVariation(expected[i], actual[i]) < 0.035);
+    }
+}
+
+void testSampledPromptLookupKeepsDistribution() {
+    auto *model = tinyQwen2();
+    auto prompt = repetitivePrompt(model);
+    expectSameDistribution(model, prompt, {4, 0.3f, 0, 1.0f, 0, 3, 4});
+    LlaisysQwen2SpeculativeStats stats;
+    llaisysQwen2ModelSpeculativeStats(model, &stats);
+    EXPECT(stats.accepted_tokens > 0 && stats.accepted_tokens < stats.drafted_tokens);
+    llaisysQwen2ModelDestroy(model);
+}
+
+// A one-layer draft sharing the target's embeddings and first layer, so that it agrees often but not always.
+LlaisysQwen2Model *tinyDraft() {
+    return tinyQwen2(64, 7, 1);
+}
+
+void testGreedyDraftModelMatchesGreedy() {
+    auto *model = tinyQwen2(), *draft = tinyDraft();
+    std::vector<int64_t> prompt{1, 2, 3, 4, 5, 6, 7, 8};
+    auto expected = greedyDecode(model, prompt, 40);
+    llaisysQwen2ModelSetDraft(model, draft);
+    EXPECT(generate(model, prompt, {40, 0.0f, 1, 1.0f, 0, 0, 4}) == expected);
+    // Continuing the sequence keeps the draft in step with the target.
+    auto longer = prompt;
+    longer.insert(longer.end(), expected.begin(), expected.begin() + 10);
+    auto rest = generate(model, longer, {30, 0.0f, 1, 1.0f, 0, 0, 3});
+    EXPECT(std::equal(rest.begin(), rest.end(), expected.begin() + 10));
+    LlaisysQwen2SpeculativeStats stats;
+    llaisysQwen2ModelSpeculativeStats(model, &stats);
+    EXPECT(stats.accepted_tokens > 0 && stats.accepted_tokens < stats.drafted_tokens);
+    llaisysQwen2ModelDestroy(model);
+    llaisysQwen2ModelDestroy(draft);
+}
+
+// Sampled drafts are verified against the draft's own distribution rather than a point mass.
+void testSampledDraftModelKeepsDistribution() {
+    auto *model = tinyQwen2(), *draft = tinyDraft();
+    llaisysQwen2ModelSetDraft(model, draft);
+    expectSameDistribution(model, {1, 2, 3, 4, 5, 6, 7, 8}, {4, 0.3f, 0, 1.0f, 0, 0, 3});
+    LlaisysQwen2SpeculativeStats stats;
+    llaisysQwen2ModelSpeculativeStats(model, &stats);
+    EXPECT(stats.accepted_tokens > 0 && stats.accepted_tokens < stats.drafted_tokens);
+    llaisysQwen2ModelDestroy(model);
+    llaisysQwen2ModelDestroy(draft);
+}
+} // namespace
+
+int main() {
+    testNgramProposer();
+    testSamplerDistribution();
+    testSamplerSample();
+    testGreedyPromptLookupMatchesGreedy();
+    testSampledPromptLookupKeepsDistribution();
+    testGreedyDraftModelMatchesGreedy();
+    testSampledDraftModelKeepsDistribution();
+    return testPassed();
+}
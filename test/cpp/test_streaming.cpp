@@ -0,0 +1,36 @@
+#include "harness.hpp"
+#include "tiny_qwen2.hpp"
+
+namespace {
+// A streaming prefill runs in chunks while decoding sees a window that slides one token at a time. The two
+// only agree if every chunk still attends over most of the window, so long prompts must decode the same way.
+void testChunkedPrefillMatchesTokenByToken() {
+    for (unsigned seed = 1; seed <= 4; ++seed) {
+        auto *model = tinyQwen2(128, seed);
+        llaisysQwen2ModelSetStreaming(model, 1, 4);
+        std::mt19937 rng(seed);
+        std::vector<int64_t> prompt(400);
+        for (int64_t &token : prompt) {
+            token = static_cast<int64_t>(rng() % 48);
+        }
+        EXPECT(greedyDecode(model, prompt, 24) == greedyDecode(model, prompt, 24, true));
+        llaisysQwen2ModelDestroy(model);
+    }
+}
+
+// Within the window nothing is evicted and streaming must not change the output.
+void testShortPromptUnchanged() {
+    auto *model = tinyQwen2(128);
+    std::vector<int64_t> prompt{1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+    auto expected = greedyDecode(model, prompt, 16);
+    llaisysQwen2ModelSetStreaming(model, 1, 4);
+    EXPECT(greedyDecode(model, prompt, 16) == expected);
+    llaisysQwen2ModelDestroy(model);
+}
+} // namespace
+
+int main() {
+    testChunkedPrefillMatchesTokenByToken();
+    testShortPromptUnchanged();
+    return testPassed();
+}
@@ -0,0 +1,182 @@
+#include "harness.hpp"
+
+#include "utils/thread_pool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using llaisys::utils::TaskGraph;
+using llaisys::utils::threadPool;
+
+namespace {
+size_t sumTo(size_t n) {
+    return n * (n - 1) / 2;
+}
+
+// Sums [0, n) over the pool.
+size_t parallelSum(size_t n, size_t grain = 1) {
+    std::atomic<size_t> sum{0};
+    threadPool().parallelFor(
+        n,
+        [&](size_t begin, size_t end) {
+            size_t part = 0;
+            for (size_t i = begin; i < end; ++i) {
+                part += i;
+            }
+            sum += part;
+        },
+        grain);
+    return sum;
+}
+
+void testParallelForCoversRange() {
+    for (size_t n : {1, 2, 3, 7, 100, 1001}) {
+        for (size_t grain : {1, 4, 64}) {
+            std::vector<std::atomic<int>> hits(n);
+            std::mutex mutex;
+            std::vector<std::pair<size_t, size_t>> ranges;
+            threadPool().parallelFor(
+                n,
+                [&](size_t begin, size_t end) {
+                    for (size_t i = begin; i < end; ++i) {
+                        ++hits[i];
+                    }
+                    std::lock_guard<std::mutex> lock(mutex);
+                    ranges.emplace_back(begin, end);
+                },
+                grain);
+            for (auto &hit : hits) {
+                EXPECT(hit == 1);
+            }
+            EXPECT(ranges.size() <= std::min((n + grain - 1) / grain, threadPool().size()));
+            for (auto [begin, end] : ranges) {
+                EXPECT(begin < end && (end - begin) * 2 >= std::min(grain, n));
+            }
+        }
+    }
+}
+
+// Loops started by different threads share the pool, and each caller sees only its own loop's exception.
+void testConcurrentLoops() {
+    std::atomic<bool> ok{true};
+    std::vector<std::thread> callers;
+    for (size_t t = 0; t < 3; ++t) {
+        callers.emplace_back([&, t] {
+            for (size_t rep = 0; rep < 200; ++rep) {
+                size_t n = 500 + t * 100 + rep;
+                if (parallelSum(n, 8) != sumTo(n)) {
+                    ok = false;
+                }
+            }
+        });
+    }
+    for (size_t rep = 0; rep < 200; ++rep) {
+        bool thrown = false;
+        try {
+            threadPool().parallelFor(64, [](size_t begin, size_t) {
+                if (begin == 0) {
+                    throw std::runtime_error("loop");
+                }
+            });
+        } catch (const std::runtime_error &) {
+            thrown = true;
+        }
+        EXPECT(thrown);
+    }
+    for (auto &caller : callers) {
+        caller.join();
+    }
+    EXPECT(ok);
+}
+
+// Every task starts after its dependencies have finished, and tasks may run parallel loops of their own.
+void testDependencies() {
+    for (size_t rep = 0; rep < 100; ++rep) {
+        constexpr size_t N = 8;
+        std::vector<std::atomic<bool>> done(N);
+        std::vector<size_t> sums(N, 0);
+        std::atomic<bool> ordered{true};
+        TaskGraph graph;
+        auto task = [&](size_t i, std::vector<size_t> deps) {
+            return graph.add(
+                [&, i, deps] {
+                    for (size_t dep : deps) {
+                        ordered = ordered && done[dep];
+                    }
+                    sums[i] = parallelSum(1000 + i, 16);
+                    done[i] = true;
+                },
+                deps);
+        };
+        size_t a = task(0, {}), b = task(1, {});
+        size_t c = task(2, {a, b});
+        size_t d = task(3, {a});
+        size_t e = task(4, {c, d});
+        task(5, {});
+        task(6, {e});
+        task(7, {b, e});
+        graph.run();
+        EXPECT(ordered);
+        for (size_t i = 0; i < N; ++i) {
+            EXPECT(done[i] && sums[i] == sumTo(1000 + i));
+        }
+    }
+}
+
+// Tasks depending on one that threw, directly or not, are skipped; the rest still run and run() rethrows.
+void testSkipAfterThrow(bool inline_run) {
+    std::atomic<bool> dependent{false}, transitive{false}, independent{false}, sibling{false};
+    TaskGraph graph;
+    size_t a = graph.add([] { throw std::runtime_error("task"); });
+    size_t b = graph.add([&] { sibling = true; });
+    size_t c = graph.add([&] { dependent = true; }, {a, b});
+    graph.add([&] { transitive = true; }, {c});
+    graph.add([&] { independent = true; }, {b});
+    bool thrown = false;
+    auto run = [&] {
+        try {
+            graph.run();
+        } catch (const std::runtime_error &) {
+            thrown = true;
+        }
+    };
+    if (inline_run) {
+        // Inside a loop chunk the graph runs in order on the calling thread.
+        threadPool().parallelFor(2, [&](size_t begin, size_t) {
+            if (begin == 0) {
+                run();
+            }
+        });
+    } else {
+        run();
+    }
+    EXPECT(thrown);
+    EXPECT(!dependent && !transitive);
+    EXPECT(sibling && independent);
+}
+
+void testForwardDependencyRejected() {
+    TaskGraph graph;
+    graph.add([] {});
+    EXPECT_THROWS(graph.add([] {}, {1}));
+}
+} // namespace
+
+int main() {
+    // More threads than this machine may have, so that every path of the pool runs.
+    setenv("LLAISYS_NUM_THREADS", "4", 1);
+    EXPECT(threadPool().size() == 4);
+
+    testParallelForCoversRange();
+    testConcurrentLoops();
+    testDependencies();
+    testSkipAfterThrow(false);
+    testSkipAfterThrow(true);
+    testForwardDependencyRejected();
+    return testPassed();
+}
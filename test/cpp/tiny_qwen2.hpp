@@ -0,0 +1,71 @@
+#pragma once
+
+// A Qwen2 model small enough for tests, with random weights from a fixed seed, built through the C API.
+
+#include "llaisys/models/qwen2.h"
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+inline void fillRandom(llaisysTensor_t tensor, float scale, std::mt19937 &rng) {
+    size_t ndim = tensorGetNdim(tensor);
+    std::vector<size_t> shape(ndim);
+    tensorGetShape(tensor, shape.data());
+    size_t numel = 1;
+    for (size_t d : shape) {
+        numel *= d;
+    }
+    std::vector<float> values(numel);
+    std::uniform_real_distribution<float> uniform(-scale, scale);
+    for (float &v : values) {
+        v = uniform(rng);
+    }
+    tensorLoad(tensor, values.data());
+}
+
+// F32, 2 layers, hidden size 32, 4 heads over 2 KV heads, vocabulary of 50 with end token 49.
+inline LlaisysQwen2Model *tinyQwen2(size_t maxseq = 64, unsigned seed = 7, size_t nlayer = 2) {
+    LlaisysQwen2Meta meta{LLAISYS_DTYPE_F32, nlayer, 32, 4, 2, 8, 48, maxseq, 50, 1e-6f, 10000.f, 49};
+    auto *model = llaisysQwen2ModelCreate(&meta, LLAISYS_DEVICE_CPU, nullptr, 0);
+    auto *w = llaisysQwen2ModelWeights(model);
+    std::mt19937 rng(seed);
+    fillRandom(w->in_embed, 1.0f, rng);
+    fillRandom(w->out_embed, 0.5f, rng);
+    fillRandom(w->out_norm_w, 1.0f, rng);
+    for (size_t l = 0; l < nlayer; ++l) {
+        fillRandom(w->attn_norm_w[l], 1.0f, rng);
+        fillRandom(w->attn_q_w[l], 0.3f, rng);
+        fillRandom(w->attn_q_b[l], 0.1f, rng);
+        fillRandom(w->attn_k_w[l], 0.3f, rng);
+        fillRandom(w->attn_k_b[l], 0.1f, rng);
+        fillRandom(w->attn_v_w[l], 0.3f, rng);
+        fillRandom(w->attn_v_b[l], 0.1f, rng);
+        fillRandom(w->attn_o_w[l], 0.3f, rng);
+        fillRandom(w->mlp_norm_w[l], 1.0f, rng);
+        fillRandom(w->mlp_gate_w[l], 0.3f, rng);
+        fillRandom(w->mlp_up_w[l], 0.3f, rng);
+        fillRandom(w->mlp_down_w[l], 0.3f, rng);
+    }
+    return model;
+}
+
+// Starts a new sequence from `prompt`, fed at once or one token per call, and decodes `n` tokens greedily.
+inline std::vector<int64_t> greedyDecode(LlaisysQwen2Model *model, std::vector<int64_t> prompt, size_t n,
+                                         bool token_by_token = false) {
+    llaisysQwen2ModelReset(model);
+    int64_t next = 0;
+    if (token_by_token) {
+        for (int64_t &token : prompt) {
+            next = llaisysQwen2ModelInfer(model, &token, 1);
+        }
+    } else {
+        next = llaisysQwen2ModelInfer(model, prompt.data(), prompt.size());
+    }
+    std::vector<int64_t> out;
+    for (size_t i = 0; i < n; ++i) {
+        out.push_back(next);
+        next = llaisysQwen2ModelInfer(model, &next, 1);
+    }
+    return out;
+}
@@ -38,6 +38,24 @@ def test_op_add(
         )
 
 
+def test_op_add_broadcast(
+    shape,
+    dtype_name="f32",
+    atol=1e-5,
+    rtol=1e-5,
+    device_name="cpu",
+):
+    print(f"   shape {shape} broadcast dtype <{dtype_name}>")
+    a, a_ = random_tensor(shape, dtype_name, device_name)
+    b, b_ = random_tensor(shape[-1:], dtype_name, device_name)
+
+    # b is broadcast over the rows of a, and the sum is written back into a
+    ans = a + b
+    llaisys.Ops.add(a_, a_, b_)
+
+    assert check_equal(a_, ans, atol=atol, rtol=rtol)
+
+
 if __name__ == "__main__":
     import argparse
 
@@ -56,5 +74,6 @@ if __name__ == "__main__":
     for shape in testShapes:
         for dtype_name, atol, rtol in testDtypePrec:
             test_op_add(shape, dtype_name, atol, rtol, args.device, args.profile)
+            test_op_add_broadcast(shape, dtype_name, atol, rtol, args.device)
 
     print("\033[92mTest passed!\033[0m\n")
@@ -6,7 +6,16 @@ parent_dir = os.path.abspath(os.path.join(os.path.dirname(__file__), ".."))
 sys.path.insert(0, parent_dir)
 import llaisys
 import torch
-from test_utils import random_tensor, check_equal, benchmark, zero_tensor
+from test_utils import (
+    random_tensor,
+    check_equal,
+    benchmark,
+    zero_tensor,
+    llaisys_dtype,
+    llaisys_device,
+    torch_dtype,
+    torch_device,
+)
 
 
 def torch_argmax(max_idx, max_val, vals):
@@ -39,6 +48,60 @@ def test_op_argmax(
         )
 
 
+def test_op_argmax_batched(
+    shape,
+    dtype_name="f32",
+    device_name="cpu",
+):
+    print(f"   shape {shape} batched dtype <{dtype_name}>")
+    vals, vals_ = random_tensor(shape, dtype_name, device_name)
+    max_idx, max_idx_ = zero_tensor((shape[0],), "i64", device_name)
+    max_val, max_val_ = zero_tensor((shape[0],), dtype_name, device_name)
+
+    torch.max(vals, dim=-1, out=(max_val, max_idx))
+    llaisys.Ops.argmax(max_idx_, max_val_, vals_)
+
+    assert check_equal(max_val_, max_val, strict=True)
+    assert check_equal(max_idx_, max_idx, strict=True)
+
+
+# Bits of a NaN with the sign bit set, as the signed integer of the element width.
+NEGATIVE_NAN = {"f32": (torch.int32, -0x400000), "f16": (torch.int16, -0x200), "bf16": (torch.int16, -0x40)}
+
+
+def test_op_argmax_negative_nan(
+    numel,
+    dtype_name="f32",
+    device_name="cpu",
+):
+    print(f"   numel {numel} negative NaN dtype <{dtype_name}>")
+    vals = torch.full(
+        (numel,), -1.0, dtype=torch_dtype(dtype_name), device=torch_device(device_name)
+    )
+    vals[:3] = torch.tensor([1.0, 2.0, 3.0])
+    int_dtype, nan_bits = NEGATIVE_NAN[dtype_name]
+    vals.view(int_dtype)[numel - 2] = nan_bits
+    vals_ = llaisys.Tensor(
+        (numel,), dtype=llaisys_dtype(dtype_name), device=llaisys_device(device_name)
+    )
+    api = llaisys.RuntimeAPI(llaisys_device(device_name))
+    api.memcpy_sync(
+        vals_.data_ptr(),
+        vals.data_ptr(),
+        vals.numel() * vals.element_size(),
+        llaisys.MemcpyKind.D2D,
+    )
+    max_idx, max_idx_ = zero_tensor((1,), "i64", device_name)
+    max_val, max_val_ = zero_tensor((1,), dtype_name, device_name)
+
+    torch_argmax(max_idx, max_val, vals)
+    llaisys.Ops.argmax(max_idx_, max_val_, vals_)
+
+    # NaN is the maximum whatever its sign, as in torch.
+    assert max_idx.item() == numel - 2
+    assert check_equal(max_idx_, max_idx, strict=True)
+
+
 if __name__ == "__main__":
     import argparse
 
@@ -52,5 +115,10 @@ if __name__ == "__main__":
     for shape in testShapes:
         for dtype_name in testDtype:
             test_op_argmax(shape, dtype_name, args.device, args.profile)
+    for dtype_name in testDtype:
+        test_op_argmax_batched((4, 151936), dtype_name, args.device)
+    for numel in [5, 4096]:
+        for dtype_name in testDtype:
+            test_op_argmax_negative_nan(numel, dtype_name, args.device)
 
     print("\033[92mTest passed!\033[0m\n")
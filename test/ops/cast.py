@@ -0,0 +1,62 @@
+import sys
+import os
+
+parent_dir = os.path.abspath(os.path.join(os.path.dirname(__file__), ".."))
+sys.path.insert(0, parent_dir)
+import llaisys
+import torch
+from test_utils import random_tensor, zero_tensor, check_equal, benchmark
+
+
+def torch_cast(ans, x):
+    ans.copy_(x)
+
+
+def test_op_cast(
+    shape,
+    src_dtype_name="f32",
+    dst_dtype_name="bf16",
+    atol=1e-3,
+    rtol=1e-3,
+    device_name="cpu",
+    profile=False,
+):
+    print(f"   shape {shape} dtype <{src_dtype_name}> -> <{dst_dtype_name}>")
+    x, x_ = random_tensor(shape, src_dtype_name, device_name)
+
+    out, out_ = zero_tensor(shape, dst_dtype_name, device_name)
+    torch_cast(out, x)
+    llaisys.Ops.cast(out_, x_)
+
+    assert check_equal(out_, out, atol=atol, rtol=rtol)
+
+    if profile:
+        benchmark(
+            lambda: torch_cast(out, x),
+            lambda: llaisys.Ops.cast(out_, x_),
+            device_name,
+        )
+
+
+if __name__ == "__main__":
+    import argparse
+
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--device", default="cpu", choices=["cpu", "nvidia"], type=str)
+    parser.add_argument("--profile", action="store_true")
+    args = parser.parse_args()
+    testShapes = [(2, 3), (512, 4096)]
+    testDtypePairs = [
+        # source type, target type, atol, rtol
+        ("f32", "bf16", 1e-2, 1e-2),
+        ("f32", "f16", 1e-3, 1e-3),
+        ("bf16", "f32", 0, 0),
+        ("f16", "f32", 0, 0),
+        ("bf16", "f16", 1e-3, 1e-3),
+    ]
+    print(f"Testing Ops.cast on {args.device}")
+    for shape in testShapes:
+        for src_dtype_name, dst_dtype_name, atol, rtol in testDtypePairs:
+            test_op_cast(shape, src_dtype_name, dst_dtype_name, atol, rtol, args.device, args.profile)
+
+    print("\033[92mTest passed!\033[0m\n")
@@ -25,7 +25,7 @@ def test_op_embedding(
     torch_embedding(out, idx, embd)
     llaisys.Ops.embedding(out_, idx_, embd_)
 
-    check_equal(out_, out, strict=True)
+    assert check_equal(out_, out, strict=True)
 
     if profile:
         benchmark(
@@ -35,6 +35,27 @@ def test_op_embedding(
         )
 
 
+def test_op_embedding_strided(
+    idx_shape,
+    embd_shape,
+    dtype_name="f32",
+    device_name="cpu",
+):
+    print(f"   idx_shape {idx_shape} embd_shape {embd_shape} strided out dtype <{dtype_name}>")
+    embd, embd_ = random_tensor(embd_shape, dtype_name, device_name)
+    # Repeated ids are gathered once and copied
+    idx, idx_ = random_int_tensor(idx_shape, device_name, high=3)
+    # Write into the middle columns of a wider buffer
+    dim = embd_shape[1]
+    buf, buf_ = random_tensor((idx_shape[0], 3 * dim), dtype_name, device_name)
+    out = buf[:, dim : 2 * dim]
+    out_ = buf_.slice(1, dim, 2 * dim)
+    torch_embedding(out, idx, embd)
+    llaisys.Ops.embedding(out_, idx_, embd_)
+
+    assert check_equal(buf_, buf, strict=True)
+
+
 if __name__ == "__main__":
     import argparse
 
@@ -58,5 +79,6 @@ if __name__ == "__main__":
             test_op_embedding(
                 idx_shape, embd_shape, dtype_name, args.device, args.profile
             )
+            test_op_embedding_strided(idx_shape, embd_shape, dtype_name, args.device)
 
     print("\033[92mTest passed!\033[0m\n")
@@ -45,6 +45,31 @@ def test_op_linear(
         )
 
 
+def test_op_linear_strided(
+    x_shape,
+    w_shape,
+    dtype_name="f32",
+    atol=1e-5,
+    rtol=1e-5,
+    device_name="cpu",
+):
+    # Input and output are column slices of wider tensors, as with a fused QKV projection
+    print(f"   strided x {x_shape}, w {w_shape}, dtype <{dtype_name}>")
+    pad = 8
+    x_wide, x_wide_ = random_tensor((x_shape[0], x_shape[1] + pad), dtype_name, device_name, scale=0.1)
+    x, x_ = x_wide[:, pad:], x_wide_.slice(1, pad, x_shape[1] + pad)
+    w, w_ = random_tensor(w_shape, dtype_name, device_name, scale=0.01)
+    bias, bias_ = random_tensor((w_shape[0],), dtype_name, device_name)
+
+    out_wide, out_wide_ = random_tensor((x_shape[0], w_shape[0] + pad), dtype_name, device_name)
+    out, out_ = out_wide[:, : w_shape[0]], out_wide_.slice(1, 0, w_shape[0])
+    out.copy_(torch.nn.functional.linear(x, w, bias))
+    llaisys.Ops.linear(out_, x_, w_, bias_)
+
+    assert check_equal(out_, out, atol=atol, rtol=rtol)
+    assert check_equal(out_wide_, out_wide, atol=atol, rtol=rtol)
+
+
 if __name__ == "__main__":
     import argparse
 
@@ -54,6 +79,7 @@ if __name__ == "__main__":
     args = parser.parse_args()
     testShapes = [
         ((2, 3), (2, 4), (3, 4), True),
+        ((4, 6), (4, 8), (6, 8), False),
         ((512, 4096), (512, 4096), (4096, 4096), True),
     ]
     testDtypePrec = [
@@ -66,5 +92,7 @@ if __name__ == "__main__":
     for shapes in testShapes:
         for dtype_name, atol, rtol in testDtypePrec:
             test_op_linear(*shapes, dtype_name, atol, rtol, args.device, args.profile)
+    for dtype_name, atol, rtol in testDtypePrec:
+        test_op_linear_strided((5, 64), (48, 64), dtype_name, atol, rtol, args.device)
 
     print("\033[92mTest passed!\033[0m\n")
@@ -0,0 +1,66 @@
+import sys
+import os
+
+parent_dir = os.path.abspath(os.path.join(os.path.dirname(__file__), ".."))
+sys.path.insert(0, parent_dir)
+import llaisys
+import torch
+from test_utils import random_tensor, random_int_tensor, zero_tensor, check_equal, benchmark
+
+
+def torch_rearrange(ans, inp):
+    ans.copy_(inp)
+
+
+def test_op_rearrange(
+    shape,
+    perm,
+    dtype_name="f32",
+    device_name="cpu",
+    profile=False,
+):
+    print(f"   shape {shape} perm {perm} dtype <{dtype_name}>")
+    if dtype_name.startswith("i"):
+        x, x_ = random_int_tensor(shape, device_name, dtype_name, high=1000)
+    else:
+        x, x_ = random_tensor(shape, dtype_name, device_name)
+    # Read through a permuted and sliced view, so the input is not contiguous
+    x = x.permute(*perm)[..., 1:]
+    x_ = x_.permute(*perm)
+    x_ = x_.slice(len(perm) - 1, 1, x_.shape()[-1])
+
+    out, out_ = zero_tensor(x.shape, dtype_name, device_name)
+    torch_rearrange(out, x)
+    llaisys.Ops.rearrange(out_, x_)
+
+    assert check_equal(out_, out, strict=True)
+
+    if profile:
+        benchmark(
+            lambda: torch_rearrange(out, x),
+            lambda: llaisys.Ops.rearrange(out_, x_),
+            device_name,
+        )
+
+
+if __name__ == "__main__":
+    import argparse
+
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--device", default="cpu", choices=["cpu", "nvidia"], type=str)
+    parser.add_argument("--profile", action="store_true")
+    args = parser.parse_args()
+    testShapes = [
+        # shape, perm
+        ((2, 3, 4), (0, 1, 2)),
+        ((5, 7), (1, 0)),
+        ((64, 8, 33), (1, 0, 2)),
+        ((512, 4096), (1, 0)),
+    ]
+    testDtypes = ["f32", "f16", "bf16", "i32", "i64"]
+    print(f"Testing Ops.rearrange on {args.device}")
+    for shape, perm in testShapes:
+        for dtype_name in testDtypes:
+            test_op_rearrange(shape, perm, dtype_name, args.device, args.profile)
+
+    print("\033[92mTest passed!\033[0m\n")
@@ -68,6 +68,7 @@ if __name__ == "__main__":
     args = parser.parse_args()
     testShapes = [
         ((2, 1, 4), (0, 2)), 
+        ((16, 8, 128), (3, 19)),
         ((512, 4, 4096), (512, 1024))]
     testDtypePrec = [
         # type, atol, rtol
@@ -18,6 +18,7 @@ def test_basic_runtime_api(device_name: str = "cpu"):
         print("Testing device {i}...")
         api.set_device(i)
         test_memcpy(api, 1024 * 1024)
+        test_memcpy_async(api, 1024 * 1024)
 
         print("     Passed")
 
@@ -53,10 +54,58 @@ def test_memcpy(api, size_bytes: int):
     torch.testing.assert_close(a, b)
 
 
+def test_memcpy_async(api, size_bytes: int):
+    a = torch.randint(0, 255, (size_bytes,), dtype=torch.uint8, device=torch_device("cpu"))
+    b = torch.zeros_like(a)
+    device_a = api.malloc_device(size_bytes)
+    device_b = api.malloc_device(size_bytes)
+    upload = api.create_stream()
+    download = api.create_stream()
+    uploaded = api.create_event()
+
+    # The copy back runs on another stream, ordered after the upload by an event.
+    api.memcpy_async(device_a, a.data_ptr(), size_bytes, llaisys.MemcpyKind.H2D, upload)
+    api.memcpy_async(device_b, device_a, size_bytes, llaisys.MemcpyKind.D2D, upload)
+    api.record_event(uploaded, upload)
+    api.stream_wait_event(download, uploaded)
+    api.memcpy_async(b.data_ptr(), device_b, size_bytes, llaisys.MemcpyKind.D2H, download)
+    api.stream_synchronize(download)
+
+    torch.testing.assert_close(a, b)
+
+    api.destroy_event(uploaded)
+    api.destroy_stream(upload)
+    api.destroy_stream(download)
+    api.free_device(device_a)
+    api.free_device(device_b)
+
+
+def test_cpu_huge_pages(size_bytes: int):
+    api = llaisys.RuntimeAPI(llaisys.DeviceType.CPU)
+    before = llaisys.cpu_memory_stats()
+    llaisys.set_cpu_huge_pages(llaisys.HugePages.THP)
+    try:
+        ptr = api.malloc_device(size_bytes)
+        assert ptr % 64 == 0
+        stats = llaisys.cpu_memory_stats()
+        # Mapped with THP, or counted as a fallback to the heap.
+        assert (
+            stats["thp_bytes"] >= before["thp_bytes"] + size_bytes
+            or stats["mmap_fallbacks"] > before["mmap_fallbacks"]
+        )
+        test_memcpy(api, size_bytes)
+        api.free_device(ptr)
+        assert llaisys.cpu_memory_stats()["thp_bytes"] == before["thp_bytes"]
+    finally:
+        llaisys.set_cpu_huge_pages(llaisys.HugePages.OFF)
+
+
 if __name__ == "__main__":
     parser = argparse.ArgumentParser()
     parser.add_argument("--device", default="cpu", choices=["cpu", "nvidia"], type=str)
     args = parser.parse_args()
     test_basic_runtime_api(args.device)
+    if args.device == "cpu":
+        test_cpu_huge_pages(4 * 1024 * 1024)
     
     print("\033[92mTest passed!\033[0m\n")
@@ -48,8 +48,67 @@ def test_tensor():
     assert llaisys_tensor.is_contiguous() == torch_tensor.is_contiguous()
     assert check_equal(llaisys_tensor_slice, torch_tensor_slice)
 
+    # Test reshape
+    print("===Test reshape===")
+    torch_tensor_reshape = torch_tensor_perm.reshape(5, 12)
+    llaisys_tensor_reshape = llaisys_tensor_perm.reshape(5, 12)
+    llaisys_tensor_reshape.debug()
+    assert llaisys_tensor_reshape.shape() == torch_tensor_reshape.shape
+    assert llaisys_tensor_reshape.strides() == torch_tensor_reshape.stride()
+    assert check_equal(llaisys_tensor_reshape, torch_tensor_reshape)
+    # Splitting a dimension of a permuted tensor needs no copy
+    torch_tensor_split = torch_tensor_perm.reshape(5, 3, 2, 2)
+    llaisys_tensor_split = llaisys_tensor_perm.reshape(5, 3, 2, 2)
+    assert llaisys_tensor_split.strides() == torch_tensor_split.stride()
+    assert check_equal(llaisys_tensor_split, torch_tensor_split)
+
+    # Test contiguous
+    print("===Test contiguous===")
+    torch_tensor_cont = torch_tensor_slice.contiguous()
+    llaisys_tensor_cont = llaisys_tensor_slice.contiguous()
+    llaisys_tensor_cont.debug()
+    assert llaisys_tensor_cont.is_contiguous()
+    assert llaisys_tensor_cont.shape() == torch_tensor_cont.shape
+    assert llaisys_tensor_cont.strides() == torch_tensor_cont.stride()
+    assert check_equal(llaisys_tensor_cont, torch_tensor_cont)
+    assert check_equal(llaisys_tensor.contiguous(), torch_tensor)
+
+
+def test_tensor_to(device_name="cpu"):
+    print(f"===Test to <{device_name}>===")
+    torch_tensor = torch.arange(60, dtype=torch_dtype("i64")).reshape(3, 4, 5)
+    llaisys_tensor = llaisys.Tensor(
+        (3, 4, 5), dtype=llaisys_dtype("i64"), device=llaisys_device("cpu")
+    )
+    llaisys_tensor.load(torch_tensor.data_ptr())
+
+    # On the same device the result shares storage and layout
+    llaisys_tensor_perm = llaisys_tensor.permute(2, 0, 1)
+    llaisys_tensor_same = llaisys_tensor_perm.to(llaisys_device("cpu"))
+    assert llaisys_tensor_same.data_ptr() == llaisys_tensor_perm.data_ptr()
+    assert llaisys_tensor_same.strides() == llaisys_tensor_perm.strides()
+    assert check_equal(llaisys_tensor_same, torch_tensor.permute(2, 0, 1))
+
+    # Across devices every layout arrives contiguous, and survives the way back
+    for llaisys_view, torch_view in [
+        (llaisys_tensor, torch_tensor),
+        (llaisys_tensor_perm, torch_tensor.permute(2, 0, 1)),
+        (llaisys_tensor.slice(2, 1, 4), torch_tensor[:, :, 1:4]),
+    ]:
+        llaisys_moved = llaisys_view.to(llaisys_device(device_name))
+        llaisys_back = llaisys_moved.to(llaisys_device("cpu"))
+        assert llaisys_back.shape() == torch_view.shape
+        if device_name != "cpu":
+            assert llaisys_moved.is_contiguous()
+            assert llaisys_back.is_contiguous()
+        assert check_equal(llaisys_back, torch_view)
+
 
 if __name__ == "__main__":
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--device", default="cpu", choices=["cpu", "nvidia"], type=str)
+    args = parser.parse_args()
     test_tensor()
+    test_tensor_to(args.device)
 
     print("\n\033[92mTest passed!\033[0m\n")
@@ -95,6 +95,21 @@ target("llaisys-ops")
     on_install(function (target) end)
 target_end()
 
+target("llaisys-models")
+    set_kind("static")
+    add_deps("llaisys-ops")
+
+    set_languages("cxx17")
+    set_warnings("all", "error")
+    if not is_plat("windows") then
+        add_cxflags("-fPIC", "-Wno-unknown-pragmas")
+    end
+
+    add_files("src/models/*/*.cpp")
+
+    on_install(function (target) end)
+target_end()
+
 target("llaisys")
     set_kind("shared")
     add_deps("llaisys-utils")
@@ -102,10 +117,15 @@ target("llaisys")
     add_deps("llaisys-core")
     add_deps("llaisys-tensor")
     add_deps("llaisys-ops")
+    add_deps("llaisys-models")
 
     set_languages("cxx17")
     set_warnings("all", "error")
+    if not is_plat("windows") then
+        add_syslinks("pthread")
+    end
     add_files("src/llaisys/*.cc")
+    add_files("src/llaisys/models/*.cc")
     set_installdir(".")
 
     
@@ -119,4 +139,18 @@ target("llaisys")
             os.cp("lib/*.so", "python/llaisys/libllaisys/")
         end
     end)
-target_end()
\ No newline at end of file
+target_end()
+-- C++ tests of library internals, one program per file: xmake build -g tests && xmake run -g tests
+for _, file in ipairs(os.files("test/cpp/test_*.cpp")) do
+    target(path.basename(file))
+        set_kind("binary")
+        set_group("tests")
+        set_default(false)
+        add_deps("llaisys")
+
+        set_languages("cxx17")
+        set_warnings("all", "error")
+        add_includedirs("src")
+        add_files(file)
+    target_end()
+end